@@ -158,6 +158,7 @@
 #include <mlpack/core/util/cli.hpp>
 #include <mlpack/core/util/ostream_extra.hpp>
 #include <mlpack/core/data/load.hpp>
+#include <mlpack/core/data/chunk_reader.hpp>
 #include <mlpack/core/data/save.hpp>
 #include <mlpack/core/data/normalize_labels.hpp>
 #include <mlpack/core/math/clamp.hpp>
@@ -165,6 +166,7 @@
 #include <mlpack/core/math/lin_alg.hpp>
 #include <mlpack/core/math/range.hpp>
 #include <mlpack/core/math/round.hpp>
+#include <mlpack/core/dists/diagonal_gaussian_distribution.hpp>
 #include <mlpack/core/dists/discrete_distribution.hpp>
 #include <mlpack/core/dists/gaussian_distribution.hpp>
 #include <mlpack/core/dists/laplace_distribution.hpp>
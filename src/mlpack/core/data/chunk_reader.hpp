@@ -0,0 +1,82 @@
+/**
+ * @file chunk_reader.hpp
+ *
+ * A reader for text datasets that loads a chunk of points at a time, for
+ * datasets that do not fit in memory.
+ */
+#ifndef __MLPACK_CORE_DATA_CHUNK_READER_HPP
+#define __MLPACK_CORE_DATA_CHUNK_READER_HPP
+
+#include <mlpack/prereqs.hpp>
+#include <mlpack/core/util/log.hpp>
+
+#include <fstream>
+
+namespace mlpack {
+namespace data {
+
+/**
+ * Read a dataset stored in a text file (CSV, TSV or whitespace-separated, one
+ * point per line) a chunk of points at a time.  As with data::Load(), each
+ * point becomes a column of the chunk.  Blank lines are skipped, and every
+ * point must have the same dimensionality as the first one.
+ *
+ * Reading continues from where the last chunk ended.  Once the end of the file
+ * is reached, Read() returns no points until Rewind() is called, or until more
+ * points are appended to the file; so a file that is still being written can
+ * be followed as it grows.
+ *
+ * @code
+ * data::ChunkReader reader("huge_dataset.csv");
+ * arma::mat chunk;
+ * while (reader.Read(10000, chunk) > 0)
+ * {
+ *   // Do something with the points in the chunk.
+ * }
+ * @endcode
+ */
+class ChunkReader
+{
+ public:
+  /**
+   * Open the given file.  If it cannot be opened, a fatal error is issued.
+   *
+   * @param filename Text file holding the dataset.
+   */
+  ChunkReader(const std::string& filename);
+
+  /**
+   * Read at most the given number of points into the chunk, returning the
+   * number of points read.  The chunk has one column per point read; if no
+   * points are left, it is empty and 0 is returned.
+   *
+   * @param points Maximum number of points to read.
+   * @param chunk Matrix to store the points in.
+   */
+  size_t Read(const size_t points, arma::mat& chunk);
+
+  //! Go back to the start of the file.
+  void Rewind();
+
+  //! Get the name of the file.
+  const std::string& Filename() const { return filename; }
+
+  //! Get the dimensionality of the points (0 until the first is read).
+  size_t Dimensionality() const { return dimensionality; }
+
+ private:
+  //! The name of the file.
+  std::string filename;
+  //! The stream the points are read from.
+  std::ifstream stream;
+  //! Dimensionality of the points in the file (0 until the first is read).
+  size_t dimensionality;
+};
+
+} // namespace data
+} // namespace mlpack
+
+// Include implementation.
+#include "chunk_reader_impl.hpp"
+
+#endif
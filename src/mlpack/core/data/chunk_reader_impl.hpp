@@ -0,0 +1,77 @@
+/**
+ * @file chunk_reader_impl.hpp
+ *
+ * Implementation of the ChunkReader class.
+ */
+#ifndef __MLPACK_CORE_DATA_CHUNK_READER_IMPL_HPP
+#define __MLPACK_CORE_DATA_CHUNK_READER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "chunk_reader.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+namespace mlpack {
+namespace data {
+
+inline ChunkReader::ChunkReader(const std::string& filename) :
+    filename(filename),
+    stream(filename.c_str()),
+    dimensionality(0)
+{
+  if (!stream.is_open())
+    Log::Fatal << "Cannot open file '" << filename << "'." << std::endl;
+}
+
+inline size_t ChunkReader::Read(const size_t points, arma::mat& chunk)
+{
+  // Clear the end-of-file state, in case points have been appended since the
+  // last read.
+  stream.clear();
+
+  std::vector<double> values;
+  size_t read = 0;
+  std::string line;
+  while (read < points && std::getline(stream, line))
+  {
+    // Commas and tabs are treated as whitespace.
+    std::replace(line.begin(), line.end(), ',', ' ');
+    std::replace(line.begin(), line.end(), '\t', ' ');
+    std::istringstream lineStream(line);
+
+    size_t dims = 0;
+    double value;
+    while (lineStream >> value)
+    {
+      values.push_back(value);
+      ++dims;
+    }
+
+    if (dims == 0)
+      continue; // Blank line.
+
+    if (dimensionality == 0)
+      dimensionality = dims;
+    else if (dims != dimensionality)
+      Log::Fatal << "ChunkReader::Read(): point in '" << filename << "' has "
+          << "dimensionality " << dims << ", but earlier points have "
+          << "dimensionality " << dimensionality << "!" << std::endl;
+
+    ++read;
+  }
+
+  chunk = arma::mat(values.data(), dimensionality, read);
+  return read;
+}
+
+inline void ChunkReader::Rewind()
+{
+  stream.clear();
+  stream.seekg(0, std::ios::beg);
+}
+
+} // namespace data
+} // namespace mlpack
+
+#endif
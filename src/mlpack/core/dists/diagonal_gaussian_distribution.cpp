@@ -0,0 +1,147 @@
+/**
+ * @file diagonal_gaussian_distribution.cpp
+ *
+ * Implementation of the Gaussian distribution with diagonal covariance.
+ */
+#include "diagonal_gaussian_distribution.hpp"
+
+using namespace mlpack;
+using namespace mlpack::distribution;
+
+DiagonalGaussianDistribution::DiagonalGaussianDistribution(
+    const arma::vec& mean,
+    const arma::vec& covariance) :
+    mean(mean)
+{
+  Covariance(covariance);
+}
+
+void DiagonalGaussianDistribution::Covariance(const arma::vec& covariance)
+{
+  this->covariance = covariance;
+  FactorCovariance();
+}
+
+void DiagonalGaussianDistribution::Covariance(arma::vec&& covariance)
+{
+  this->covariance = std::move(covariance);
+  FactorCovariance();
+}
+
+void DiagonalGaussianDistribution::FactorCovariance()
+{
+  invCov = 1.0 / covariance;
+  logDetCov = arma::accu(arma::log(covariance));
+}
+
+double DiagonalGaussianDistribution::LogProbability(
+    const arma::vec& observation) const
+{
+  const size_t k = observation.n_elem;
+  const arma::vec diff = observation - mean;
+  return -0.5 * k * log2pi - 0.5 * logDetCov -
+      0.5 * arma::dot(invCov, arma::square(diff));
+}
+
+arma::vec DiagonalGaussianDistribution::Random() const
+{
+  return arma::sqrt(covariance) % arma::randn<arma::vec>(mean.n_elem) + mean;
+}
+
+/**
+ * Estimate the Gaussian distribution directly from the given observations.
+ *
+ * @param observations List of observations.
+ */
+void DiagonalGaussianDistribution::Estimate(const arma::mat& observations)
+{
+  if (observations.n_cols == 0)
+  {
+    // This will end up just being empty.
+    mean.zeros(0);
+    covariance.zeros(0);
+    return;
+  }
+
+  mean = arma::mean(observations, 1);
+
+  // Calculate the variances with the (1 / (n - 1)) normalization, so that they
+  // are unbiased, as GaussianDistribution does.  Like arma::cov(), a single
+  // observation is normalized by 1 (so its variances are 0).
+  arma::mat diffs = observations;
+  diffs.each_col() -= mean;
+  const size_t norm = std::max((size_t) observations.n_cols - 1, (size_t) 1);
+  covariance = arma::sum(arma::square(diffs), 1) / norm;
+
+  EnsurePositive();
+  FactorCovariance();
+}
+
+/**
+ * Estimate the Gaussian distribution from the given observations, taking into
+ * account the probability of each observation actually being from this
+ * distribution.
+ */
+void DiagonalGaussianDistribution::Estimate(const arma::mat& observations,
+                                            const arma::vec& probabilities)
+{
+  if (observations.n_cols == 0)
+  {
+    // This will end up just being empty.
+    mean.zeros(0);
+    covariance.zeros(0);
+    return;
+  }
+
+  const double sumProb = arma::accu(probabilities);
+  if (sumProb == 0)
+  {
+    // Nothing in this Gaussian!  At least set the variances so that the
+    // covariance is invertible.
+    mean.zeros(observations.n_rows);
+    covariance.zeros(observations.n_rows);
+    covariance += 1e-50;
+    FactorCovariance();
+    return;
+  }
+
+  mean = (observations * probabilities) / sumProb;
+
+  arma::mat diffs = observations;
+  diffs.each_col() -= mean;
+  covariance = (arma::square(diffs) * probabilities) / sumProb;
+
+  EnsurePositive();
+  FactorCovariance();
+}
+
+void DiagonalGaussianDistribution::EnsurePositive()
+{
+  for (size_t i = 0; i < covariance.n_elem; ++i)
+  {
+    // NaN variances are not positive either.
+    if (!(covariance[i] > 1e-50))
+    {
+      Log::Debug << "DiagonalGaussianDistribution::Estimate(): variance " << i
+          << " is not positive.  Adding perturbation." << std::endl;
+      covariance[i] = 1e-50;
+    }
+  }
+}
+
+/**
+ * Returns a string representation of this object.
+ */
+std::string DiagonalGaussianDistribution::ToString() const
+{
+  std::ostringstream convert;
+  convert << "DiagonalGaussianDistribution [" << this << "]" << std::endl;
+
+  // Secondary ostringstream so things can be indented right.
+  std::ostringstream data;
+  data << "Mean: " << std::endl << mean;
+  data << "Variances: " << std::endl << covariance;
+
+  convert << util::Indent(data.str());
+  return convert.str();
+}
@@ -62,14 +62,32 @@ void GaussianDistribution::FactorCovariance()
   double sign = 0.;
   arma::log_det(logDetCov, sign, covLower);
   logDetCov *= 2;
+
+  diagonal = IsDiagonal(covariance);
+}
+
+bool GaussianDistribution::IsDiagonal(const arma::mat& matrix)
+{
+  for (size_t j = 0; j < matrix.n_cols; ++j)
+    for (size_t i = 0; i < matrix.n_rows; ++i)
+      if (i != j && matrix(i, j) != 0.0)
+        return false;
+
+  return true;
 }
 
 double GaussianDistribution::LogProbability(const arma::vec& observation) const
 {
   const size_t k = observation.n_elem;
-  const arma::vec diff = mean - observation;
-  const arma::vec v = (diff.t() * invCov * diff);
-  return -0.5 * k * log2pi - 0.5 * logDetCov - 0.5 * v(0);
+
+  // Whiten the difference with the Cholesky factor of the covariance.
+  arma::vec diff = observation - mean;
+  if (diagonal)
+    diff /= covLower.diag();
+  else
+    diff = arma::solve(arma::trimatl(covLower), diff);
+
+  return -0.5 * k * log2pi - 0.5 * logDetCov - 0.5 * arma::dot(diff, diff);
 }
 
 arma::vec GaussianDistribution::Random() const
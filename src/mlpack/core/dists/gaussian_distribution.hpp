@@ -15,6 +15,13 @@ namespace distribution {
 
 /**
  * A single multivariate Gaussian distribution.
+ *
+ * The lower Cholesky factor L of the covariance (cov = L L^T) is cached when
+ * the covariance is set, so the log-density of a matrix of observations is
+ * found by whitening all the observations with a single triangular solve
+ * (L^-1 (x - mean)) and summing the squares of each column.  If the
+ * covariance is diagonal, the whitening is just a division by the standard
+ * deviations, which takes O(d) time per observation.
  */
 class GaussianDistribution
 {
@@ -29,6 +36,9 @@ class GaussianDistribution
   arma::mat invCov;
   //! Cached logdet(cov).
   double logDetCov;
+  //! Whether the covariance is diagonal (so covLower holds the standard
+  //! deviations on its diagonal).
+  bool diagonal;
 
   //! log(2pi)
   static const constexpr double log2pi = 1.83787706640934533908193770912475883;
@@ -37,7 +47,7 @@ class GaussianDistribution
   /**
    * Default constructor, which creates a Gaussian with zero dimension.
    */
-  GaussianDistribution() { /* nothing to do */ }
+  GaussianDistribution() : diagonal(false) { /* nothing to do */ }
 
   /**
    * Create a Gaussian distribution with zero mean and identity covariance with
@@ -48,7 +58,8 @@ class GaussianDistribution
       covariance(arma::eye<arma::mat>(dimension, dimension)),
       covLower(arma::eye<arma::mat>(dimension, dimension)),
       invCov(arma::eye<arma::mat>(dimension, dimension)),
-      logDetCov(0)
+      logDetCov(0),
+      diagonal(true)
   { /* Nothing to do. */ }
 
   /**
@@ -78,7 +89,7 @@ class GaussianDistribution
 
   /**
    * Calculates the multivariate Gaussian probability density function for each
-   * data point (column) in the given matrix
+   * data point (column) in the given matrix.
    *
    * @param x List of observations.
    * @param probabilities Output probabilities for each input observation.
@@ -90,6 +101,15 @@ class GaussianDistribution
     probabilities = arma::exp(logProbabilities);
   }
 
+  /**
+   * Calculates the multivariate Gaussian log probability density function for
+   * each data point (column) in the given matrix, using the cached Cholesky
+   * factor of the covariance.
+   *
+   * @param x List of observations.
+   * @param logProbabilities Output log probabilities for each input
+   *     observation.
+   */
   void LogProbability(const arma::mat& x, arma::vec& logProbabilities) const;
 
   /**
@@ -151,6 +171,11 @@ class GaussianDistribution
     ar & CreateNVP(covLower, "covLower");
     ar & CreateNVP(invCov, "invCov");
     ar & CreateNVP(logDetCov, "logDetCov");
+
+    // The diagonal flag is not stored, since it can be recovered from the
+    // covariance.
+    if (Archive::is_loading::value)
+      diagonal = IsDiagonal(covariance);
   }
 
   /**
@@ -159,38 +184,41 @@ class GaussianDistribution
   std::string ToString() const;
 
  private:
+  //! Compute the Cholesky factor, inverse and log-determinant of the
+  //! covariance.
   void FactorCovariance();
 
+  //! Return whether every off-diagonal element of the given matrix is zero.
+  static bool IsDiagonal(const arma::mat& matrix);
+
 };
 
 /**
-* Calculates the multivariate Gaussian log probability density function for each
-* data point (column) in the given matrix
-*
-* @param x List of observations.
-* @param probabilities Output log probabilities for each input observation.
-*/
-inline void GaussianDistribution::LogProbability(const arma::mat& x,
-                                                 arma::vec& logProbabilities) const
+ * Calculates the multivariate Gaussian log probability density function for
+ * each data point (column) in the given matrix.
+ */
+inline void GaussianDistribution::LogProbability(
+    const arma::mat& x,
+    arma::vec& logProbabilities) const
 {
-  // Column i of 'diffs' is the difference between x.col(i) and the mean.
-  arma::mat diffs = x - (mean * arma::ones<arma::rowvec>(x.n_cols));
-
-  // Now, we only want to calculate the diagonal elements of (diffs' * cov^-1 *
-  // diffs).  We just don't need any of the other elements.  We can calculate
-  // the right hand part of the equation (instead of the left side) so that
-  // later we are referencing columns, not rows -- that is faster.
-  const arma::mat rhs = -0.5 * invCov * diffs;
-  arma::vec logExponents(diffs.n_cols); // We will now fill this.
-  for (size_t i = 0; i < diffs.n_cols; i++)
-    logExponents(i) = accu(diffs.unsafe_col(i) % rhs.unsafe_col(i));
+  // Column i of 'whitened' is the difference between x.col(i) and the mean.
+  arma::mat whitened = x;
+  whitened.each_col() -= mean;
+
+  // The exponent is -0.5 * || L^-1 (x - mean) ||^2.  Whiten every observation
+  // at once with a triangular solve, or by scaling with the standard deviations
+  // if the covariance is diagonal.
+  if (diagonal)
+    whitened.each_col() /= arma::vec(covLower.diag());
+  else
+    whitened = arma::solve(arma::trimatl(covLower), whitened);
 
   const size_t k = x.n_rows;
 
-  logProbabilities = -0.5 * k * log2pi - 0.5 * logDetCov + logExponents;
+  logProbabilities = -0.5 * k * log2pi - 0.5 * logDetCov -
+      0.5 * trans(arma::sum(arma::square(whitened), 0));
 }
 
-
 }; // namespace distribution
 }; // namespace mlpack
 
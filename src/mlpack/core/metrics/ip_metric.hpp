@@ -33,6 +33,12 @@ class IPMetric
   //! Create the IPMetric with an instantiated kernel.
   IPMetric(KernelType& kernel);
 
+  //! Copy the given metric.  The copy holds its own copy of the kernel.
+  IPMetric(const IPMetric& other);
+
+  //! Copy the given metric.  The copy holds its own copy of the kernel.
+  IPMetric& operator=(const IPMetric& other);
+
   //! Destroy the IPMetric object.
   ~IPMetric();
 
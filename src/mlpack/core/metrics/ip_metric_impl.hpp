@@ -34,6 +34,31 @@ IPMetric<KernelType>::IPMetric(KernelType& kernel) :
   // Nothing to do.
 }
 
+// Copy constructor.
+template<typename KernelType>
+IPMetric<KernelType>::IPMetric(const IPMetric& other) :
+    kernel(new KernelType(*other.kernel)),
+    kernelOwner(true)
+{
+  // Nothing to do.
+}
+
+// Copy assignment operator.
+template<typename KernelType>
+IPMetric<KernelType>& IPMetric<KernelType>::operator=(const IPMetric& other)
+{
+  if (this == &other)
+    return *this;
+
+  if (kernelOwner)
+    delete kernel;
+
+  kernel = new KernelType(*other.kernel);
+  kernelOwner = true;
+
+  return *this;
+}
+
 // Destructor for the IPMetric.
 template<typename KernelType>
 IPMetric<KernelType>::~IPMetric()
@@ -59,11 +84,15 @@ template<typename Archive>
 void IPMetric<KernelType>::Serialize(Archive& ar,
                                      const unsigned int /* version */)
 {
-  // If we're loading, we need to allocate space for the kernel, and we will own
-  // the kernel.
+  // If we're loading, the kernel will be allocated during loading, and we will
+  // own it.
   if (Archive::is_loading::value)
-    kernel = new KernelType();
-  kernelOwner = true;
+  {
+    if (kernelOwner)
+      delete kernel;
+
+    kernelOwner = true;
+  }
 
   ar & data::CreateNVP(kernel, "kernel");
 }
@@ -76,6 +76,12 @@ class BallBound
   //! Destructor to release allocated memory.
   ~BallBound();
 
+  /**
+   * Reset the bound to the empty ball (so that it contains nothing), keeping
+   * its dimensionality and its metric.
+   */
+  void Clear();
+
   //! Get the radius of the ball.
   double Radius() const { return radius; }
   //! Modify the radius of the ball.
@@ -71,6 +71,16 @@ BallBound<VecType, TMetricType>& BallBound<VecType, TMetricType>::operator=(
   center = other.center;
   metric = other.metric;
   ownsMetric = false;
+
+  return *this;
+}
+
+//! Reset the bound to the empty ball.
+template<typename VecType, typename TMetricType>
+void BallBound<VecType, TMetricType>::Clear()
+{
+  radius = -DBL_MAX;
+  center.zeros();
 }
 
 //! Destructor to release allocated memory.
@@ -334,6 +334,9 @@ class BinarySpaceTree
    * it will never be greater than this).
    */
   double FurthestDescendantDistance() const;
+  //! Modify the furthest possible descendant distance.  This should only be
+  //! changed if the bound has changed.  Be careful!
+  double& FurthestDescendantDistance() { return furthestDescendantDistance; }
 
   //! Return the minimum distance from the center of the node to any bound edge.
   double MinimumBoundDistance() const;
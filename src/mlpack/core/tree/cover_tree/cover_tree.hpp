@@ -215,7 +215,7 @@ class CoverTree
   using BreadthFirstDualTreeTraverser = DualTreeTraverser<RuleType>;
 
   //! Get a reference to the dataset.
-  const MatType& Dataset() const { return dataset; }
+  const MatType& Dataset() const { return *dataset; }
 
   //! Get the index of the point which this node represents.
   size_t Point() const { return point; }
@@ -335,7 +335,7 @@ class CoverTree
   //! Get the center of the node and store it in the given vector.
   void Center(arma::vec& center) const
   {
-    center = arma::vec(dataset.col(point));
+    center = arma::vec(dataset->col(point));
   }
 
   //! Get the instantiated metric.
@@ -343,7 +343,10 @@ class CoverTree
 
  private:
   //! Reference to the matrix which this tree is built on.
-  const MatType& dataset;
+  const MatType* dataset;
+  //! Whether or not we need to destroy the dataset in the destructor.  This is
+  //! only true for the root of a tree that was loaded with Serialize().
+  bool localDataset;
 
   //! Index of the point in the matrix which this node represents.
   size_t point;
@@ -466,7 +469,25 @@ class CoverTree
    */
   void RemoveNewImplicitNodes();
 
+ protected:
+  /**
+   * A default constructor.  This is meant to only be used with
+   * boost::serialization, which is allowed with the friend declaration below.
+   * This does not return a valid tree!  This method must be protected, so that
+   * the serialization shim can work with the default constructor.
+   */
+  CoverTree();
+
+  //! Friend access is given for the default constructor.
+  friend class boost::serialization::access;
+
  public:
+  /**
+   * Serialize the tree.
+   */
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */);
+
   /**
    * Returns a string representation of this object.
    */
@@ -27,7 +27,8 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CoverTree(
     const MatType& dataset,
     const double base,
     MetricType* metric) :
-    dataset(dataset),
+    dataset(&dataset),
+    localDataset(false),
     point(RootPointPolicy::ChooseRoot(dataset)),
     scale(INT_MAX),
     base(base),
@@ -114,7 +115,8 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CoverTree(
     const MatType& dataset,
     MetricType& metric,
     const double base) :
-    dataset(dataset),
+    dataset(&dataset),
+    localDataset(false),
     point(RootPointPolicy::ChooseRoot(dataset)),
     scale(INT_MAX),
     base(base),
@@ -207,7 +209,8 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CoverTree(
     size_t& farSetSize,
     size_t& usedSetSize,
     MetricType& metric) :
-    dataset(dataset),
+    dataset(&dataset),
+    localDataset(false),
     point(pointIndex),
     scale(scale),
     base(base),
@@ -251,7 +254,8 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CoverTree(
     const double parentDistance,
     const double furthestDescendantDistance,
     MetricType* metric) :
-    dataset(dataset),
+    dataset(&dataset),
+    localDataset(false),
     point(pointIndex),
     scale(scale),
     base(base),
@@ -280,6 +284,7 @@ template<
 CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CoverTree(
     const CoverTree& other) :
     dataset(other.dataset),
+    localDataset(false),
     point(other.point),
     scale(other.scale),
     base(other.base),
@@ -300,6 +305,29 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CoverTree(
   }
 }
 
+template<
+    typename MetricType,
+    typename StatisticType,
+    typename MatType,
+    typename RootPointPolicy
+>
+CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CoverTree() :
+    dataset(NULL),
+    localDataset(false),
+    point(0),
+    scale(INT_MIN),
+    base(0.0),
+    numDescendants(0),
+    parent(NULL),
+    parentDistance(0.0),
+    furthestDescendantDistance(0.0),
+    localMetric(false),
+    metric(NULL),
+    distanceComps(0)
+{
+  // Nothing to do.
+}
+
 template<
     typename MetricType,
     typename StatisticType,
@@ -315,6 +343,10 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::~CoverTree()
   // Delete the local metric, if necessary.
   if (localMetric)
     delete metric;
+
+  // Delete the local dataset, if necessary.
+  if (localDataset)
+    delete dataset;
 }
 
 //! Return the number of descendant points.
@@ -373,7 +405,7 @@ double CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
     MinDistance(const CoverTree* other) const
 {
   // Every cover tree node will contain points up to base^(scale + 1) away.
-  return std::max(metric->Evaluate(dataset.col(point),
+  return std::max(metric->Evaluate(dataset->col(point),
       other->Dataset().col(other->Point())) -
       furthestDescendantDistance - other->FurthestDescendantDistance(), 0.0);
 }
@@ -401,7 +433,7 @@ template<
 double CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
     MinDistance(const arma::vec& other) const
 {
-  return std::max(metric->Evaluate(dataset.col(point), other) -
+  return std::max(metric->Evaluate(dataset->col(point), other) -
       furthestDescendantDistance, 0.0);
 }
 
@@ -426,7 +458,7 @@ template<
 double CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
     MaxDistance(const CoverTree* other) const
 {
-  return metric->Evaluate(dataset.col(point),
+  return metric->Evaluate(dataset->col(point),
       other->Dataset().col(other->Point())) +
       furthestDescendantDistance + other->FurthestDescendantDistance();
 }
@@ -454,7 +486,7 @@ template<
 double CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
     MaxDistance(const arma::vec& other) const
 {
-  return metric->Evaluate(dataset.col(point), other) +
+  return metric->Evaluate(dataset->col(point), other) +
       furthestDescendantDistance;
 }
 
@@ -480,7 +512,7 @@ template<
 math::Range CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
     RangeDistance(const CoverTree* other) const
 {
-  const double distance = metric->Evaluate(dataset.col(point),
+  const double distance = metric->Evaluate(dataset->col(point),
       other->Dataset().col(other->Point()));
 
   math::Range result;
@@ -523,7 +555,7 @@ template<
 math::Range CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
     RangeDistance(const arma::vec& other) const
 {
-  const double distance = metric->Evaluate(dataset.col(point), other);
+  const double distance = metric->Evaluate(dataset->col(point), other);
 
   return math::Range(distance - furthestDescendantDistance,
                      distance + furthestDescendantDistance);
@@ -575,7 +607,7 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CreateChildren(
     // Make the self child at the lowest possible level.
     // This should not modify farSetSize or usedSetSize.
     size_t tempSize = 0;
-    children.push_back(new CoverTree(dataset, base, point, INT_MIN, this, 0,
+    children.push_back(new CoverTree(*dataset, base, point, INT_MIN, this, 0,
         indices, distances, 0, tempSize, usedSetSize, *metric));
     distanceComps += children.back()->DistanceComps();
 
@@ -583,7 +615,7 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CreateChildren(
     for (size_t i = 0; i < nearSetSize; ++i)
     {
       // farSetSize and usedSetSize will not be modified.
-      children.push_back(new CoverTree(dataset, base, indices[i],
+      children.push_back(new CoverTree(*dataset, base, indices[i],
           INT_MIN, this, distances[i], indices, distances, 0, tempSize,
           usedSetSize, *metric));
       distanceComps += children.back()->DistanceComps();
@@ -615,7 +647,7 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CreateChildren(
   // Build the self child (recursively).
   size_t childFarSetSize = nearSetSize - childNearSetSize;
   size_t childUsedSetSize = 0;
-  children.push_back(new CoverTree(dataset, base, point, nextScale, this, 0,
+  children.push_back(new CoverTree(*dataset, base, point, nextScale, this, 0,
       indices, distances, childNearSetSize, childFarSetSize, childUsedSetSize,
       *metric));
   // Don't double-count the self-child (so, subtract one).
@@ -673,7 +705,7 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CreateChildren(
     if ((nearSetSize == 1) && (farSetSize == 0))
     {
       size_t childNearSetSize = 0;
-      children.push_back(new CoverTree(dataset, base, indices[0], nextScale,
+      children.push_back(new CoverTree(*dataset, base, indices[0], nextScale,
           this, distances[0], indices, distances, childNearSetSize, farSetSize,
           usedSetSize, *metric));
       distanceComps += children.back()->DistanceComps();
@@ -715,7 +747,7 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CreateChildren(
 
     // Build this child (recursively).
     childUsedSetSize = 1; // Mark self point as used.
-    children.push_back(new CoverTree(dataset, base, indices[0], nextScale,
+    children.push_back(new CoverTree(*dataset, base, indices[0], nextScale,
         this, distances[0], childIndices, childDistances, childNearSetSize,
         childFarSetSize, childUsedSetSize, *metric));
     numDescendants += children.back()->NumDescendants();
@@ -816,8 +848,8 @@ void CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
   distanceComps += pointSetSize;
   for (size_t i = 0; i < pointSetSize; ++i)
   {
-    distances[i] = metric->Evaluate(dataset.col(pointIndex),
-        dataset.col(indices[i]));
+    distances[i] = metric->Evaluate(dataset->col(pointIndex),
+        dataset->col(indices[i]));
   }
 }
 
@@ -1111,6 +1143,95 @@ inline void CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
   }
 }
 
+/**
+ * Serialize the tree.
+ */
+template<
+    typename MetricType,
+    typename StatisticType,
+    typename MatType,
+    typename RootPointPolicy
+>
+template<typename Archive>
+void CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::Serialize(
+    Archive& ar,
+    const unsigned int /* version */)
+{
+  using data::CreateNVP;
+
+  // If we're loading, and we have children, they need to be deleted.  We may
+  // also need to delete the local metric and dataset.
+  if (Archive::is_loading::value)
+  {
+    for (size_t i = 0; i < children.size(); ++i)
+      delete children[i];
+    children.clear();
+
+    if (localMetric && metric)
+      delete metric;
+    if (localDataset && dataset)
+      delete dataset;
+  }
+
+  ar & CreateNVP(dataset, "dataset");
+  ar & CreateNVP(point, "point");
+  ar & CreateNVP(scale, "scale");
+  ar & CreateNVP(base, "base");
+  ar & CreateNVP(stat, "stat");
+  ar & CreateNVP(numDescendants, "numDescendants");
+
+  // Due to quirks of boost::serialization, if a tree is saved as an object and
+  // not a pointer, the root will be duplicated on load if its children point to
+  // it.  So the children of the root do not save their parent link; the root
+  // fixes the link below.
+  if (Archive::is_saving::value && parent != NULL && parent->Parent() == NULL)
+  {
+    CoverTree* fakeParent = NULL;
+    ar & CreateNVP(fakeParent, "parent");
+  }
+  else
+  {
+    ar & CreateNVP(parent, "parent");
+  }
+
+  ar & CreateNVP(parentDistance, "parentDistance");
+  ar & CreateNVP(furthestDescendantDistance, "furthestDescendantDistance");
+  ar & CreateNVP(metric, "metric");
+
+  // The root owns the dataset and the metric once it is loaded.
+  if (Archive::is_loading::value && parent == NULL)
+  {
+    localMetric = true;
+    localDataset = true;
+  }
+
+  // Lastly, serialize the children.
+  size_t numChildren = children.size();
+  ar & CreateNVP(numChildren, "numChildren");
+  if (Archive::is_loading::value)
+    children.resize(numChildren, NULL);
+  for (size_t i = 0; i < numChildren; ++i)
+  {
+    std::ostringstream oss;
+    oss << "child" << i;
+    ar & CreateNVP(children[i], oss.str());
+  }
+
+  // Fix the parent links and ownership of the children of the root.
+  if (Archive::is_loading::value && parent == NULL)
+  {
+    for (size_t i = 0; i < children.size(); ++i)
+    {
+      children[i]->localMetric = false;
+      children[i]->localDataset = false;
+      children[i]->Parent() = this;
+    }
+  }
+
+  if (Archive::is_loading::value)
+    distanceComps = 0;
+}
+
 /**
  * Returns a string representation of this object.
  */
@@ -1125,7 +1246,7 @@ std::string CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
 {
   std::ostringstream convert;
   convert << "CoverTree [" << this << "]" << std::endl;
-  convert << "  dataset: " << &dataset << std::endl;
+  convert << "  dataset: " << dataset << std::endl;
   convert << "  point: " << point << std::endl;
   convert << "  scale: " << scale << std::endl;
   convert << "  base: " << base << std::endl;
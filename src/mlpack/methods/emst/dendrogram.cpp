@@ -0,0 +1,75 @@
+/**
+ * @file dendrogram.cpp
+ *
+ * Implementation of the single-linkage dendrogram and core distances.
+ */
+#include "dendrogram.hpp"
+#include "union_find.hpp"
+
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+
+using namespace mlpack;
+using namespace mlpack::emst;
+
+void mlpack::emst::ComputeDendrogram(const arma::mat& mst,
+                                     const size_t numPoints,
+                                     arma::mat& dendrogram)
+{
+  if (mst.n_rows != 3 || mst.n_cols + 1 != numPoints)
+    throw std::invalid_argument("ComputeDendrogram(): the MST must have 3 rows "
+        "and one column fewer than the number of points");
+
+  // The edges are usually sorted already, but we can't rely on that.
+  const arma::uvec order = arma::stable_sort_index(mst.row(2));
+
+  // The dendrogram cluster that each UnionFind component corresponds to.
+  arma::Col<size_t> clusterOf(numPoints);
+  for (size_t i = 0; i < numPoints; ++i)
+    clusterOf[i] = i;
+
+  // The number of points in each cluster.
+  arma::Col<size_t> sizes(2 * numPoints - 1);
+  sizes.subvec(0, numPoints - 1).ones();
+
+  UnionFind connections(numPoints);
+  dendrogram.set_size(4, mst.n_cols);
+  for (size_t i = 0; i < mst.n_cols; ++i)
+  {
+    const size_t edge = order[i];
+    const size_t rootA = connections.Find((size_t) mst(0, edge));
+    const size_t rootB = connections.Find((size_t) mst(1, edge));
+    if (rootA == rootB)
+      throw std::invalid_argument("ComputeDendrogram(): the given edges do not "
+          "form a spanning tree");
+
+    const size_t clusterA = clusterOf[rootA];
+    const size_t clusterB = clusterOf[rootB];
+    const size_t newCluster = numPoints + i;
+    sizes[newCluster] = sizes[clusterA] + sizes[clusterB];
+
+    dendrogram(0, i) = std::min(clusterA, clusterB);
+    dendrogram(1, i) = std::max(clusterA, clusterB);
+    dendrogram(2, i) = mst(2, edge);
+    dendrogram(3, i) = sizes[newCluster];
+
+    connections.Union(rootA, rootB);
+    clusterOf[connections.Find(rootA)] = newCluster;
+  }
+}
+
+void mlpack::emst::ComputeCoreDistances(const arma::mat& data,
+                                        const size_t minPoints,
+                                        arma::vec& coreDistances)
+{
+  if (minPoints == 0 || minPoints >= data.n_cols)
+    throw std::invalid_argument("ComputeCoreDistances(): minPoints must be "
+        "greater than 0 and less than the number of points");
+
+  neighbor::AllkNN allknn(data);
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  allknn.Search(minPoints, neighbors, distances);
+
+  coreDistances = distances.row(minPoints - 1).t();
+}
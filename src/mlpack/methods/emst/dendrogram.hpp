@@ -0,0 +1,62 @@
+/**
+ * @file dendrogram.hpp
+ *
+ * Build a single-linkage dendrogram from a minimum spanning tree, and compute
+ * the core distances used for the mutual reachability distance of
+ * density-based (HDBSCAN-style) clustering.
+ */
+#ifndef __MLPACK_METHODS_EMST_DENDROGRAM_HPP
+#define __MLPACK_METHODS_EMST_DENDROGRAM_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace emst {
+
+/**
+ * Build the single-linkage dendrogram from the minimum spanning tree of a
+ * dataset, as returned by DualTreeBoruvka::ComputeMST().  The edges are merged
+ * in order of increasing length with a UnionFind structure, so this takes
+ * O(n log n) time.
+ *
+ * The dendrogram has one column for each merge, in the order of the merges.
+ * The original points are clusters 0 to (numPoints - 1), and the cluster
+ * created by the merge in column i is cluster numPoints + i.  The rows are:
+ *
+ *  - row 0: the lesser index of the two merged clusters;
+ *  - row 1: the greater index of the two merged clusters;
+ *  - row 2: the distance at which the clusters are merged;
+ *  - row 3: the number of points in the new cluster.
+ *
+ * This is the same layout as a SciPy linkage matrix (transposed).
+ *
+ * @param mst Minimum spanning tree (3 x (numPoints - 1)).
+ * @param numPoints Number of points in the dataset.
+ * @param dendrogram Matrix to store the dendrogram in.
+ */
+void ComputeDendrogram(const arma::mat& mst,
+                       const size_t numPoints,
+                       arma::mat& dendrogram);
+
+/**
+ * Compute the core distance of every point in the dataset: the Euclidean
+ * distance to its minPoints'th nearest neighbor (not counting the point
+ * itself).  Passing these to DualTreeBoruvka::ComputeMST() gives the MST under
+ * the mutual reachability distance
+ *
+ *   d_mreach(a, b) = max(core(a), core(b), d(a, b)),
+ *
+ * whose single-linkage dendrogram is the HDBSCAN cluster hierarchy.
+ *
+ * @param data Dataset.
+ * @param minPoints Number of neighbors to use for the core distance.
+ * @param coreDistances Vector to store the core distances in.
+ */
+void ComputeCoreDistances(const arma::mat& data,
+                          const size_t minPoints,
+                          arma::vec& coreDistances);
+
+} // namespace emst
+} // namespace mlpack
+
+#endif
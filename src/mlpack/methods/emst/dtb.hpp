@@ -27,6 +27,7 @@
 #include <mlpack/core/metrics/lmetric.hpp>
 
 #include <mlpack/core/tree/binary_space_tree.hpp>
+#include <atomic>
 
 namespace mlpack {
 namespace emst /** Euclidean Minimum Spanning Trees. */ {
@@ -113,6 +114,13 @@ class DualTreeBoruvka
   //! The instantiated metric.
   MetricType metric;
 
+  //! The number of threads to use for the MST computation.
+  size_t numThreads;
+
+  //! Core distances of the points, in the order of data (empty unless the
+  //! mutual reachability distance is used).
+  arma::vec coreDistances;
+
   //! For sorting the edge list after the computation.
   struct SortEdgesHelper
   {
@@ -171,6 +179,26 @@ class DualTreeBoruvka
    */
   void ComputeMST(arma::mat& results);
 
+  /**
+   * Compute the minimum spanning tree under the mutual reachability distance
+   * max(core(a), core(b), d(a, b)), given the core distance of each point (see
+   * ComputeCoreDistances()).  The core distances are given in the order of the
+   * original dataset, unless the object was constructed with a pre-built tree,
+   * in which case they must be in the order of the tree's dataset.  The results
+   * have the same form as with ComputeMST(results).
+   *
+   * @param results Matrix which results will be stored in.
+   * @param coreDistances Core distance of each point.
+   */
+  void ComputeMST(arma::mat& results, const arma::vec& coreDistances);
+
+  //! Get the number of threads used to compute the MST (0 means as many as
+  //! OpenMP allows).
+  size_t NumThreads() const { return numThreads; }
+  //! Modify the number of threads used to compute the MST (0 means as many as
+  //! OpenMP allows).
+  size_t& NumThreads() { return numThreads; }
+
   /**
    * Returns a string representation of this object.
    */
@@ -203,6 +231,21 @@ class DualTreeBoruvka
    */
   void Cleanup();
 
+  /**
+   * Find the candidate edge of every component with the given number of
+   * threads.  The query tree is split into subtrees which are traversed
+   * against the whole tree in parallel; candidates are collected in
+   * sharedDistances and then copied to neighborsDistances.
+   */
+  void ParallelFindNeighbors(const size_t threads,
+                             std::atomic<double>* sharedDistances,
+                             std::atomic<bool>* componentLocks,
+                             size_t& baseCases,
+                             size_t& scores);
+
+  //! Get the number of threads that will actually be used.
+  size_t ThreadsToUse() const;
+
 }; // class DualTreeBoruvka
 
 } // namespace emst
@@ -9,6 +9,12 @@
 
 #include "dtb_rules.hpp"
 
+#include <algorithm>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace emst {
 
@@ -24,6 +30,19 @@ TreeType* BuildTree(
   return new TreeType(dataset, oldFromNew);
 }
 
+//! Call the tree constructor that does mapping, moving the dataset into the
+//! tree instead of copying it.
+template<typename MatType, typename TreeType>
+TreeType* BuildTree(
+    MatType&& dataset,
+    std::vector<size_t>& oldFromNew,
+    typename boost::enable_if_c<
+        tree::TreeTraits<TreeType>::RearrangesDataset == true, TreeType*
+    >::type = 0)
+{
+  return new TreeType(std::move(dataset), oldFromNew);
+}
+
 //! Call the tree constructor that does not do mapping.
 template<typename MatType, typename TreeType>
 TreeType* BuildTree(
@@ -57,7 +76,8 @@ DualTreeBoruvka<MetricType, MatType, TreeType>::DualTreeBoruvka(
     naive(naive),
     connections(dataset.n_cols),
     totalDist(0.0),
-    metric(metric)
+    metric(metric),
+    numThreads(1)
 {
   edges.reserve(data.n_cols - 1); // Set size.
 
@@ -82,7 +102,8 @@ DualTreeBoruvka<MetricType, MatType, TreeType>::DualTreeBoruvka(
     naive(false),
     connections(data.n_cols),
     totalDist(0.0),
-    metric(metric)
+    metric(metric),
+    numThreads(1)
 {
   edges.reserve(data.n_cols - 1); // Fill with EdgePairs.
 
@@ -104,6 +125,40 @@ DualTreeBoruvka<MetricType, MatType, TreeType>::~DualTreeBoruvka()
     delete tree;
 }
 
+/**
+ * Compute the MST under the mutual reachability distance.
+ */
+template<
+    typename MetricType,
+    typename MatType,
+    template<typename TreeMetricType,
+             typename TreeStatType,
+             typename TreeMatType> class TreeType>
+void DualTreeBoruvka<MetricType, MatType, TreeType>::ComputeMST(
+    arma::mat& results,
+    const arma::vec& coreDistances)
+{
+  if (coreDistances.n_elem != data.n_cols)
+    throw std::invalid_argument("DualTreeBoruvka::ComputeMST(): the number of "
+        "core distances must be equal to the number of points");
+
+  // Put the core distances in the same order as the points in the tree.
+  if (!naive && ownTree && tree::TreeTraits<Tree>::RearrangesDataset)
+  {
+    this->coreDistances.set_size(data.n_cols);
+    for (size_t i = 0; i < data.n_cols; ++i)
+      this->coreDistances[i] = coreDistances[oldFromNew[i]];
+  }
+  else
+  {
+    this->coreDistances = coreDistances;
+  }
+
+  ComputeMST(results);
+
+  this->coreDistances.reset();
+}
+
 /**
  * Iteratively find the nearest neighbor of each component until the MST is
  * complete.
@@ -122,11 +177,34 @@ void DualTreeBoruvka<MetricType, MatType, TreeType>::ComputeMST(
   totalDist = 0; // Reset distance.
 
   typedef DTBRules<MetricType, Tree> RuleType;
+  const arma::vec* cores = (coreDistances.n_elem == 0) ? NULL :
+      &coreDistances;
   RuleType rules(data, connections, neighborsDistances, neighborsInComponent,
-                 neighborsOutComponent, metric);
+                 neighborsOutComponent, metric, NULL, NULL, cores);
+
+  // With more than one thread, the candidate distances are shared between the
+  // threads, and each component has a lock for its candidate edge.
+  const size_t threads = ThreadsToUse();
+  const size_t sharedSize = (threads > 1) ? data.n_cols : 0;
+  std::vector<std::atomic<double> > sharedDistances(sharedSize);
+  std::vector<std::atomic<bool> > componentLocks(sharedSize);
+  for (size_t i = 0; i < sharedSize; ++i)
+  {
+    sharedDistances[i].store(DBL_MAX);
+    componentLocks[i].store(false);
+  }
+
+  size_t parallelBaseCases = 0;
+  size_t parallelScores = 0;
+
   while (edges.size() < (data.n_cols - 1))
   {
-    if (naive)
+    if (threads > 1)
+    {
+      ParallelFindNeighbors(threads, sharedDistances.data(),
+          componentLocks.data(), parallelBaseCases, parallelScores);
+    }
+    else if (naive)
     {
       // Full O(N^2) traversal.
       for (size_t i = 0; i < data.n_cols; ++i)
@@ -146,8 +224,11 @@ void DualTreeBoruvka<MetricType, MatType, TreeType>::ComputeMST(
     Log::Info << edges.size() << " edges found so far." << std::endl;
     if (!naive)
     {
-      Log::Info << rules.BaseCases() << " cumulative base cases." << std::endl;
-      Log::Info << rules.Scores() << " cumulative node combinations scored."
+      const size_t baseCases = (threads > 1) ? parallelBaseCases :
+          rules.BaseCases();
+      const size_t scores = (threads > 1) ? parallelScores : rules.Scores();
+      Log::Info << baseCases << " cumulative base cases." << std::endl;
+      Log::Info << scores << " cumulative node combinations scored."
           << std::endl;
     }
   }
@@ -323,6 +404,127 @@ void DualTreeBoruvka<MetricType, MatType, TreeType>::Cleanup()
     CleanupHelper(tree);
 }
 
+/**
+ * Find the candidate edge of every component with several threads.
+ */
+template<
+    typename MetricType,
+    typename MatType,
+    template<typename TreeMetricType,
+             typename TreeStatType,
+             typename TreeMatType> class TreeType>
+void DualTreeBoruvka<MetricType, MatType, TreeType>::ParallelFindNeighbors(
+    const size_t threads,
+    std::atomic<double>* sharedDistances,
+    std::atomic<bool>* componentLocks,
+    size_t& baseCases,
+    size_t& scores)
+{
+  typedef DTBRules<MetricType, Tree> RuleType;
+  const arma::vec* cores = (coreDistances.n_elem == 0) ? NULL :
+      &coreDistances;
+
+  size_t roundBaseCases = 0;
+  size_t roundScores = 0;
+
+  if (naive)
+  {
+    #pragma omp parallel num_threads(threads) reduction(+:roundBaseCases)
+    {
+      RuleType rules(data, connections, neighborsDistances,
+          neighborsInComponent, neighborsOutComponent, metric, sharedDistances,
+          componentLocks, cores);
+
+      #pragma omp for schedule(dynamic, 16)
+      for (size_t i = 0; i < data.n_cols; ++i)
+        for (size_t j = 0; j < data.n_cols; ++j)
+          rules.BaseCase(i, j);
+
+      roundBaseCases += rules.BaseCases();
+    }
+  }
+  else
+  {
+    // Split the query tree into disjoint subtrees by repeatedly replacing the
+    // largest non-leaf subtree with its children, until there are enough
+    // subtrees to balance the work or only leaves are left.  The rules only
+    // modify the statistics of the query nodes they are given (and their
+    // descendants), so each subtree can be traversed independently.
+    std::vector<Tree*> subtrees(1, tree);
+    while (subtrees.size() < 4 * threads)
+    {
+      size_t largest = subtrees.size();
+      for (size_t i = 0; i < subtrees.size(); ++i)
+      {
+        if (!subtrees[i]->IsLeaf() && (largest == subtrees.size() ||
+            subtrees[i]->NumDescendants() >
+            subtrees[largest]->NumDescendants()))
+          largest = i;
+      }
+
+      if (largest == subtrees.size())
+        break; // Everything is a leaf.
+
+      Tree* node = subtrees[largest];
+      subtrees.erase(subtrees.begin() + largest);
+      for (size_t i = 0; i < node->NumChildren(); ++i)
+        subtrees.push_back(&node->Child(i));
+    }
+
+    // Traverse the largest subtrees first, so that the small ones fill in at
+    // the end.
+    std::stable_sort(subtrees.begin(), subtrees.end(), [](const Tree* a,
+        const Tree* b)
+    {
+      return a->NumDescendants() > b->NumDescendants();
+    });
+
+    #pragma omp parallel num_threads(threads) \
+        reduction(+:roundBaseCases, roundScores)
+    {
+      RuleType rules(data, connections, neighborsDistances,
+          neighborsInComponent, neighborsOutComponent, metric, sharedDistances,
+          componentLocks, cores);
+
+      #pragma omp for schedule(dynamic, 1)
+      for (size_t i = 0; i < subtrees.size(); ++i)
+      {
+        typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
+        traverser.Traverse(*subtrees[i], *tree);
+      }
+
+      roundBaseCases += rules.BaseCases();
+      roundScores += rules.Scores();
+    }
+  }
+
+  baseCases += roundBaseCases;
+  scores += roundScores;
+
+  // Collect the candidates for AddAllEdges(), and reset the shared distances
+  // for the next iteration.
+  for (size_t i = 0; i < data.n_cols; ++i)
+    neighborsDistances[i] = sharedDistances[i].exchange(DBL_MAX);
+}
+
+template<
+    typename MetricType,
+    typename MatType,
+    template<typename TreeMetricType,
+             typename TreeStatType,
+             typename TreeMatType> class TreeType>
+size_t DualTreeBoruvka<MetricType, MatType, TreeType>::ThreadsToUse() const
+{
+  if (numThreads != 0)
+    return numThreads;
+
+#ifdef _OPENMP
+  return (size_t) omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
 // convert the object to a string
 template<
     typename MetricType,
@@ -8,6 +8,7 @@
 #define __MLPACK_METHODS_EMST_DTB_RULES_HPP
 
 #include <mlpack/core.hpp>
+#include <atomic>
 
 #include "../neighbor_search/ns_traversal_info.hpp"
 
@@ -18,7 +19,62 @@ template<typename MetricType, typename TreeType>
 class DTBRules
 {
  public:
+  /**
+   * Construct the rules.  If sharedDistances and componentLocks are given, the
+   * rules may be used by several threads at once: candidate distances are then
+   * read from and published to sharedDistances (instead of
+   * neighborsDistances), and the candidate edge of a component is only changed
+   * while holding that component's lock.  Ties between candidate edges are
+   * then broken by point indices, so the result does not depend on the order
+   * in which threads find the edges.
+   *
+   * @param dataSet The data points.
+   * @param connections Components found so far.
+   * @param neighborsDistances Candidate distance for each component.
+   * @param neighborsInComponent Candidate edge endpoint in each component.
+   * @param neighborsOutComponent Candidate edge endpoint out of each component.
+   * @param metric Instantiated metric.
+   * @param sharedDistances Candidate distances shared between threads.
+   * @param componentLocks One lock for each component.
+   * @param coreDistances If given, the core distance of each point; the
+   *     mutual reachability distance max(core(a), core(b), d(a, b)) is then
+   *     used instead of the metric.
+   */
   DTBRules(const arma::mat& dataSet,
+           UnionFind& connections,
+           arma::vec& neighborsDistances,
+           arma::Col<size_t>& neighborsInComponent,
+           arma::Col<size_t>& neighborsOutComponent,
+           MetricType& metric,
+           std::atomic<double>* sharedDistances = NULL,
+           std::atomic<bool>* componentLocks = NULL,
+           const arma::vec* coreDistances = NULL);
+
+  /**
+   * Construct the rules for one Boruvka step between two different chunks of a
+   * dataset, as done by OutOfCoreBoruvka: for every component, the shortest
+   * edge from a point of the query chunk in that component to a point of the
+   * reference chunk in a different component is found.  Points are identified
+   * in the UnionFind structure and in the candidate arrays by their global
+   * index (the index in the whole dataset); queryIndices and referenceIndices
+   * map the columns of each chunk to global indices.  The component membership
+   * of the nodes of both trees must be set with global component indices
+   * before the traversal.
+   *
+   * @param querySet Points of the query chunk.
+   * @param queryIndices Global index of each point of the query chunk.
+   * @param referenceSet Points of the reference chunk.
+   * @param referenceIndices Global index of each point of the reference chunk.
+   * @param connections Components found so far, for the whole dataset.
+   * @param neighborsDistances Candidate distance for each component.
+   * @param neighborsInComponent Candidate edge endpoint in each component.
+   * @param neighborsOutComponent Candidate edge endpoint out of each component.
+   * @param metric Instantiated metric.
+   */
+  DTBRules(const arma::mat& querySet,
+           const std::vector<size_t>& queryIndices,
+           const arma::mat& referenceSet,
+           const std::vector<size_t>& referenceIndices,
            UnionFind& connections,
            arma::vec& neighborsDistances,
            arma::Col<size_t>& neighborsInComponent,
@@ -121,8 +177,14 @@ class DTBRules
   size_t& Scores() { return scores; }
 
  private:
-  //! The data points.
-  const arma::mat& dataSet;
+  //! The query points (the whole dataset, unless two chunks are used).
+  const arma::mat& querySet;
+  //! The reference points (the whole dataset, unless two chunks are used).
+  const arma::mat& referenceSet;
+  //! Global index of each query point (NULL unless two chunks are used).
+  const std::vector<size_t>* queryIndices;
+  //! Global index of each reference point (NULL unless two chunks are used).
+  const std::vector<size_t>* referenceIndices;
 
   //! Stores the tree structure so far
   UnionFind& connections;
@@ -141,11 +203,38 @@ class DTBRules
   //! The instantiated metric.
   MetricType& metric;
 
+  //! Candidate distances shared between threads (NULL if single-threaded).
+  std::atomic<double>* sharedDistances;
+  //! Per-component locks for the candidate edges (NULL if single-threaded).
+  std::atomic<bool>* componentLocks;
+  //! Core distances of the points (NULL unless mutual reachability is used).
+  const arma::vec* coreDistances;
+
   /**
    * Update the bound for the given query node.
    */
   inline double CalculateBound(TreeType& queryNode) const;
 
+  //! Get the global index of the given query point.
+  size_t QueryPoint(const size_t index) const
+  { return (queryIndices == NULL) ? index : (*queryIndices)[index]; }
+
+  //! Get the global index of the given reference point.
+  size_t ReferencePoint(const size_t index) const
+  { return (referenceIndices == NULL) ? index : (*referenceIndices)[index]; }
+
+  //! Get the distance of the candidate edge of the given component.
+  inline double NeighborDistance(const size_t component) const;
+
+  /**
+   * Replace the candidate edge of the given component if the given edge is
+   * shorter.
+   */
+  inline void UpdateNeighbor(const size_t component,
+                             const size_t queryIndex,
+                             const size_t referenceIndex,
+                             const double distance);
+
   TraversalInfoType traversalInfo;
 
   //! The number of base cases calculated.
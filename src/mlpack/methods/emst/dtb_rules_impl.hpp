@@ -13,18 +13,57 @@ namespace emst {
 template<typename MetricType, typename TreeType>
 DTBRules<MetricType, TreeType>::
 DTBRules(const arma::mat& dataSet,
+         UnionFind& connections,
+         arma::vec& neighborsDistances,
+         arma::Col<size_t>& neighborsInComponent,
+         arma::Col<size_t>& neighborsOutComponent,
+         MetricType& metric,
+         std::atomic<double>* sharedDistances,
+         std::atomic<bool>* componentLocks,
+         const arma::vec* coreDistances)
+:
+  querySet(dataSet),
+  referenceSet(dataSet),
+  queryIndices(NULL),
+  referenceIndices(NULL),
+  connections(connections),
+  neighborsDistances(neighborsDistances),
+  neighborsInComponent(neighborsInComponent),
+  neighborsOutComponent(neighborsOutComponent),
+  metric(metric),
+  sharedDistances(sharedDistances),
+  componentLocks(componentLocks),
+  coreDistances(coreDistances),
+  baseCases(0),
+  scores(0)
+{
+  // Nothing else to do.
+}
+
+template<typename MetricType, typename TreeType>
+DTBRules<MetricType, TreeType>::
+DTBRules(const arma::mat& querySet,
+         const std::vector<size_t>& queryIndices,
+         const arma::mat& referenceSet,
+         const std::vector<size_t>& referenceIndices,
          UnionFind& connections,
          arma::vec& neighborsDistances,
          arma::Col<size_t>& neighborsInComponent,
          arma::Col<size_t>& neighborsOutComponent,
          MetricType& metric)
 :
-  dataSet(dataSet),
+  querySet(querySet),
+  referenceSet(referenceSet),
+  queryIndices(&queryIndices),
+  referenceIndices(&referenceIndices),
   connections(connections),
   neighborsDistances(neighborsDistances),
   neighborsInComponent(neighborsInComponent),
   neighborsOutComponent(neighborsOutComponent),
   metric(metric),
+  sharedDistances(NULL),
+  componentLocks(NULL),
+  coreDistances(NULL),
   baseCases(0),
   scores(0)
 {
@@ -41,29 +80,32 @@ double DTBRules<MetricType, TreeType>::BaseCase(const size_t queryIndex,
   // the current neighbor, if necessary.
   double newUpperBound = -1.0;
 
-  // Find the index of the component the query is in.
-  size_t queryComponentIndex = connections.Find(queryIndex);
+  // Find the index of the component the query is in.  The components are
+  // indexed by the global indices of the points.
+  const size_t queryPoint = QueryPoint(queryIndex);
+  const size_t referencePoint = ReferencePoint(referenceIndex);
+  size_t queryComponentIndex = connections.Find(queryPoint);
 
-  size_t referenceComponentIndex = connections.Find(referenceIndex);
+  size_t referenceComponentIndex = connections.Find(referencePoint);
 
   if (queryComponentIndex != referenceComponentIndex)
   {
     ++baseCases;
-    double distance = metric.Evaluate(dataSet.col(queryIndex),
-                                      dataSet.col(referenceIndex));
+    double distance = metric.Evaluate(querySet.col(queryIndex),
+                                      referenceSet.col(referenceIndex));
 
-    if (distance < neighborsDistances[queryComponentIndex])
-    {
-      Log::Assert(queryIndex != referenceIndex);
+    // The mutual reachability distance is never less than the metric, so all
+    // the pruning rules below stay valid.
+    if (coreDistances != NULL)
+      distance = std::max(distance, std::max((*coreDistances)[queryPoint],
+          (*coreDistances)[referencePoint]));
 
-      neighborsDistances[queryComponentIndex] = distance;
-      neighborsInComponent[queryComponentIndex] = queryIndex;
-      neighborsOutComponent[queryComponentIndex] = referenceIndex;
-    }
+    UpdateNeighbor(queryComponentIndex, queryPoint, referencePoint, distance);
   }
 
-  if (newUpperBound < neighborsDistances[queryComponentIndex])
-    newUpperBound = neighborsDistances[queryComponentIndex];
+  const double neighborDistance = NeighborDistance(queryComponentIndex);
+  if (newUpperBound < neighborDistance)
+    newUpperBound = neighborDistance;
 
   Log::Assert(newUpperBound >= 0.0);
 
@@ -74,7 +116,7 @@ template<typename MetricType, typename TreeType>
 double DTBRules<MetricType, TreeType>::Score(const size_t queryIndex,
                                              TreeType& referenceNode)
 {
-  size_t queryComponentIndex = connections.Find(queryIndex);
+  size_t queryComponentIndex = connections.Find(QueryPoint(queryIndex));
 
   // If the query belongs to the same component as all of the references,
   // then prune.  The cast is to stop a warning about comparing unsigned to
@@ -83,12 +125,12 @@ double DTBRules<MetricType, TreeType>::Score(const size_t queryIndex,
       (size_t) referenceNode.Stat().ComponentMembership())
     return DBL_MAX;
 
-  const arma::vec queryPoint = dataSet.unsafe_col(queryIndex);
+  const arma::vec queryPoint = querySet.unsafe_col(queryIndex);
   const double distance = referenceNode.MinDistance(queryPoint);
 
   // If all the points in the reference node are farther than the candidate
   // nearest neighbor for the query's component, we prune.
-  return neighborsDistances[queryComponentIndex] < distance
+  return NeighborDistance(queryComponentIndex) < distance
       ? DBL_MAX : distance;
 }
 
@@ -100,20 +142,20 @@ double DTBRules<MetricType, TreeType>::Score(const size_t queryIndex,
   // I don't really understand the last argument here
   // It just gets passed in the distance call, otherwise this function
   // is the same as the one above.
-  size_t queryComponentIndex = connections.Find(queryIndex);
+  size_t queryComponentIndex = connections.Find(QueryPoint(queryIndex));
 
   // If the query belongs to the same component as all of the references,
   // then prune.
   if (queryComponentIndex == referenceNode.Stat().ComponentMembership())
     return DBL_MAX;
 
-  const arma::vec queryPoint = dataSet.unsafe_col(queryIndex);
+  const arma::vec queryPoint = querySet.unsafe_col(queryIndex);
   const double distance = referenceNode.MinDistance(queryPoint,
                                                     baseCaseResult);
 
   // If all the points in the reference node are farther than the candidate
   // nearest neighbor for the query's component, we prune.
-  return (neighborsDistances[queryComponentIndex] < distance) ? DBL_MAX :
+  return (NeighborDistance(queryComponentIndex) < distance) ? DBL_MAX :
       distance;
 }
 
@@ -124,7 +166,7 @@ double DTBRules<MetricType, TreeType>::Rescore(const size_t queryIndex,
 {
   // We don't need to check component membership again, because it can't
   // change inside a single iteration.
-  return (oldScore > neighborsDistances[connections.Find(queryIndex)])
+  return (oldScore > NeighborDistance(connections.Find(QueryPoint(queryIndex))))
       ? DBL_MAX : oldScore;
 }
 
@@ -193,8 +235,9 @@ inline double DTBRules<MetricType, TreeType>::CalculateBound(
   // Now, find the best and worst point bounds.
   for (size_t i = 0; i < queryNode.NumPoints(); ++i)
   {
-    const size_t pointComponent = connections.Find(queryNode.Point(i));
-    const double bound = neighborsDistances[pointComponent];
+    const size_t pointComponent = connections.Find(
+        QueryPoint(queryNode.Point(i)));
+    const double bound = NeighborDistance(pointComponent);
 
     if (bound > worstPointBound)
       worstPointBound = bound;
@@ -218,7 +261,12 @@ inline double DTBRules<MetricType, TreeType>::CalculateBound(
   const double worstBound = std::max(worstPointBound, worstChildBound);
   const double bestBound = std::min(bestPointBound, bestChildBound);
   // We must check that bestBound != DBL_MAX; otherwise, we risk overflow.
-  const double bestAdjustedBound = (bestBound == DBL_MAX) ? DBL_MAX :
+  // The adjusted bound relies on the triangle inequality, which the mutual
+  // reachability distance does not satisfy with respect to the node's radius
+  // (a nearby point may have a much larger core distance), so it is not used
+  // then.
+  const double bestAdjustedBound = (bestBound == DBL_MAX ||
+      coreDistances != NULL) ? DBL_MAX :
       bestBound + 2 * queryNode.FurthestDescendantDistance();
 
   // Update the relevant quantities in the node.
@@ -229,6 +277,61 @@ inline double DTBRules<MetricType, TreeType>::CalculateBound(
   return queryNode.Stat().Bound();
 }
 
+template<typename MetricType, typename TreeType>
+inline double DTBRules<MetricType, TreeType>::NeighborDistance(
+    const size_t component) const
+{
+  if (sharedDistances == NULL)
+    return neighborsDistances[component];
+  else
+    return sharedDistances[component].load(std::memory_order_relaxed);
+}
+
+template<typename MetricType, typename TreeType>
+inline void DTBRules<MetricType, TreeType>::UpdateNeighbor(
+    const size_t component,
+    const size_t queryIndex,
+    const size_t referenceIndex,
+    const double distance)
+{
+  Log::Assert(queryIndex != referenceIndex);
+
+  if (sharedDistances == NULL)
+  {
+    if (distance < neighborsDistances[component])
+    {
+      neighborsDistances[component] = distance;
+      neighborsInComponent[component] = queryIndex;
+      neighborsOutComponent[component] = referenceIndex;
+    }
+
+    return;
+  }
+
+  // Almost all candidates are rejected here, without taking the lock.
+  if (distance > sharedDistances[component].load(std::memory_order_relaxed))
+    return;
+
+  while (componentLocks[component].exchange(true, std::memory_order_acquire))
+    ; // Spin until the lock is released.
+
+  // Only a thread holding the lock can change the candidate, so it can be
+  // compared safely now.  Ties go to the edge with the smallest indices.
+  const double current = sharedDistances[component].load(
+      std::memory_order_relaxed);
+  if (distance < current || (distance == current &&
+      (queryIndex < neighborsInComponent[component] ||
+      (queryIndex == neighborsInComponent[component] &&
+       referenceIndex < neighborsOutComponent[component]))))
+  {
+    neighborsInComponent[component] = queryIndex;
+    neighborsOutComponent[component] = referenceIndex;
+    sharedDistances[component].store(distance, std::memory_order_relaxed);
+  }
+
+  componentLocks[component].store(false, std::memory_order_release);
+}
+
 }; // namespace emst
 }; // namespace mlpack
 
@@ -21,6 +21,8 @@
  */
 
 #include "dtb.hpp"
+#include "dendrogram.hpp"
+#include "out_of_core_dtb.hpp"
 
 #include <mlpack/core.hpp>
 
@@ -31,15 +33,42 @@ PROGRAM_INFO("Fast Euclidean Minimum Spanning Tree", "This program can compute "
     "The output is saved in a three-column matrix, where each row indicates an "
     "edge.  The first column corresponds to the lesser index of the edge; the "
     "second column corresponds to the greater index of the edge; and the third "
-    "column corresponds to the distance between the two points.");
-
-PARAM_STRING_REQ("input_file", "Data input file.", "i");
+    "column corresponds to the distance between the two points."
+    "\n\n"
+    "The single-linkage dendrogram of the points can be saved with "
+    "--dendrogram_file (-d).  Each row of the dendrogram is one merge, in the "
+    "same format as a SciPy linkage matrix: the two merged clusters (the points"
+    " are clusters 0 to n - 1, and the cluster created in row i is cluster "
+    "n + i), the distance at which they are merged, and the size of the new "
+    "cluster."
+    "\n\n"
+    "If --min_points (-m) is given, the MST and the dendrogram are computed "
+    "with the mutual reachability distance max(core(a), core(b), d(a, b)) used "
+    "by HDBSCAN, where the core distance of a point is the distance to its "
+    "min_points'th nearest neighbor."
+    "\n\n"
+    "A dataset that does not fit in memory can be split into several files, "
+    "which are given in order with --chunk_files (-c) instead of --input_file "
+    "(repeat the option once for each file).  The MST of each chunk is computed"
+    " first, and the chunks are then merged with dual-tree searches between "
+    "each pair of chunks; only two chunks are held in memory at a time.  The "
+    "points are numbered in chunk order in the output.");
+
+PARAM_STRING("input_file", "Data input file.", "i", "");
+PARAM_VECTOR(std::string, "chunk_files", "Files holding consecutive chunks of "
+    "the dataset, for datasets that do not fit in memory.", "c");
 PARAM_STRING("output_file", "Data output file.  Stored as an edge list.", "o",
     "emst_output.csv");
 PARAM_FLAG("naive", "Compute the MST using O(n^2) naive algorithm.", "n");
 PARAM_INT("leaf_size", "Leaf size in the kd-tree.  One-element leaves give the "
     "empirically best performance, but at the cost of greater memory "
     "requirements.", "l", 1);
+PARAM_STRING("dendrogram_file", "File to save the single-linkage dendrogram "
+    "to.", "d", "");
+PARAM_INT("min_points", "If greater than 0, use the mutual reachability "
+    "distance with core distances to this many nearest neighbors.", "m", 0);
+PARAM_INT("threads", "Number of threads to use to compute the MST (0 uses as "
+    "many threads as OpenMP allows).", "T", 1);
 
 using namespace mlpack;
 using namespace mlpack::emst;
@@ -51,24 +80,79 @@ int main(int argc, char* argv[])
 {
   CLI::ParseCommandLine(argc, argv);
 
+  // Either the whole dataset or its chunks must be given, but not both.
+  if (CLI::HasParam("input_file") == CLI::HasParam("chunk_files"))
+    Log::Fatal << "Exactly one of --input_file and --chunk_files must be "
+        << "specified!" << endl;
+
+  // Sanity check on the number of threads.
+  if (CLI::GetParam<int>("threads") < 0)
+    Log::Fatal << "Invalid number of threads: " << CLI::GetParam<int>("threads")
+        << ".  Must be greater than or equal to 0." << endl;
+  const size_t threads = (size_t) CLI::GetParam<int>("threads");
+
+  if (CLI::HasParam("chunk_files"))
+  {
+    if (CLI::HasParam("naive") || CLI::HasParam("min_points"))
+      Log::Fatal << "--naive and --min_points cannot be used with "
+          << "--chunk_files." << endl;
+
+    const vector<string> chunkFiles =
+        CLI::GetParam<vector<string> >("chunk_files");
+    OutOfCoreBoruvka<> oocb(chunkFiles);
+    oocb.NumThreads() = threads;
+
+    Log::Info << "Calculating minimum spanning tree of " << chunkFiles.size()
+        << " chunks." << endl;
+    arma::mat results;
+    oocb.ComputeMST(results);
+
+    const string outputFilename = CLI::GetParam<string>("output_file");
+    data::Save(outputFilename, results, true);
+
+    if (CLI::HasParam("dendrogram_file"))
+    {
+      arma::mat dendrogram;
+      ComputeDendrogram(results, results.n_cols + 1, dendrogram);
+      data::Save(CLI::GetParam<string>("dendrogram_file"), dendrogram, true);
+    }
+
+    return 0;
+  }
+
   const string dataFilename = CLI::GetParam<string>("input_file");
 
   arma::mat dataPoints;
   data::Load(dataFilename, dataPoints, true);
 
+  // Sanity check on the number of neighbors for the core distances.
+  if (CLI::GetParam<int>("min_points") < 0 ||
+      CLI::GetParam<int>("min_points") >= (int) dataPoints.n_cols)
+    Log::Fatal << "Invalid --min_points: " << CLI::GetParam<int>("min_points")
+        << ".  Must be at least 0 and less than the number of points." << endl;
+  const size_t minPoints = (size_t) CLI::GetParam<int>("min_points");
+
+  arma::mat results;
+  const size_t numPoints = dataPoints.n_cols;
+
   // Do naive computation if necessary.
   if (CLI::GetParam<bool>("naive"))
   {
     Log::Info << "Running naive algorithm." << endl;
 
     DualTreeBoruvka<> naive(dataPoints, true);
+    naive.NumThreads() = threads;
 
-    arma::mat naiveResults;
-    naive.ComputeMST(naiveResults);
-
-    const string outputFilename = CLI::GetParam<string>("output_file");
-
-    data::Save(outputFilename, naiveResults, true);
+    if (minPoints > 0)
+    {
+      arma::vec coreDistances;
+      ComputeCoreDistances(dataPoints, minPoints, coreDistances);
+      naive.ComputeMST(results, coreDistances);
+    }
+    else
+    {
+      naive.ComputeMST(results);
+    }
   }
   else
   {
@@ -93,36 +177,55 @@ int main(int argc, char* argv[])
     Timer::Stop("tree_building");
 
     DualTreeBoruvka<> dtb(&tree, metric);
+    dtb.NumThreads() = threads;
 
     // Run the DTB algorithm.
     Log::Info << "Calculating minimum spanning tree." << endl;
-    arma::mat results;
-    dtb.ComputeMST(results);
+    arma::mat mappedResults;
+    if (minPoints > 0)
+    {
+      // The tree holds a rearranged copy of the dataset, and the core
+      // distances must be in the order of the tree, so they are computed on
+      // that copy.
+      arma::vec coreDistances;
+      ComputeCoreDistances(tree.Dataset(), minPoints, coreDistances);
+      dtb.ComputeMST(mappedResults, coreDistances);
+    }
+    else
+    {
+      dtb.ComputeMST(mappedResults);
+    }
 
     // Unmap the results.
-    arma::mat unmappedResults(results.n_rows, results.n_cols);
-    for (size_t i = 0; i < results.n_cols; ++i)
+    results.set_size(mappedResults.n_rows, mappedResults.n_cols);
+    for (size_t i = 0; i < mappedResults.n_cols; ++i)
     {
-      const size_t indexA = oldFromNew[size_t(results(0, i))];
-      const size_t indexB = oldFromNew[size_t(results(1, i))];
+      const size_t indexA = oldFromNew[size_t(mappedResults(0, i))];
+      const size_t indexB = oldFromNew[size_t(mappedResults(1, i))];
 
       if (indexA < indexB)
       {
-        unmappedResults(0, i) = indexA;
-        unmappedResults(1, i) = indexB;
+        results(0, i) = indexA;
+        results(1, i) = indexB;
       }
       else
       {
-        unmappedResults(0, i) = indexB;
-        unmappedResults(1, i) = indexA;
+        results(0, i) = indexB;
+        results(1, i) = indexA;
       }
 
-      unmappedResults(2, i) = results(2, i);
+      results(2, i) = mappedResults(2, i);
     }
+  }
 
-    // Output the results.
-    const string outputFilename = CLI::GetParam<string>("output_file");
+  // Output the results.
+  const string outputFilename = CLI::GetParam<string>("output_file");
+  data::Save(outputFilename, results, true);
 
-    data::Save(outputFilename, unmappedResults, true);
+  if (CLI::HasParam("dendrogram_file"))
+  {
+    arma::mat dendrogram;
+    ComputeDendrogram(results, numPoints, dendrogram);
+    data::Save(CLI::GetParam<string>("dendrogram_file"), dendrogram, true);
   }
 }
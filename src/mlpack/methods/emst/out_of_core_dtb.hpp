@@ -0,0 +1,136 @@
+/**
+ * @file out_of_core_dtb.hpp
+ *
+ * Compute the Euclidean minimum spanning tree of a dataset that is stored in
+ * several chunks on disk, with at most two chunks in memory at a time.
+ */
+#ifndef __MLPACK_METHODS_EMST_OUT_OF_CORE_DTB_HPP
+#define __MLPACK_METHODS_EMST_OUT_OF_CORE_DTB_HPP
+
+#include <mlpack/core.hpp>
+
+#include "dtb.hpp"
+#include "dtb_rules.hpp"
+
+namespace mlpack {
+namespace emst {
+
+/**
+ * Performs the MST calculation for a dataset that is split into chunks, each
+ * stored in its own file, when the whole dataset does not fit in memory.  The
+ * points of the dataset are numbered in chunk order: the first point of the
+ * second chunk comes right after the last point of the first chunk, and so on.
+ *
+ * The computation has two phases.  First, the MST of each chunk is computed on
+ * its own with DualTreeBoruvka.  An edge between two points of the same chunk
+ * that is not in that chunk's MST is the longest edge of a cycle, so it cannot
+ * be in the MST of the whole dataset; hence only the chunk MSTs are kept.
+ * Then Boruvka steps are run on the whole dataset: in each step, the shortest
+ * edge leaving each component is found among the chunk MST edges and among the
+ * edges between each pair of chunks.  The edges between two chunks are found
+ * by a dual-tree traversal between the trees built on the two chunks, which
+ * prunes pairs of nodes that are in the same component or that are farther
+ * apart than the current candidate edges.
+ *
+ * Only two chunks (and their trees) are held in memory at once; in addition,
+ * O(1) values per point are kept for the components and candidate edges.  For
+ * each chunk i, the chunks after it are loaded from the last one down, and the
+ * tree of chunk i + 1, loaded last, is kept for the pairs of chunk i + 1.  So,
+ * with C chunks, each Boruvka step reads 1 + C (C - 1) / 2 chunk files and
+ * builds as many trees, and there are O(log n) steps.
+ *
+ * @code
+ * std::vector<std::string> chunks;
+ * chunks.push_back("chunk0.csv");
+ * chunks.push_back("chunk1.csv");
+ * OutOfCoreBoruvka<> oocb(chunks);
+ *
+ * arma::mat mstResults;
+ * oocb.ComputeMST(mstResults);
+ * @endcode
+ *
+ * @tparam MetricType The metric to use.
+ * @tparam MatType The type of data matrix to use.
+ * @tparam TreeType Type of tree to use.  This should follow the TreeType policy
+ *      API.
+ */
+template<
+    typename MetricType = metric::EuclideanDistance,
+    typename MatType = arma::mat,
+    template<typename TreeMetricType,
+             typename TreeStatType,
+             typename TreeMatType> class TreeType = tree::KDTree
+>
+class OutOfCoreBoruvka
+{
+ public:
+  //! Convenience typedef.
+  typedef TreeType<MetricType, DTBStat, MatType> Tree;
+
+  /**
+   * Create the object for the dataset stored in the given files.  No data is
+   * loaded until ComputeMST() is called.
+   *
+   * @param chunkFiles Files holding the chunks of the dataset, in order.
+   * @param metric Instantiated metric.
+   */
+  OutOfCoreBoruvka(const std::vector<std::string>& chunkFiles,
+                   const MetricType metric = MetricType());
+
+  /**
+   * Compute the minimum spanning tree of the whole dataset.  The results have
+   * the same form as for DualTreeBoruvka::ComputeMST(): a 3 x (n - 1) matrix
+   * holding the lesser index, the greater index, and the length of each edge,
+   * sorted by length.  The indices refer to the points in chunk order.
+   *
+   * @param results Matrix which results will be stored in.
+   */
+  void ComputeMST(arma::mat& results);
+
+  //! Get the number of threads used for the MST of each chunk.
+  size_t NumThreads() const { return numThreads; }
+  //! Modify the number of threads used for the MST of each chunk (0 means as
+  //! many as OpenMP allows).
+  size_t& NumThreads() { return numThreads; }
+
+  //! Get the chunk files.
+  const std::vector<std::string>& ChunkFiles() const { return chunkFiles; }
+
+ private:
+  //! The files holding the chunks of the dataset.
+  std::vector<std::string> chunkFiles;
+  //! The global index of the first point of each chunk, and the total number
+  //! of points at the end (filled by ComputeMST()).
+  std::vector<size_t> chunkOffsets;
+
+  //! The instantiated metric.
+  MetricType metric;
+  //! The number of threads to use for each chunk's MST.
+  size_t numThreads;
+
+  /**
+   * Load the given chunk into dataset and build a tree on it.  If the tree
+   * rearranges its dataset, the points are moved into the tree (and dataset is
+   * left empty); otherwise the tree refers to dataset, which must be kept until
+   * the tree is deleted.  The global index of each point of the tree's dataset
+   * is stored in indices.
+   */
+  Tree* LoadChunk(const size_t chunk,
+                  MatType& dataset,
+                  std::vector<size_t>& indices);
+
+  /**
+   * Reset the bounds in the statistics of the given tree, and set the
+   * component membership of each node from the global components.
+   */
+  void SetComponents(Tree& node,
+                     const std::vector<size_t>& indices,
+                     UnionFind& connections);
+}; // class OutOfCoreBoruvka
+
+} // namespace emst
+} // namespace mlpack
+
+#include "out_of_core_dtb_impl.hpp"
+
+#endif
@@ -0,0 +1,308 @@
+/**
+ * @file out_of_core_dtb_impl.hpp
+ *
+ * Implementation of OutOfCoreBoruvka.
+ */
+#ifndef __MLPACK_METHODS_EMST_OUT_OF_CORE_DTB_IMPL_HPP
+#define __MLPACK_METHODS_EMST_OUT_OF_CORE_DTB_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "out_of_core_dtb.hpp"
+
+namespace mlpack {
+namespace emst {
+
+template<
+    typename MetricType,
+    typename MatType,
+    template<typename TreeMetricType,
+             typename TreeStatType,
+             typename TreeMatType> class TreeType>
+OutOfCoreBoruvka<MetricType, MatType, TreeType>::OutOfCoreBoruvka(
+    const std::vector<std::string>& chunkFiles,
+    const MetricType metric) :
+    chunkFiles(chunkFiles),
+    metric(metric),
+    numThreads(1)
+{
+  if (chunkFiles.empty())
+    throw std::invalid_argument("OutOfCoreBoruvka::OutOfCoreBoruvka(): at "
+        "least one chunk file must be given");
+}
+
+template<
+    typename MetricType,
+    typename MatType,
+    template<typename TreeMetricType,
+             typename TreeStatType,
+             typename TreeMatType> class TreeType>
+void OutOfCoreBoruvka<MetricType, MatType, TreeType>::ComputeMST(
+    arma::mat& results)
+{
+  Timer::Start("emst/mst_computation");
+
+  // First, compute the MST of each chunk.  Only these edges can join two points
+  // of the same chunk in the MST of the whole dataset.
+  std::vector<EdgePair> candidates;
+  chunkOffsets.assign(1, 0);
+  for (size_t c = 0; c < chunkFiles.size(); ++c)
+  {
+    MatType chunk;
+    data::Load(chunkFiles[c], chunk, true);
+
+    const size_t offset = chunkOffsets.back();
+    if (chunk.n_cols > 1)
+    {
+      DualTreeBoruvka<MetricType, MatType, TreeType> dtb(chunk, false, metric);
+      dtb.NumThreads() = numThreads;
+
+      arma::mat chunkResults;
+      dtb.ComputeMST(chunkResults);
+
+      for (size_t i = 0; i < chunkResults.n_cols; ++i)
+        candidates.push_back(EdgePair(offset + size_t(chunkResults(0, i)),
+            offset + size_t(chunkResults(1, i)), chunkResults(2, i)));
+    }
+
+    chunkOffsets.push_back(offset + chunk.n_cols);
+    Log::Info << "Chunk " << c << " ('" << chunkFiles[c] << "'): "
+        << chunk.n_cols << " points." << std::endl;
+  }
+
+  const size_t numPoints = chunkOffsets.back();
+  if (numPoints == 0)
+  {
+    Timer::Stop("emst/mst_computation");
+    throw std::invalid_argument("OutOfCoreBoruvka::ComputeMST(): the chunks "
+        "contain no points");
+  }
+
+  UnionFind connections(numPoints);
+  arma::vec neighborsDistances(numPoints);
+  arma::Col<size_t> neighborsInComponent(numPoints);
+  arma::Col<size_t> neighborsOutComponent(numPoints);
+
+  std::vector<EdgePair> edges;
+  edges.reserve(numPoints - 1);
+
+  typedef DTBRules<MetricType, Tree> RuleType;
+  size_t baseCases = 0;
+  size_t scores = 0;
+
+  while (edges.size() < numPoints - 1)
+  {
+    neighborsDistances.fill(DBL_MAX);
+
+    // Candidate edges inside each chunk.
+    for (size_t i = 0; i < candidates.size(); ++i)
+    {
+      const size_t a = candidates[i].Lesser();
+      const size_t b = candidates[i].Greater();
+      const double distance = candidates[i].Distance();
+      const size_t componentA = connections.Find(a);
+      const size_t componentB = connections.Find(b);
+      if (componentA == componentB)
+        continue;
+
+      if (distance < neighborsDistances[componentA])
+      {
+        neighborsDistances[componentA] = distance;
+        neighborsInComponent[componentA] = a;
+        neighborsOutComponent[componentA] = b;
+      }
+
+      if (distance < neighborsDistances[componentB])
+      {
+        neighborsDistances[componentB] = distance;
+        neighborsInComponent[componentB] = b;
+        neighborsOutComponent[componentB] = a;
+      }
+    }
+
+    // Candidate edges between each pair of chunks, in both directions.  The
+    // chunks after chunk i are loaded from the last one down, so the last tree
+    // loaded is the one of the next non-empty chunk, and it is kept as the tree
+    // of the next i instead of being built again.
+    MatType chunks[2];
+    std::vector<size_t> indices[2];
+    size_t slotI = 0;
+    Tree* treeI = NULL;
+    for (size_t i = 0; i + 1 < chunkFiles.size(); ++i)
+    {
+      if (chunkOffsets[i + 1] == chunkOffsets[i])
+        continue; // Empty chunk.
+
+      if (treeI == NULL)
+        treeI = LoadChunk(i, chunks[slotI], indices[slotI]);
+
+      const size_t slotJ = 1 - slotI;
+      const std::vector<size_t>& indicesI = indices[slotI];
+      const std::vector<size_t>& indicesJ = indices[slotJ];
+      Tree* treeJ = NULL;
+      for (size_t j = chunkFiles.size() - 1; j > i; --j)
+      {
+        if (chunkOffsets[j + 1] == chunkOffsets[j])
+          continue; // Empty chunk.
+
+        // The previous tree may refer to the matrix that is loaded into.
+        delete treeJ;
+        treeJ = LoadChunk(j, chunks[slotJ], indices[slotJ]);
+
+        SetComponents(*treeI, indicesI, connections);
+        SetComponents(*treeJ, indicesJ, connections);
+
+        RuleType rulesIJ(treeI->Dataset(), indicesI, treeJ->Dataset(),
+            indicesJ, connections, neighborsDistances, neighborsInComponent,
+            neighborsOutComponent, metric);
+        typename Tree::template DualTreeTraverser<RuleType> traverserIJ(
+            rulesIJ);
+        traverserIJ.Traverse(*treeI, *treeJ);
+
+        RuleType rulesJI(treeJ->Dataset(), indicesJ, treeI->Dataset(),
+            indicesI, connections, neighborsDistances, neighborsInComponent,
+            neighborsOutComponent, metric);
+        typename Tree::template DualTreeTraverser<RuleType> traverserJI(
+            rulesJI);
+        traverserJI.Traverse(*treeJ, *treeI);
+
+        baseCases += rulesIJ.BaseCases() + rulesJI.BaseCases();
+        scores += rulesIJ.Scores() + rulesJI.Scores();
+      }
+
+      delete treeI;
+      treeI = treeJ;
+      slotI = slotJ;
+    }
+
+    delete treeI;
+
+    // Add the candidate edge of every component.
+    for (size_t i = 0; i < numPoints; ++i)
+    {
+      const size_t component = connections.Find(i);
+      if (neighborsDistances[component] == DBL_MAX)
+        continue;
+
+      const size_t inEdge = neighborsInComponent[component];
+      const size_t outEdge = neighborsOutComponent[component];
+      if (connections.Find(inEdge) != connections.Find(outEdge))
+      {
+        if (inEdge < outEdge)
+          edges.push_back(EdgePair(inEdge, outEdge,
+              neighborsDistances[component]));
+        else
+          edges.push_back(EdgePair(outEdge, inEdge,
+              neighborsDistances[component]));
+
+        connections.Union(inEdge, outEdge);
+      }
+    }
+
+    // Chunk MST edges inside one component can never be used again.
+    size_t kept = 0;
+    for (size_t i = 0; i < candidates.size(); ++i)
+    {
+      if (connections.Find(candidates[i].Lesser()) !=
+          connections.Find(candidates[i].Greater()))
+        candidates[kept++] = candidates[i];
+    }
+    candidates.erase(candidates.begin() + kept, candidates.end());
+
+    Log::Info << edges.size() << " edges found so far." << std::endl;
+    Log::Info << baseCases << " cumulative base cases between chunks."
+        << std::endl;
+    Log::Info << scores << " cumulative node combinations scored between "
+        << "chunks." << std::endl;
+  }
+
+  Timer::Stop("emst/mst_computation");
+
+  // Sort the edges and output them.
+  std::sort(edges.begin(), edges.end(), [](const EdgePair& a,
+      const EdgePair& b) { return a.Distance() < b.Distance(); });
+
+  double totalDist = 0.0;
+  results.set_size(3, edges.size());
+  for (size_t i = 0; i < edges.size(); ++i)
+  {
+    results(0, i) = edges[i].Lesser();
+    results(1, i) = edges[i].Greater();
+    results(2, i) = edges[i].Distance();
+    totalDist += edges[i].Distance();
+  }
+
+  Log::Info << "Total spanning tree length: " << totalDist << std::endl;
+}
+
+template<
+    typename MetricType,
+    typename MatType,
+    template<typename TreeMetricType,
+             typename TreeStatType,
+             typename TreeMatType> class TreeType>
+typename OutOfCoreBoruvka<MetricType, MatType, TreeType>::Tree*
+OutOfCoreBoruvka<MetricType, MatType, TreeType>::LoadChunk(
+    const size_t chunk,
+    MatType& dataset,
+    std::vector<size_t>& indices)
+{
+  data::Load(chunkFiles[chunk], dataset, true);
+  if (dataset.n_cols != chunkOffsets[chunk + 1] - chunkOffsets[chunk])
+    Log::Fatal << "Chunk file '" << chunkFiles[chunk] << "' changed during the "
+        << "computation!" << std::endl;
+
+  Timer::Start("tree_building");
+  std::vector<size_t> oldFromNew;
+  const size_t numPoints = dataset.n_cols;
+  Tree* tree = BuildTree<MatType, Tree>(std::move(dataset), oldFromNew);
+  Timer::Stop("tree_building");
+
+  indices.resize(numPoints);
+  for (size_t i = 0; i < numPoints; ++i)
+    indices[i] = chunkOffsets[chunk] + (oldFromNew.empty() ? i :
+        oldFromNew[i]);
+
+  return tree;
+}
+
+template<
+    typename MetricType,
+    typename MatType,
+    template<typename TreeMetricType,
+             typename TreeStatType,
+             typename TreeMatType> class TreeType>
+void OutOfCoreBoruvka<MetricType, MatType, TreeType>::SetComponents(
+    Tree& node,
+    const std::vector<size_t>& indices,
+    UnionFind& connections)
+{
+  node.Stat().MaxNeighborDistance() = DBL_MAX;
+  node.Stat().MinNeighborDistance() = DBL_MAX;
+  node.Stat().Bound() = DBL_MAX;
+  node.Stat().ComponentMembership() = -1;
+
+  for (size_t i = 0; i < node.NumChildren(); ++i)
+    SetComponents(node.Child(i), indices, connections);
+
+  // The node is in one component only if all of its children and points are.
+  const int component = (node.NumChildren() != 0) ?
+      node.Child(0).Stat().ComponentMembership() :
+      (int) connections.Find(indices[node.Point(0)]);
+  if (component < 0)
+    return;
+
+  for (size_t i = 0; i < node.NumChildren(); ++i)
+    if (node.Child(i).Stat().ComponentMembership() != component)
+      return;
+
+  for (size_t i = 0; i < node.NumPoints(); ++i)
+    if (connections.Find(indices[node.Point(i)]) != size_t(component))
+      return;
+
+  node.Stat().ComponentMembership() = component;
+}
+
+} // namespace emst
+} // namespace mlpack
+
+#endif
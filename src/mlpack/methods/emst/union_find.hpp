@@ -11,6 +11,7 @@
 #define __MLPACK_METHODS_EMST_UNION_FIND_HPP
 
 #include <mlpack/core.hpp>
+#include <atomic>
 
 namespace mlpack {
 namespace emst {
@@ -21,11 +22,15 @@ namespace emst {
  * initially in its own component.  Calling Union(x, y) unites the components
  * indexed by x and y.  Find(x) returns the index of the component containing
  * point x.
+ *
+ * Find() compresses paths with compare-and-swap operations, so it may be called
+ * concurrently from several threads, as long as no thread is calling Union() at
+ * the same time.
  */
 class UnionFind
 {
  private:
-  arma::Col<size_t> parent;
+  std::vector<std::atomic<size_t> > parent;
   arma::ivec rank;
 
  public:
@@ -34,7 +39,7 @@ class UnionFind
   {
     for (size_t i = 0; i < size; ++i)
     {
-      parent[i] = i;
+      parent[i].store(i, std::memory_order_relaxed);
       rank[i] = 0;
     }
   }
@@ -48,17 +53,24 @@ class UnionFind
    * @param x the component to be found
    * @return The index of the component containing x
    */
-  size_t Find(const size_t x)
+  size_t Find(size_t x)
   {
-    if (parent[x] == x)
-    {
-      return x;
-    }
-    else
+    // Path halving: point each node we pass at its grandparent.  If another
+    // thread already changed the parent, the compare-and-swap fails and the
+    // other thread's (equally valid) compression is kept.
+    while (true)
     {
-      // This ensures that the tree has a small depth
-      parent[x] = Find(parent[x]);
-      return parent[x];
+      size_t xParent = parent[x].load(std::memory_order_relaxed);
+      if (xParent == x)
+        return x;
+
+      const size_t xGrandparent =
+          parent[xParent].load(std::memory_order_relaxed);
+      if (xParent != xGrandparent)
+        parent[x].compare_exchange_weak(xParent, xGrandparent,
+            std::memory_order_relaxed);
+
+      x = xGrandparent;
     }
   }
 
@@ -79,16 +91,16 @@ class UnionFind
     }
     else if (rank[xRoot] == rank[yRoot])
     {
-      parent[yRoot] = parent[xRoot];
+      parent[yRoot].store(xRoot, std::memory_order_relaxed);
       rank[xRoot] = rank[xRoot] + 1;
     }
     else if (rank[xRoot] > rank[yRoot])
     {
-      parent[yRoot] = xRoot;
+      parent[yRoot].store(xRoot, std::memory_order_relaxed);
     }
     else
     {
-      parent[xRoot] = yRoot;
+      parent[xRoot].store(yRoot, std::memory_order_relaxed);
     }
   }
 }; // class UnionFind
@@ -42,6 +42,13 @@ namespace fastmks /** Fast max-kernel search. */ {
  * on points in the dataset (and not centroids of regions or anything like
  * that).
  *
+ * Search can be run on multiple threads by setting NumThreads().  Single-tree
+ * search splits the query points between the threads, dual-tree search splits
+ * the query tree into subtrees, and naive search splits the query points into
+ * blocks.  Naive search evaluates the kernel between blocks of points at once,
+ * which for LinearKernel, PolynomialKernel, and GaussianKernel is done with a
+ * single matrix multiplication (see BlockKernel).
+ *
  * @tparam KernelType Type of kernel to run FastMKS with.
  * @tparam MatType Type of data matrix (usually arma::mat).
  * @tparam TreeType Type of tree to run FastMKS with; it must satisfy the
@@ -60,6 +67,15 @@ class FastMKS
   //! Convenience typedef.
   typedef TreeType<metric::IPMetric<KernelType>, FastMKSStat, MatType> Tree;
 
+  /**
+   * Create the FastMKS object with an empty reference set and default kernel.
+   * Make sure to call Train() before Search() is called!
+   *
+   * @param singleMode Whether or not to run single-tree search.
+   * @param naive Whether or not to run brute-force (naive) search.
+   */
+  FastMKS(const bool singleMode = false, const bool naive = false);
+
   /**
    * Create the FastMKS object with the given reference set (this is the set
    * that is searched).  Optionally, specify whether or not single-tree search
@@ -106,6 +122,34 @@ class FastMKS
   //! Destructor for the FastMKS object.
   ~FastMKS();
 
+  /**
+   * "Train" the FastMKS model on the given reference set (this will just build
+   * a tree, if the current search mode is not naive mode).  The kernel held by
+   * the model is kept.
+   *
+   * @param referenceSet Set of reference data.
+   */
+  void Train(const MatType& referenceSet);
+
+  /**
+   * "Train" the FastMKS model on the given reference set and use the given
+   * kernel.  This will just build a tree and replace the metric, if the current
+   * search mode is not naive mode.
+   *
+   * @param referenceSet Set of reference data.
+   * @param kernel Kernel to use for search.
+   */
+  void Train(const MatType& referenceSet, KernelType& kernel);
+
+  /**
+   * Train the FastMKS model on the given reference tree.  This takes ownership
+   * of the tree, so you do not need to delete it!  This will throw an
+   * exception if the model is in naive mode.
+   *
+   * @param referenceTree Tree built on reference data.
+   */
+  void Train(Tree* referenceTree);
+
   /**
    * Search for the points in the reference set with maximum kernel evaluation
    * to each point in the given query set.  The resulting kernel evaluations are
@@ -186,27 +230,86 @@ class FastMKS
   //! Modify whether or not single-tree search is used.
   bool& SingleMode() { return singleMode; }
 
+  //! Get whether or not brute-force (naive) search is used.
+  bool Naive() const { return naive; }
+  //! Modify whether or not brute-force (naive) search is used.
+  bool& Naive() { return naive; }
+
+  //! Get the number of threads used for search (0 means as many as OpenMP
+  //! allows).
+  size_t NumThreads() const { return numThreads; }
+  //! Modify the number of threads used for search (0 means as many as OpenMP
+  //! allows).
+  size_t& NumThreads() { return numThreads; }
+
   /**
    * Returns a string representation of this object.
    */
   std::string ToString() const;
 
+  /**
+   * Serialize the model.  In tree mode only the tree is stored, since it holds
+   * both the dataset and the kernel.
+   */
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */);
+
  private:
   //! The reference dataset.
-  const MatType& referenceSet;
+  const MatType* referenceSet;
   //! The tree built on the reference dataset.
   Tree* referenceTree;
   //! If true, this object created the tree and is responsible for it.
   bool treeOwner;
+  //! If true, we own the dataset.  This happens in only a few situations.
+  bool setOwner;
 
   //! If true, single-tree search is used.
   bool singleMode;
   //! If true, naive (brute-force) search is used.
   bool naive;
+  //! The number of threads to use for search.
+  size_t numThreads;
 
   //! The instantiated inner-product metric induced by the given kernel.
   metric::IPMetric<KernelType> metric;
 
+  /**
+   * Run brute-force search, evaluating the kernel between blocks of query
+   * points and blocks of reference points with BlockKernel.  The kernels
+   * matrix must already be filled with -DBL_MAX.
+   *
+   * @param querySet Set of query points.
+   * @param sameSet If true, a point is never returned as its own candidate.
+   * @param indices Matrix to store resulting indices of max-kernel search in.
+   * @param kernels Matrix to store resulting max-kernel values in.
+   */
+  void NaiveSearch(const MatType& querySet,
+                   const bool sameSet,
+                   arma::Mat<size_t>& indices,
+                   arma::mat& kernels);
+
+  /**
+   * Run single-tree search on NumThreads() threads, each of which handles a
+   * contiguous block of query points with its own rules object.  The kernels
+   * matrix must already be filled with -DBL_MAX.
+   */
+  void ParallelSingleTreeSearch(const MatType& querySet,
+                                arma::Mat<size_t>& indices,
+                                arma::mat& kernels);
+
+  /**
+   * Run dual-tree search on NumThreads() threads.  The query tree is split
+   * into disjoint subtrees, each of which is traversed against the whole
+   * reference tree.  The kernels matrix must already be filled with -DBL_MAX.
+   */
+  void ParallelDualTreeSearch(Tree* queryTree,
+                              arma::Mat<size_t>& indices,
+                              arma::mat& kernels);
+
+  //! Return the number of threads that will actually be used for search.
+  size_t ThreadsToUse() const;
+
   //! Utility function.  Copied too many times from too many places.
   void InsertNeighbor(arma::Mat<size_t>& indices,
                       arma::mat& products,
@@ -0,0 +1,137 @@
+/**
+ * @file fastmks_block_kernel.hpp
+ *
+ * Evaluation of a kernel between a block of query points and a block of
+ * reference points.  For kernels that depend only on inner products (and
+ * norms), the whole block is computed with one matrix multiplication.
+ */
+#ifndef __MLPACK_METHODS_FASTMKS_FASTMKS_BLOCK_KERNEL_HPP
+#define __MLPACK_METHODS_FASTMKS_FASTMKS_BLOCK_KERNEL_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/kernels/linear_kernel.hpp>
+#include <mlpack/core/kernels/polynomial_kernel.hpp>
+#include <mlpack/core/kernels/gaussian_kernel.hpp>
+
+namespace mlpack {
+namespace fastmks {
+
+/**
+ * Compute the kernel evaluations between the columns
+ * [referenceBegin, referenceBegin + referenceCount) of the reference set and
+ * the columns [queryBegin, queryBegin + queryCount) of the query set.  After
+ * Evaluate() returns, kernels(i, j) holds K(r_{referenceBegin + i},
+ * q_{queryBegin + j}).
+ *
+ * The generic implementation evaluates the kernel once for each pair of
+ * points.  It is specialized for LinearKernel, PolynomialKernel, and
+ * GaussianKernel to use a single matrix multiplication per block.
+ *
+ * @tparam KernelType Type of kernel to evaluate.
+ */
+template<typename KernelType>
+class BlockKernel
+{
+ public:
+  template<typename MatType>
+  static void Evaluate(KernelType& kernel,
+                       const MatType& querySet,
+                       const size_t queryBegin,
+                       const size_t queryCount,
+                       const MatType& referenceSet,
+                       const size_t referenceBegin,
+                       const size_t referenceCount,
+                       arma::mat& kernels)
+  {
+    kernels.set_size(referenceCount, queryCount);
+    for (size_t q = 0; q < queryCount; ++q)
+      for (size_t r = 0; r < referenceCount; ++r)
+        kernels(r, q) = kernel.Evaluate(querySet.col(queryBegin + q),
+            referenceSet.col(referenceBegin + r));
+  }
+};
+
+//! The linear kernel is just the matrix of inner products.
+template<>
+class BlockKernel<kernel::LinearKernel>
+{
+ public:
+  template<typename MatType>
+  static void Evaluate(const kernel::LinearKernel& /* kernel */,
+                       const MatType& querySet,
+                       const size_t queryBegin,
+                       const size_t queryCount,
+                       const MatType& referenceSet,
+                       const size_t referenceBegin,
+                       const size_t referenceCount,
+                       arma::mat& kernels)
+  {
+    kernels = referenceSet.cols(referenceBegin, referenceBegin +
+        referenceCount - 1).t() * querySet.cols(queryBegin, queryBegin +
+        queryCount - 1);
+  }
+};
+
+//! The polynomial kernel is an elementwise function of the inner products.
+template<>
+class BlockKernel<kernel::PolynomialKernel>
+{
+ public:
+  template<typename MatType>
+  static void Evaluate(const kernel::PolynomialKernel& kernel,
+                       const MatType& querySet,
+                       const size_t queryBegin,
+                       const size_t queryCount,
+                       const MatType& referenceSet,
+                       const size_t referenceBegin,
+                       const size_t referenceCount,
+                       arma::mat& kernels)
+  {
+    kernels = referenceSet.cols(referenceBegin, referenceBegin +
+        referenceCount - 1).t() * querySet.cols(queryBegin, queryBegin +
+        queryCount - 1);
+    kernels = arma::pow(kernels + kernel.Offset(), kernel.Degree());
+  }
+};
+
+/**
+ * The Gaussian kernel uses ||q - r||^2 = ||q||^2 + ||r||^2 - 2 q^T r, so the
+ * only expensive part is the matrix of inner products.
+ */
+template<>
+class BlockKernel<kernel::GaussianKernel>
+{
+ public:
+  template<typename MatType>
+  static void Evaluate(const kernel::GaussianKernel& kernel,
+                       const MatType& querySet,
+                       const size_t queryBegin,
+                       const size_t queryCount,
+                       const MatType& referenceSet,
+                       const size_t referenceBegin,
+                       const size_t referenceCount,
+                       arma::mat& kernels)
+  {
+    const arma::mat queries(querySet.cols(queryBegin, queryBegin + queryCount -
+        1));
+    const arma::mat references(referenceSet.cols(referenceBegin,
+        referenceBegin + referenceCount - 1));
+
+    const arma::rowvec queryNorms = arma::sum(arma::square(queries), 0);
+    const arma::colvec referenceNorms =
+        arma::sum(arma::square(references), 0).t();
+
+    kernels = -2.0 * references.t() * queries;
+    kernels.each_col() += referenceNorms;
+    kernels.each_row() += queryNorms;
+
+    // Rounding can make some squared distances slightly negative.
+    kernels.elem(arma::find(kernels < 0.0)).zeros();
+    kernels = arma::exp(kernel.Gamma() * kernels);
+  }
+};
+
+} // namespace fastmks
+} // namespace mlpack
+
+#endif
@@ -11,13 +11,39 @@
 #include "fastmks.hpp"
 
 #include "fastmks_rules.hpp"
+#include "fastmks_block_kernel.hpp"
 
 #include <mlpack/core/kernels/gaussian_kernel.hpp>
 #include <queue>
+#include <algorithm>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
 
 namespace mlpack {
 namespace fastmks {
 
+// No data; create a model on an empty dataset.
+template<typename KernelType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+FastMKS<KernelType, MatType, TreeType>::FastMKS(const bool singleMode,
+                                                const bool naive) :
+    referenceSet(new MatType()),
+    referenceTree(NULL),
+    treeOwner(true),
+    setOwner(true),
+    singleMode(singleMode),
+    naive(naive),
+    numThreads(1)
+{
+  // A cover tree cannot be built on an empty dataset, so the tree is not built
+  // until Train() is called.
+}
+
 // No instantiated kernel.
 template<typename KernelType,
          typename MatType,
@@ -28,11 +54,13 @@ FastMKS<KernelType, MatType, TreeType>::FastMKS(
     const MatType& referenceSet,
     const bool singleMode,
     const bool naive) :
-    referenceSet(referenceSet),
+    referenceSet(&referenceSet),
     referenceTree(NULL),
     treeOwner(true),
+    setOwner(false),
     singleMode(singleMode),
-    naive(naive)
+    naive(naive),
+    numThreads(1)
 {
   Timer::Start("tree_building");
 
@@ -52,11 +80,13 @@ FastMKS<KernelType, MatType, TreeType>::FastMKS(const MatType& referenceSet,
                                                 KernelType& kernel,
                                                 const bool singleMode,
                                                 const bool naive) :
-    referenceSet(referenceSet),
+    referenceSet(&referenceSet),
     referenceTree(NULL),
     treeOwner(true),
+    setOwner(false),
     singleMode(singleMode),
     naive(naive),
+    numThreads(1),
     metric(kernel)
 {
   Timer::Start("tree_building");
@@ -76,11 +106,13 @@ template<typename KernelType,
                   typename TreeMatType> class TreeType>
 FastMKS<KernelType, MatType, TreeType>::FastMKS(Tree* referenceTree,
                                                 const bool singleMode) :
-    referenceSet(referenceTree->Dataset()),
+    referenceSet(&referenceTree->Dataset()),
     referenceTree(referenceTree),
     treeOwner(false),
+    setOwner(false),
     singleMode(singleMode),
     naive(false),
+    numThreads(1),
     metric(referenceTree->Metric())
 {
   // Nothing to do.
@@ -96,6 +128,67 @@ FastMKS<KernelType, MatType, TreeType>::~FastMKS()
   // If we created the trees, we must delete them.
   if (treeOwner && referenceTree)
     delete referenceTree;
+  if (setOwner)
+    delete referenceSet;
+}
+
+template<typename KernelType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void FastMKS<KernelType, MatType, TreeType>::Train(const MatType& referenceSet)
+{
+  if (setOwner)
+    delete this->referenceSet;
+
+  this->referenceSet = &referenceSet;
+  this->setOwner = false;
+
+  if (!naive)
+  {
+    if (treeOwner && referenceTree)
+      delete referenceTree;
+    referenceTree = new Tree(referenceSet, metric);
+    treeOwner = true;
+  }
+}
+
+template<typename KernelType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void FastMKS<KernelType, MatType, TreeType>::Train(const MatType& referenceSet,
+                                                   KernelType& kernel)
+{
+  metric = metric::IPMetric<KernelType>(kernel);
+  Train(referenceSet);
+}
+
+template<typename KernelType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void FastMKS<KernelType, MatType, TreeType>::Train(Tree* tree)
+{
+  if (naive)
+    throw std::invalid_argument("cannot call FastMKS::Train() with a tree when "
+        "in naive search mode");
+
+  if (setOwner)
+    delete this->referenceSet;
+
+  this->referenceSet = &tree->Dataset();
+  this->metric = tree->Metric();
+  this->setOwner = false;
+
+  if (treeOwner && referenceTree)
+    delete referenceTree;
+
+  this->referenceTree = tree;
+  this->treeOwner = true;
 }
 
 template<typename KernelType,
@@ -121,24 +214,7 @@ void FastMKS<KernelType, MatType, TreeType>::Search(
     // Fill kernels.
     kernels.fill(-DBL_MAX);
 
-    // Simple double loop.  Stupid, slow, but a good benchmark.
-    for (size_t q = 0; q < querySet.n_cols; ++q)
-    {
-      for (size_t r = 0; r < referenceSet.n_cols; ++r)
-      {
-        const double eval = metric.Kernel().Evaluate(querySet.col(q),
-                                                     referenceSet.col(r));
-
-        size_t insertPosition;
-        for (insertPosition = 0; insertPosition < indices.n_rows;
-            ++insertPosition)
-          if (eval > kernels(insertPosition, q))
-            break;
-
-        if (insertPosition < indices.n_rows)
-          InsertNeighbor(indices, kernels, q, insertPosition, r, eval);
-      }
-    }
+    NaiveSearch(querySet, false, indices, kernels);
 
     Timer::Stop("computing_products");
 
@@ -146,7 +222,16 @@ void FastMKS<KernelType, MatType, TreeType>::Search(
   }
 
   // Single-tree implementation.
-  if (singleMode)
+  if (singleMode && ThreadsToUse() > 1)
+  {
+    kernels.fill(-DBL_MAX);
+
+    ParallelSingleTreeSearch(querySet, indices, kernels);
+
+    Timer::Stop("computing_products");
+    return;
+  }
+  else if (singleMode)
   {
     // Fill kernels.
     kernels.fill(-DBL_MAX);
@@ -154,7 +239,7 @@ void FastMKS<KernelType, MatType, TreeType>::Search(
     // Create rules object (this will store the results).  This constructor
     // precalculates each self-kernel value.
     typedef FastMKSRules<KernelType, Tree> RuleType;
-    RuleType rules(referenceSet, querySet, indices, kernels, metric.Kernel());
+    RuleType rules(*referenceSet, querySet, indices, kernels, metric.Kernel());
 
     typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
 
@@ -202,8 +287,16 @@ void FastMKS<KernelType, MatType, TreeType>::Search(
   kernels.fill(-DBL_MAX);
 
   Timer::Start("computing_products");
+  if (ThreadsToUse() > 1)
+  {
+    ParallelDualTreeSearch(queryTree, indices, kernels);
+
+    Timer::Stop("computing_products");
+    return;
+  }
+
   typedef FastMKSRules<KernelType, Tree> RuleType;
-  RuleType rules(referenceSet, queryTree->Dataset(), indices, kernels,
+  RuleType rules(*referenceSet, queryTree->Dataset(), indices, kernels,
       metric.Kernel());
 
   typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
@@ -228,34 +321,14 @@ void FastMKS<KernelType, MatType, TreeType>::Search(
 {
   // No remapping will be necessary because we are using the cover tree.
   Timer::Start("computing_products");
-  indices.set_size(k, referenceSet.n_cols);
-  kernels.set_size(k, referenceSet.n_cols);
+  indices.set_size(k, referenceSet->n_cols);
+  kernels.set_size(k, referenceSet->n_cols);
   kernels.fill(-DBL_MAX);
 
   // Naive implementation.
   if (naive)
   {
-    // Simple double loop.  Stupid, slow, but a good benchmark.
-    for (size_t q = 0; q < referenceSet.n_cols; ++q)
-    {
-      for (size_t r = 0; r < referenceSet.n_cols; ++r)
-      {
-        if (q == r)
-          continue; // Don't return the point as its own candidate.
-
-        const double eval = metric.Kernel().Evaluate(referenceSet.col(q),
-                                                     referenceSet.col(r));
-
-        size_t insertPosition;
-        for (insertPosition = 0; insertPosition < indices.n_rows;
-            ++insertPosition)
-          if (eval > kernels(insertPosition, q))
-            break;
-
-        if (insertPosition < indices.n_rows)
-          InsertNeighbor(indices, kernels, q, insertPosition, r, eval);
-      }
-    }
+    NaiveSearch(*referenceSet, true, indices, kernels);
 
     Timer::Stop("computing_products");
 
@@ -263,17 +336,24 @@ void FastMKS<KernelType, MatType, TreeType>::Search(
   }
 
   // Single-tree implementation.
-  if (singleMode)
+  if (singleMode && ThreadsToUse() > 1)
+  {
+    ParallelSingleTreeSearch(*referenceSet, indices, kernels);
+
+    Timer::Stop("computing_products");
+    return;
+  }
+  else if (singleMode)
   {
     // Create rules object (this will store the results).  This constructor
     // precalculates each self-kernel value.
     typedef FastMKSRules<KernelType, Tree> RuleType;
-    RuleType rules(referenceSet, referenceSet, indices, kernels,
+    RuleType rules(*referenceSet, *referenceSet, indices, kernels,
         metric.Kernel());
 
     typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
 
-    for (size_t i = 0; i < referenceSet.n_cols; ++i)
+    for (size_t i = 0; i < referenceSet->n_cols; ++i)
       traverser.Traverse(i, *referenceTree);
 
     // Save the number of pruned nodes.
@@ -294,6 +374,213 @@ void FastMKS<KernelType, MatType, TreeType>::Search(
   Search(referenceTree, k, indices, kernels);
 }
 
+template<typename KernelType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void FastMKS<KernelType, MatType, TreeType>::NaiveSearch(
+    const MatType& querySet,
+    const bool sameSet,
+    arma::Mat<size_t>& indices,
+    arma::mat& kernels)
+{
+  // The kernel values are computed for a block of query points against a block
+  // of reference points at a time.  Each block of query points is handled by
+  // one thread, so the results for each query point are only written by one
+  // thread.
+  const size_t queryBlockSize = 256;
+  const size_t referenceBlockSize = 1024;
+  const size_t numQueryBlocks = (querySet.n_cols + queryBlockSize - 1) /
+      queryBlockSize;
+  const size_t threads = ThreadsToUse();
+
+  #pragma omp parallel for num_threads(threads) schedule(dynamic, 1)
+  for (size_t b = 0; b < numQueryBlocks; ++b)
+  {
+    const size_t queryBegin = b * queryBlockSize;
+    const size_t queryCount = std::min(queryBlockSize,
+        (size_t) querySet.n_cols - queryBegin);
+
+    arma::mat blockKernels;
+    for (size_t referenceBegin = 0; referenceBegin < referenceSet->n_cols;
+         referenceBegin += referenceBlockSize)
+    {
+      const size_t referenceCount = std::min(referenceBlockSize,
+          (size_t) referenceSet->n_cols - referenceBegin);
+
+      BlockKernel<KernelType>::Evaluate(metric.Kernel(), querySet, queryBegin,
+          queryCount, *referenceSet, referenceBegin, referenceCount,
+          blockKernels);
+
+      for (size_t q = 0; q < queryCount; ++q)
+      {
+        const size_t queryIndex = queryBegin + q;
+        for (size_t r = 0; r < referenceCount; ++r)
+        {
+          const size_t referenceIndex = referenceBegin + r;
+          if (sameSet && (queryIndex == referenceIndex))
+            continue; // Don't return the point as its own candidate.
+
+          const double eval = blockKernels(r, q);
+          if (eval <= kernels(kernels.n_rows - 1, queryIndex))
+            continue; // Not good enough to be inserted.
+
+          size_t insertPosition;
+          for (insertPosition = 0; insertPosition < indices.n_rows;
+              ++insertPosition)
+            if (eval > kernels(insertPosition, queryIndex))
+              break;
+
+          InsertNeighbor(indices, kernels, queryIndex, insertPosition,
+              referenceIndex, eval);
+        }
+      }
+    }
+  }
+}
+
+template<typename KernelType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void FastMKS<KernelType, MatType, TreeType>::ParallelSingleTreeSearch(
+    const MatType& querySet,
+    arma::Mat<size_t>& indices,
+    arma::mat& kernels)
+{
+  typedef FastMKSRules<KernelType, Tree> RuleType;
+  const size_t threads = ThreadsToUse();
+
+  size_t baseCases = 0;
+  size_t scores = 0;
+
+  // The self-kernels are computed once and shared by the rules of every
+  // thread.
+  arma::vec queryKernels, referenceKernels;
+  RuleType::SelfKernels(querySet, metric.Kernel(), queryKernels);
+  RuleType::SelfKernels(*referenceSet, metric.Kernel(), referenceKernels);
+
+  // Each thread handles a contiguous block of query points.  The rules objects
+  // must not cache kernel evaluations in the (shared) reference tree.
+  #pragma omp parallel for num_threads(threads) schedule(static, 1) \
+      reduction(+:baseCases, scores)
+  for (size_t t = 0; t < threads; ++t)
+  {
+    const size_t begin = (t * querySet.n_cols) / threads;
+    const size_t end = ((t + 1) * querySet.n_cols) / threads;
+
+    RuleType rules(*referenceSet, querySet, indices, kernels, metric.Kernel(),
+        queryKernels, referenceKernels, true);
+    typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
+
+    for (size_t i = begin; i < end; ++i)
+      traverser.Traverse(i, *referenceTree);
+
+    baseCases += rules.BaseCases();
+    scores += rules.Scores();
+  }
+
+  Log::Info << baseCases << " base cases." << std::endl;
+  Log::Info << scores << " scores." << std::endl;
+}
+
+template<typename KernelType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void FastMKS<KernelType, MatType, TreeType>::ParallelDualTreeSearch(
+    Tree* queryTree,
+    arma::Mat<size_t>& indices,
+    arma::mat& kernels)
+{
+  typedef FastMKSRules<KernelType, Tree> RuleType;
+  const size_t threads = ThreadsToUse();
+
+  // Split the query tree into disjoint subtrees by repeatedly replacing the
+  // largest non-leaf subtree with its children.  The nodes that are split are
+  // never visited by the traversal, so their bounds are reset; the bound of a
+  // subtree's parent is used by CalculateBound().
+  std::vector<Tree*> subtrees(1, queryTree);
+  while (subtrees.size() < 4 * threads)
+  {
+    size_t largest = subtrees.size();
+    for (size_t i = 0; i < subtrees.size(); ++i)
+    {
+      if (!subtrees[i]->IsLeaf() && (largest == subtrees.size() ||
+          subtrees[i]->NumDescendants() >
+          subtrees[largest]->NumDescendants()))
+        largest = i;
+    }
+
+    if (largest == subtrees.size())
+      break; // Everything is a leaf.
+
+    Tree* node = subtrees[largest];
+    node->Stat().Bound() = -DBL_MAX;
+    subtrees.erase(subtrees.begin() + largest);
+    for (size_t i = 0; i < node->NumChildren(); ++i)
+      subtrees.push_back(&node->Child(i));
+  }
+
+  // Hand out the largest subtrees first.
+  std::stable_sort(subtrees.begin(), subtrees.end(), [](const Tree* a,
+      const Tree* b) { return a->NumDescendants() > b->NumDescendants(); });
+
+  // The self-kernels are computed once and shared by the rules of every
+  // thread.
+  arma::vec queryKernels, referenceKernels;
+  RuleType::SelfKernels(queryTree->Dataset(), metric.Kernel(), queryKernels);
+  RuleType::SelfKernels(*referenceSet, metric.Kernel(), referenceKernels);
+
+  size_t baseCases = 0;
+  size_t scores = 0;
+
+  #pragma omp parallel num_threads(threads) reduction(+:baseCases, scores)
+  {
+    RuleType rules(*referenceSet, queryTree->Dataset(), indices, kernels,
+        metric.Kernel(), queryKernels, referenceKernels);
+
+    // Each subtree traversal must start from the same state as a traversal of
+    // the whole tree.
+    const typename RuleType::TraversalInfoType initialInfo =
+        rules.TraversalInfo();
+
+    #pragma omp for schedule(dynamic, 1)
+    for (size_t i = 0; i < subtrees.size(); ++i)
+    {
+      rules.TraversalInfo() = initialInfo;
+      typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
+      traverser.Traverse(*subtrees[i], *referenceTree);
+    }
+
+    baseCases += rules.BaseCases();
+    scores += rules.Scores();
+  }
+
+  Log::Info << baseCases << " base cases." << std::endl;
+  Log::Info << scores << " scores." << std::endl;
+}
+
+template<typename KernelType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+size_t FastMKS<KernelType, MatType, TreeType>::ThreadsToUse() const
+{
+  if (numThreads != 0)
+    return numThreads;
+
+#ifdef _OPENMP
+  return (size_t) omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
 /**
  * Helper function to insert a point into the neighbors and distances matrices.
  *
@@ -350,6 +637,67 @@ std::string FastMKS<KernelType, MatType, TreeType>::ToString() const
   return convert.str();
 }
 
+template<typename KernelType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+template<typename Archive>
+void FastMKS<KernelType, MatType, TreeType>::Serialize(
+    Archive& ar,
+    const unsigned int /* version */)
+{
+  using data::CreateNVP;
+
+  // Serialize preferences for search.
+  ar & CreateNVP(naive, "naive");
+  ar & CreateNVP(singleMode, "singleMode");
+
+  // If we are doing naive search, serialize the dataset.  Otherwise we
+  // serialize the tree, which holds the dataset and the kernel.
+  if (naive)
+  {
+    if (Archive::is_loading::value)
+    {
+      if (setOwner && referenceSet)
+        delete referenceSet;
+
+      // A tree held from before is not used by naive search.
+      if (treeOwner && referenceTree)
+        delete referenceTree;
+      referenceTree = NULL;
+
+      setOwner = true;
+      treeOwner = true;
+    }
+
+    ar & CreateNVP(referenceSet, "referenceSet");
+    ar & CreateNVP(metric, "metric");
+  }
+  else
+  {
+    // Delete the current reference tree, if necessary.
+    if (Archive::is_loading::value)
+    {
+      if (treeOwner && referenceTree)
+        delete referenceTree;
+      if (setOwner && referenceSet)
+        delete referenceSet;
+
+      treeOwner = true;
+      setOwner = false;
+    }
+
+    ar & CreateNVP(referenceTree, "referenceTree");
+
+    if (Archive::is_loading::value)
+    {
+      referenceSet = &referenceTree->Dataset();
+      metric = referenceTree->Metric();
+    }
+  }
+}
+
 } // namespace fastmks
 } // namespace mlpack
 
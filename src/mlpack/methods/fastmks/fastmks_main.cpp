@@ -7,6 +7,7 @@
 #include <mlpack/core.hpp>
 
 #include "fastmks.hpp"
+#include "fastmks_model.hpp"
 
 using namespace std;
 using namespace mlpack;
@@ -37,19 +38,31 @@ PROGRAM_INFO("FastMKS (Fast Max-Kernel Search)",
     "to the kernel evaluation between those two points."
     "\n\n"
     "This executable performs FastMKS using a cover tree.  The base used to "
-    "build the cover tree can be specified with the --base option.");
+    "build the cover tree can be specified with the --base option."
+    "\n\n"
+    "The model (the kernel and the cover tree built on the reference set) can "
+    "be saved with --output_model (-m) and loaded again with --input_model "
+    "(-M), so that the tree only needs to be built once.  For example, the "
+    "following builds a model with the polynomial kernel and then uses it to "
+    "search with a query set:"
+    "\n\n"
+    "$ fastmks -r reference.csv -K polynomial -d 3 -m fastmks_model.xml\n"
+    "$ fastmks -M fastmks_model.xml -q query.csv -k 5 -i indices.csv");
 
 // Define our input parameters.
-PARAM_STRING_REQ("reference_file", "File containing the reference dataset.",
-    "r");
+PARAM_STRING("reference_file", "File containing the reference dataset.",
+    "r", "");
 PARAM_STRING("query_file", "File containing the query dataset.", "q", "");
 
-PARAM_INT_REQ("k", "Number of maximum kernels to find.", "k");
+PARAM_INT("k", "Number of maximum kernels to find.", "k", 0);
 
 PARAM_STRING("kernels_file", "File to save kernels into.", "p", "");
 PARAM_STRING("indices_file", "File to save indices of kernels into.",
     "i", "");
 
+PARAM_STRING("input_model", "File containing a saved FastMKS model.", "M", "");
+PARAM_STRING("output_model", "File to save the FastMKS model to.", "m", "");
+
 PARAM_STRING("kernel", "Kernel type to use: 'linear', 'polynomial', 'cosine', "
     "'gaussian', 'epanechnikov', 'triangular', 'hyptan'.", "K", "linear");
 
@@ -60,6 +73,9 @@ PARAM_FLAG("single", "If true, single-tree search is used (as opposed to "
 // Cover tree parameter.
 PARAM_DOUBLE("base", "Base to use during cover tree construction.", "b", 2.0);
 
+PARAM_INT("threads", "Number of threads to use for search (0 uses as many "
+    "threads as OpenMP allows).", "T", 1);
+
 // Kernel parameters.
 PARAM_DOUBLE("degree", "Degree of polynomial kernel.", "d", 2.0);
 PARAM_DOUBLE("offset", "Offset of kernel (for polynomial and hyptan kernels).",
@@ -68,91 +84,28 @@ PARAM_DOUBLE("bandwidth", "Bandwidth (for Gaussian, Epanechnikov, and "
     "triangular kernels).", "w", 1.0);
 PARAM_DOUBLE("scale", "Scale of kernel (for hyptan kernel).", "s", 1.0);
 
-//! Run FastMKS on a single dataset for the given kernel type.
-template<typename KernelType>
-void RunFastMKS(const arma::mat& referenceData,
-                const bool single,
-                const bool naive,
-                const double base,
-                const size_t k,
-                arma::Mat<size_t>& indices,
-                arma::mat& kernels,
-                KernelType& kernel)
-{
-  if (naive)
-  {
-    // No need for trees.
-    FastMKS<KernelType> fastmks(referenceData, kernel, false, naive);
-    fastmks.Search(k, indices, kernels);
-  }
-  else
-  {
-    // Create the tree with the specified base.
-    typedef CoverTree<IPMetric<KernelType>, FastMKSStat, arma::mat,
-        FirstPointIsRoot> TreeType;
-    IPMetric<KernelType> metric(kernel);
-    TreeType tree(referenceData, metric, base);
-
-    // Create FastMKS object.
-    FastMKS<KernelType> fastmks(&tree, single);
-
-    // Now search with it.
-    fastmks.Search(k, indices, kernels);
-  }
-}
-
-//! Run FastMKS for a given query and reference set using the given kernel type.
-template<typename KernelType>
-void RunFastMKS(const arma::mat& referenceData,
-                const arma::mat& queryData,
-                const bool single,
-                const bool naive,
-                const double base,
-                const size_t k,
-                arma::Mat<size_t>& indices,
-                arma::mat& kernels,
-                KernelType& kernel)
-{
-  if (naive)
-  {
-    // No need for trees.
-    FastMKS<KernelType> fastmks(referenceData, kernel, false, naive);
-    fastmks.Search(queryData, k, indices, kernels);
-  }
-  else
-  {
-    // Create the tree with the specified base.
-    typedef CoverTree<IPMetric<KernelType>, FastMKSStat, arma::mat,
-        FirstPointIsRoot> TreeType;
-    IPMetric<KernelType> metric(kernel);
-    TreeType referenceTree(referenceData, metric, base);
-
-    // Create FastMKS object.
-    FastMKS<KernelType, arma::mat, StandardCoverTree> fastmks(&referenceTree,
-        single);
-
-    // Now search with it.
-    if (single)
-    {
-      fastmks.Search(queryData, k, indices, kernels);
-    }
-    else
-    {
-      TreeType queryTree(queryData, metric, base);
-      fastmks.Search(&queryTree, k, indices, kernels);
-    }
-  }
-}
-
 int main(int argc, char** argv)
 {
   CLI::ParseCommandLine(argc, argv);
 
-  // Get reference dataset filename.
   const string referenceFile = CLI::GetParam<string>("reference_file");
+  const string inputModelFile = CLI::GetParam<string>("input_model");
+  const string outputModelFile = CLI::GetParam<string>("output_model");
+
+  // Either a reference set or a model must be given, but not both.
+  if (CLI::HasParam("reference_file") == CLI::HasParam("input_model"))
+    Log::Fatal << "Exactly one of --reference_file and --input_model must be "
+        << "specified!" << endl;
 
   // The number of max kernel values to find.
-  const size_t k = CLI::GetParam<int>("k");
+  if (CLI::GetParam<int>("k") < 0)
+    Log::Fatal << "Invalid k: " << CLI::GetParam<int>("k") << "; must be "
+        << "greater than 0." << endl;
+  const size_t k = (size_t) CLI::GetParam<int>("k");
+
+  if (k == 0 && !CLI::HasParam("output_model"))
+    Log::Warn << "Neither --k nor --output_model is specified; no search will "
+        << "be performed and the model will not be saved." << endl;
 
   // Runtime parameters.
   const bool naive = CLI::HasParam("naive");
@@ -161,6 +114,12 @@ int main(int argc, char** argv)
   // For cover tree construction.
   const double base = CLI::GetParam<double>("base");
 
+  // Sanity check on the number of threads.
+  if (CLI::GetParam<int>("threads") < 0)
+    Log::Fatal << "Invalid number of threads: " << CLI::GetParam<int>("threads")
+        << ".  Must be greater than or equal to 0." << endl;
+  const size_t threads = (size_t) CLI::GetParam<int>("threads");
+
   // Kernel parameters.
   const string kernelType = CLI::GetParam<string>("kernel");
   const double degree = CLI::GetParam<double>("degree");
@@ -168,162 +127,136 @@ int main(int argc, char** argv)
   const double bandwidth = CLI::GetParam<double>("bandwidth");
   const double scale = CLI::GetParam<double>("scale");
 
-  // The datasets.  The query matrix may never be used.
+  // The reference set must outlive the model, which does not copy it.
   arma::mat referenceData;
-  arma::mat queryData;
-
-  data::Load(referenceFile, referenceData, true);
-
-  Log::Info << "Loaded reference data from '" << referenceFile << "' ("
-      << referenceData.n_rows << " x " << referenceData.n_cols << ")." << endl;
-
-  // Sanity check on k value.
-  if (k > referenceData.n_cols)
-  {
-    Log::Fatal << "Invalid k: " << k << "; must be greater than 0 and less ";
-    Log::Fatal << "than or equal to the number of reference points (";
-    Log::Fatal << referenceData.n_cols << ")." << endl;
-  }
+  FastMKSModel model;
 
-  // Check on kernel type.
-  if ((kernelType != "linear") && (kernelType != "polynomial") &&
-      (kernelType != "cosine") && (kernelType != "gaussian") &&
-      (kernelType != "graph") && (kernelType != "approxGraph") &&
-      (kernelType != "triangular") && (kernelType != "hyptan") &&
-      (kernelType != "inv-mq") && (kernelType != "epanechnikov"))
+  if (CLI::HasParam("reference_file"))
   {
-    Log::Fatal << "Invalid kernel type: '" << kernelType << "'; must be ";
-    Log::Fatal << "'linear' or 'polynomial'." << endl;
-  }
+    data::Load(referenceFile, referenceData, true);
 
-  // Load the query matrix, if we can.
-  if (CLI::HasParam("query_file"))
-  {
-    const string queryFile = CLI::GetParam<string>("query_file");
-    data::Load(queryFile, queryData, true);
+    Log::Info << "Loaded reference data from '" << referenceFile << "' ("
+        << referenceData.n_rows << " x " << referenceData.n_cols << ")."
+        << endl;
 
-    Log::Info << "Loaded query data from '" << queryFile << "' ("
-        << queryData.n_rows << " x " << queryData.n_cols << ")." << endl;
-  }
-  else
-  {
-    Log::Info << "Using reference dataset as query dataset (--query_file not "
-        << "specified)." << endl;
-  }
-
-  // Naive mode overrides single mode.
-  if (naive && single)
-  {
-    Log::Warn << "--single ignored because --naive is present." << endl;
-  }
+    // Sanity check on k value.
+    if (k > referenceData.n_cols)
+    {
+      Log::Fatal << "Invalid k: " << k << "; must be greater than 0 and less ";
+      Log::Fatal << "than or equal to the number of reference points (";
+      Log::Fatal << referenceData.n_cols << ")." << endl;
+    }
 
-  // Matrices for output storage.
-  arma::Mat<size_t> indices;
-  arma::mat kernels;
+    // Naive mode overrides single mode.
+    if (naive && single)
+    {
+      Log::Warn << "--single ignored because --naive is present." << endl;
+    }
 
-  // Construct FastMKS object.
-  if (queryData.n_elem == 0)
-  {
+    // Build the model with the right kernel.
     if (kernelType == "linear")
     {
+      model.KernelType() = FastMKSModel::LINEAR_KERNEL;
       LinearKernel lk;
-      RunFastMKS<LinearKernel>(referenceData, single, naive, base, k, indices,
-          kernels, lk);
+      model.BuildModel(referenceData, lk, single, naive, base);
     }
     else if (kernelType == "polynomial")
     {
-
+      model.KernelType() = FastMKSModel::POLYNOMIAL_KERNEL;
       PolynomialKernel pk(degree, offset);
-      RunFastMKS<PolynomialKernel>(referenceData, single, naive, base, k,
-          indices, kernels, pk);
+      model.BuildModel(referenceData, pk, single, naive, base);
     }
     else if (kernelType == "cosine")
     {
+      model.KernelType() = FastMKSModel::COSINE_DISTANCE;
       CosineDistance cd;
-      RunFastMKS<CosineDistance>(referenceData, single, naive, base, k, indices,
-          kernels, cd);
+      model.BuildModel(referenceData, cd, single, naive, base);
     }
     else if (kernelType == "gaussian")
     {
+      model.KernelType() = FastMKSModel::GAUSSIAN_KERNEL;
       GaussianKernel gk(bandwidth);
-      RunFastMKS<GaussianKernel>(referenceData, single, naive, base, k, indices,
-          kernels, gk);
+      model.BuildModel(referenceData, gk, single, naive, base);
     }
     else if (kernelType == "epanechnikov")
     {
+      model.KernelType() = FastMKSModel::EPANECHNIKOV_KERNEL;
       EpanechnikovKernel ek(bandwidth);
-      RunFastMKS<EpanechnikovKernel>(referenceData, single, naive, base, k,
-          indices, kernels, ek);
+      model.BuildModel(referenceData, ek, single, naive, base);
     }
     else if (kernelType == "triangular")
     {
+      model.KernelType() = FastMKSModel::TRIANGULAR_KERNEL;
       TriangularKernel tk(bandwidth);
-      RunFastMKS<TriangularKernel>(referenceData, single, naive, base, k,
-          indices, kernels, tk);
+      model.BuildModel(referenceData, tk, single, naive, base);
     }
     else if (kernelType == "hyptan")
     {
+      model.KernelType() = FastMKSModel::HYPTAN_KERNEL;
       HyperbolicTangentKernel htk(scale, offset);
-      RunFastMKS<HyperbolicTangentKernel>(referenceData, single, naive, base, k,
-          indices, kernels, htk);
+      model.BuildModel(referenceData, htk, single, naive, base);
+    }
+    else
+    {
+      Log::Fatal << "Invalid kernel type: '" << kernelType << "'; must be "
+          << "'linear', 'polynomial', 'cosine', 'gaussian', 'epanechnikov', "
+          << "'triangular', or 'hyptan'." << endl;
     }
   }
   else
   {
-    if (kernelType == "linear")
-    {
-      LinearKernel lk;
-      RunFastMKS<LinearKernel>(referenceData, queryData, single, naive, base, k,
-          indices, kernels, lk);
-    }
-    else if (kernelType == "polynomial")
-    {
-      PolynomialKernel pk(degree, offset);
-      RunFastMKS<PolynomialKernel>(referenceData, queryData, single, naive,
-          base, k, indices, kernels, pk);
-    }
-    else if (kernelType == "cosine")
-    {
-      CosineDistance cd;
-      RunFastMKS<CosineDistance>(referenceData, queryData, single, naive, base,
-          k, indices, kernels, cd);
-    }
-    else if (kernelType == "gaussian")
+    Log::Info << "Loading FastMKS model from '" << inputModelFile << "'."
+        << endl;
+    data::Load(inputModelFile, "fastmks_model", model, true);
+
+    if (naive || single)
+      Log::Warn << "--naive and --single are ignored when --input_model is "
+          << "specified; the search mode stored in the model is used." << endl;
+  }
+
+  model.NumThreads(threads);
+
+  if (k > 0)
+  {
+    // Matrices for output storage.
+    arma::Mat<size_t> indices;
+    arma::mat kernels;
+
+    // Search with the query matrix, if we have one.
+    if (CLI::HasParam("query_file"))
     {
-      GaussianKernel gk(bandwidth);
-      RunFastMKS<GaussianKernel>(referenceData, queryData, single, naive, base,
-          k, indices, kernels, gk);
+      const string queryFile = CLI::GetParam<string>("query_file");
+      arma::mat queryData;
+      data::Load(queryFile, queryData, true);
+
+      Log::Info << "Loaded query data from '" << queryFile << "' ("
+          << queryData.n_rows << " x " << queryData.n_cols << ")." << endl;
+
+      model.Search(queryData, k, indices, kernels, base);
     }
-    else if (kernelType == "epanechnikov")
+    else
     {
-      EpanechnikovKernel ek(bandwidth);
-      RunFastMKS<EpanechnikovKernel>(referenceData, queryData, single, naive,
-          base, k, indices, kernels, ek);
+      Log::Info << "Using reference dataset as query dataset (--query_file "
+          << "not specified)." << endl;
+
+      model.Search(k, indices, kernels);
     }
-    else if (kernelType == "triangular")
+
+    // Save output, if we were asked to.
+    if (CLI::HasParam("kernels_file"))
     {
-      TriangularKernel tk(bandwidth);
-      RunFastMKS<TriangularKernel>(referenceData, queryData, single, naive,
-          base, k, indices, kernels, tk);
+      const string kernelsFile = CLI::GetParam<string>("kernels_file");
+      data::Save(kernelsFile, kernels, false);
     }
-    else if (kernelType == "hyptan")
+
+    if (CLI::HasParam("indices_file"))
     {
-      HyperbolicTangentKernel htk(scale, offset);
-      RunFastMKS<HyperbolicTangentKernel>(referenceData, queryData, single,
-          naive, base, k, indices, kernels, htk);
+      const string indicesFile = CLI::GetParam<string>("indices_file");
+      data::Save(indicesFile, indices, false);
     }
   }
 
-  // Save output, if we were asked to.
-  if (CLI::HasParam("kernels_file"))
-  {
-    const string kernelsFile = CLI::GetParam<string>("kernels_file");
-    data::Save(kernelsFile, kernels, false);
-  }
-
-  if (CLI::HasParam("indices_file"))
-  {
-    const string indicesFile = CLI::GetParam<string>("indices_file");
-    data::Save(indicesFile, indices, false);
-  }
+  // Save the model, if requested.
+  if (CLI::HasParam("output_model"))
+    data::Save(outputModelFile, "fastmks_model", model);
 }
@@ -0,0 +1,172 @@
+/**
+ * @file fastmks_model.hpp
+ *
+ * A utility struct to contain all the possible FastMKS models, so that the
+ * kernel type can be chosen at runtime and the model can be saved and loaded
+ * by the command-line program.
+ */
+#ifndef __MLPACK_METHODS_FASTMKS_FASTMKS_MODEL_HPP
+#define __MLPACK_METHODS_FASTMKS_FASTMKS_MODEL_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/kernels/linear_kernel.hpp>
+#include <mlpack/core/kernels/polynomial_kernel.hpp>
+#include <mlpack/core/kernels/cosine_distance.hpp>
+#include <mlpack/core/kernels/gaussian_kernel.hpp>
+#include <mlpack/core/kernels/epanechnikov_kernel.hpp>
+#include <mlpack/core/kernels/hyperbolic_tangent_kernel.hpp>
+#include <mlpack/core/kernels/triangular_kernel.hpp>
+
+#include "fastmks.hpp"
+
+namespace mlpack {
+namespace fastmks {
+
+/**
+ * A wrapper around the FastMKS class for each of the supported kernels.  Only
+ * one of the FastMKS objects is ever non-NULL; which one is given by
+ * KernelType().
+ */
+class FastMKSModel
+{
+ public:
+  //! A list of all the kernels we support.
+  enum KernelTypes
+  {
+    LINEAR_KERNEL,
+    POLYNOMIAL_KERNEL,
+    COSINE_DISTANCE,
+    GAUSSIAN_KERNEL,
+    EPANECHNIKOV_KERNEL,
+    TRIANGULAR_KERNEL,
+    HYPTAN_KERNEL
+  };
+
+  /**
+   * Create the FastMKSModel with the given kernel type.  BuildModel() must be
+   * called before the model can be used.
+   */
+  FastMKSModel(const int kernelType = LINEAR_KERNEL);
+
+  //! Clean memory.
+  ~FastMKSModel();
+
+  /**
+   * Build the model on the given reference set.  The kernel type of the given
+   * kernel must match the kernel type of the model.  If the model is not in
+   * naive mode, a cover tree with the given base is built on the data.
+   *
+   * @param referenceData Set of reference points.  As with FastMKS itself, this
+   *     is not copied, so it must remain valid as long as the model is used.
+   * @param kernel Initialized kernel.
+   * @param singleMode Whether or not to run single-tree search.
+   * @param naive Whether or not to run brute-force (naive) search.
+   * @param base Base to use for the cover tree.
+   */
+  template<typename TKernelType>
+  void BuildModel(const arma::mat& referenceData,
+                  TKernelType& kernel,
+                  const bool singleMode,
+                  const bool naive,
+                  const double base);
+
+  //! Get the kernel type.
+  int KernelType() const { return kernelType; }
+  //! Modify the kernel type.
+  int& KernelType() { return kernelType; }
+
+  //! Get whether or not naive search is used.
+  bool Naive() const;
+  //! Get whether or not single-tree search is used.
+  bool SingleMode() const;
+
+  //! Set the number of threads to use for search (0 means as many as OpenMP
+  //! allows).
+  void NumThreads(const size_t threads);
+
+  /**
+   * Search with a different query set.
+   *
+   * @param querySet Set to search with.
+   * @param k Number of max-kernel candidates to search for.
+   * @param indices A matrix in which to store the indices of max-kernel
+   *     candidates.
+   * @param kernels A matrix in which to store the max-kernel candidate kernel
+   *     values.
+   * @param base Base to use for cover tree building (if in dual-tree search
+   *     mode).
+   */
+  void Search(const arma::mat& querySet,
+              const size_t k,
+              arma::Mat<size_t>& indices,
+              arma::mat& kernels,
+              const double base);
+
+  /**
+   * Search with the reference set as the query set.
+   *
+   * @param k Number of max-kernel candidates to search for.
+   * @param indices A matrix in which to store the indices of max-kernel
+   *     candidates.
+   * @param kernels A matrix in which to store the max-kernel candidate kernel
+   *     values.
+   */
+  void Search(const size_t k,
+              arma::Mat<size_t>& indices,
+              arma::mat& kernels);
+
+  /**
+   * Serialize the model.
+   */
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */);
+
+ private:
+  //! The type of kernel we are using.
+  int kernelType;
+
+  //! This will only be non-NULL if this is the type of kernel we are using.
+  FastMKS<kernel::LinearKernel>* linear;
+  //! This will only be non-NULL if this is the type of kernel we are using.
+  FastMKS<kernel::PolynomialKernel>* polynomial;
+  //! This will only be non-NULL if this is the type of kernel we are using.
+  FastMKS<kernel::CosineDistance>* cosine;
+  //! This will only be non-NULL if this is the type of kernel we are using.
+  FastMKS<kernel::GaussianKernel>* gaussian;
+  //! This will only be non-NULL if this is the type of kernel we are using.
+  FastMKS<kernel::EpanechnikovKernel>* epan;
+  //! This will only be non-NULL if this is the type of kernel we are using.
+  FastMKS<kernel::TriangularKernel>* triangular;
+  //! This will only be non-NULL if this is the type of kernel we are using.
+  FastMKS<kernel::HyperbolicTangentKernel>* hyptan;
+
+  //! Build the model for a specific FastMKS type.
+  template<typename TKernelType>
+  void BuildFastMKSModel(FastMKS<TKernelType>& f,
+                         TKernelType& kernel,
+                         const arma::mat& referenceData,
+                         const double base);
+
+  //! Throw an exception: the given kernel does not match the FastMKS type.
+  template<typename FastMKSType, typename TKernelType>
+  void BuildFastMKSModel(FastMKSType& f,
+                         TKernelType& kernel,
+                         const arma::mat& referenceData,
+                         const double base);
+
+  //! Search with a query set for a specific FastMKS type.
+  template<typename FastMKSType>
+  void Search(FastMKSType& f,
+              const arma::mat& querySet,
+              const size_t k,
+              arma::Mat<size_t>& indices,
+              arma::mat& kernels,
+              const double base);
+};
+
+} // namespace fastmks
+} // namespace mlpack
+
+#include "fastmks_model_impl.hpp"
+
+#endif
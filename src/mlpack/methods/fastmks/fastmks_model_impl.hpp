@@ -0,0 +1,201 @@
+/**
+ * @file fastmks_model_impl.hpp
+ *
+ * Implementation of templated functions of FastMKSModel.
+ */
+#ifndef __MLPACK_METHODS_FASTMKS_FASTMKS_MODEL_IMPL_HPP
+#define __MLPACK_METHODS_FASTMKS_FASTMKS_MODEL_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "fastmks_model.hpp"
+
+namespace mlpack {
+namespace fastmks {
+
+template<typename TKernelType>
+void FastMKSModel::BuildFastMKSModel(FastMKS<TKernelType>& f,
+                                     TKernelType& kernel,
+                                     const arma::mat& referenceData,
+                                     const double base)
+{
+  // Set the kernel first, so that a tree built here points at the metric held
+  // by the FastMKS object.
+  f.Metric() = metric::IPMetric<TKernelType>(kernel);
+
+  if (f.Naive())
+  {
+    f.Train(referenceData, kernel);
+  }
+  else
+  {
+    // Build the tree with the specified base.  FastMKS takes ownership of it.
+    Timer::Start("tree_building");
+    typename FastMKS<TKernelType>::Tree* tree =
+        new typename FastMKS<TKernelType>::Tree(referenceData, f.Metric(),
+        base);
+    Timer::Stop("tree_building");
+
+    f.Train(tree);
+  }
+}
+
+template<typename FastMKSType, typename TKernelType>
+void FastMKSModel::BuildFastMKSModel(FastMKSType& /* f */,
+                                     TKernelType& /* kernel */,
+                                     const arma::mat& /* referenceData */,
+                                     const double /* base */)
+{
+  throw std::invalid_argument("FastMKSModel::BuildModel(): given kernel type "
+      "is not equal to kernel type of the model!");
+}
+
+template<typename TKernelType>
+void FastMKSModel::BuildModel(const arma::mat& referenceData,
+                              TKernelType& kernel,
+                              const bool singleMode,
+                              const bool naive,
+                              const double base)
+{
+  // Clean memory if necessary.
+  delete linear;
+  delete polynomial;
+  delete cosine;
+  delete gaussian;
+  delete epan;
+  delete triangular;
+  delete hyptan;
+
+  linear = NULL;
+  polynomial = NULL;
+  cosine = NULL;
+  gaussian = NULL;
+  epan = NULL;
+  triangular = NULL;
+  hyptan = NULL;
+
+  // Instantiate the right model.
+  switch (kernelType)
+  {
+    case LINEAR_KERNEL:
+      linear = new FastMKS<kernel::LinearKernel>(singleMode, naive);
+      BuildFastMKSModel(*linear, kernel, referenceData, base);
+      break;
+
+    case POLYNOMIAL_KERNEL:
+      polynomial = new FastMKS<kernel::PolynomialKernel>(singleMode, naive);
+      BuildFastMKSModel(*polynomial, kernel, referenceData, base);
+      break;
+
+    case COSINE_DISTANCE:
+      cosine = new FastMKS<kernel::CosineDistance>(singleMode, naive);
+      BuildFastMKSModel(*cosine, kernel, referenceData, base);
+      break;
+
+    case GAUSSIAN_KERNEL:
+      gaussian = new FastMKS<kernel::GaussianKernel>(singleMode, naive);
+      BuildFastMKSModel(*gaussian, kernel, referenceData, base);
+      break;
+
+    case EPANECHNIKOV_KERNEL:
+      epan = new FastMKS<kernel::EpanechnikovKernel>(singleMode, naive);
+      BuildFastMKSModel(*epan, kernel, referenceData, base);
+      break;
+
+    case TRIANGULAR_KERNEL:
+      triangular = new FastMKS<kernel::TriangularKernel>(singleMode, naive);
+      BuildFastMKSModel(*triangular, kernel, referenceData, base);
+      break;
+
+    case HYPTAN_KERNEL:
+      hyptan = new FastMKS<kernel::HyperbolicTangentKernel>(singleMode, naive);
+      BuildFastMKSModel(*hyptan, kernel, referenceData, base);
+      break;
+  }
+}
+
+template<typename FastMKSType>
+void FastMKSModel::Search(FastMKSType& f,
+                          const arma::mat& querySet,
+                          const size_t k,
+                          arma::Mat<size_t>& indices,
+                          arma::mat& kernels,
+                          const double base)
+{
+  if (f.Naive() || f.SingleMode())
+  {
+    f.Search(querySet, k, indices, kernels);
+  }
+  else
+  {
+    Timer::Start("tree_building");
+    typename FastMKSType::Tree queryTree(querySet, f.Metric(), base);
+    Timer::Stop("tree_building");
+
+    f.Search(&queryTree, k, indices, kernels);
+  }
+}
+
+template<typename Archive>
+void FastMKSModel::Serialize(Archive& ar, const unsigned int /* version */)
+{
+  using data::CreateNVP;
+
+  ar & CreateNVP(kernelType, "kernelType");
+
+  if (Archive::is_loading::value)
+  {
+    // Clean memory.
+    delete linear;
+    delete polynomial;
+    delete cosine;
+    delete gaussian;
+    delete epan;
+    delete triangular;
+    delete hyptan;
+
+    linear = NULL;
+    polynomial = NULL;
+    cosine = NULL;
+    gaussian = NULL;
+    epan = NULL;
+    triangular = NULL;
+    hyptan = NULL;
+  }
+
+  // Serialize the correct model.
+  switch (kernelType)
+  {
+    case LINEAR_KERNEL:
+      ar & CreateNVP(linear, "linear_fastmks");
+      break;
+
+    case POLYNOMIAL_KERNEL:
+      ar & CreateNVP(polynomial, "polynomial_fastmks");
+      break;
+
+    case COSINE_DISTANCE:
+      ar & CreateNVP(cosine, "cosine_fastmks");
+      break;
+
+    case GAUSSIAN_KERNEL:
+      ar & CreateNVP(gaussian, "gaussian_fastmks");
+      break;
+
+    case EPANECHNIKOV_KERNEL:
+      ar & CreateNVP(epan, "epan_fastmks");
+      break;
+
+    case TRIANGULAR_KERNEL:
+      ar & CreateNVP(triangular, "triangular_fastmks");
+      break;
+
+    case HYPTAN_KERNEL:
+      ar & CreateNVP(hyptan, "hyptan_fastmks");
+      break;
+  }
+}
+
+} // namespace fastmks
+} // namespace mlpack
+
+#endif
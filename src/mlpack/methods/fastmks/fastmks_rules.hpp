@@ -12,6 +12,8 @@
 
 #include "../neighbor_search/ns_traversal_info.hpp"
 
+#include <unordered_map>
+
 namespace mlpack {
 namespace fastmks {
 
@@ -22,11 +24,64 @@ template<typename KernelType, typename TreeType>
 class FastMKSRules
 {
  public:
+  /**
+   * Construct the rules object.  During single-tree search, the last kernel
+   * evaluation with each reference node is normally cached in the node's
+   * statistic.  If several rules objects search the same reference tree at
+   * the same time (on different threads), set localLastKernels to true so
+   * that each rules object keeps those evaluations to itself.
+   *
+   * @param referenceSet Set of reference points.
+   * @param querySet Set of query points.
+   * @param indices Matrix to store resulting indices in.
+   * @param products Matrix to store resulting kernel values in.
+   * @param kernel Instantiated kernel.
+   * @param localLastKernels Whether to cache the last kernel evaluation with
+   *     each reference node in this object instead of in the tree.
+   */
+  FastMKSRules(const typename TreeType::Mat& referenceSet,
+               const typename TreeType::Mat& querySet,
+               arma::Mat<size_t>& indices,
+               arma::mat& products,
+               KernelType& kernel,
+               const bool localLastKernels = false);
+
+  /**
+   * Construct the rules object with self-kernels that were already computed
+   * with SelfKernels().  They are not copied, so they must stay valid for the
+   * lifetime of this object.  This is useful when several rules objects search
+   * with the same sets, so the self-kernels are only computed once.
+   *
+   * @param referenceSet Set of reference points.
+   * @param querySet Set of query points.
+   * @param indices Matrix to store resulting indices in.
+   * @param products Matrix to store resulting kernel values in.
+   * @param kernel Instantiated kernel.
+   * @param queryKernels Self-kernels of the query points.
+   * @param referenceKernels Self-kernels of the reference points.
+   * @param localLastKernels Whether to cache the last kernel evaluation with
+   *     each reference node in this object instead of in the tree.
+   */
   FastMKSRules(const typename TreeType::Mat& referenceSet,
                const typename TreeType::Mat& querySet,
                arma::Mat<size_t>& indices,
                arma::mat& products,
-               KernelType& kernel);
+               KernelType& kernel,
+               const arma::vec& queryKernels,
+               const arma::vec& referenceKernels,
+               const bool localLastKernels = false);
+
+  /**
+   * Compute the self-kernel of each point of the given set (|| p || for each
+   * p, in the space induced by the kernel).
+   *
+   * @param dataset Set of points.
+   * @param kernel Instantiated kernel.
+   * @param selfKernels Vector to store the self-kernels in.
+   */
+  static void SelfKernels(const typename TreeType::Mat& dataset,
+                          KernelType& kernel,
+                          arma::vec& selfKernels);
 
   //! Compute the base case (kernel value) between two points.
   double BaseCase(const size_t queryIndex, const size_t referenceIndex);
@@ -122,6 +177,17 @@ class FastMKSRules
   //! The last kernel evaluation resulting from BaseCase().
   double lastKernel;
 
+  //! If true, lastKernels is used instead of the reference node statistics.
+  bool localLastKernels;
+  //! The last kernel evaluation with each reference node, if
+  //! localLastKernels is true.
+  std::unordered_map<const TreeType*, double> lastKernels;
+
+  //! Get the last kernel evaluation with the given reference node.
+  double LastKernel(const TreeType& referenceNode) const;
+  //! Store the last kernel evaluation with the given reference node.
+  void LastKernel(TreeType& referenceNode, const double kernelEval);
+
   //! Calculate the bound for a given query node.
   double CalculateBound(TreeType& queryNode) const;
 
@@ -19,7 +19,8 @@ FastMKSRules<KernelType, TreeType>::FastMKSRules(
     const typename TreeType::Mat& querySet,
     arma::Mat<size_t>& indices,
     arma::mat& products,
-    KernelType& kernel) :
+    KernelType& kernel,
+    const bool localLastKernels) :
     referenceSet(referenceSet),
     querySet(querySet),
     indices(indices),
@@ -28,26 +29,64 @@ FastMKSRules<KernelType, TreeType>::FastMKSRules(
     lastQueryIndex(-1),
     lastReferenceIndex(-1),
     lastKernel(0.0),
+    localLastKernels(localLastKernels),
     baseCases(0),
     scores(0)
 {
   // Precompute each self-kernel.
-  queryKernels.set_size(querySet.n_cols);
-  for (size_t i = 0; i < querySet.n_cols; ++i)
-    queryKernels[i] = sqrt(kernel.Evaluate(querySet.col(i),
-                                           querySet.col(i)));
+  SelfKernels(querySet, kernel, queryKernels);
+  SelfKernels(referenceSet, kernel, referenceKernels);
 
-  referenceKernels.set_size(referenceSet.n_cols);
-  for (size_t i = 0; i < referenceSet.n_cols; ++i)
-    referenceKernels[i] = sqrt(kernel.Evaluate(referenceSet.col(i),
-                                               referenceSet.col(i)));
+  // Set to invalid memory, so that the first node combination does not try to
+  // dereference null pointers.
+  traversalInfo.LastQueryNode() = (TreeType*) this;
+  traversalInfo.LastReferenceNode() = (TreeType*) this;
+}
 
+template<typename KernelType, typename TreeType>
+FastMKSRules<KernelType, TreeType>::FastMKSRules(
+    const typename TreeType::Mat& referenceSet,
+    const typename TreeType::Mat& querySet,
+    arma::Mat<size_t>& indices,
+    arma::mat& products,
+    KernelType& kernel,
+    const arma::vec& queryKernels,
+    const arma::vec& referenceKernels,
+    const bool localLastKernels) :
+    referenceSet(referenceSet),
+    querySet(querySet),
+    indices(indices),
+    products(products),
+    // The self-kernels are only read, so they can alias the given vectors.
+    queryKernels(const_cast<double*>(queryKernels.memptr()),
+        queryKernels.n_elem, false, true),
+    referenceKernels(const_cast<double*>(referenceKernels.memptr()),
+        referenceKernels.n_elem, false, true),
+    kernel(kernel),
+    lastQueryIndex(-1),
+    lastReferenceIndex(-1),
+    lastKernel(0.0),
+    localLastKernels(localLastKernels),
+    baseCases(0),
+    scores(0)
+{
   // Set to invalid memory, so that the first node combination does not try to
   // dereference null pointers.
   traversalInfo.LastQueryNode() = (TreeType*) this;
   traversalInfo.LastReferenceNode() = (TreeType*) this;
 }
 
+template<typename KernelType, typename TreeType>
+void FastMKSRules<KernelType, TreeType>::SelfKernels(
+    const typename TreeType::Mat& dataset,
+    KernelType& kernel,
+    arma::vec& selfKernels)
+{
+  selfKernels.set_size(dataset.n_cols);
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+    selfKernels[i] = sqrt(kernel.Evaluate(dataset.col(i), dataset.col(i)));
+}
+
 template<typename KernelType, typename TreeType>
 inline force_inline
 double FastMKSRules<KernelType, TreeType>::BaseCase(
@@ -111,7 +150,7 @@ double FastMKSRules<KernelType, TreeType>::Score(const size_t queryIndex,
     double maxKernelBound;
     const double parentDist = referenceNode.ParentDistance();
     const double combinedDistBound = parentDist + furthestDist;
-    const double lastKernel = referenceNode.Parent()->Stat().LastKernel();
+    const double lastKernel = LastKernel(*referenceNode.Parent());
     if (kernel::KernelTraits<KernelType>::IsNormalized)
     {
       const double squaredDist = std::pow(combinedDistBound, 2.0);
@@ -148,7 +187,7 @@ double FastMKSRules<KernelType, TreeType>::Score(const size_t queryIndex,
         referenceNode.Parent() != NULL &&
         referenceNode.Point(0) == referenceNode.Parent()->Point(0))
     {
-      kernelEval = referenceNode.Parent()->Stat().LastKernel();
+      kernelEval = LastKernel(*referenceNode.Parent());
     }
     else
     {
@@ -163,7 +202,7 @@ double FastMKSRules<KernelType, TreeType>::Score(const size_t queryIndex,
     kernelEval = kernel.Evaluate(querySet.col(queryIndex), refCenter);
   }
 
-  referenceNode.Stat().LastKernel() = kernelEval;
+  LastKernel(referenceNode, kernelEval);
 
   double maxKernel;
   if (kernel::KernelTraits<KernelType>::IsNormalized)
@@ -401,6 +440,33 @@ double FastMKSRules<KernelType, TreeType>::Rescore(TreeType& queryNode,
   return ((1.0 / oldScore) >= bestKernel) ? oldScore : DBL_MAX;
 }
 
+template<typename KernelType, typename TreeType>
+inline double FastMKSRules<KernelType, TreeType>::LastKernel(
+    const TreeType& referenceNode) const
+{
+  if (!localLastKernels)
+    return referenceNode.Stat().LastKernel();
+
+  // If the node has never been scored by this object (the root may not be, for
+  // some traversals), fall back to the statistic, which is not modified when
+  // localLastKernels is true.
+  typename std::unordered_map<const TreeType*, double>::const_iterator it =
+      lastKernels.find(&referenceNode);
+  return (it == lastKernels.end()) ? referenceNode.Stat().LastKernel() :
+      (*it).second;
+}
+
+template<typename KernelType, typename TreeType>
+inline void FastMKSRules<KernelType, TreeType>::LastKernel(
+    TreeType& referenceNode,
+    const double kernelEval)
+{
+  if (localLastKernels)
+    lastKernels[&referenceNode] = kernelEval;
+  else
+    referenceNode.Stat().LastKernel() = kernelEval;
+}
+
 /**
  * Calculate the bound for the given query node.  This bound represents the
  * minimum value which a node combination must achieve to guarantee an
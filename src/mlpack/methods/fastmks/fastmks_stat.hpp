@@ -93,6 +93,25 @@ class FastMKSStat
   //! evaluation.
   void*& LastKernelNode() { return lastKernelNode; }
 
+  /**
+   * Serialize the statistic.  The self-kernel is saved, so it does not need to
+   * be recomputed when a tree is loaded.  The bound and the last kernel
+   * evaluation are only meaningful during a search, so they are reset.
+   */
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */)
+  {
+    ar & data::CreateNVP(selfKernel, "selfKernel");
+
+    // Void pointers are not serialized, so we just set it to NULL.
+    if (Archive::is_loading::value)
+    {
+      bound = -DBL_MAX;
+      lastKernel = 0.0;
+      lastKernelNode = NULL;
+    }
+  }
+
  private:
   //! The bound for pruning.
   double bound;
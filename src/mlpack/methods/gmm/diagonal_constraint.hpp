@@ -26,6 +26,9 @@ class DiagonalConstraint
     covariance = arma::diagmat(diagonal);
   }
 
+  //! A vector of variances is already diagonal, so there is nothing to do.
+  static void ApplyConstraint(const arma::vec& /* diagCovariance */) { }
+
   //! Serialize the constraint (which holds nothing, so, nothing to do).
   template<typename Archive>
   static void Serialize(Archive& /* ar */, const unsigned int /* version */) { }
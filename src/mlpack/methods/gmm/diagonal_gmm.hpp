@@ -0,0 +1,47 @@
+/**
+ * @file diagonal_gmm.hpp
+ *
+ * Template typedefs for Gaussian mixture models whose components have diagonal
+ * covariance matrices.
+ */
+#ifndef __MLPACK_METHODS_GMM_DIAGONAL_GMM_HPP
+#define __MLPACK_METHODS_GMM_DIAGONAL_GMM_HPP
+
+#include <mlpack/core.hpp>
+
+#include "gmm.hpp"
+
+namespace mlpack {
+namespace gmm {
+
+/**
+ * A template typedef for the EMFit fitting mechanism with components that have
+ * diagonal covariances (distribution::DiagonalGaussianDistribution).  Only the
+ * variances of each component are accumulated and updated, so each iteration
+ * takes O(d) time for each point and component.
+ */
+template<typename InitialClusteringType = kmeans::KMeans<>,
+         typename CovarianceConstraintPolicy = PositiveDefiniteConstraint>
+using DiagonalEMFit = EMFit<InitialClusteringType, CovarianceConstraintPolicy,
+    distribution::DiagonalGaussianDistribution>;
+
+/**
+ * A template typedef for a Gaussian mixture model whose components have
+ * diagonal covariances.  Each component stores only its mean and its vector of
+ * variances (Component(i).Covariance() is that vector), instead of a d x d
+ * covariance matrix and its factors.  Otherwise, it is used in the same way as
+ * a GMM:
+ *
+ * @code
+ * DiagonalGMM<> g(512, 1000);
+ * g.Estimate(data);
+ * @endcode
+ */
+template<typename FittingType = DiagonalEMFit<>>
+using DiagonalGMM = GMM<FittingType,
+    distribution::DiagonalGaussianDistribution>;
+
+} // namespace gmm
+} // namespace mlpack
+
+#endif
@@ -71,6 +71,20 @@ class EigenvalueRatioConstraint
     covariance = eigenvectors * arma::diagmat(eigenvalues) * eigenvectors.t();
   }
 
+  /**
+   * Apply the eigenvalue ratio constraint to the given vector of variances (the
+   * diagonal of a diagonal covariance matrix).  The variances are the
+   * eigenvalues, so they are sorted in the same order as the eigenvalues are
+   * above, and each one is replaced.
+   */
+  void ApplyConstraint(arma::vec& diagCovariance) const
+  {
+    const arma::uvec order = arma::sort_index(diagCovariance);
+    const double first = diagCovariance[order[0]];
+    for (size_t i = 0; i < order.n_elem; ++i)
+      diagCovariance[order[i]] = first * ratios[i];
+  }
+
   //! Serialize the constraint.
   template<typename Archive>
   void Serialize(Archive& ar, const unsigned int /* version */)
@@ -31,9 +31,27 @@ namespace gmm {
  *
  * This method should create 'clusters' clusters, and return the assignment of
  * each point to a cluster.
+ *
+ * The components are of type Distribution, which may be
+ * distribution::GaussianDistribution (full covariance) or
+ * distribution::DiagonalGaussianDistribution (diagonal covariance).  For
+ * diagonal Gaussians, only the variances are accumulated and updated, so each
+ * iteration takes O(d) time per point and component instead of O(d^2).  The
+ * CovarianceConstraintPolicy must then also be able to constrain a vector of
+ * variances.
+ *
+ * Each iteration of EM is spread across NumThreads() threads with OpenMP.  The
+ * observations are split into one contiguous shard per thread; each thread
+ * computes the responsibilities of the points of its shard (a chunk of points
+ * at a time, so that the full matrix of responsibilities is never stored) and
+ * accumulates the weighted count, sum and scatter of every component.  The
+ * partial statistics are then reduced in shard order, so for a given number of
+ * threads the result is deterministic.  Each thread holds a d x d scatter
+ * matrix (or d variances) for every component.
  */
 template<typename InitialClusteringType = kmeans::KMeans<>,
-         typename CovarianceConstraintPolicy = PositiveDefiniteConstraint>
+         typename CovarianceConstraintPolicy = PositiveDefiniteConstraint,
+         typename Distribution = distribution::GaussianDistribution>
 class EMFit
 {
  public:
@@ -75,7 +93,7 @@ class EMFit
    *      clustering.
    */
   void Estimate(const arma::mat& observations,
-                std::vector<distribution::GaussianDistribution>& dists,
+                std::vector<Distribution>& dists,
                 arma::vec& weights,
                 const bool useInitialModel = false);
 
@@ -98,7 +116,7 @@ class EMFit
    */
   void Estimate(const arma::mat& observations,
                 const arma::vec& probabilities,
-                std::vector<distribution::GaussianDistribution>& dists,
+                std::vector<Distribution>& dists,
                 arma::vec& weights,
                 const bool useInitialModel = false);
 
@@ -122,6 +140,12 @@ class EMFit
   //! Modify the tolerance for the convergence of the EM algorithm.
   double& Tolerance() { return tolerance; }
 
+  //! Get the number of threads used for each iteration.
+  size_t NumThreads() const { return numThreads; }
+  //! Modify the number of threads used for each iteration (0 means as many as
+  //! OpenMP allows).
+  size_t& NumThreads() { return numThreads; }
+
   //! Serialize the fitter.
   template<typename Archive>
   void Serialize(Archive& ar, const unsigned int version);
@@ -138,9 +162,27 @@ class EMFit
    * @param weights Vector to store a priori weights in.
    */
   void InitialClustering(const arma::mat& observations,
-                         std::vector<distribution::GaussianDistribution>& dists,
+                         std::vector<Distribution>& dists,
                          arma::vec& weights);
 
+  /**
+   * Run one iteration of EM: compute the responsibilities of each component for
+   * each point, and then update the means, covariances and weights of the
+   * components from the weighted statistics of the points.  If probabilities is
+   * not empty, the responsibilities for each point are scaled by the
+   * probability of the point being from this mixture.
+   *
+   * @param observations List of observations.
+   * @param probabilities Probability of each point being from this model, or
+   *     an empty vector if every point is.
+   * @param dists Vector of distributions to update.
+   * @param weights Vector of a priori weights to update.
+   */
+  void Step(const arma::mat& observations,
+            const arma::vec& probabilities,
+            std::vector<Distribution>& dists,
+            arma::vec& weights);
+
   /**
    * Calculate the log-likelihood of a model.  Yes, this is reimplemented in the
    * GMM code.  Intuition suggests that the log-likelihood is not the best way
@@ -152,8 +194,7 @@ class EMFit
    * @param weights Vector of a priori weights.
    */
   double LogLikelihood(const arma::mat& data,
-                       const std::vector<distribution::GaussianDistribution>&
-                           dists,
+                       const std::vector<Distribution>& dists,
                        const arma::vec& weights) const;
 
   //! Maximum iterations of EM algorithm.
@@ -164,6 +205,37 @@ class EMFit
   InitialClusteringType clusterer;
   //! Object which applies constraints to the covariance matrix.
   CovarianceConstraintPolicy constraint;
+  //! Number of threads to use for each iteration.
+  size_t numThreads;
+
+  //! Get the number of threads that will actually be used.
+  size_t ThreadsToUse() const;
+
+  //! Add the weighted outer products of the given centered points to the
+  //! scatter matrix of a full-covariance Gaussian.
+  void AccumulateScatter(const distribution::GaussianDistribution& dist,
+                         const arma::mat& centered,
+                         const arma::mat& weighted,
+                         arma::mat& scatter);
+
+  //! Add the weighted squares of the given centered points to the scatter (a
+  //! single column) of a diagonal Gaussian.
+  void AccumulateScatter(const distribution::DiagonalGaussianDistribution& dist,
+                         const arma::mat& centered,
+                         const arma::mat& weighted,
+                         arma::mat& scatter);
+
+  //! Set the constrained covariance of a full-covariance Gaussian, given its
+  //! normalized scatter about a point which is shift away from its mean.
+  void UpdateCovariance(distribution::GaussianDistribution& dist,
+                        const arma::mat& scatter,
+                        const arma::vec& shift);
+
+  //! Set the constrained variances of a diagonal Gaussian, given its
+  //! normalized scatter about a point which is shift away from its mean.
+  void UpdateCovariance(distribution::DiagonalGaussianDistribution& dist,
+                        const arma::mat& scatter,
+                        const arma::vec& shift);
 };
 
 } // namespace gmm
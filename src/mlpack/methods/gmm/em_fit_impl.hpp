@@ -11,12 +11,20 @@
 // In case it hasn't been included yet.
 #include "em_fit.hpp"
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace gmm {
 
 //! Constructor.
-template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
-EMFit<InitialClusteringType, CovarianceConstraintPolicy>::EMFit(
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
+EMFit<InitialClusteringType,
+      CovarianceConstraintPolicy,
+      Distribution>::EMFit(
     const size_t maxIterations,
     const double tolerance,
     InitialClusteringType clusterer,
@@ -24,13 +32,18 @@ EMFit<InitialClusteringType, CovarianceConstraintPolicy>::EMFit(
     maxIterations(maxIterations),
     tolerance(tolerance),
     clusterer(clusterer),
-    constraint(constraint)
+    constraint(constraint),
+    numThreads(1)
 { /* Nothing to do. */ }
 
-template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
-void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
+void EMFit<InitialClusteringType,
+           CovarianceConstraintPolicy,
+           Distribution>::Estimate(
     const arma::mat& observations,
-    std::vector<distribution::GaussianDistribution>& dists,
+    std::vector<Distribution>& dists,
     arma::vec& weights,
     const bool useInitialModel)
 {
@@ -44,7 +57,6 @@ void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
       << l << std::endl;
 
   double lOld = -DBL_MAX;
-  arma::mat condProb(observations.n_cols, dists.size());
 
   // Iterate to update the model until no more improvement is found.
   size_t iteration = 1;
@@ -54,56 +66,9 @@ void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
         << "log-likelihood " << l << "." << std::endl;
 
     // Calculate the conditional probabilities of choosing a particular
-    // Gaussian given the observations and the present theta value.
-    for (size_t i = 0; i < dists.size(); i++)
-    {
-      // Store conditional probabilities into condProb vector for each
-      // Gaussian.  First we make an alias of the condProb vector.
-      arma::vec condProbAlias = condProb.unsafe_col(i);
-      dists[i].Probability(observations, condProbAlias);
-      condProbAlias *= weights[i];
-    }
-
-    // Normalize row-wise.
-    for (size_t i = 0; i < condProb.n_rows; i++)
-    {
-      // Avoid dividing by zero; if the probability for everything is 0, we
-      // don't want to make it NaN.
-      const double probSum = accu(condProb.row(i));
-      if (probSum != 0.0)
-        condProb.row(i) /= probSum;
-    }
-
-    // Store the sum of the probability of each state over all the observations.
-    arma::vec probRowSums = trans(arma::sum(condProb, 0 /* columnwise */));
-
-    // Calculate the new value of the means using the updated conditional
-    // probabilities.
-    for (size_t i = 0; i < dists.size(); i++)
-    {
-      // Don't update if there's no probability of the Gaussian having points.
-      if (probRowSums[i] != 0)
-        dists[i].Mean() = (observations * condProb.col(i)) / probRowSums[i];
-
-      // Calculate the new value of the covariances using the updated
-      // conditional probabilities and the updated means.
-      arma::mat tmp = observations - (dists[i].Mean() *
-          arma::ones<arma::rowvec>(observations.n_cols));
-      arma::mat tmpB = tmp % (arma::ones<arma::vec>(observations.n_rows) *
-          trans(condProb.col(i)));
-
-      // Don't update if there's no probability of the Gaussian having points.
-      if (probRowSums[i] != 0.0) {
-        arma::mat covariance = (tmp * trans(tmpB)) / probRowSums[i];
-        // Apply covariance constraint.
-        constraint.ApplyConstraint(covariance);
-        dists[i].Covariance(std::move(covariance));
-      }
-    }
-
-    // Calculate the new values for omega using the updated conditional
-    // probabilities.
-    weights = probRowSums / observations.n_cols;
+    // Gaussian given the observations and the present theta value, and use
+    // them to update the model.
+    Step(observations, arma::vec(), dists, weights);
 
     // Update values of l; calculate new log-likelihood.
     lOld = l;
@@ -113,11 +78,15 @@ void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
   }
 }
 
-template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
-void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
+void EMFit<InitialClusteringType,
+           CovarianceConstraintPolicy,
+           Distribution>::Estimate(
     const arma::mat& observations,
     const arma::vec& probabilities,
-    std::vector<distribution::GaussianDistribution>& dists,
+    std::vector<Distribution>& dists,
     arma::vec& weights,
     const bool useInitialModel)
 {
@@ -130,82 +99,156 @@ void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
       << l << std::endl;
 
   double lOld = -DBL_MAX;
-  arma::mat condProb(observations.n_cols, dists.size());
 
   // Iterate to update the model until no more improvement is found.
   size_t iteration = 1;
   while (std::abs(l - lOld) > tolerance && iteration != maxIterations)
   {
     // Calculate the conditional probabilities of choosing a particular
-    // Gaussian given the observations and the present theta value.
-    for (size_t i = 0; i < dists.size(); i++)
-    {
-      // Store conditional probabilities into condProb vector for each
-      // Gaussian.  First we make an alias of the condProb vector.
-      arma::vec condProbAlias = condProb.unsafe_col(i);
-      dists[i].Probability(observations, condProbAlias);
-      condProbAlias *= weights[i];
-    }
-
-    // Normalize row-wise.
-    for (size_t i = 0; i < condProb.n_rows; i++)
-    {
-      // Avoid dividing by zero; if the probability for everything is 0, we
-      // don't want to make it NaN.
-      const double probSum = accu(condProb.row(i));
-      if (probSum != 0.0)
-        condProb.row(i) /= probSum;
-    }
-
-    // This will store the sum of probabilities of each state over all the
-    // observations.
-    arma::vec probRowSums(dists.size());
+    // Gaussian given the observations and the present theta value, and use
+    // them to update the model.
+    Step(observations, probabilities, dists, weights);
 
-    // Calculate the new value of the means using the updated conditional
-    // probabilities.
-    for (size_t i = 0; i < dists.size(); i++)
-    {
-      // Calculate the sum of probabilities of points, which is the
-      // conditional probability of each point being from Gaussian i
-      // multiplied by the probability of the point being from this mixture
-      // model.
-      probRowSums[i] = accu(condProb.col(i) % probabilities);
+    // Update values of l; calculate new log-likelihood.
+    lOld = l;
+    l = LogLikelihood(observations, dists, weights);
 
-      dists[i].Mean() = (observations * (condProb.col(i) % probabilities)) /
-        probRowSums[i];
+    iteration++;
+  }
+}
 
-      // Calculate the new value of the covariances using the updated
-      // conditional probabilities and the updated means.
-      arma::mat tmp = observations - (dists[i].Mean() *
-          arma::ones<arma::rowvec>(observations.n_cols));
-      arma::mat tmpB = tmp % (arma::ones<arma::vec>(observations.n_rows) *
-          trans(condProb.col(i) % probabilities));
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
+void EMFit<InitialClusteringType,
+           CovarianceConstraintPolicy,
+           Distribution>::Step(
+    const arma::mat& observations,
+    const arma::vec& probabilities,
+    std::vector<Distribution>& dists,
+    arma::vec& weights)
+{
+  const size_t n = observations.n_cols;
+  const size_t d = observations.n_rows;
+  const size_t k = dists.size();
+
+  // Each shard is processed this many points at a time, so that only the
+  // responsibilities of one chunk are stored.
+  const size_t chunkSize = 1024;
+
+  // The scatter of each component is taken about its old mean, which is close
+  // to the new mean, so that there is little cancellation when the new mean is
+  // subtracted afterwards.
+  arma::mat centers(d, k);
+  for (size_t i = 0; i < k; ++i)
+    centers.col(i) = dists[i].Mean();
+
+  // The points are split into one contiguous shard per thread.  Each shard
+  // keeps its own counts, sums and scatters, which are reduced in shard order
+  // afterwards so that the result does not depend on the scheduling.
+  const size_t blocks = std::max(std::min(ThreadsToUse(), n), (size_t) 1);
+  arma::mat partialCounts(k, blocks, arma::fill::zeros);
+  arma::cube partialSums(d, k, blocks, arma::fill::zeros);
+  std::vector<arma::cube> partialScatters(blocks);
+
+  // For a diagonal Gaussian, only the diagonal of the scatter is kept.
+  const size_t scatterCols = std::is_same<Distribution,
+      distribution::DiagonalGaussianDistribution>::value ? 1 : d;
+
+  #pragma omp parallel for num_threads(blocks) schedule(static, 1)
+  for (size_t b = 0; b < blocks; ++b)
+  {
+    const size_t blockBegin = (b * n) / blocks;
+    const size_t blockEnd = ((b + 1) * n) / blocks;
+    partialScatters[b].zeros(d, scatterCols, k);
 
-      arma::mat cov = (tmp * trans(tmpB)) / probRowSums[i];
+    arma::vec phis;
+    for (size_t begin = blockBegin; begin < blockEnd; begin += chunkSize)
+    {
+      const size_t end = std::min(begin + chunkSize, blockEnd);
+      const arma::mat chunk = observations.cols(begin, end - 1);
+
+      // Calculate the conditional probabilities of choosing a particular
+      // Gaussian given the points of the chunk and the present theta value.
+      arma::mat condProb(chunk.n_cols, k);
+      for (size_t i = 0; i < k; ++i)
+      {
+        dists[i].Probability(chunk, phis);
+        condProb.col(i) = weights[i] * phis;
+      }
 
-      // Apply covariance constraint.
-      constraint.ApplyConstraint(cov);
+      // Normalize row-wise.
+      for (size_t j = 0; j < chunk.n_cols; ++j)
+      {
+        // Avoid dividing by zero; if the probability for everything is 0, we
+        // don't want to make it NaN.
+        const double probSum = accu(condProb.row(j));
+        if (probSum != 0.0)
+          condProb.row(j) /= probSum;
+
+        // Take into account the probability of the point being from this
+        // mixture model.
+        if (probabilities.n_elem != 0)
+          condProb.row(j) *= probabilities[begin + j];
+      }
 
-      dists[i].Covariance(std::move(cov));
+      // Accumulate the weighted statistics of each component.
+      for (size_t i = 0; i < k; ++i)
+      {
+        const arma::vec condProbCol = condProb.unsafe_col(i);
+        arma::mat centered = chunk;
+        centered.each_col() -= centers.col(i);
+        arma::mat weighted = centered;
+        for (size_t j = 0; j < chunk.n_cols; ++j)
+          weighted.col(j) *= condProbCol[j];
+
+        partialCounts(i, b) += accu(condProbCol);
+        partialSums.slice(b).col(i) += arma::sum(weighted, 1);
+        AccumulateScatter(dists[i], centered, weighted,
+            partialScatters[b].slice(i));
+      }
     }
+  }
 
-    // Calculate the new values for omega using the updated conditional
-    // probabilities.
-    weights = probRowSums / accu(probabilities);
+  // Reduce the statistics of the shards.
+  arma::vec counts = partialCounts.col(0);
+  arma::mat sums = partialSums.slice(0);
+  for (size_t b = 1; b < blocks; ++b)
+  {
+    counts += partialCounts.col(b);
+    sums += partialSums.slice(b);
+    partialScatters[0] += partialScatters[b];
+  }
 
-    // Update values of l; calculate new log-likelihood.
-    lOld = l;
-    l = LogLikelihood(observations, dists, weights);
+  // Calculate the new values of the means and covariances.
+  for (size_t i = 0; i < k; ++i)
+  {
+    // Don't update if there's no probability of the Gaussian having points.
+    if (counts[i] == 0.0)
+      continue;
 
-    iteration++;
+    const arma::vec shift = sums.col(i) / counts[i];
+    dists[i].Mean() = centers.col(i) + shift;
+    UpdateCovariance(dists[i], partialScatters[0].slice(i) / counts[i], shift);
   }
+
+  // Calculate the new values for omega using the updated conditional
+  // probabilities.
+  if (probabilities.n_elem != 0)
+    weights = counts / accu(probabilities);
+  else
+    weights = counts / n;
 }
 
-template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
-void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::
-InitialClustering(const arma::mat& observations,
-                  std::vector<distribution::GaussianDistribution>& dists,
-                  arma::vec& weights)
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
+void EMFit<InitialClusteringType,
+           CovarianceConstraintPolicy,
+           Distribution>::InitialClustering(
+    const arma::mat& observations,
+    std::vector<Distribution>& dists,
+    arma::vec& weights)
 {
   // Assignments from clustering.
   arma::Col<size_t> assignments;
@@ -213,6 +256,10 @@ InitialClustering(const arma::mat& observations,
   // Run clustering algorithm.
   clusterer.Cluster(observations, dists.size(), assignments);
 
+  const size_t d = observations.n_rows;
+  const size_t scatterCols = std::is_same<Distribution,
+      distribution::DiagonalGaussianDistribution>::value ? 1 : d;
+
   std::vector<arma::vec> means(dists.size());
   std::vector<arma::mat> covs(dists.size());
 
@@ -220,12 +267,11 @@ InitialClustering(const arma::mat& observations,
   weights.zeros();
   for (size_t i = 0; i < dists.size(); ++i)
   {
-    means[i].zeros(dists[i].Mean().n_elem);
-    covs[i].zeros(dists[i].Covariance().n_rows,
-                  dists[i].Covariance().n_cols);
+    means[i].zeros(d);
+    covs[i].zeros(d, scatterCols);
   }
 
-  // From the assignments, generate our means, covariances, and weights.
+  // From the assignments, generate our means and weights.
   for (size_t i = 0; i < observations.n_cols; ++i)
   {
     const size_t cluster = assignments[i];
@@ -233,9 +279,6 @@ InitialClustering(const arma::mat& observations,
     // Add this to the relevant mean.
     means[cluster] += observations.col(i);
 
-    // Add this to the relevant covariance.
-    covs[cluster] += observations.col(i) * trans(observations.col(i));
-
     // Now add one to the weights (we will normalize).
     weights[cluster]++;
   }
@@ -249,56 +292,172 @@ InitialClustering(const arma::mat& observations,
   for (size_t i = 0; i < observations.n_cols; ++i)
   {
     const size_t cluster = assignments[i];
-    const arma::vec normObs = observations.col(i) - means[cluster];
-    covs[cluster] += normObs * normObs.t();
+    const arma::mat normObs = observations.col(i) - means[cluster];
+    AccumulateScatter(dists[cluster], normObs, normObs, covs[cluster]);
   }
 
+  const arma::vec noShift = arma::zeros<arma::vec>(d);
   for (size_t i = 0; i < dists.size(); ++i)
   {
     covs[i] /= (weights[i] > 1) ? weights[i] : 1;
 
-    // Apply constraints to covariance matrix.
-    constraint.ApplyConstraint(covs[i]);
-
     std::swap(dists[i].Mean(), means[i]);
-    dists[i].Covariance(std::move(covs[i]));
+
+    // Apply constraints to covariance matrix.
+    UpdateCovariance(dists[i], covs[i], noShift);
   }
 
   // Finally, normalize weights.
   weights /= accu(weights);
 }
 
-template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
-double EMFit<InitialClusteringType, CovarianceConstraintPolicy>::LogLikelihood(
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
+double EMFit<InitialClusteringType,
+             CovarianceConstraintPolicy,
+             Distribution>::LogLikelihood(
     const arma::mat& observations,
-    const std::vector<distribution::GaussianDistribution>& dists,
+    const std::vector<Distribution>& dists,
     const arma::vec& weights) const
 {
-  double logLikelihood = 0;
+  const size_t n = observations.n_cols;
+  const size_t chunkSize = 1024;
 
-  arma::vec phis;
-  arma::mat likelihoods(dists.size(), observations.n_cols);
+  // Sum the log-likelihood of each shard of points separately, and then add
+  // the sums in shard order.
+  const size_t blocks = std::max(std::min(ThreadsToUse(), n), (size_t) 1);
+  arma::vec partialLogLikelihoods(blocks, arma::fill::zeros);
+  arma::Col<size_t> partialOutliers(blocks, arma::fill::zeros);
 
-  for (size_t i = 0; i < dists.size(); ++i)
+  #pragma omp parallel for num_threads(blocks) schedule(static, 1)
+  for (size_t b = 0; b < blocks; ++b)
   {
-    dists[i].Probability(observations, phis);
-    likelihoods.row(i) = weights(i) * trans(phis);
-  }
-  // Now sum over every point.
-  for (size_t j = 0; j < observations.n_cols; ++j)
-  {
-    if (accu(likelihoods.col(j)) == 0)
-      Log::Info << "Likelihood of point " << j << " is 0!  It is probably an "
-          << "outlier." << std::endl;
-    logLikelihood += log(accu(likelihoods.col(j)));
+    const size_t blockBegin = (b * n) / blocks;
+    const size_t blockEnd = ((b + 1) * n) / blocks;
+
+    arma::vec phis;
+    for (size_t begin = blockBegin; begin < blockEnd; begin += chunkSize)
+    {
+      const size_t end = std::min(begin + chunkSize, blockEnd);
+      const arma::mat chunk = observations.cols(begin, end - 1);
+
+      arma::mat likelihoods(dists.size(), chunk.n_cols);
+      for (size_t i = 0; i < dists.size(); ++i)
+      {
+        dists[i].Probability(chunk, phis);
+        likelihoods.row(i) = weights(i) * trans(phis);
+      }
+
+      // Now sum over every point.
+      for (size_t j = 0; j < chunk.n_cols; ++j)
+      {
+        const double likelihood = accu(likelihoods.col(j));
+        if (likelihood == 0)
+          ++partialOutliers[b];
+        partialLogLikelihoods[b] += log(likelihood);
+      }
+    }
   }
 
+  double logLikelihood = 0;
+  for (size_t b = 0; b < blocks; ++b)
+    logLikelihood += partialLogLikelihoods[b];
+
+  const size_t outliers = accu(partialOutliers);
+  if (outliers > 0)
+    Log::Info << "Likelihood of " << outliers << " points is 0!  They are "
+        << "probably outliers." << std::endl;
+
   return logLikelihood;
 }
 
-template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
+void EMFit<InitialClusteringType,
+           CovarianceConstraintPolicy,
+           Distribution>::AccumulateScatter(
+    const distribution::GaussianDistribution& /* dist */,
+    const arma::mat& centered,
+    const arma::mat& weighted,
+    arma::mat& scatter)
+{
+  scatter += centered * trans(weighted);
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
+void EMFit<InitialClusteringType,
+           CovarianceConstraintPolicy,
+           Distribution>::AccumulateScatter(
+    const distribution::DiagonalGaussianDistribution& /* dist */,
+    const arma::mat& centered,
+    const arma::mat& weighted,
+    arma::mat& scatter)
+{
+  scatter += arma::sum(centered % weighted, 1);
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
+void EMFit<InitialClusteringType,
+           CovarianceConstraintPolicy,
+           Distribution>::UpdateCovariance(
+    distribution::GaussianDistribution& dist,
+    const arma::mat& scatter,
+    const arma::vec& shift)
+{
+  arma::mat covariance = scatter - shift * trans(shift);
+
+  // Apply covariance constraint.
+  constraint.ApplyConstraint(covariance);
+  dist.Covariance(std::move(covariance));
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
+void EMFit<InitialClusteringType,
+           CovarianceConstraintPolicy,
+           Distribution>::UpdateCovariance(
+    distribution::DiagonalGaussianDistribution& dist,
+    const arma::mat& scatter,
+    const arma::vec& shift)
+{
+  arma::vec covariance = scatter.col(0) - arma::square(shift);
+
+  // Apply covariance constraint.
+  constraint.ApplyConstraint(covariance);
+  dist.Covariance(std::move(covariance));
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
+size_t EMFit<InitialClusteringType,
+             CovarianceConstraintPolicy,
+             Distribution>::ThreadsToUse() const
+{
+  if (numThreads != 0)
+    return numThreads;
+
+#ifdef _OPENMP
+  return (size_t) omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
 template<typename Archive>
-void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Serialize(
+void EMFit<InitialClusteringType,
+           CovarianceConstraintPolicy,
+           Distribution>::Serialize(
     Archive& ar,
     const unsigned int /* version */)
 {
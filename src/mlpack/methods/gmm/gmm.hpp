@@ -44,9 +44,18 @@ namespace gmm /** Gaussian Mixture Models. */ {
  * the method should expect that these vectors are already set to the size of
  * the GMM as specified in the constructor.
  *
+ * If the Distribution template parameter is changed, the vectors hold objects
+ * of that type instead.
+ *
  * For a sample implementation, see the EMFit class; this class uses the EM
  * algorithm to train a GMM, and is the default fitting type.
  *
+ * The components are distribution::GaussianDistribution objects by default.
+ * For a mixture of Gaussians with diagonal covariances, which stores only the
+ * variances of each component and evaluates and fits them in O(d) time per
+ * point, use the DiagonalGMM template typedef (see diagonal_gmm.hpp), which
+ * uses distribution::DiagonalGaussianDistribution components.
+ *
  * The GMM, once trained, can be used to generate random points from the
  * distribution and estimate the probability of points being from the
  * distribution.  The parameters of the GMM can be obtained through the
@@ -69,7 +78,8 @@ namespace gmm /** Gaussian Mixture Models. */ {
  * arma::vec observation = g.Random();
  * @endcode
  */
-template<typename FittingType = EMFit<>>
+template<typename FittingType = EMFit<>,
+         typename Distribution = distribution::GaussianDistribution>
 class GMM
 {
  private:
@@ -79,7 +89,7 @@ class GMM
   size_t dimensionality;
 
   //! Vector of Gaussians
-  std::vector<distribution::GaussianDistribution> dists;
+  std::vector<Distribution> dists;
 
   //! Vector of a priori weights for each Gaussian.
   arma::vec weights;
@@ -89,6 +99,9 @@ class GMM
   //! Whether or not we own the fitter.
   bool ownsFitter;
 
+  //! Number of threads to run the trials of Estimate() in.
+  size_t numThreads;
+
  public:
   /**
    * Create an empty Gaussian Mixture Model, with zero gaussians.
@@ -97,7 +110,8 @@ class GMM
       gaussians(0),
       dimensionality(0),
       fitter(new FittingType()),
-      ownsFitter(true)
+      ownsFitter(true),
+      numThreads(1)
   {
     // Warn the user.  They probably don't want to do this.  If this constructor
     // is being used (because it is required by some template classes), the user
@@ -135,14 +149,15 @@ class GMM
    * @param dists Distributions of the model.
    * @param weights Weights of the model.
    */
-  GMM(const std::vector<distribution::GaussianDistribution> & dists,
+  GMM(const std::vector<Distribution> & dists,
       const arma::vec& weights) :
       gaussians(dists.size()),
       dimensionality((!dists.empty()) ? dists[0].Mean().n_elem : 0),
       dists(dists),
       weights(weights),
       fitter(new FittingType()),
-      ownsFitter(true) { /* Nothing to do. */ }
+      ownsFitter(true),
+      numThreads(1) { /* Nothing to do. */ }
 
   /**
    * Create a GMM with the given means, covariances, and weights, and use the
@@ -153,7 +168,7 @@ class GMM
    * @param covariances Covariances of the model.
    * @param weights Weights of the model.
    */
-  GMM(const std::vector<distribution::GaussianDistribution> & dists,
+  GMM(const std::vector<Distribution> & dists,
       const arma::vec& weights,
       FittingType& fitter) :
       gaussians(dists.size()),
@@ -161,13 +176,14 @@ class GMM
       dists(dists),
       weights(weights),
       fitter(&fitter),
-      ownsFitter(false) { /* Nothing to do. */ }
+      ownsFitter(false),
+      numThreads(1) { /* Nothing to do. */ }
 
   /**
    * Copy constructor for GMMs which use different fitting types.
    */
   template<typename OtherFittingType>
-  GMM(const GMM<OtherFittingType>& other);
+  GMM(const GMM<OtherFittingType, Distribution>& other);
 
   /**
    * Copy constructor for GMMs using the same fitting type.  This also copies
@@ -182,7 +198,7 @@ class GMM
    * Copy operator for GMMs which use different fitting types.
    */
   template<typename OtherFittingType>
-  GMM& operator=(const GMM<OtherFittingType>& other);
+  GMM& operator=(const GMM<OtherFittingType, Distribution>& other);
 
   /**
    * Copy operator for GMMs which use the same fitting type.  This also copies
@@ -207,14 +223,14 @@ class GMM
    *
    * @param i index of component.
    */
-  const distribution::GaussianDistribution& Component(size_t i) const {
+  const Distribution& Component(size_t i) const {
       return dists[i]; }
   /**
    * Return a reference to a component distribution.
    *
    * @param i index of component.
    */
-  distribution::GaussianDistribution& Component(size_t i) { return dists[i]; }
+  Distribution& Component(size_t i) { return dists[i]; }
 
   //! Return a const reference to the a priori weights of each Gaussian.
   const arma::vec& Weights() const { return weights; }
@@ -222,9 +238,16 @@ class GMM
   arma::vec& Weights() { return weights; }
 
   //! Return a const reference to the fitting type.
-  const FittingType& Fitter() const { return fitter; }
+  const FittingType& Fitter() const { return *fitter; }
   //! Return a reference to the fitting type.
-  FittingType& Fitter() { return fitter; }
+  FittingType& Fitter() { return *fitter; }
+
+  //! Get the number of threads the trials of Estimate() are run in.
+  size_t NumThreads() const { return numThreads; }
+  //! Modify the number of threads the trials of Estimate() are run in (0 means
+  //! as many as OpenMP allows).  See Estimate() for the requirements on the
+  //! fitter.
+  size_t& NumThreads() { return numThreads; }
 
   /**
    * Return the probability that the given observation came from this
@@ -244,6 +267,31 @@ class GMM
   double Probability(const arma::vec& observation,
                      const size_t component) const;
 
+  /**
+   * Compute the probability of each of the given observations (one per column)
+   * being from this distribution.  For each component, the log-densities of all
+   * the observations are computed at once.
+   *
+   * @param observations Observations to evaluate the probability of.
+   * @param probabilities Vector to store the probability of each observation
+   *     in.
+   */
+  void Probability(const arma::mat& observations,
+                   arma::vec& probabilities) const;
+
+  /**
+   * Compute the log-probability of each of the given observations (one per
+   * column) being from this distribution.  The sum over the components is taken
+   * in log space, so the result does not underflow for observations far from
+   * every component.
+   *
+   * @param observations Observations to evaluate the log-probability of.
+   * @param logProbabilities Vector to store the log-probability of each
+   *     observation in.
+   */
+  void LogProbability(const arma::mat& observations,
+                      arma::vec& logProbabilities) const;
+
   /**
    * Return a randomly generated observation according to the probability
    * distribution defined by this object.
@@ -265,6 +313,16 @@ class GMM
    * is deterministic after the initial position is given, then 'trials' should
    * be set to 1.
    *
+   * If NumThreads() is not 1, the trials are run in parallel, each
+   * independently with its own copy of the fitter.  The trial with the
+   * greatest log-likelihood is then chosen deterministically from whatever
+   * the trials produced (the earliest trial wins ties); the trials need not
+   * produce the same models as a serial run would.  The fitter must be safe
+   * to run from several threads at once.  In particular, its random choices
+   * must not be made with the global random number generators of mlpack and
+   * Armadillo; the SubsampledKMeans initial clustering policy only takes a
+   * seed from math::randGen, so EMFit<SubsampledKMeans<> > can be used.
+   *
    * @tparam FittingType The type of fitting method which should be used
    *     (EMFit<> is suggested).
    * @param observations Observations of the model.
@@ -291,7 +349,8 @@ class GMM
    * Optionally, the existing model can be used as an initial model for the
    * estimation by setting 'useExistingModel' to true.  If the fitting procedure
    * is deterministic after the initial position is given, then 'trials' should
-   * be set to 1.
+   * be set to 1.  The trials are run in parallel as with the other overload of
+   * Estimate().
    *
    * @param observations Observations of the model.
    * @param probabilities Probability of each observation being from this
@@ -338,6 +397,21 @@ class GMM
   void Serialize(Archive& ar, const unsigned int /* version */);
 
  private:
+  /**
+   * Compute the log-probability of each of the given observations under the
+   * mixture with the given components and weights.
+   *
+   * @param observations Observations to evaluate the log-probability of.
+   * @param distsL Components of the mixture.
+   * @param weightsL Weights of the mixture.
+   * @param logProbabilities Vector to store the log-probabilities in.
+   */
+  void LogProbability(
+      const arma::mat& observations,
+      const std::vector<Distribution>& distsL,
+      const arma::vec& weightsL,
+      arma::vec& logProbabilities) const;
+
   /**
    * This function computes the loglikelihood of the given model.  This function
    * is used by GMM::Estimate().
@@ -349,8 +423,29 @@ class GMM
    */
   double LogLikelihood(
       const arma::mat& dataPoints,
-      const std::vector<distribution::GaussianDistribution>& distsL,
+      const std::vector<Distribution>& distsL,
       const arma::vec& weights) const;
+
+  /**
+   * Run the given number of trials of the fitter in parallel, each with its own
+   * copy of the fitter and of the model, and keep the model with the greatest
+   * log-likelihood.  If probabilities is empty, every point is taken to be from
+   * this mixture.
+   *
+   * @param observations Observations of the model.
+   * @param probabilities Probability of each observation being from this
+   *     distribution, or an empty vector.
+   * @param trials Number of trials to perform.
+   * @param useExistingModel If true, each trial starts from the existing model.
+   * @return The log-likelihood of the best fit.
+   */
+  double ParallelEstimate(const arma::mat& observations,
+                          const arma::vec& probabilities,
+                          const size_t trials,
+                          const bool useExistingModel);
+
+  //! Get the number of threads that will actually be used.
+  size_t ThreadsToUse() const;
 };
 
 }; // namespace gmm
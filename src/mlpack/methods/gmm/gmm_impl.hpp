@@ -12,6 +12,10 @@
 // In case it hasn't already been included.
 #include "gmm.hpp"
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace gmm {
 
@@ -22,14 +26,16 @@ namespace gmm {
  * @param gaussians Number of Gaussians in this GMM.
  * @param dimensionality Dimensionality of each Gaussian.
  */
-template<typename FittingType>
-GMM<FittingType>::GMM(const size_t gaussians, const size_t dimensionality) :
+template<typename FittingType, typename Distribution>
+GMM<FittingType, Distribution>::GMM(const size_t gaussians,
+                                    const size_t dimensionality) :
     gaussians(gaussians),
     dimensionality(dimensionality),
-    dists(gaussians, distribution::GaussianDistribution(dimensionality)),
+    dists(gaussians, Distribution(dimensionality)),
     weights(gaussians),
     fitter(new FittingType()),
-    ownsFitter(true)
+    ownsFitter(true),
+    numThreads(1)
 {
   // Set equal weights.  Technically this model is still valid, but only barely.
   weights.fill(1.0 / gaussians);
@@ -45,16 +51,17 @@ GMM<FittingType>::GMM(const size_t gaussians, const size_t dimensionality) :
  * @param dimensionality Dimensionality of each Gaussian.
  * @param fitter Initialized fitting mechanism.
  */
-template<typename FittingType>
-GMM<FittingType>::GMM(const size_t gaussians,
-                      const size_t dimensionality,
-                      FittingType& fitter) :
+template<typename FittingType, typename Distribution>
+GMM<FittingType, Distribution>::GMM(const size_t gaussians,
+                                    const size_t dimensionality,
+                                    FittingType& fitter) :
     gaussians(gaussians),
     dimensionality(dimensionality),
-    dists(gaussians, distribution::GaussianDistribution(dimensionality)),
+    dists(gaussians, Distribution(dimensionality)),
     weights(gaussians),
     fitter(&fitter),
-    ownsFitter(false)
+    ownsFitter(false),
+    numThreads(1)
 {
   // Set equal weights.  Technically this model is still valid, but only barely.
   weights.fill(1.0 / gaussians);
@@ -62,53 +69,60 @@ GMM<FittingType>::GMM(const size_t gaussians,
 
 
 // Copy constructor.
-template<typename FittingType>
+template<typename FittingType, typename Distribution>
 template<typename OtherFittingType>
-GMM<FittingType>::GMM(const GMM<OtherFittingType>& other) :
+GMM<FittingType, Distribution>::GMM(
+    const GMM<OtherFittingType, Distribution>& other) :
     gaussians(other.gaussians),
     dimensionality(other.dimensionality),
     dists(other.dists),
     weights(other.weights),
     fitter(new FittingType()),
-    ownsFitter(true) { /* Nothing to do. */ }
+    ownsFitter(true),
+    numThreads(other.NumThreads()) { /* Nothing to do. */ }
 
 // Copy constructor for when the other GMM uses the same fitting type.
-template<typename FittingType>
-GMM<FittingType>::GMM(const GMM<FittingType>& other) :
+template<typename FittingType, typename Distribution>
+GMM<FittingType, Distribution>::GMM(
+    const GMM<FittingType, Distribution>& other) :
     gaussians(other.Gaussians()),
     dimensionality(other.dimensionality),
     dists(other.dists),
     weights(other.weights),
     fitter(new FittingType(*other.fitter)),
-    ownsFitter(true) { /* Nothing to do. */ }
+    ownsFitter(true),
+    numThreads(other.numThreads) { /* Nothing to do. */ }
 
-template<typename FittingType>
-GMM<FittingType>::~GMM()
+template<typename FittingType, typename Distribution>
+GMM<FittingType, Distribution>::~GMM()
 {
   if (ownsFitter)
     delete fitter;
 }
 
-template<typename FittingType>
+template<typename FittingType, typename Distribution>
 template<typename OtherFittingType>
-GMM<FittingType>& GMM<FittingType>::operator=(
-    const GMM<OtherFittingType>& other)
+GMM<FittingType, Distribution>& GMM<FittingType, Distribution>::operator=(
+    const GMM<OtherFittingType, Distribution>& other)
 {
   gaussians = other.gaussians;
   dimensionality = other.dimensionality;
   dists = other.dists;
   weights = other.weights;
+  numThreads = other.NumThreads();
 
   return *this;
 }
 
-template<typename FittingType>
-GMM<FittingType>& GMM<FittingType>::operator=(const GMM<FittingType>& other)
+template<typename FittingType, typename Distribution>
+GMM<FittingType, Distribution>& GMM<FittingType, Distribution>::operator=(
+    const GMM<FittingType, Distribution>& other)
 {
   gaussians = other.gaussians;
   dimensionality = other.dimensionality;
   dists = other.dists;
   weights = other.weights;
+  numThreads = other.numThreads;
 
   if (fitter && ownsFitter)
     delete fitter;
@@ -121,8 +135,9 @@ GMM<FittingType>& GMM<FittingType>::operator=(const GMM<FittingType>& other)
 /**
  * Return the probability of the given observation being from this GMM.
  */
-template<typename FittingType>
-double GMM<FittingType>::Probability(const arma::vec& observation) const
+template<typename FittingType, typename Distribution>
+double GMM<FittingType, Distribution>::Probability(
+    const arma::vec& observation) const
 {
   // Sum the probability for each Gaussian in our mixture (and we have to
   // multiply by the prior for each Gaussian too).
@@ -137,21 +152,46 @@ double GMM<FittingType>::Probability(const arma::vec& observation) const
  * Return the probability of the given observation being from the given
  * component in the mixture.
  */
-template<typename FittingType>
-double GMM<FittingType>::Probability(const arma::vec& observation,
-                                     const size_t component) const
+template<typename FittingType, typename Distribution>
+double GMM<FittingType, Distribution>::Probability(const arma::vec& observation,
+                                                   const size_t component) const
 {
   // We are only considering one Gaussian component -- so we only need to call
   // Probability() once.  We do consider the prior probability!
   return weights[component] * dists[component].Probability(observation);
 }
 
+/**
+ * Return the probability of each of the given observations being from this
+ * GMM.
+ */
+template<typename FittingType, typename Distribution>
+void GMM<FittingType, Distribution>::Probability(const arma::mat& observations,
+                                                 arma::vec& probabilities) const
+{
+  arma::vec logProbabilities;
+  LogProbability(observations, dists, weights, logProbabilities);
+  probabilities = arma::exp(logProbabilities);
+}
+
+/**
+ * Return the log-probability of each of the given observations being from this
+ * GMM.
+ */
+template<typename FittingType, typename Distribution>
+void GMM<FittingType, Distribution>::LogProbability(
+    const arma::mat& observations,
+    arma::vec& logProbabilities) const
+{
+  LogProbability(observations, dists, weights, logProbabilities);
+}
+
 /**
  * Return a randomly generated observation according to the probability
  * distribution defined by this object.
  */
-template<typename FittingType>
-arma::vec GMM<FittingType>::Random() const
+template<typename FittingType, typename Distribution>
+arma::vec GMM<FittingType, Distribution>::Random() const
 {
   // Determine which Gaussian it will be coming from.
   double gaussRand = math::Random();
@@ -168,17 +208,16 @@ arma::vec GMM<FittingType>::Random() const
     }
   }
 
-  return trans(chol(dists[gaussian].Covariance())) *
-      arma::randn<arma::vec>(dimensionality) + dists[gaussian].Mean();
+  return dists[gaussian].Random();
 }
 
 /**
  * Fit the GMM to the given observations.
  */
-template<typename FittingType>
-double GMM<FittingType>::Estimate(const arma::mat& observations,
-                                  const size_t trials,
-                                  const bool useExistingModel)
+template<typename FittingType, typename Distribution>
+double GMM<FittingType, Distribution>::Estimate(const arma::mat& observations,
+                                                const size_t trials,
+                                                const bool useExistingModel)
 {
   double bestLikelihood; // This will be reported later.
 
@@ -191,13 +230,19 @@ double GMM<FittingType>::Estimate(const arma::mat& observations,
         useExistingModel);
     bestLikelihood = LogLikelihood(observations, dists, weights);
   }
+  else if (trials > 1 && ThreadsToUse() > 1)
+  {
+    // Each trial gets its own copy of the fitter and the model.
+    bestLikelihood = ParallelEstimate(observations, arma::vec(), trials,
+        useExistingModel);
+  }
   else
   {
     if (trials == 0)
       return -DBL_MAX; // It's what they asked for...
 
     // If each trial must start from the same initial location, we must save it.
-    std::vector<distribution::GaussianDistribution> distsOrig;
+    std::vector<Distribution> distsOrig;
     arma::vec weightsOrig;
     if (useExistingModel)
     {
@@ -205,6 +250,10 @@ double GMM<FittingType>::Estimate(const arma::mat& observations,
       weightsOrig = weights;
     }
 
+    // Every trial starts from the same fitter too, so that the statistics kept
+    // by a fitter like OnlineEMFit don't carry over from one trial to the next.
+    const FittingType fitterOrig(*fitter);
+
     // We need to keep temporary copies.  We'll do the first training into the
     // actual model position, so that if it's the best we don't need to copy it.
     fitter->Estimate(observations, dists, weights,
@@ -216,8 +265,8 @@ double GMM<FittingType>::Estimate(const arma::mat& observations,
         << bestLikelihood << "." << std::endl;
 
     // Now the temporary model.
-    std::vector<distribution::GaussianDistribution> distsTrial(gaussians,
-        distribution::GaussianDistribution(dimensionality));
+    std::vector<Distribution> distsTrial(gaussians,
+        Distribution(dimensionality));
     arma::vec weightsTrial(gaussians);
 
     for (size_t trial = 1; trial < trials; ++trial)
@@ -228,7 +277,8 @@ double GMM<FittingType>::Estimate(const arma::mat& observations,
         weightsTrial = weightsOrig;
       }
 
-      fitter->Estimate(observations, distsTrial, weightsTrial,
+      FittingType fitterTrial(fitterOrig);
+      fitterTrial.Estimate(observations, distsTrial, weightsTrial,
           useExistingModel);
 
       // Check to see if the log-likelihood of this one is better.
@@ -245,6 +295,7 @@ double GMM<FittingType>::Estimate(const arma::mat& observations,
 
         dists = distsTrial;
         weights = weightsTrial;
+        *fitter = std::move(fitterTrial);
       }
     }
   }
@@ -259,11 +310,11 @@ double GMM<FittingType>::Estimate(const arma::mat& observations,
  * Fit the GMM to the given observations, each of which has a certain
  * probability of being from this distribution.
  */
-template<typename FittingType>
-double GMM<FittingType>::Estimate(const arma::mat& observations,
-                                  const arma::vec& probabilities,
-                                  const size_t trials,
-                                  const bool useExistingModel)
+template<typename FittingType, typename Distribution>
+double GMM<FittingType, Distribution>::Estimate(const arma::mat& observations,
+                                                const arma::vec& probabilities,
+                                                const size_t trials,
+                                                const bool useExistingModel)
 {
   double bestLikelihood; // This will be reported later.
 
@@ -276,13 +327,19 @@ double GMM<FittingType>::Estimate(const arma::mat& observations,
         useExistingModel);
     bestLikelihood = LogLikelihood(observations, dists, weights);
   }
+  else if (trials > 1 && ThreadsToUse() > 1)
+  {
+    // Each trial gets its own copy of the fitter and the model.
+    bestLikelihood = ParallelEstimate(observations, probabilities, trials,
+        useExistingModel);
+  }
   else
   {
     if (trials == 0)
       return -DBL_MAX; // It's what they asked for...
 
     // If each trial must start from the same initial location, we must save it.
-    std::vector<distribution::GaussianDistribution> distsOrig;
+    std::vector<Distribution> distsOrig;
     arma::vec weightsOrig;
     if (useExistingModel)
     {
@@ -290,6 +347,10 @@ double GMM<FittingType>::Estimate(const arma::mat& observations,
       weightsOrig = weights;
     }
 
+    // Every trial starts from the same fitter too, so that the statistics kept
+    // by a fitter like OnlineEMFit don't carry over from one trial to the next.
+    const FittingType fitterOrig(*fitter);
+
     // We need to keep temporary copies.  We'll do the first training into the
     // actual model position, so that if it's the best we don't need to copy it.
     fitter->Estimate(observations, probabilities, dists, weights,
@@ -301,8 +362,8 @@ double GMM<FittingType>::Estimate(const arma::mat& observations,
         << bestLikelihood << "." << std::endl;
 
     // Now the temporary model.
-    std::vector<distribution::GaussianDistribution> distsTrial(gaussians,
-        distribution::GaussianDistribution(dimensionality));
+    std::vector<Distribution> distsTrial(gaussians,
+        Distribution(dimensionality));
     arma::vec weightsTrial(gaussians);
 
     for (size_t trial = 1; trial < trials; ++trial)
@@ -313,8 +374,9 @@ double GMM<FittingType>::Estimate(const arma::mat& observations,
         weightsTrial = weightsOrig;
       }
 
-      fitter->Estimate(observations, distsTrial, weightsTrial,
-          useExistingModel);
+      FittingType fitterTrial(fitterOrig);
+      fitterTrial.Estimate(observations, probabilities, distsTrial,
+          weightsTrial, useExistingModel);
 
       // Check to see if the log-likelihood of this one is better.
       double newLikelihood = LogLikelihood(observations, distsTrial,
@@ -330,6 +392,7 @@ double GMM<FittingType>::Estimate(const arma::mat& observations,
 
         dists = distsTrial;
         weights = weightsTrial;
+        *fitter = std::move(fitterTrial);
       }
     }
   }
@@ -340,15 +403,90 @@ double GMM<FittingType>::Estimate(const arma::mat& observations,
   return bestLikelihood;
 }
 
+/**
+ * Run the trials of Estimate() in parallel and keep the best one.
+ */
+template<typename FittingType, typename Distribution>
+double GMM<FittingType, Distribution>::ParallelEstimate(
+    const arma::mat& observations,
+    const arma::vec& probabilities,
+    const size_t trials,
+    const bool useExistingModel)
+{
+  // Every trial starts from the existing model (if it is used at all), so the
+  // trials don't depend on each other.
+  std::vector<FittingType> fitters(trials, *fitter);
+  std::vector<std::vector<Distribution> > distsTrial(trials, dists);
+  std::vector<arma::vec> weightsTrial(trials, weights);
+  arma::vec likelihoods(trials);
+
+  // The log streams are not thread-safe, so the fitters are silenced while the
+  // trials run, and each trial is reported afterwards.
+#ifdef DEBUG
+  const bool ignoringDebug = Log::Debug.ignoreInput;
+  Log::Debug.ignoreInput = true;
+#endif
+  const bool ignoringInfo = Log::Info.ignoreInput;
+  const bool ignoringWarn = Log::Warn.ignoreInput;
+  Log::Info.ignoreInput = true;
+  Log::Warn.ignoreInput = true;
+
+  const size_t threads = std::min(ThreadsToUse(), trials);
+  #pragma omp parallel for num_threads(threads) schedule(dynamic)
+  for (size_t trial = 0; trial < trials; ++trial)
+  {
+    if (probabilities.n_elem != 0)
+      fitters[trial].Estimate(observations, probabilities, distsTrial[trial],
+          weightsTrial[trial], useExistingModel);
+    else
+      fitters[trial].Estimate(observations, distsTrial[trial],
+          weightsTrial[trial], useExistingModel);
+
+    likelihoods[trial] = LogLikelihood(observations, distsTrial[trial],
+        weightsTrial[trial]);
+  }
+
+#ifdef DEBUG
+  Log::Debug.ignoreInput = ignoringDebug;
+#endif
+  Log::Info.ignoreInput = ignoringInfo;
+  Log::Warn.ignoreInput = ignoringWarn;
+
+  // Keep the best trial; the earliest one wins ties, as in the serial case.
+  size_t best = 0;
+  for (size_t trial = 0; trial < trials; ++trial)
+  {
+    Log::Info << "GMM::Estimate(): Log-likelihood of trial " << trial << " is "
+        << likelihoods[trial] << "." << std::endl;
+
+    if (likelihoods[trial] > likelihoods[best])
+      best = trial;
+  }
+
+  dists = std::move(distsTrial[best]);
+  weights = std::move(weightsTrial[best]);
+  *fitter = std::move(fitters[best]);
+
+  return likelihoods[best];
+}
+
 /**
  * Classify the given observations as being from an individual component in this
  * GMM.
  */
-template<typename FittingType>
-void GMM<FittingType>::Classify(const arma::mat& observations,
-                                arma::Col<size_t>& labels) const
+template<typename FittingType, typename Distribution>
+void GMM<FittingType, Distribution>::Classify(const arma::mat& observations,
+                                              arma::Col<size_t>& labels) const
 {
-  // This is not the best way to do this!
+  // Compute the log-probability of every observation under every component
+  // (including the prior), one component at a time.
+  arma::mat logProbabilities(gaussians, observations.n_cols);
+  arma::vec phis;
+  for (size_t i = 0; i < gaussians; ++i)
+  {
+    dists[i].LogProbability(observations, phis);
+    logProbabilities.row(i) = std::log(weights[i]) + trans(phis);
+  }
 
   // We should not have to fill this with values, because each one should be
   // overwritten.
@@ -356,13 +494,12 @@ void GMM<FittingType>::Classify(const arma::mat& observations,
   for (size_t i = 0; i < observations.n_cols; ++i)
   {
     // Find maximum probability component.
-    double probability = 0;
+    double logProbability = -std::numeric_limits<double>::infinity();
     for (size_t j = 0; j < gaussians; ++j)
     {
-      double newProb = Probability(observations.unsafe_col(i), j);
-      if (newProb >= probability)
+      if (logProbabilities(j, i) >= logProbability)
       {
-        probability = newProb;
+        logProbability = logProbabilities(j, i);
         labels[i] = j;
       }
     }
@@ -370,35 +507,58 @@ void GMM<FittingType>::Classify(const arma::mat& observations,
 }
 
 /**
- * Get the log-likelihood of this data's fit to the model.
+ * Compute the log-probability of each observation under the given mixture.
  */
-template<typename FittingType>
-double GMM<FittingType>::LogLikelihood(
-    const arma::mat& data,
-    const std::vector<distribution::GaussianDistribution>& distsL,
-    const arma::vec& weightsL) const
+template<typename FittingType, typename Distribution>
+void GMM<FittingType, Distribution>::LogProbability(
+    const arma::mat& observations,
+    const std::vector<Distribution>& distsL,
+    const arma::vec& weightsL,
+    arma::vec& logProbabilities) const
 {
-  double loglikelihood = 0;
+  arma::mat logLikelihoods(gaussians, observations.n_cols);
   arma::vec phis;
-  arma::mat likelihoods(gaussians, data.n_cols);
+  for (size_t i = 0; i < gaussians; ++i)
+  {
+    distsL[i].LogProbability(observations, phis);
+    logLikelihoods.row(i) = std::log(weightsL[i]) + trans(phis);
+  }
 
-  for (size_t i = 0; i < gaussians; i++)
+  // The sum over the components is a log-sum-exp; the largest term is taken out
+  // so that the exponentials can't all underflow.
+  logProbabilities.set_size(observations.n_cols);
+  for (size_t j = 0; j < observations.n_cols; ++j)
   {
-    distsL[i].Probability(data, phis);
-    likelihoods.row(i) = weightsL(i) * trans(phis);
+    const double shift = logLikelihoods.col(j).max();
+    if (shift == -std::numeric_limits<double>::infinity())
+      logProbabilities[j] = shift;
+    else
+      logProbabilities[j] = shift +
+          std::log(arma::accu(arma::exp(logLikelihoods.col(j) - shift)));
   }
+}
 
-  // Now sum over every point.
-  for (size_t j = 0; j < data.n_cols; j++)
-    loglikelihood += log(accu(likelihoods.col(j)));
+/**
+ * Get the log-likelihood of this data's fit to the model.
+ */
+template<typename FittingType, typename Distribution>
+double GMM<FittingType, Distribution>::LogLikelihood(
+    const arma::mat& data,
+    const std::vector<Distribution>& distsL,
+    const arma::vec& weightsL) const
+{
+  arma::vec logProbabilities;
+  LogProbability(data, distsL, weightsL, logProbabilities);
+
+  const double loglikelihood = arma::accu(logProbabilities);
   return loglikelihood;
 }
 
 /**
 * Returns a string representation of this object.
 */
-template<typename FittingType>
-std::string GMM<FittingType>::ToString() const
+template<typename FittingType, typename Distribution>
+std::string GMM<FittingType, Distribution>::ToString() const
 {
   std::ostringstream convert;
   std::ostringstream data;
@@ -426,9 +586,11 @@ std::string GMM<FittingType>::ToString() const
 /**
  * Serialize the object.
  */
-template<typename FittingType>
+template<typename FittingType, typename Distribution>
 template<typename Archive>
-void GMM<FittingType>::Serialize(Archive& ar, const unsigned int /* version */)
+void GMM<FittingType, Distribution>::Serialize(
+    Archive& ar,
+    const unsigned int /* version */)
 {
   using data::CreateNVP;
 
@@ -461,6 +623,19 @@ void GMM<FittingType>::Serialize(Archive& ar, const unsigned int /* version */)
   ar & CreateNVP(fitter, "fitter");
 }
 
+template<typename FittingType, typename Distribution>
+size_t GMM<FittingType, Distribution>::ThreadsToUse() const
+{
+  if (numThreads != 0)
+    return numThreads;
+
+#ifdef _OPENMP
+  return (size_t) omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
 } // namespace gmm
 } // namespace mlpack
 
@@ -7,10 +7,13 @@
 #include <mlpack/core.hpp>
 
 #include "gmm.hpp"
+#include "online_em_fit.hpp"
 #include "no_constraint.hpp"
+#include "subsampled_kmeans.hpp"
 #include "gmm_util.hpp"
 
 #include <mlpack/methods/kmeans/refined_start.hpp>
+#include <mlpack/methods/kmeans/dual_tree_kmeans.hpp>
 
 using namespace mlpack;
 using namespace mlpack::gmm;
@@ -35,7 +38,35 @@ PROGRAM_INFO("Gaussian Mixture Model (GMM) Training",
     "iteration of the EM algorithm which ensure that the covariance matrices "
     "are positive definite.  Specifying the flag can cause faster runtime, "
     "but may also cause non-positive definite covariance matrices, which will "
-    "cause the program to crash.");
+    "cause the program to crash."
+    "\n\n"
+    "Each iteration of the EM algorithm can be spread across several threads "
+    "with the --threads option."
+    "\n\n"
+    "If the 'diagonal_covariance' flag is specified, each Gaussian has a "
+    "diagonal covariance matrix, and only the variance of each dimension is "
+    "stored and estimated.  This takes much less memory and time in high "
+    "dimensions, and the covariance of each Gaussian in the output model is a "
+    "vector of variances."
+    "\n\n"
+    "If the 'online' flag is specified, the model is fit with online (stepwise)"
+    " EM, and the input file (which must be a CSV or whitespace-separated text "
+    "file) is read one mini-batch of --batch_size points at a time, so it does "
+    "not need to fit in memory.  After each mini-batch, the model is moved "
+    "towards the estimate from that mini-batch by a step size that decays as "
+    "t^(-decay), where t is the number of mini-batches seen.  The initial model"
+    " is computed from the first mini-batch, so the points in the file should "
+    "be in random order.  The --trials, --max_iterations, --tolerance, "
+    "--noise, and --threads options are not used with --online."
+    "\n\n"
+    "If --init_sample_size is given, the initial clustering of each trial is "
+    "done with k-means (seeded with k-means++) on a random subsample of that "
+    "many points, and then every point is assigned to its closest centroid.  "
+    "The --init_algorithm option selects the accelerated k-means algorithm used"
+    " on the subsample: 'hamerly' or 'dtnn' (dual-tree k-means, which is "
+    "faster for many Gaussians in low dimensions).  With 'hamerly', the "
+    "--threads option runs several trials at once instead of spreading each "
+    "iteration of EM across threads, and the best trial is kept.");
 
 PARAM_STRING_REQ("input_file", "File containing the data on which the model "
     "will be fit.", "i");
@@ -51,6 +82,20 @@ PARAM_FLAG("no_force_positive", "Do not force the covariance matrices to be "
     "positive definite.", "P");
 PARAM_INT("max_iterations", "Maximum number of iterations of EM algorithm "
     "(passing 0 will run until convergence).", "n", 250);
+PARAM_FLAG("diagonal_covariance", "Force the covariance of each Gaussian to be "
+    "diagonal, storing only the variances.", "d");
+PARAM_INT("threads", "Number of threads to use for each iteration of the EM "
+    "algorithm (0 uses as many threads as OpenMP allows).", "", 1);
+
+// Parameters for online EM.
+PARAM_FLAG("online", "Fit the model with online EM, reading the input file one "
+    "mini-batch at a time.", "O");
+PARAM_INT("batch_size", "Number of points in each mini-batch for online EM.",
+    "b", 1000);
+PARAM_INT("passes", "Number of passes over the input file for online EM.", "",
+    1);
+PARAM_DOUBLE("decay", "Exponent of the decay of the step size for online EM "
+    "(greater than 0.5 and at most 1.0).", "", 0.6);
 
 // Parameters for dataset modification.
 PARAM_DOUBLE("noise", "Variance of zero-mean Gaussian noise to add to data.",
@@ -64,6 +109,117 @@ PARAM_INT("samplings", "If using --refined_start, specify the number of "
 PARAM_DOUBLE("percentage", "If using --refined_start, specify the percentage of"
     " the dataset used for each sampling (should be between 0.0 and 1.0).",
     "p", 0.02);
+PARAM_INT("init_sample_size", "If nonzero, run k-means for the initialization "
+    "on a random subsample of this many points.", "", 0);
+PARAM_STRING("init_algorithm", "If using --init_sample_size, the k-means "
+    "algorithm to run on the subsample ('hamerly' or 'dtnn').", "", "hamerly");
+
+// Train a GMM with the given fitting mechanism, running the given number of
+// trials at once, and save it to the output file.
+template<typename Distribution, typename FittingType>
+void TrainGMM(const arma::mat& dataPoints,
+              const size_t gaussians,
+              FittingType& em,
+              const size_t trialThreads)
+{
+  GMM<FittingType, Distribution> gmm(gaussians, dataPoints.n_rows, em);
+  gmm.NumThreads() = trialThreads;
+
+  // Compute the parameters of the model using the EM algorithm.
+  Timer::Start("em");
+  const double likelihood = gmm.Estimate(dataPoints,
+      CLI::GetParam<int>("trials"));
+  Timer::Stop("em");
+
+  Log::Info << "Log-likelihood of estimate: " << likelihood << ".\n";
+
+  // Save results.
+  const string outputFile = CLI::GetParam<string>("output_file");
+  SaveGMM(gmm, outputFile);
+}
+
+// Train a GMM with online EM on the input file, reading it one mini-batch at a
+// time, and save it to the output file.
+template<typename Distribution, typename FittingType>
+void TrainOnlineGMM(const size_t gaussians, FittingType& fitter)
+{
+  data::ChunkReader reader(CLI::GetParam<string>("input_file"));
+  std::vector<Distribution> dists(gaussians);
+  arma::vec weights(gaussians);
+
+  Timer::Start("online_em");
+  fitter.Estimate(reader, dists, weights);
+  Timer::Stop("online_em");
+
+  if (reader.Dimensionality() == 0)
+    Log::Fatal << "No points in '" << reader.Filename() << "'!" << std::endl;
+
+  // Save results.
+  GMM<FittingType, Distribution> gmm(dists, weights, fitter);
+  const string outputFile = CLI::GetParam<string>("output_file");
+  SaveGMM(gmm, outputFile);
+}
+
+// Build the right fitting type for the --online option, and train the GMM.
+template<typename Distribution,
+         typename CovarianceConstraintPolicy,
+         typename InitialClusteringType>
+void TrainWithConstraint(const arma::mat& dataPoints,
+                         const size_t gaussians,
+                         const InitialClusteringType& clusterer,
+                         const size_t threads,
+                         const size_t trialThreads)
+{
+  if (CLI::HasParam("online"))
+  {
+    OnlineEMFit<InitialClusteringType, CovarianceConstraintPolicy,
+        Distribution> fitter((size_t) CLI::GetParam<int>("batch_size"),
+        (size_t) CLI::GetParam<int>("passes"), CLI::GetParam<double>("decay"),
+        clusterer);
+    TrainOnlineGMM<Distribution>(gaussians, fitter);
+  }
+  else
+  {
+    EMFit<InitialClusteringType, CovarianceConstraintPolicy, Distribution> em(
+        (size_t) CLI::GetParam<int>("max_iterations"),
+        CLI::GetParam<double>("tolerance"), clusterer);
+    em.NumThreads() = threads;
+    TrainGMM<Distribution>(dataPoints, gaussians, em, trialThreads);
+  }
+}
+
+// Pick the distribution and covariance constraint for the
+// --diagonal_covariance and --no_force_positive options, and train the GMM.
+template<typename InitialClusteringType>
+void TrainWithClusterer(const arma::mat& dataPoints,
+                        const size_t gaussians,
+                        const InitialClusteringType& clusterer,
+                        const size_t threads,
+                        const size_t trialThreads = 1)
+{
+  const bool forcePositive = !CLI::HasParam("no_force_positive");
+
+  if (CLI::HasParam("diagonal_covariance"))
+  {
+    typedef distribution::DiagonalGaussianDistribution DistType;
+    if (forcePositive)
+      TrainWithConstraint<DistType, PositiveDefiniteConstraint>(dataPoints,
+          gaussians, clusterer, threads, trialThreads);
+    else // Use no constraints on the covariance matrix.
+      TrainWithConstraint<DistType, NoConstraint>(dataPoints, gaussians,
+          clusterer, threads, trialThreads);
+  }
+  else
+  {
+    typedef distribution::GaussianDistribution DistType;
+    if (forcePositive)
+      TrainWithConstraint<DistType, PositiveDefiniteConstraint>(dataPoints,
+          gaussians, clusterer, threads, trialThreads);
+    else // Use no constraints on the covariance matrix.
+      TrainWithConstraint<DistType, NoConstraint>(dataPoints, gaussians,
+          clusterer, threads, trialThreads);
+  }
+}
 
 int main(int argc, char* argv[])
 {
@@ -75,10 +231,6 @@ int main(int argc, char* argv[])
   else
     math::RandomSeed((size_t) std::time(NULL));
 
-  arma::mat dataPoints;
-  data::Load(CLI::GetParam<string>("input_file"), dataPoints,
-      true);
-
   const int gaussians = CLI::GetParam<int>("gaussians");
   if (gaussians <= 0)
   {
@@ -86,8 +238,34 @@ int main(int argc, char* argv[])
         "be greater than or equal to 1." << std::endl;
   }
 
+  // With --online, the input file is read one mini-batch at a time later.
+  arma::mat dataPoints;
+  if (CLI::HasParam("online"))
+  {
+    if (CLI::GetParam<int>("batch_size") <= 0)
+      Log::Fatal << "Invalid batch size (" << CLI::GetParam<int>("batch_size")
+          << "); must be greater than 0." << std::endl;
+
+    if (CLI::GetParam<int>("passes") <= 0)
+      Log::Fatal << "Invalid number of passes (" << CLI::GetParam<int>("passes")
+          << "); must be greater than 0." << std::endl;
+
+    const double decay = CLI::GetParam<double>("decay");
+    if (decay <= 0.5 || decay > 1.0)
+      Log::Fatal << "Invalid decay (" << decay << "); must be greater than 0.5 "
+          << "and less than or equal to 1.0." << std::endl;
+
+    if (CLI::HasParam("noise"))
+      Log::Warn << "--noise is ignored when --online is specified."
+          << std::endl;
+  }
+  else
+  {
+    data::Load(CLI::GetParam<string>("input_file"), dataPoints, true);
+  }
+
   // Do we need to add noise to the dataset?
-  if (CLI::HasParam("noise"))
+  if (CLI::HasParam("noise") && !CLI::HasParam("online"))
   {
     Timer::Start("noise_addition");
     const double noise = CLI::GetParam<double>("noise");
@@ -97,15 +275,55 @@ int main(int argc, char* argv[])
     Timer::Stop("noise_addition");
   }
 
-  // Gather parameters for EMFit object.
-  const size_t maxIterations = (size_t) CLI::GetParam<int>("max_iterations");
-  const double tolerance = CLI::GetParam<double>("tolerance");
-  const bool forcePositive = !CLI::HasParam("no_force_positive");
+  const int threads = CLI::GetParam<int>("threads");
+  if (threads < 0)
+    Log::Fatal << "Invalid number of threads: " << threads << ".  Must be "
+        << "greater than or equal to 0." << std::endl;
+
+  const int initSampleSize = CLI::GetParam<int>("init_sample_size");
+  if (initSampleSize < 0)
+    Log::Fatal << "Invalid initialization sample size (" << initSampleSize
+        << "); must be greater than or equal to 0." << std::endl;
+
+  if (initSampleSize > 0 && CLI::HasParam("refined_start"))
+    Log::Fatal << "Cannot specify both --init_sample_size and --refined_start!"
+        << std::endl;
 
   // This gets a bit weird because we need different types depending on whether
-  // --refined_start is specified.
-  double likelihood;
-  if (CLI::HasParam("refined_start"))
+  // --refined_start or --init_sample_size is specified.
+  if (initSampleSize > 0)
+  {
+    const string initAlgorithm = CLI::GetParam<string>("init_algorithm");
+    if (initAlgorithm == "hamerly")
+    {
+      // The trials are independent, so they are spread across the threads
+      // instead of each iteration of EM, unless there is only one trial (or
+      // with --online, where there are no trials).
+      SubsampledKMeans<HamerlyKMeans> k((size_t) initSampleSize);
+      if (CLI::GetParam<int>("trials") > 1 && !CLI::HasParam("online"))
+        TrainWithClusterer(dataPoints, size_t(gaussians), k, 1,
+            size_t(threads));
+      else
+      {
+        k.NumThreads() = size_t(threads);
+        TrainWithClusterer(dataPoints, size_t(gaussians), k, size_t(threads));
+      }
+    }
+    else if (initAlgorithm == "dtnn")
+    {
+      // Dual-tree k-means uses the global timers, so its trials run one at a
+      // time.
+      SubsampledKMeans<DefaultDualTreeKMeans> k((size_t) initSampleSize);
+      k.NumThreads() = size_t(threads);
+      TrainWithClusterer(dataPoints, size_t(gaussians), k, size_t(threads));
+    }
+    else
+    {
+      Log::Fatal << "Unknown initialization algorithm '" << initAlgorithm
+          << "'; must be 'hamerly' or 'dtnn'." << std::endl;
+    }
+  }
+  else if (CLI::HasParam("refined_start"))
   {
     const int samplings = CLI::GetParam<int>("samplings");
     const double percentage = CLI::GetParam<double>("percentage");
@@ -124,78 +342,11 @@ int main(int argc, char* argv[])
     KMeansType k(1000, metric::SquaredEuclideanDistance(),
         RefinedStart(samplings, percentage));
 
-    // Depending on the value of 'forcePositive', we have to use different
-    // types.
-    if (forcePositive)
-    {
-      EMFit<KMeansType> em(maxIterations, tolerance, k);
-
-      GMM<EMFit<KMeansType> > gmm(size_t(gaussians), dataPoints.n_rows, em);
-
-      // Compute the parameters of the model using the EM algorithm.
-      Timer::Start("em");
-      likelihood = gmm.Estimate(dataPoints, CLI::GetParam<int>("trials"));
-      Timer::Stop("em");
-
-      // Save results.
-      const string outputFile = CLI::GetParam<string>("output_file");
-      SaveGMM(gmm, outputFile);
-    }
-    else
-    {
-      EMFit<KMeansType, NoConstraint> em(maxIterations, tolerance, k);
-
-      GMM<EMFit<KMeansType, NoConstraint> > gmm(size_t(gaussians),
-          dataPoints.n_rows, em);
-
-      // Compute the parameters of the model using the EM algorithm.
-      Timer::Start("em");
-      likelihood = gmm.Estimate(dataPoints, CLI::GetParam<int>("trials"));
-      Timer::Stop("em");
-
-      // Save results.
-      const string outputFile = CLI::GetParam<string>("output_file");
-      SaveGMM(gmm, outputFile);
-    }
+    TrainWithClusterer(dataPoints, size_t(gaussians), k, size_t(threads));
   }
   else
   {
-    // Depending on the value of forcePositive, we have to use different types.
-    if (forcePositive)
-    {
-      EMFit<> em(maxIterations, tolerance);
-
-      // Calculate mixture of Gaussians.
-      GMM<> gmm(size_t(gaussians), dataPoints.n_rows, em);
-
-      // Compute the parameters of the model using the EM algorithm.
-      Timer::Start("em");
-      likelihood = gmm.Estimate(dataPoints, CLI::GetParam<int>("trials"));
-      Timer::Stop("em");
-
-      // Save results.
-      const string outputFile = CLI::GetParam<string>("output_file");
-      SaveGMM(gmm, outputFile);
-    }
-    else
-    {
-      // Use no constraints on the covariance matrix.
-      EMFit<KMeans<>, NoConstraint> em(maxIterations, tolerance);
-
-      // Calculate mixture of Gaussians.
-      GMM<EMFit<KMeans<>, NoConstraint> > gmm(size_t(gaussians),
-          dataPoints.n_rows, em);
-
-      // Compute the parameters of the model using the EM algorithm.
-      Timer::Start("em");
-      likelihood = gmm.Estimate(dataPoints, CLI::GetParam<int>("trials"));
-      Timer::Stop("em");
-
-      // Save results.
-      const string outputFile = CLI::GetParam<string>("output_file");
-      SaveGMM(gmm, outputFile);
-    }
+    TrainWithClusterer(dataPoints, size_t(gaussians), KMeans<>(),
+        size_t(threads));
   }
-
-  Log::Info << "Log-likelihood of estimate: " << likelihood << ".\n";
 }
@@ -0,0 +1,202 @@
+/**
+ * @file gmm_tree_scorer.hpp
+ *
+ * Approximate computation of the log-probability of points under a GMM with
+ * many components, using a tree built on the means of the components.
+ */
+#ifndef __MLPACK_METHODS_GMM_GMM_TREE_SCORER_HPP
+#define __MLPACK_METHODS_GMM_GMM_TREE_SCORER_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/dists/diagonal_gaussian_distribution.hpp>
+#include <mlpack/core/tree/binary_space_tree.hpp>
+
+#include "gmm.hpp"
+#include "gmm_tree_scorer_stat.hpp"
+#include "gmm_tree_scorer_rules.hpp"
+
+namespace mlpack {
+namespace gmm {
+
+/**
+ * This class computes the log-probability of points under a GMM with many
+ * components, without evaluating the components that contribute next to
+ * nothing.  A kd-tree is built on the means of the components, and each node
+ * holds the largest weighted density at the mean and the largest variance of
+ * its components.  The weighted density of each component at a point is at most
+ * its value at the mean times exp(-d^2 / (2 v)), where d is the distance from
+ * the point to the mean and v is the largest variance of the component, so a
+ * bound on the total contribution of a node is found from the distance of the
+ * point to the bounding box of the node.  For each point, the tree is traversed
+ * with the nodes of largest bound first, and a node is pruned if its bound is
+ * at most its share of the tolerance times the probability found so far.
+ *
+ * The result is certified: the computed probability p' of each point is at
+ * most the true probability p, and p <= p' + (the sum of the pruned bounds) <=
+ * (1 + tolerance) p'.  So the log-probability is underestimated by at most the
+ * returned error bound for the point, which is itself at most
+ * log(1 + tolerance).  A tolerance of 0 gives the exact log-probability.
+ *
+ * @code
+ * GMM<> gmm(4096, data.n_rows);
+ * gmm.Estimate(data);
+ *
+ * GMMTreeScorer<> scorer(gmm, 1e-3);
+ * arma::vec logProbabilities, errorBounds;
+ * scorer.LogProbability(queries, logProbabilities, errorBounds);
+ * @endcode
+ *
+ * The scorer keeps its own copy of the components, so it must be rebuilt if
+ * the GMM changes.
+ *
+ * @tparam Distribution Type of the components (distribution::
+ *     GaussianDistribution or distribution::DiagonalGaussianDistribution).
+ */
+template<typename Distribution = distribution::GaussianDistribution>
+class GMMTreeScorer
+{
+ public:
+  //! The type of tree built on the means of the components.
+  typedef tree::KDTree<metric::EuclideanDistance, GMMTreeScorerStat, arma::mat>
+      Tree;
+
+  /**
+   * Build the tree on the given components.
+   *
+   * @param dists Components of the GMM.
+   * @param weights Weight of each component.
+   * @param tolerance Allowed relative error on the probability of each point.
+   * @param leafSize Maximum number of components in each leaf of the tree.
+   */
+  GMMTreeScorer(const std::vector<Distribution>& dists,
+                const arma::vec& weights,
+                const double tolerance = 1e-3,
+                const size_t leafSize = 20);
+
+  /**
+   * Build the tree on the components of the given GMM.
+   *
+   * @param gmm GMM to compute the log-probabilities under.
+   * @param tolerance Allowed relative error on the probability of each point.
+   * @param leafSize Maximum number of components in each leaf of the tree.
+   */
+  template<typename FittingType>
+  GMMTreeScorer(const GMM<FittingType, Distribution>& gmm,
+                const double tolerance = 1e-3,
+                const size_t leafSize = 20);
+
+  //! Copy the given scorer, including its tree.
+  GMMTreeScorer(const GMMTreeScorer& other);
+
+  //! Take the tree and components of the given scorer, which is left without
+  //! a tree (it can then only be destroyed or assigned to).
+  GMMTreeScorer(GMMTreeScorer&& other);
+
+  //! Copy the given scorer, including its tree.
+  GMMTreeScorer& operator=(const GMMTreeScorer& other);
+
+  //! Take the tree and components of the given scorer, which is left without
+  //! a tree (it can then only be destroyed or assigned to).
+  GMMTreeScorer& operator=(GMMTreeScorer&& other);
+
+  //! Delete the tree.
+  ~GMMTreeScorer();
+
+  /**
+   * Compute the log-probability of the given observation, and a bound on how
+   * much it is underestimated by.
+   *
+   * @param observation Observation to evaluate the log-probability of.
+   * @param errorBound Set to the bound on the error of the log-probability.
+   * @return Log-probability of the observation.
+   */
+  double LogProbability(const arma::vec& observation, double& errorBound);
+
+  /**
+   * Compute the log-probability of each of the given observations (one per
+   * column), and a bound on how much each is underestimated by.  The
+   * observations are scored in parallel if NumThreads() is not 1.
+   *
+   * @param observations Observations to evaluate the log-probability of.
+   * @param logProbabilities Vector to store the log-probability of each
+   *     observation in.
+   * @param errorBounds Vector to store the bound on the error of each
+   *     log-probability in.
+   */
+  void LogProbability(const arma::mat& observations,
+                      arma::vec& logProbabilities,
+                      arma::vec& errorBounds);
+
+  /**
+   * Compute the log-likelihood of the given observations, and a bound on how
+   * much it is underestimated by (the sum of the bounds for each observation).
+   *
+   * @param observations Observations to evaluate the log-likelihood of.
+   * @param errorBound Set to the bound on the error of the log-likelihood.
+   * @return Log-likelihood of the observations.
+   */
+  double LogLikelihood(const arma::mat& observations, double& errorBound);
+
+  //! Get the allowed relative error on the probability of each point.
+  double Tolerance() const { return tolerance; }
+  //! Modify the allowed relative error on the probability of each point.
+  double& Tolerance() { return tolerance; }
+
+  //! Get the number of threads used to score observations.
+  size_t NumThreads() const { return numThreads; }
+  //! Modify the number of threads used to score observations (0 means as many
+  //! as OpenMP allows).
+  size_t& NumThreads() { return numThreads; }
+
+  //! Get the number of components evaluated in the last call.
+  size_t BaseCases() const { return baseCases; }
+
+  //! Get the number of components.
+  size_t Components() const { return dists.size(); }
+
+  //! Get the tree built on the means of the components.
+  const Tree& ReferenceTree() const { return *tree; }
+
+ private:
+  //! The tree built on the means of the components.
+  Tree* tree;
+  //! The components, in the order of the tree.
+  std::vector<Distribution> dists;
+  //! The log of the weight of each component, in the order of the tree.
+  arma::vec logWeights;
+  //! The allowed relative error on the probability of each point.
+  double tolerance;
+  //! The number of threads to use.
+  size_t numThreads;
+  //! The number of components evaluated in the last call.
+  size_t baseCases;
+
+  //! Build the tree on the given components, and fill its statistics.
+  void BuildTree(const std::vector<Distribution>& components,
+                 const arma::vec& weights,
+                 const size_t leafSize);
+
+  //! Fill the statistics of the given node and its descendants, given the
+  //! log-scale and largest variance of each component.
+  void BuildStatistics(Tree& node,
+                       const arma::vec& logScales,
+                       const arma::vec& variances);
+
+  //! Get the largest variance of a full-covariance Gaussian.
+  static double MaxVariance(const distribution::GaussianDistribution& dist);
+
+  //! Get the largest variance of a diagonal Gaussian.
+  static double MaxVariance(
+      const distribution::DiagonalGaussianDistribution& dist);
+
+  //! Get the number of threads that will actually be used.
+  size_t ThreadsToUse() const;
+};
+
+} // namespace gmm
+} // namespace mlpack
+
+// Include implementation.
+#include "gmm_tree_scorer_impl.hpp"
+
+#endif
@@ -0,0 +1,290 @@
+/**
+ * @file gmm_tree_scorer_impl.hpp
+ *
+ * Implementation of GMMTreeScorer.
+ */
+#ifndef __MLPACK_METHODS_GMM_GMM_TREE_SCORER_IMPL_HPP
+#define __MLPACK_METHODS_GMM_GMM_TREE_SCORER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "gmm_tree_scorer.hpp"
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+namespace mlpack {
+namespace gmm {
+
+template<typename Distribution>
+GMMTreeScorer<Distribution>::GMMTreeScorer(
+    const std::vector<Distribution>& dists,
+    const arma::vec& weights,
+    const double tolerance,
+    const size_t leafSize) :
+    tree(NULL),
+    tolerance(tolerance),
+    numThreads(1),
+    baseCases(0)
+{
+  BuildTree(dists, weights, leafSize);
+}
+
+template<typename Distribution>
+template<typename FittingType>
+GMMTreeScorer<Distribution>::GMMTreeScorer(
+    const GMM<FittingType, Distribution>& gmm,
+    const double tolerance,
+    const size_t leafSize) :
+    tree(NULL),
+    tolerance(tolerance),
+    numThreads(1),
+    baseCases(0)
+{
+  std::vector<Distribution> components;
+  for (size_t i = 0; i < gmm.Gaussians(); ++i)
+    components.push_back(gmm.Component(i));
+
+  BuildTree(components, gmm.Weights(), leafSize);
+}
+
+template<typename Distribution>
+GMMTreeScorer<Distribution>::GMMTreeScorer(const GMMTreeScorer& other) :
+    tree((other.tree == NULL) ? NULL : new Tree(*other.tree)),
+    dists(other.dists),
+    logWeights(other.logWeights),
+    tolerance(other.tolerance),
+    numThreads(other.numThreads),
+    baseCases(other.baseCases)
+{
+  // Nothing to do.
+}
+
+template<typename Distribution>
+GMMTreeScorer<Distribution>::GMMTreeScorer(GMMTreeScorer&& other) :
+    tree(other.tree),
+    dists(std::move(other.dists)),
+    logWeights(std::move(other.logWeights)),
+    tolerance(other.tolerance),
+    numThreads(other.numThreads),
+    baseCases(other.baseCases)
+{
+  other.tree = NULL;
+}
+
+template<typename Distribution>
+GMMTreeScorer<Distribution>& GMMTreeScorer<Distribution>::operator=(
+    const GMMTreeScorer& other)
+{
+  if (this != &other)
+  {
+    delete tree;
+    tree = (other.tree == NULL) ? NULL : new Tree(*other.tree);
+    dists = other.dists;
+    logWeights = other.logWeights;
+    tolerance = other.tolerance;
+    numThreads = other.numThreads;
+    baseCases = other.baseCases;
+  }
+
+  return *this;
+}
+
+template<typename Distribution>
+GMMTreeScorer<Distribution>& GMMTreeScorer<Distribution>::operator=(
+    GMMTreeScorer&& other)
+{
+  if (this != &other)
+  {
+    delete tree;
+    tree = other.tree;
+    other.tree = NULL;
+    dists = std::move(other.dists);
+    logWeights = std::move(other.logWeights);
+    tolerance = other.tolerance;
+    numThreads = other.numThreads;
+    baseCases = other.baseCases;
+  }
+
+  return *this;
+}
+
+template<typename Distribution>
+GMMTreeScorer<Distribution>::~GMMTreeScorer()
+{
+  delete tree;
+}
+
+template<typename Distribution>
+double GMMTreeScorer<Distribution>::LogProbability(
+    const arma::vec& observation,
+    double& errorBound)
+{
+  arma::vec logProbabilities, errorBounds;
+  LogProbability(arma::mat(observation), logProbabilities, errorBounds);
+
+  errorBound = errorBounds[0];
+  return logProbabilities[0];
+}
+
+template<typename Distribution>
+void GMMTreeScorer<Distribution>::LogProbability(
+    const arma::mat& observations,
+    arma::vec& logProbabilities,
+    arma::vec& errorBounds)
+{
+  if (tolerance < 0.0)
+    Log::Fatal << "GMMTreeScorer::LogProbability(): tolerance must be "
+        << "nonnegative (given " << tolerance << ")!" << std::endl;
+
+  if (observations.n_rows != tree->Dataset().n_rows)
+    Log::Fatal << "GMMTreeScorer::LogProbability(): observations have "
+        << "dimensionality " << observations.n_rows << ", but the GMM has "
+        << "dimensionality " << tree->Dataset().n_rows << "!" << std::endl;
+
+  const size_t n = observations.n_cols;
+  logProbabilities.set_size(n);
+  logProbabilities.fill(-std::numeric_limits<double>::infinity());
+  arma::vec logPruned(n);
+  logPruned.fill(-std::numeric_limits<double>::infinity());
+
+  // Each point is scored with its own traversal of the tree, which only
+  // touches the entries of that point.
+  typedef GMMTreeScorerRules<Distribution, Tree> RuleType;
+  size_t totalBaseCases = 0;
+  const size_t threads = ThreadsToUse();
+  #pragma omp parallel for num_threads(threads) schedule(dynamic, 16) \
+      reduction(+:totalBaseCases)
+  for (size_t i = 0; i < n; ++i)
+  {
+    RuleType rules(observations, dists, logWeights, tolerance,
+        logProbabilities, logPruned);
+    typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
+    traverser.Traverse(i, *tree);
+
+    totalBaseCases += rules.BaseCases();
+  }
+
+  baseCases = totalBaseCases;
+  Log::Info << baseCases << " component evaluations for " << n << " points ("
+      << dists.size() << " components)." << std::endl;
+
+  // The true probability is at most the computed probability plus the pruned
+  // bounds.
+  errorBounds.set_size(n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (logPruned[i] == -std::numeric_limits<double>::infinity())
+      errorBounds[i] = 0.0;
+    else
+      errorBounds[i] = std::log1p(std::exp(logPruned[i] -
+          logProbabilities[i]));
+  }
+}
+
+template<typename Distribution>
+double GMMTreeScorer<Distribution>::LogLikelihood(
+    const arma::mat& observations,
+    double& errorBound)
+{
+  arma::vec logProbabilities, errorBounds;
+  LogProbability(observations, logProbabilities, errorBounds);
+
+  errorBound = accu(errorBounds);
+  return accu(logProbabilities);
+}
+
+template<typename Distribution>
+void GMMTreeScorer<Distribution>::BuildTree(
+    const std::vector<Distribution>& components,
+    const arma::vec& weights,
+    const size_t leafSize)
+{
+  const size_t k = components.size();
+  if (k == 0)
+    Log::Fatal << "GMMTreeScorer::GMMTreeScorer(): the GMM has no components!"
+        << std::endl;
+
+  if (weights.n_elem != k)
+    Log::Fatal << "GMMTreeScorer::GMMTreeScorer(): there are " << k
+        << " components but " << weights.n_elem << " weights!" << std::endl;
+
+  if (leafSize == 0)
+    Log::Fatal << "GMMTreeScorer::GMMTreeScorer(): leaf size must be greater "
+        << "than 0!" << std::endl;
+
+  arma::mat means(components[0].Mean().n_elem, k);
+  for (size_t i = 0; i < k; ++i)
+    means.col(i) = components[i].Mean();
+
+  Timer::Start("tree_building");
+  std::vector<size_t> oldFromNew;
+  tree = new Tree(std::move(means), oldFromNew, leafSize);
+  Timer::Stop("tree_building");
+
+  // Store the components in the order of the tree, along with the largest
+  // weighted density of each (which is at its mean) and its largest variance.
+  dists.clear();
+  dists.reserve(k);
+  logWeights.set_size(k);
+  arma::vec logScales(k), variances(k);
+  for (size_t i = 0; i < k; ++i)
+  {
+    const Distribution& dist = components[oldFromNew[i]];
+    dists.push_back(dist);
+    logWeights[i] = std::log(weights[oldFromNew[i]]);
+    logScales[i] = logWeights[i] + dist.LogProbability(dist.Mean());
+    variances[i] = MaxVariance(dist);
+  }
+
+  BuildStatistics(*tree, logScales, variances);
+}
+
+template<typename Distribution>
+void GMMTreeScorer<Distribution>::BuildStatistics(Tree& node,
+                                                  const arma::vec& logScales,
+                                                  const arma::vec& variances)
+{
+  GMMTreeScorerStat& stat = node.Stat();
+  for (size_t i = 0; i < node.NumDescendants(); ++i)
+  {
+    const size_t index = node.Descendant(i);
+    stat.MaxLogScale() = std::max(stat.MaxLogScale(), logScales[index]);
+    stat.MaxVariance() = std::max(stat.MaxVariance(), variances[index]);
+  }
+
+  for (size_t i = 0; i < node.NumChildren(); ++i)
+    BuildStatistics(node.Child(i), logScales, variances);
+}
+
+template<typename Distribution>
+double GMMTreeScorer<Distribution>::MaxVariance(
+    const distribution::GaussianDistribution& dist)
+{
+  return arma::max(arma::eig_sym(dist.Covariance()));
+}
+
+template<typename Distribution>
+double GMMTreeScorer<Distribution>::MaxVariance(
+    const distribution::DiagonalGaussianDistribution& dist)
+{
+  return arma::max(dist.Covariance());
+}
+
+template<typename Distribution>
+size_t GMMTreeScorer<Distribution>::ThreadsToUse() const
+{
+  if (numThreads != 0)
+    return numThreads;
+
+#ifdef _OPENMP
+  return (size_t) omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+} // namespace gmm
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,124 @@
+/**
+ * @file gmm_tree_scorer_rules.hpp
+ *
+ * Rules for the single-tree traversal done by GMMTreeScorer, which evaluate the
+ * components of a GMM that may contribute to the probability of a point and
+ * prune the others.
+ */
+#ifndef __MLPACK_METHODS_GMM_GMM_TREE_SCORER_RULES_HPP
+#define __MLPACK_METHODS_GMM_GMM_TREE_SCORER_RULES_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace gmm {
+
+/**
+ * The rules for scoring points against a tree of the means of the components
+ * of a GMM.  The log-probability of each query point is accumulated as the
+ * components are evaluated.  A node is pruned when the bound on the total
+ * contribution of its components is at most its share of the allowed error:
+ * the tolerance times the probability accumulated so far, times the fraction of
+ * the components that are in the node.  The bounds of the pruned nodes are
+ * accumulated too, so the error of each point can be reported.
+ *
+ * Only single-tree traversals are supported.
+ */
+template<typename Distribution, typename TreeType>
+class GMMTreeScorerRules
+{
+ public:
+  /**
+   * Construct the rules.  The log-probabilities and pruned bounds of the query
+   * points must be initialized to -infinity before the traversal.
+   *
+   * @param querySet Set of query points.
+   * @param dists Components of the GMM, in the order of the tree.
+   * @param logWeights Log of the weight of each component, in the order of the
+   *     tree.
+   * @param tolerance Allowed relative error on the probability of each point.
+   * @param logProbabilities Vector to accumulate the log-probability of the
+   *     evaluated components for each query point in.
+   * @param logPruned Vector to accumulate the log of the bound on the pruned
+   *     components for each query point in.
+   */
+  GMMTreeScorerRules(const arma::mat& querySet,
+                     const std::vector<Distribution>& dists,
+                     const arma::vec& logWeights,
+                     const double tolerance,
+                     arma::vec& logProbabilities,
+                     arma::vec& logPruned);
+
+  /**
+   * Evaluate the given component for the given query point, and add its
+   * weighted probability to the probability of the point.
+   *
+   * @param queryIndex Index of query point.
+   * @param referenceIndex Index of component.
+   * @return Log of the weighted probability of the point under the component.
+   */
+  double BaseCase(const size_t queryIndex, const size_t referenceIndex);
+
+  /**
+   * Get the score for recursion order.  Nodes with a larger bound on their
+   * contribution get a lower score, and DBL_MAX indicates that the node is
+   * pruned (and its bound is added to the pruned bound of the query point).
+   *
+   * @param queryIndex Index of query point.
+   * @param referenceNode Candidate node to be recursed into.
+   */
+  double Score(const size_t queryIndex, TreeType& referenceNode);
+
+  /**
+   * Re-evaluate the score for recursion order, since the probability of the
+   * query point (and so the allowed error) may have grown since the score was
+   * computed.
+   *
+   * @param queryIndex Index of query point.
+   * @param referenceNode Candidate node to be recursed into.
+   * @param oldScore Old score produced by Score() (or Rescore()).
+   */
+  double Rescore(const size_t queryIndex,
+                 TreeType& referenceNode,
+                 const double oldScore);
+
+  //! Get the number of base cases (component evaluations).
+  size_t BaseCases() const { return baseCases; }
+  //! Modify the number of base cases (component evaluations).
+  size_t& BaseCases() { return baseCases; }
+
+ private:
+  //! The query set.
+  const arma::mat& querySet;
+  //! The components, in the order of the tree.
+  const std::vector<Distribution>& dists;
+  //! The log of the weight of each component, in the order of the tree.
+  const arma::vec& logWeights;
+  //! The log of the tolerance.
+  double logTolerance;
+  //! The log of the number of components.
+  double logComponents;
+  //! The log-probability of the evaluated components for each query point.
+  arma::vec& logProbabilities;
+  //! The log of the bound on the pruned components for each query point.
+  arma::vec& logPruned;
+  //! The number of base cases.
+  size_t baseCases;
+
+  //! Prune the node if its bound is small enough, returning DBL_MAX, or return
+  //! the score of the node.
+  double PruneOrScore(const size_t queryIndex,
+                      const TreeType& referenceNode,
+                      const double logBound);
+
+  //! Return log(exp(a) + exp(b)) without underflow.
+  static double LogAdd(const double a, const double b);
+};
+
+} // namespace gmm
+} // namespace mlpack
+
+// Include implementation.
+#include "gmm_tree_scorer_rules_impl.hpp"
+
+#endif
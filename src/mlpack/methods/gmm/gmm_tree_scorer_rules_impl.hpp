@@ -0,0 +1,117 @@
+/**
+ * @file gmm_tree_scorer_rules_impl.hpp
+ *
+ * Implementation of the rules for GMMTreeScorer.
+ */
+#ifndef __MLPACK_METHODS_GMM_GMM_TREE_SCORER_RULES_IMPL_HPP
+#define __MLPACK_METHODS_GMM_GMM_TREE_SCORER_RULES_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "gmm_tree_scorer_rules.hpp"
+
+namespace mlpack {
+namespace gmm {
+
+template<typename Distribution, typename TreeType>
+GMMTreeScorerRules<Distribution, TreeType>::GMMTreeScorerRules(
+    const arma::mat& querySet,
+    const std::vector<Distribution>& dists,
+    const arma::vec& logWeights,
+    const double tolerance,
+    arma::vec& logProbabilities,
+    arma::vec& logPruned) :
+    querySet(querySet),
+    dists(dists),
+    logWeights(logWeights),
+    logTolerance(std::log(tolerance)),
+    logComponents(std::log((double) dists.size())),
+    logProbabilities(logProbabilities),
+    logPruned(logPruned),
+    baseCases(0)
+{
+  // Nothing to do.
+}
+
+template<typename Distribution, typename TreeType>
+inline force_inline
+double GMMTreeScorerRules<Distribution, TreeType>::BaseCase(
+    const size_t queryIndex,
+    const size_t referenceIndex)
+{
+  ++baseCases;
+  const double logProbability = logWeights[referenceIndex] +
+      dists[referenceIndex].LogProbability(querySet.unsafe_col(queryIndex));
+  logProbabilities[queryIndex] = LogAdd(logProbabilities[queryIndex],
+      logProbability);
+
+  return logProbability;
+}
+
+template<typename Distribution, typename TreeType>
+double GMMTreeScorerRules<Distribution, TreeType>::Score(
+    const size_t queryIndex,
+    TreeType& referenceNode)
+{
+  // The log-density of each component is at most its value at the mean, minus
+  // half the squared distance to the mean over the largest variance.
+  const double distance = referenceNode.MinDistance(
+      querySet.unsafe_col(queryIndex));
+  double logBound = std::log((double) referenceNode.NumDescendants()) +
+      referenceNode.Stat().MaxLogScale();
+  if (distance > 0.0)
+    logBound -= distance * distance /
+        (2.0 * referenceNode.Stat().MaxVariance());
+
+  return PruneOrScore(queryIndex, referenceNode, logBound);
+}
+
+template<typename Distribution, typename TreeType>
+double GMMTreeScorerRules<Distribution, TreeType>::Rescore(
+    const size_t queryIndex,
+    TreeType& referenceNode,
+    const double oldScore)
+{
+  // If the node was already pruned, its bound has already been counted.
+  if (oldScore == DBL_MAX)
+    return oldScore;
+
+  return PruneOrScore(queryIndex, referenceNode, -oldScore);
+}
+
+template<typename Distribution, typename TreeType>
+double GMMTreeScorerRules<Distribution, TreeType>::PruneOrScore(
+    const size_t queryIndex,
+    const TreeType& referenceNode,
+    const double logBound)
+{
+  // The node may use its share of the allowed error.  The probability of the
+  // query point only grows, so the total of the pruned bounds is at most the
+  // tolerance times the final probability.
+  const double logAllowed = logTolerance + logProbabilities[queryIndex] +
+      std::log((double) referenceNode.NumDescendants()) - logComponents;
+
+  if (logBound <= logAllowed)
+  {
+    logPruned[queryIndex] = LogAdd(logPruned[queryIndex], logBound);
+    return DBL_MAX;
+  }
+
+  // Recurse into the nodes with the largest bounds first.
+  return -logBound;
+}
+
+template<typename Distribution, typename TreeType>
+double GMMTreeScorerRules<Distribution, TreeType>::LogAdd(const double a,
+                                                          const double b)
+{
+  const double larger = std::max(a, b);
+  if (larger == -std::numeric_limits<double>::infinity())
+    return larger;
+
+  return larger + std::log1p(std::exp(std::min(a, b) - larger));
+}
+
+} // namespace gmm
+} // namespace mlpack
+
+#endif
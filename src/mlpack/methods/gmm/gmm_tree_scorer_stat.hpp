@@ -0,0 +1,62 @@
+/**
+ * @file gmm_tree_scorer_stat.hpp
+ *
+ * Statistic for the tree of component means built by GMMTreeScorer, which
+ * holds what is needed to bound the contribution of the components in a node.
+ */
+#ifndef __MLPACK_METHODS_GMM_GMM_TREE_SCORER_STAT_HPP
+#define __MLPACK_METHODS_GMM_GMM_TREE_SCORER_STAT_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace gmm {
+
+/**
+ * Statistic class for GMMTreeScorer.  For the components whose means are
+ * descendants of the node, this holds the largest value of the log of the
+ * weighted density (which is reached at the mean of each component) and the
+ * largest variance in any direction.  These are filled in by GMMTreeScorer
+ * after the tree is built.
+ */
+class GMMTreeScorerStat
+{
+ public:
+  /**
+   * Initialize the statistic.
+   */
+  GMMTreeScorerStat() :
+      maxLogScale(-std::numeric_limits<double>::infinity()),
+      maxVariance(0.0) { }
+
+  /**
+   * Initialize the statistic given a tree node that this statistic belongs to.
+   * In this case, we ignore the node; the statistic is filled in later.
+   */
+  template<typename TreeType>
+  GMMTreeScorerStat(TreeType& /* node */) :
+      maxLogScale(-std::numeric_limits<double>::infinity()),
+      maxVariance(0.0) { }
+
+  //! Get the largest log of the weighted density of any descendant component.
+  double MaxLogScale() const { return maxLogScale; }
+  //! Modify the largest log of the weighted density of any descendant
+  //! component.
+  double& MaxLogScale() { return maxLogScale; }
+
+  //! Get the largest variance of any descendant component.
+  double MaxVariance() const { return maxVariance; }
+  //! Modify the largest variance of any descendant component.
+  double& MaxVariance() { return maxVariance; }
+
+ private:
+  //! The largest log of the weighted density of any descendant component.
+  double maxLogScale;
+  //! The largest variance (in any direction) of any descendant component.
+  double maxVariance;
+};
+
+} // namespace gmm
+} // namespace mlpack
+
+#endif
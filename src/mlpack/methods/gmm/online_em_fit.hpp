@@ -0,0 +1,265 @@
+/**
+ * @file online_em_fit.hpp
+ *
+ * Utility class to fit a GMM with online (stepwise) EM, one mini-batch of
+ * points at a time.
+ */
+#ifndef __MLPACK_METHODS_GMM_ONLINE_EM_FIT_HPP
+#define __MLPACK_METHODS_GMM_ONLINE_EM_FIT_HPP
+
+#include <mlpack/core.hpp>
+
+#include "em_fit.hpp"
+
+namespace mlpack {
+namespace gmm {
+
+/**
+ * This class fits a GMM to observations with the online EM algorithm of Cappé
+ * and Moulines:
+ *
+ * @code
+ * @article{cappe2009online,
+ *   title={On-line expectation-maximization algorithm for latent data
+ *       models},
+ *   author={Capp{\'e}, Olivier and Moulines, Eric},
+ *   journal={Journal of the Royal Statistical Society: Series B (Statistical
+ *       Methodology)},
+ *   volume={71},
+ *   number={3},
+ *   pages={593--613},
+ *   year={2009}
+ * }
+ * @endcode
+ *
+ * Instead of computing the responsibilities of every point before each update,
+ * the points are visited one mini-batch at a time.  For each component, the
+ * fitter keeps a running estimate of the expected count and scatter of the
+ * points it is responsible for; after each mini-batch, these are moved towards
+ * the statistics of the mini-batch by the step size t^(-decay) (where t is the
+ * number of mini-batches seen so far), and the model is recomputed from them.
+ * The decay should be in (0.5, 1]; smaller values forget old mini-batches
+ * faster.
+ *
+ * The statistics are kept between calls, so the model can be kept up to date
+ * as new data arrives by calling Estimate() with useInitialModel set to true
+ * for each new chunk of points.  (GMM::Estimate() gives each of its trials a
+ * copy of the fitter as it was before the first trial, so the trials don't
+ * share statistics.)  Datasets that do not fit in memory can be streamed from
+ * a file with a data::ChunkReader:
+ *
+ * @code
+ * std::vector<distribution::GaussianDistribution> dists(100);
+ * arma::vec weights(100);
+ * data::ChunkReader reader("huge_dataset.csv");
+ *
+ * OnlineEMFit<> fitter(1000); // Mini-batches of 1000 points.
+ * fitter.Estimate(reader, dists, weights);
+ *
+ * GMM<OnlineEMFit<> > gmm(dists, weights, fitter);
+ * @endcode
+ *
+ * If there is no initial model, the InitialClusteringType and the
+ * CovarianceConstraintPolicy are used as in EMFit on the first chunk of points
+ * (or on the first mini-batch, when reading from a file).  The components may
+ * be distribution::GaussianDistribution or
+ * distribution::DiagonalGaussianDistribution objects.
+ *
+ * The mini-batches of an in-memory dataset are taken in a random order in each
+ * pass; mini-batches read from a file are taken in file order, so the points
+ * in the file should be in random order.
+ */
+template<typename InitialClusteringType = kmeans::KMeans<>,
+         typename CovarianceConstraintPolicy = PositiveDefiniteConstraint,
+         typename Distribution = distribution::GaussianDistribution>
+class OnlineEMFit
+{
+ public:
+  /**
+   * Construct the OnlineEMFit object.
+   *
+   * @param batchSize Number of points in each mini-batch.
+   * @param passes Number of passes over the data in each call to Estimate().
+   * @param decay Exponent of the decay of the step size.
+   * @param clusterer Object which will perform the initial clustering.
+   * @param constraint Object which will constrain the covariances.
+   */
+  OnlineEMFit(const size_t batchSize = 1000,
+              const size_t passes = 1,
+              const double decay = 0.6,
+              InitialClusteringType clusterer = InitialClusteringType(),
+              CovarianceConstraintPolicy constraint =
+                  CovarianceConstraintPolicy());
+
+  /**
+   * Update the model with the given observations, one mini-batch at a time.
+   * If useInitialModel is false, the statistics are reset and the initial
+   * model is computed from the observations; otherwise, the given model (and
+   * the statistics of earlier calls) is updated with the observations.  The
+   * size of the vectors (indicating the number of components) must already be
+   * set.
+   *
+   * @param observations List of observations to train on.
+   * @param dists Vector of distributions to update.
+   * @param weights Vector of a priori weights to update.
+   * @param useInitialModel If true, the given model is used as the initial
+   *      model.
+   */
+  void Estimate(const arma::mat& observations,
+                std::vector<Distribution>& dists,
+                arma::vec& weights,
+                const bool useInitialModel = false);
+
+  /**
+   * Update the model with the given observations, one mini-batch at a time,
+   * taking into account the probability of each point being from this
+   * mixture.  See the other overload for details.
+   *
+   * @param observations List of observations to train on.
+   * @param probabilities Probability of each point being from this model.
+   * @param dists Vector of distributions to update.
+   * @param weights Vector of a priori weights to update.
+   * @param useInitialModel If true, the given model is used as the initial
+   *      model.
+   */
+  void Estimate(const arma::mat& observations,
+                const arma::vec& probabilities,
+                std::vector<Distribution>& dists,
+                arma::vec& weights,
+                const bool useInitialModel = false);
+
+  /**
+   * Update the model with the points read from the given reader, one
+   * mini-batch at a time, until its end is reached.  If more than one pass is
+   * requested, the reader is rewound after each pass but the last.  If
+   * useInitialModel is false, the statistics are reset and the initial model is
+   * computed from the first mini-batch.
+   *
+   * @param reader Reader for the dataset.
+   * @param dists Vector of distributions to update.
+   * @param weights Vector of a priori weights to update.
+   * @param useInitialModel If true, the given model is used as the initial
+   *      model.
+   */
+  void Estimate(data::ChunkReader& reader,
+                std::vector<Distribution>& dists,
+                arma::vec& weights,
+                const bool useInitialModel = false);
+
+  /**
+   * Run one step of online EM on the given mini-batch: compute the
+   * responsibilities of each component for the points of the mini-batch, move
+   * the statistics towards those of the mini-batch, and recompute the model.
+   * If probabilities is not empty, the responsibilities for each point are
+   * scaled by the probability of the point being from this mixture.
+   *
+   * @param batch Mini-batch of observations.
+   * @param probabilities Probability of each point being from this model, or
+   *     an empty vector if every point is.
+   * @param dists Vector of distributions to update.
+   * @param weights Vector of a priori weights to update.
+   */
+  void Step(const arma::mat& batch,
+            const arma::vec& probabilities,
+            std::vector<Distribution>& dists,
+            arma::vec& weights);
+
+  //! Forget the statistics, so that the next step starts from scratch.
+  void Reset();
+
+  //! Get the number of steps since the statistics were reset.
+  size_t Steps() const { return steps; }
+
+  //! Get the number of points in each mini-batch.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the number of points in each mini-batch.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the number of passes over the data in each call to Estimate().
+  size_t Passes() const { return passes; }
+  //! Modify the number of passes over the data in each call to Estimate().
+  size_t& Passes() { return passes; }
+
+  //! Get the exponent of the decay of the step size.
+  double Decay() const { return decay; }
+  //! Modify the exponent of the decay of the step size.
+  double& Decay() { return decay; }
+
+  //! Get the clusterer.
+  const InitialClusteringType& Clusterer() const { return clusterer; }
+  //! Modify the clusterer.
+  InitialClusteringType& Clusterer() { return clusterer; }
+
+  //! Get the covariance constraint policy class.
+  const CovarianceConstraintPolicy& Constraint() const { return constraint; }
+  //! Modify the covariance constraint policy class.
+  CovarianceConstraintPolicy& Constraint() { return constraint; }
+
+  //! Serialize the fitter, including its statistics.
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int version);
+
+ private:
+  //! Number of points in each mini-batch.
+  size_t batchSize;
+  //! Number of passes over the data in each call to Estimate().
+  size_t passes;
+  //! Exponent of the decay of the step size.
+  double decay;
+  //! Object which will perform the clustering.
+  InitialClusteringType clusterer;
+  //! Object which applies constraints to the covariance matrix.
+  CovarianceConstraintPolicy constraint;
+
+  //! Number of steps since the statistics were reset.
+  size_t steps;
+  //! Running estimate of the expected count of each component.
+  arma::vec counts;
+  //! Mean of the statistics of each component.
+  arma::mat means;
+  //! Running estimate of the scatter of each component about its mean (or of
+  //! the diagonal of the scatter, for diagonal Gaussians).
+  std::vector<arma::mat> scatters;
+
+  //! Compute the initial model from the given observations with EMFit's
+  //! initial clustering.
+  void InitialModel(const arma::mat& observations,
+                    std::vector<Distribution>& dists,
+                    arma::vec& weights);
+
+  //! Add the weighted outer products of the given centered points to the
+  //! scatter matrix of a full-covariance Gaussian.
+  void AccumulateScatter(const distribution::GaussianDistribution& dist,
+                         const arma::mat& centered,
+                         const arma::mat& weighted,
+                         arma::mat& scatter);
+
+  //! Add the weighted squares of the given centered points to the scatter (a
+  //! single column) of a diagonal Gaussian.
+  void AccumulateScatter(const distribution::DiagonalGaussianDistribution& dist,
+                         const arma::mat& centered,
+                         const arma::mat& weighted,
+                         arma::mat& scatter);
+
+  //! Move the scatter of a full-covariance Gaussian to a mean which is shift
+  //! away, and set the constrained covariance of the Gaussian from it.
+  void UpdateCovariance(distribution::GaussianDistribution& dist,
+                        arma::mat& scatter,
+                        const arma::vec& shift,
+                        const double count);
+
+  //! Move the scatter of a diagonal Gaussian to a mean which is shift away, and
+  //! set the constrained variances of the Gaussian from it.
+  void UpdateCovariance(distribution::DiagonalGaussianDistribution& dist,
+                        arma::mat& scatter,
+                        const arma::vec& shift,
+                        const double count);
+};
+
+} // namespace gmm
+} // namespace mlpack
+
+// Include implementation.
+#include "online_em_fit_impl.hpp"
+
+#endif
@@ -0,0 +1,383 @@
+/**
+ * @file online_em_fit_impl.hpp
+ *
+ * Implementation of online EM for fitting GMMs.
+ */
+#ifndef __MLPACK_METHODS_GMM_ONLINE_EM_FIT_IMPL_HPP
+#define __MLPACK_METHODS_GMM_ONLINE_EM_FIT_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "online_em_fit.hpp"
+
+namespace mlpack {
+namespace gmm {
+
+//! Constructor.
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
+OnlineEMFit<InitialClusteringType,
+            CovarianceConstraintPolicy,
+            Distribution>::OnlineEMFit(
+    const size_t batchSize,
+    const size_t passes,
+    const double decay,
+    InitialClusteringType clusterer,
+    CovarianceConstraintPolicy constraint) :
+    batchSize(batchSize),
+    passes(passes),
+    decay(decay),
+    clusterer(clusterer),
+    constraint(constraint),
+    steps(0)
+{ /* Nothing to do. */ }
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
+void OnlineEMFit<InitialClusteringType,
+                 CovarianceConstraintPolicy,
+                 Distribution>::Estimate(
+    const arma::mat& observations,
+    std::vector<Distribution>& dists,
+    arma::vec& weights,
+    const bool useInitialModel)
+{
+  Estimate(observations, arma::vec(), dists, weights, useInitialModel);
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
+void OnlineEMFit<InitialClusteringType,
+                 CovarianceConstraintPolicy,
+                 Distribution>::Estimate(
+    const arma::mat& observations,
+    const arma::vec& probabilities,
+    std::vector<Distribution>& dists,
+    arma::vec& weights,
+    const bool useInitialModel)
+{
+  if (batchSize == 0)
+    Log::Fatal << "OnlineEMFit::Estimate(): batch size must be greater than 0!"
+        << std::endl;
+
+  if (!useInitialModel)
+  {
+    Reset();
+    InitialModel(observations, dists, weights);
+  }
+
+  const size_t n = observations.n_cols;
+  arma::mat batch;
+  arma::vec batchProbabilities;
+  for (size_t pass = 0; pass < passes; ++pass)
+  {
+    // Visit the points in a different random order in each pass.
+    const arma::Col<size_t> order = arma::shuffle(
+        arma::linspace<arma::Col<size_t> >(0, n - 1, n));
+
+    for (size_t begin = 0; begin < n; begin += batchSize)
+    {
+      const size_t end = std::min(begin + batchSize, n);
+      batch.set_size(observations.n_rows, end - begin);
+      for (size_t j = begin; j < end; ++j)
+        batch.col(j - begin) = observations.col(order[j]);
+
+      if (probabilities.n_elem != 0)
+      {
+        batchProbabilities.set_size(end - begin);
+        for (size_t j = begin; j < end; ++j)
+          batchProbabilities[j - begin] = probabilities[order[j]];
+      }
+
+      Step(batch, batchProbabilities, dists, weights);
+    }
+
+    Log::Info << "OnlineEMFit::Estimate(): pass " << (pass + 1) << ", "
+        << steps << " steps." << std::endl;
+  }
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
+void OnlineEMFit<InitialClusteringType,
+                 CovarianceConstraintPolicy,
+                 Distribution>::Estimate(
+    data::ChunkReader& reader,
+    std::vector<Distribution>& dists,
+    arma::vec& weights,
+    const bool useInitialModel)
+{
+  if (batchSize == 0)
+    Log::Fatal << "OnlineEMFit::Estimate(): batch size must be greater than 0!"
+        << std::endl;
+
+  if (!useInitialModel)
+    Reset();
+
+  bool initialized = useInitialModel;
+  arma::mat batch;
+  for (size_t pass = 0; pass < passes; ++pass)
+  {
+    if (pass > 0)
+      reader.Rewind();
+
+    while (reader.Read(batchSize, batch) > 0)
+    {
+      if (!initialized)
+      {
+        if (batch.n_cols < dists.size())
+          Log::Fatal << "OnlineEMFit::Estimate(): the first mini-batch has "
+              << "only " << batch.n_cols << " points, but there are "
+              << dists.size() << " components!" << std::endl;
+
+        InitialModel(batch, dists, weights);
+        initialized = true;
+      }
+
+      Step(batch, arma::vec(), dists, weights);
+    }
+
+    Log::Info << "OnlineEMFit::Estimate(): pass " << (pass + 1) << " over '"
+        << reader.Filename() << "', " << steps << " steps." << std::endl;
+  }
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
+void OnlineEMFit<InitialClusteringType,
+                 CovarianceConstraintPolicy,
+                 Distribution>::Step(
+    const arma::mat& batch,
+    const arma::vec& probabilities,
+    std::vector<Distribution>& dists,
+    arma::vec& weights)
+{
+  const size_t n = batch.n_cols;
+  const size_t d = batch.n_rows;
+  const size_t k = dists.size();
+  if (n == 0)
+    return;
+
+  // For a diagonal Gaussian, only the diagonal of the scatter is kept.
+  const size_t scatterCols = std::is_same<Distribution,
+      distribution::DiagonalGaussianDistribution>::value ? 1 : d;
+
+  // If the statistics don't fit the model, start over.
+  if (counts.n_elem != k || means.n_rows != d)
+    Reset();
+
+  if (steps == 0)
+  {
+    counts.zeros(k);
+    means.set_size(d, k);
+    for (size_t i = 0; i < k; ++i)
+      means.col(i) = dists[i].Mean();
+    scatters.assign(k, arma::zeros<arma::mat>(d, scatterCols));
+  }
+
+  // Calculate the conditional probabilities of choosing a particular Gaussian
+  // given the points of the mini-batch and the present theta value.  This is
+  // done in log-space, so that points far from every component still get
+  // responsibilities.
+  arma::mat condProb(n, k);
+  arma::vec logPhis;
+  for (size_t i = 0; i < k; ++i)
+  {
+    dists[i].LogProbability(batch, logPhis);
+    condProb.col(i) = std::log(weights[i]) + logPhis;
+  }
+
+  // Normalize row-wise.
+  for (size_t j = 0; j < n; ++j)
+  {
+    const double maxLogProb = condProb.row(j).max();
+    if (maxLogProb == -std::numeric_limits<double>::infinity())
+    {
+      condProb.row(j).zeros();
+      continue;
+    }
+
+    condProb.row(j) = arma::exp(condProb.row(j) - maxLogProb);
+    condProb.row(j) /= accu(condProb.row(j));
+
+    // Take into account the probability of the point being from this mixture
+    // model.
+    if (probabilities.n_elem != 0)
+      condProb.row(j) *= probabilities[j];
+  }
+
+  // The first step replaces the statistics entirely.
+  ++steps;
+  const double stepSize = std::pow((double) steps, -decay);
+
+  for (size_t i = 0; i < k; ++i)
+  {
+    // Statistics of the mini-batch, about the mean of the statistics.
+    const arma::vec condProbCol = condProb.unsafe_col(i);
+    arma::mat centered = batch;
+    centered.each_col() -= means.col(i);
+    arma::mat weighted = centered;
+    for (size_t j = 0; j < n; ++j)
+      weighted.col(j) *= condProbCol[j];
+
+    arma::mat batchScatter(d, scatterCols, arma::fill::zeros);
+    AccumulateScatter(dists[i], centered, weighted, batchScatter);
+
+    // Move the statistics towards those of the mini-batch.  The running sum of
+    // the centered points is zero, since they are centered about their mean.
+    counts[i] = (1.0 - stepSize) * counts[i] + stepSize * accu(condProbCol) / n;
+    scatters[i] = (1.0 - stepSize) * scatters[i] + stepSize * batchScatter / n;
+
+    // Don't update if there's no probability of the Gaussian having points.
+    if (counts[i] == 0.0)
+      continue;
+
+    const arma::vec shift = stepSize * arma::sum(weighted, 1) / (n * counts[i]);
+    means.col(i) += shift;
+    dists[i].Mean() = means.col(i);
+    UpdateCovariance(dists[i], scatters[i], shift, counts[i]);
+  }
+
+  const double totalCount = accu(counts);
+  if (totalCount > 0.0)
+    weights = counts / totalCount;
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
+void OnlineEMFit<InitialClusteringType,
+                 CovarianceConstraintPolicy,
+                 Distribution>::Reset()
+{
+  steps = 0;
+  counts.reset();
+  means.reset();
+  scatters.clear();
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
+void OnlineEMFit<InitialClusteringType,
+                 CovarianceConstraintPolicy,
+                 Distribution>::InitialModel(
+    const arma::mat& observations,
+    std::vector<Distribution>& dists,
+    arma::vec& weights)
+{
+  // With a maximum of one iteration, EMFit stops right after its initial
+  // clustering.
+  EMFit<InitialClusteringType, CovarianceConstraintPolicy, Distribution>
+      initializer(1, 0.0, clusterer, constraint);
+  initializer.Estimate(observations, dists, weights, false);
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
+void OnlineEMFit<InitialClusteringType,
+                 CovarianceConstraintPolicy,
+                 Distribution>::AccumulateScatter(
+    const distribution::GaussianDistribution& /* dist */,
+    const arma::mat& centered,
+    const arma::mat& weighted,
+    arma::mat& scatter)
+{
+  scatter += centered * trans(weighted);
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
+void OnlineEMFit<InitialClusteringType,
+                 CovarianceConstraintPolicy,
+                 Distribution>::AccumulateScatter(
+    const distribution::DiagonalGaussianDistribution& /* dist */,
+    const arma::mat& centered,
+    const arma::mat& weighted,
+    arma::mat& scatter)
+{
+  scatter += arma::sum(centered % weighted, 1);
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
+void OnlineEMFit<InitialClusteringType,
+                 CovarianceConstraintPolicy,
+                 Distribution>::UpdateCovariance(
+    distribution::GaussianDistribution& dist,
+    arma::mat& scatter,
+    const arma::vec& shift,
+    const double count)
+{
+  scatter -= count * shift * trans(shift);
+
+  // Apply covariance constraint.
+  arma::mat covariance = scatter / count;
+  constraint.ApplyConstraint(covariance);
+  dist.Covariance(std::move(covariance));
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
+void OnlineEMFit<InitialClusteringType,
+                 CovarianceConstraintPolicy,
+                 Distribution>::UpdateCovariance(
+    distribution::DiagonalGaussianDistribution& dist,
+    arma::mat& scatter,
+    const arma::vec& shift,
+    const double count)
+{
+  scatter.col(0) -= count * arma::square(shift);
+
+  // Apply covariance constraint.
+  arma::vec covariance = scatter.col(0) / count;
+  constraint.ApplyConstraint(covariance);
+  dist.Covariance(std::move(covariance));
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
+template<typename Archive>
+void OnlineEMFit<InitialClusteringType,
+                 CovarianceConstraintPolicy,
+                 Distribution>::Serialize(
+    Archive& ar,
+    const unsigned int /* version */)
+{
+  using data::CreateNVP;
+
+  ar & CreateNVP(batchSize, "batchSize");
+  ar & CreateNVP(passes, "passes");
+  ar & CreateNVP(decay, "decay");
+  ar & CreateNVP(clusterer, "clusterer");
+  ar & CreateNVP(constraint, "constraint");
+
+  ar & CreateNVP(steps, "steps");
+  ar & CreateNVP(counts, "counts");
+  ar & CreateNVP(means, "means");
+
+  // The scatters are serialized one at a time, like the components of a GMM.
+  if (Archive::is_loading::value)
+    scatters.resize(counts.n_elem);
+
+  for (size_t i = 0; i < scatters.size(); ++i)
+  {
+    std::ostringstream oss;
+    oss << "scatter" << i;
+    ar & CreateNVP(scatters[i], oss.str());
+  }
+}
+
+} // namespace gmm
+} // namespace mlpack
+
+#endif
@@ -40,6 +40,26 @@ class PositiveDefiniteConstraint
     }
   }
 
+  /**
+   * Apply the positive definiteness constraint to the given vector of variances
+   * (the diagonal of a diagonal covariance matrix), which is positive definite
+   * when each variance is positive.
+   *
+   * @param diagCovariance Vector of variances.
+   */
+  static void ApplyConstraint(arma::vec& diagCovariance)
+  {
+    for (size_t i = 0; i < diagCovariance.n_elem; ++i)
+    {
+      if (diagCovariance[i] <= 1e-50)
+      {
+        Log::Debug << "Variance " << i << " is not positive.  Adding "
+            << "perturbation." << std::endl;
+        diagCovariance[i] = 1e-50;
+      }
+    }
+  }
+
   //! Serialize the constraint (which stores nothing, so, nothing to do).
   template<typename Archive>
   static void Serialize(Archive& /* ar */, const unsigned int /* version */) { }
@@ -0,0 +1,107 @@
+/**
+ * @file subsampled_kmeans.hpp
+ *
+ * An initial clustering policy for EMFit that runs accelerated k-means on a
+ * random subsample of the observations.
+ */
+#ifndef __MLPACK_METHODS_GMM_SUBSAMPLED_KMEANS_HPP
+#define __MLPACK_METHODS_GMM_SUBSAMPLED_KMEANS_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/methods/kmeans/kmeans.hpp>
+#include <mlpack/methods/kmeans/kmeans_plus_plus.hpp>
+#include <mlpack/methods/kmeans/hamerly_kmeans.hpp>
+
+namespace mlpack {
+namespace gmm {
+
+/**
+ * An initial clustering policy for EMFit (or OnlineEMFit) which clusters a
+ * random subsample of the observations instead of the whole dataset.  The
+ * centroids are seeded with k-means++ on the subsample and refined with k-means
+ * using the given Lloyd step type.  By default, this is Hamerly's algorithm;
+ * kmeans::DefaultDualTreeKMeans is a good choice when there are many clusters
+ * in low dimensions.  Then, every observation is assigned to its closest
+ * centroid.  So the cost of the k-means iterations does not depend on the size
+ * of the dataset, and only one pass over the whole dataset is made.
+ *
+ * All the random choices are made with a random number generator of this
+ * object's own, seeded from math::randGen when Cluster() is called.  So
+ * several copies of the policy can cluster at once, as they do when the trials
+ * of GMM::Estimate() run in parallel.
+ *
+ * @code
+ * // Initialize each trial from k-means on 5000 points.
+ * EMFit<SubsampledKMeans<> > fitter(300, 1e-10, SubsampledKMeans<>(5000));
+ * GMM<EMFit<SubsampledKMeans<> > > gmm(100, data.n_rows, fitter);
+ * gmm.NumThreads() = 4;
+ * gmm.Estimate(data, 8); // 8 trials, 4 at a time.
+ * @endcode
+ *
+ * @tparam LloydStepType Lloyd step used for k-means on the subsample.
+ */
+template<template<class, class> class LloydStepType = kmeans::HamerlyKMeans>
+class SubsampledKMeans
+{
+ public:
+  /**
+   * Create the policy.
+   *
+   * @param sampleSize Number of points to cluster (0 means the whole dataset).
+   * @param maxIterations Maximum number of iterations of k-means.
+   */
+  SubsampledKMeans(const size_t sampleSize = 10000,
+                   const size_t maxIterations = 100);
+
+  /**
+   * Cluster the given dataset into the given number of clusters.  If the
+   * sample size is smaller than the number of clusters, that many points are
+   * sampled instead.
+   *
+   * @param data Dataset to cluster.
+   * @param clusters Number of clusters.
+   * @param assignments Vector to store the cluster of each point in.
+   */
+  void Cluster(const arma::mat& data,
+               const size_t clusters,
+               arma::Col<size_t>& assignments);
+
+  //! Get the number of points to cluster.
+  size_t SampleSize() const { return sampleSize; }
+  //! Modify the number of points to cluster (0 means the whole dataset).
+  size_t& SampleSize() { return sampleSize; }
+
+  //! Get the maximum number of iterations of k-means.
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations of k-means.
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the number of threads used by k-means and the assignment of points.
+  size_t NumThreads() const { return numThreads; }
+  //! Modify the number of threads used by k-means and the assignment of points
+  //! (0 means as many as OpenMP allows).
+  size_t& NumThreads() { return numThreads; }
+
+  //! Serialize the policy.
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int version);
+
+ private:
+  //! Number of points to cluster (0 means the whole dataset).
+  size_t sampleSize;
+  //! Maximum number of iterations of k-means.
+  size_t maxIterations;
+  //! Number of threads to use.
+  size_t numThreads;
+
+  //! Get the number of threads that will actually be used.
+  size_t ThreadsToUse() const;
+};
+
+} // namespace gmm
+} // namespace mlpack
+
+// Include implementation.
+#include "subsampled_kmeans_impl.hpp"
+
+#endif
@@ -0,0 +1,127 @@
+/**
+ * @file subsampled_kmeans_impl.hpp
+ *
+ * Implementation of the SubsampledKMeans initial clustering policy.
+ */
+#ifndef __MLPACK_METHODS_GMM_SUBSAMPLED_KMEANS_IMPL_HPP
+#define __MLPACK_METHODS_GMM_SUBSAMPLED_KMEANS_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "subsampled_kmeans.hpp"
+
+#include <mlpack/core/metrics/lmetric.hpp>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+namespace mlpack {
+namespace gmm {
+
+template<template<class, class> class LloydStepType>
+SubsampledKMeans<LloydStepType>::SubsampledKMeans(const size_t sampleSize,
+                                                  const size_t maxIterations) :
+    sampleSize(sampleSize),
+    maxIterations(maxIterations),
+    numThreads(1)
+{
+  // Nothing to do.
+}
+
+template<template<class, class> class LloydStepType>
+void SubsampledKMeans<LloydStepType>::Cluster(const arma::mat& data,
+                                              const size_t clusters,
+                                              arma::Col<size_t>& assignments)
+{
+  const size_t n = data.n_cols;
+  if (clusters == 0 || n == 0)
+  {
+    assignments.zeros(n);
+    return;
+  }
+
+  // Only the seed comes from the global generator, so that several copies of
+  // this object can cluster at once.
+  std::mt19937 rng;
+  #pragma omp critical(SubsampledKMeansSeed)
+  rng.seed((uint32_t) math::randGen());
+
+  // Choose the subsample with a partial Fisher-Yates shuffle.
+  size_t samples = (sampleSize == 0) ? n : std::max(sampleSize, clusters);
+  samples = std::min(samples, n);
+  arma::Col<size_t> order = arma::linspace<arma::Col<size_t> >(0, n - 1, n);
+  for (size_t i = 0; i < samples; ++i)
+  {
+    std::uniform_int_distribution<size_t> pick(i, n - 1);
+    std::swap(order[i], order[pick(rng)]);
+  }
+
+  arma::mat sample(data.n_rows, samples);
+  for (size_t i = 0; i < samples; ++i)
+    sample.col(i) = data.col(order[i]);
+
+  Log::Info << "SubsampledKMeans::Cluster(): clustering " << samples << " of "
+      << n << " points." << std::endl;
+
+  // Seed with k-means++ and then run k-means on the subsample.
+  arma::Col<size_t> sampleAssignments;
+  kmeans::KMeansPlusPlus().Cluster(sample, clusters, sampleAssignments, rng);
+
+  kmeans::KMeans<metric::EuclideanDistance, kmeans::RandomPartition,
+      kmeans::MaxVarianceNewCluster, LloydStepType> k(maxIterations);
+  k.NumThreads() = numThreads;
+  arma::mat centroids;
+  k.Cluster(sample, clusters, sampleAssignments, centroids, true);
+
+  // Now assign every point to its closest centroid.
+  assignments.set_size(n);
+  const size_t threads = ThreadsToUse();
+  #pragma omp parallel for num_threads(threads) schedule(static)
+  for (size_t i = 0; i < n; ++i)
+  {
+    double minDistance = DBL_MAX;
+    size_t closest = 0;
+    for (size_t c = 0; c < clusters; ++c)
+    {
+      const double distance = metric::SquaredEuclideanDistance::Evaluate(
+          data.col(i), centroids.col(c));
+      if (distance < minDistance)
+      {
+        minDistance = distance;
+        closest = c;
+      }
+    }
+
+    assignments[i] = closest;
+  }
+}
+
+template<template<class, class> class LloydStepType>
+template<typename Archive>
+void SubsampledKMeans<LloydStepType>::Serialize(
+    Archive& ar,
+    const unsigned int /* version */)
+{
+  using data::CreateNVP;
+
+  ar & CreateNVP(sampleSize, "sampleSize");
+  ar & CreateNVP(maxIterations, "maxIterations");
+}
+
+template<template<class, class> class LloydStepType>
+size_t SubsampledKMeans<LloydStepType>::ThreadsToUse() const
+{
+  if (numThreads != 0)
+    return numThreads;
+
+#ifdef _OPENMP
+  return (size_t) omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+} // namespace gmm
+} // namespace mlpack
+
+#endif
@@ -14,6 +14,21 @@
 namespace mlpack {
 namespace hmm /** Hidden Markov Models. */ {
 
+// This gives us a HasLogProbabilityCheck<T, U> type (where U is a function
+// pointer) we can use with SFINAE to catch when an emission distribution can
+// compute log-probabilities directly.
+HAS_MEM_FUNC(LogProbability, HasLogProbabilityCheck);
+
+// This gives us a HasProbabilityCheck<T, U> type, used to catch when an
+// emission distribution can compute the probabilities of a whole matrix of
+// observations at once.
+HAS_MEM_FUNC(Probability, HasProbabilityCheck);
+
+// Forward declaration of the streaming decoder, which uses the helper
+// functions of the HMM.
+template<typename Distribution>
+class StreamingDecoder;
+
 /**
  * A class that represents a Hidden Markov Model with an arbitrary type of
  * emission distribution.  This HMM class supports training (supervised and
@@ -71,7 +86,14 @@ namespace hmm /** Hidden Markov Models. */ {
  * Once initialized, the HMM can evaluate the probability of a certain sequence
  * (with LogLikelihood()), predict the most likely sequence of hidden states
  * (with Predict()), generate a sequence (with Generate()), or estimate the
- * probabilities of each state for a sequence of observations (with Estimate()).
+ * probabilities of each state for a sequence of observations (with Estimate(),
+ * or LogEstimate() in log space).
+ *
+ * When at most a tenth of the entries of the transition matrix are nonzero (as
+ * with left-to-right or banded topologies), Predict() and LogEstimate() store
+ * the transition matrix as a sparse matrix, so each time step takes time
+ * proportional to the number of nonzero transitions instead of the square of
+ * the number of states.
  *
  * @tparam Distribution Type of emission distribution for this HMM.
  */
@@ -152,6 +174,13 @@ class HMM
    * log-likelihood of the model between iterations is less than the tolerance,
    * the Baum-Welch algorithm terminates.
    *
+   * The probability of each observation under each emission distribution is
+   * computed only once per sequence in each iteration, and is shared by the
+   * Forward and Backward algorithms and the re-estimation of the transition
+   * matrix.  The E-step is spread across the sequences on NumThreads()
+   * threads; the sums of each thread are added in a fixed order, so for a
+   * given number of threads the result is deterministic.
+   *
    * @note
    * Train() can be called multiple times with different sequences; each time it
    * is called, it uses the current parameters of the HMM as a starting point
@@ -224,6 +253,32 @@ class HMM
   double Estimate(const arma::mat& dataSeq,
                   arma::mat& stateProb) const;
 
+  /**
+   * Estimate the log-probabilities of each hidden state at each time step of
+   * each given data observation, using the Forward-Backward algorithm in log
+   * space.  Unlike Estimate(), no probability is ever represented outside of
+   * log space, so this is safe for very long sequences and for observations
+   * that are very unlikely under some states.  Each step is a matrix-vector
+   * product with the transition matrix (a log-sum-exp); if the transition
+   * matrix is sparse enough, a sparse matrix is used.  The returned matrices
+   * have columns equal to the number of data observations, and rows equal to
+   * the number of hidden states in the model.  The log-likelihood of the
+   * sequence is returned.
+   *
+   * @param dataSeq Sequence of observations.
+   * @param stateLogProb Matrix in which the log-probabilities of each state at
+   *    each time interval will be stored.
+   * @param forwardLogProb Matrix in which the forward log-probabilities of each
+   *    state at each time interval will be stored.
+   * @param backwardLogProb Matrix in which the backward log-probabilities of
+   *    each state at each time interval will be stored.
+   * @return Log-likelihood of the sequence.
+   */
+  double LogEstimate(const arma::mat& dataSeq,
+                     arma::mat& stateLogProb,
+                     arma::mat& forwardLogProb,
+                     arma::mat& backwardLogProb) const;
+
   /**
    * Generate a random data sequence of the given length.  The data sequence is
    * stored in the dataSequence parameter, and the state sequence is stored in
@@ -243,7 +298,8 @@ class HMM
   /**
    * Compute the most probable hidden state sequence for the given data
    * sequence, using the Viterbi algorithm, returning the log-likelihood of the
-   * most likely state sequence.
+   * most likely state sequence.  If the transition matrix is sparse enough,
+   * only the nonzero transitions are searched at each time step.
    *
    * @param dataSeq Sequence of observations.
    * @param stateSeq Vector in which the most probable state sequence will be
@@ -261,6 +317,22 @@ class HMM
    */
   double LogLikelihood(const arma::mat& dataSeq) const;
 
+  /**
+   * Compute the log-likelihood of a data sequence, given the log-probability of
+   * each of its observations under the emission distribution of each state
+   * (one row per state and one column per observation).  This allows the
+   * emission log-probabilities to be computed some other way; for instance,
+   * approximately, with a gmm::GMMTreeScorer for the GMM of each state.  If
+   * each emission log-probability of an observation is underestimated by at
+   * most some amount, then the log-likelihood is underestimated by at most the
+   * sum over the observations of those amounts.
+   *
+   * @param emissionLogProb Emission log-probabilities of each state for each
+   *     observation.
+   * @return Log-likelihood of the sequence.
+   */
+  double EmissionLogLikelihood(const arma::mat& emissionLogProb) const;
+
   /**
    * HMM filtering. Computes the k-step-ahead expected emission at each time
    * conditioned only on prior observations. That is
@@ -316,6 +388,12 @@ class HMM
   //! Modify the tolerance of the Baum-Welch algorithm.
   double& Tolerance() { return tolerance; }
 
+  //! Get the number of threads used by the Baum-Welch algorithm.
+  size_t NumThreads() const { return numThreads; }
+  //! Modify the number of threads used by the Baum-Welch algorithm (0 means
+  //! as many as OpenMP allows).
+  size_t& NumThreads() { return numThreads; }
+
   /**
    * Returns a string representation of this object.
    */
@@ -358,6 +436,94 @@ class HMM
                 const arma::vec& scales,
                 arma::mat& backwardProb) const;
 
+  /**
+   * Compute the probability of each observation in the given data sequence
+   * under the emission distribution of each state.  The returned matrix has
+   * rows equal to the number of hidden states and columns equal to the number
+   * of observations.
+   *
+   * @param dataSeq Data sequence to compute probabilities for.
+   * @param emissionProb Matrix in which emission probabilities will be saved.
+   */
+  void EmissionProbabilities(const arma::mat& dataSeq,
+                             arma::mat& emissionProb) const;
+
+  /**
+   * The Forward algorithm, given the emission probabilities of each
+   * observation (as computed by EmissionProbabilities()).
+   *
+   * @param emissionProb Emission probabilities of each state for each
+   *     observation.
+   * @param scales Vector in which scaling factors will be saved.
+   * @param forwardProb Matrix in which forward probabilities will be saved.
+   */
+  void ForwardEmission(const arma::mat& emissionProb,
+                       arma::vec& scales,
+                       arma::mat& forwardProb) const;
+
+  /**
+   * The Backward algorithm, given the emission probabilities of each
+   * observation (as computed by EmissionProbabilities()) and the scaling
+   * factors found by ForwardEmission().
+   *
+   * @param emissionProb Emission probabilities of each state for each
+   *     observation.
+   * @param scales Vector of scaling factors.
+   * @param backwardProb Matrix in which backward probabilities will be saved.
+   */
+  void BackwardEmission(const arma::mat& emissionProb,
+                        const arma::vec& scales,
+                        arma::mat& backwardProb) const;
+
+  /**
+   * Compute the log-probability of each observation in the given data sequence
+   * under the emission distribution of each state.  The returned matrix has
+   * rows equal to the number of hidden states and columns equal to the number
+   * of observations.
+   *
+   * @param dataSeq Data sequence to compute log-probabilities for.
+   * @param emissionLogProb Matrix in which emission log-probabilities will be
+   *     saved.
+   */
+  void EmissionLogProbabilities(const arma::mat& dataSeq,
+                                arma::mat& emissionLogProb) const;
+
+  /**
+   * The Forward algorithm in log space.  Each step is a log-sum-exp over the
+   * given transition matrix, which may be dense (arma::mat) or sparse
+   * (arma::sp_mat).
+   *
+   * @param transitionMat Transition matrix to use.
+   * @param emissionLogProb Emission log-probabilities of each state for each
+   *     observation.
+   * @param forwardLogProb Matrix in which forward log-probabilities will be
+   *     saved.
+   */
+  template<typename TransitionMatType>
+  void LogForward(const TransitionMatType& transitionMat,
+                  const arma::mat& emissionLogProb,
+                  arma::mat& forwardLogProb) const;
+
+  /**
+   * The Backward algorithm in log space.  Each step is a log-sum-exp over the
+   * given transition matrix, which may be dense (arma::mat) or sparse
+   * (arma::sp_mat).
+   *
+   * @param transitionMat Transition matrix to use.
+   * @param emissionLogProb Emission log-probabilities of each state for each
+   *     observation.
+   * @param backwardLogProb Matrix in which backward log-probabilities will be
+   *     saved.
+   */
+  template<typename TransitionMatType>
+  void LogBackward(const TransitionMatType& transitionMat,
+                   const arma::mat& emissionLogProb,
+                   arma::mat& backwardLogProb) const;
+
+  //! Return whether the transition matrix is sparse enough (at most a tenth
+  //! of its entries nonzero) to be stored as a sparse matrix.
+  bool SparseTransition() const;
+
   //! Set of emission probability distributions; one for each state.
   std::vector<Distribution> emission;
 
@@ -373,6 +539,89 @@ class HMM
 
   //! Tolerance of Baum-Welch algorithm.
   double tolerance;
+
+  //! Number of threads used by the Baum-Welch algorithm.
+  size_t numThreads;
+
+  //! The streaming decoder uses the emission log-probabilities and the
+  //! sparsity of the transition matrix.
+  friend class StreamingDecoder<Distribution>;
+
+  //! Get the number of threads that will actually be used.
+  size_t ThreadsToUse() const;
+
+  //! Compute the log-probability of an observation with the LogProbability()
+  //! function of the distribution.
+  template<typename DistType>
+  typename std::enable_if<
+      HasLogProbabilityCheck<DistType,
+          double(DistType::*)(const arma::vec&) const>::value, double>::type
+  EmissionLogProbability(const DistType& dist, const arma::vec& observation)
+      const
+  { return dist.LogProbability(observation); }
+
+  //! Compute the log-probability of an observation as the log of its
+  //! probability, for distributions without a LogProbability() function.
+  template<typename DistType>
+  typename std::enable_if<
+      !HasLogProbabilityCheck<DistType,
+          double(DistType::*)(const arma::vec&) const>::value, double>::type
+  EmissionLogProbability(const DistType& dist, const arma::vec& observation)
+      const
+  { return std::log(dist.Probability(observation)); }
+
+  //! Compute the probabilities of a sequence of observations with the batch
+  //! Probability() function of the distribution.
+  template<typename DistType>
+  typename std::enable_if<
+      HasProbabilityCheck<DistType,
+          void(DistType::*)(const arma::mat&, arma::vec&) const>::value>::type
+  DistributionProbabilities(const DistType& dist,
+                            const arma::mat& dataSeq,
+                            arma::vec& probabilities) const
+  { dist.Probability(dataSeq, probabilities); }
+
+  //! Compute the probabilities of a sequence of observations one at a time,
+  //! for distributions without a batch Probability() function.
+  template<typename DistType>
+  typename std::enable_if<
+      !HasProbabilityCheck<DistType,
+          void(DistType::*)(const arma::mat&, arma::vec&) const>::value>::type
+  DistributionProbabilities(const DistType& dist,
+                            const arma::mat& dataSeq,
+                            arma::vec& probabilities) const
+  {
+    probabilities.set_size(dataSeq.n_cols);
+    for (size_t t = 0; t < dataSeq.n_cols; t++)
+      probabilities[t] = dist.Probability(dataSeq.unsafe_col(t));
+  }
+
+  //! Compute the log-probabilities of a sequence of observations with the
+  //! batch LogProbability() function of the distribution.
+  template<typename DistType>
+  typename std::enable_if<
+      HasLogProbabilityCheck<DistType,
+          void(DistType::*)(const arma::mat&, arma::vec&) const>::value>::type
+  DistributionLogProbabilities(const DistType& dist,
+                               const arma::mat& dataSeq,
+                               arma::vec& logProbabilities) const
+  { dist.LogProbability(dataSeq, logProbabilities); }
+
+  //! Compute the log-probabilities of a sequence of observations one at a
+  //! time, for distributions without a batch LogProbability() function.
+  template<typename DistType>
+  typename std::enable_if<
+      !HasLogProbabilityCheck<DistType,
+          void(DistType::*)(const arma::mat&, arma::vec&) const>::value>::type
+  DistributionLogProbabilities(const DistType& dist,
+                               const arma::mat& dataSeq,
+                               arma::vec& logProbabilities) const
+  {
+    logProbabilities.set_size(dataSeq.n_cols);
+    for (size_t t = 0; t < dataSeq.n_cols; t++)
+      logProbabilities[t] = EmissionLogProbability(dist,
+          dataSeq.unsafe_col(t));
+  }
 };
 
 }; // namespace hmm
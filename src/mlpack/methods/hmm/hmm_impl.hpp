@@ -12,6 +12,10 @@
 // Just in case...
 #include "hmm.hpp"
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace hmm {
 
@@ -27,7 +31,8 @@ HMM<Distribution>::HMM(const size_t states,
     transition(arma::ones<arma::mat>(states, states) / (double) states),
     initial(arma::ones<arma::vec>(states) / (double) states),
     dimensionality(emissions.Dimensionality()),
-    tolerance(tolerance)
+    tolerance(tolerance),
+    numThreads(1)
 { /* nothing to do */ }
 
 /**
@@ -42,7 +47,8 @@ HMM<Distribution>::HMM(const arma::vec& initial,
     emission(emission),
     transition(transition),
     initial(initial),
-    tolerance(tolerance)
+    tolerance(tolerance),
+    numThreads(1)
 {
   // Set the dimensionality, if we can.
   if (emission.size() > 0)
@@ -75,16 +81,19 @@ template<typename Distribution>
 void HMM<Distribution>::Train(const std::vector<arma::mat>& dataSeq)
 {
   // We should allow a guess at the transition and emission matrices.
-  double loglik = 0;
   double oldLoglik = 0;
 
   // Maximum iterations?
   size_t iterations = 1000;
 
-  // Find length of all sequences and ensure they are the correct size.
+  // Find length of all sequences and ensure they are the correct size.  The
+  // observations of each sequence start at offsets[seq] in the list of all
+  // observations.
   size_t totalLength = 0;
+  std::vector<size_t> offsets(dataSeq.size());
   for (size_t seq = 0; seq < dataSeq.size(); seq++)
   {
+    offsets[seq] = totalLength;
     totalLength += dataSeq[seq].n_cols;
 
     if (dataSeq[seq].n_rows != dimensionality)
@@ -94,10 +103,20 @@ void HMM<Distribution>::Train(const std::vector<arma::mat>& dataSeq)
   }
 
   // These are used later for training of each distribution.  We initialize it
-  // all now so we don't have to do any allocation later on.
+  // all now so we don't have to do any allocation later on.  The observations
+  // don't change between iterations, so the list of them is filled only once.
   std::vector<arma::vec> emissionProb(transition.n_cols,
       arma::vec(totalLength));
   arma::mat emissionList(dimensionality, totalLength);
+  for (size_t seq = 0; seq < dataSeq.size(); seq++)
+    for (size_t t = 0; t < dataSeq[seq].n_cols; t++)
+      emissionList.col(offsets[seq] + t) = dataSeq[seq].col(t);
+
+  // The sequences are split into one contiguous block per thread.  Each block
+  // keeps its own sums, which are added in block order afterwards so that the
+  // result does not depend on the scheduling.
+  const size_t blocks = std::max(std::min(ThreadsToUse(), dataSeq.size()),
+      (size_t) 1);
 
   // This should be the Baum-Welch algorithm (EM for HMM estimation). This
   // follows the procedure outlined in Elliot, Aggoun, and Moore's book "Hidden
@@ -105,59 +124,75 @@ void HMM<Distribution>::Train(const std::vector<arma::mat>& dataSeq)
   for (size_t iter = 0; iter < iterations; iter++)
   {
     // Clear new transition matrix and emission probabilities.
-    arma::vec newInitial(transition.n_rows);
-    newInitial.zeros();
-    arma::mat newTransition(transition.n_rows, transition.n_cols);
-    newTransition.zeros();
-
-    // Reset log likelihood.
-    loglik = 0;
+    arma::mat partialInitial(transition.n_rows, blocks, arma::fill::zeros);
+    arma::cube partialTransition(transition.n_rows, transition.n_cols, blocks,
+        arma::fill::zeros);
+    arma::vec partialLoglik(blocks, arma::fill::zeros);
 
-    // Sum over time.
-    size_t sumTime = 0;
-
-    // Loop over each sequence.
-    for (size_t seq = 0; seq < dataSeq.size(); seq++)
+    #pragma omp parallel for num_threads(blocks) schedule(static, 1)
+    for (size_t b = 0; b < blocks; ++b)
     {
-      arma::mat stateProb;
+      const size_t begin = (b * dataSeq.size()) / blocks;
+      const size_t end = ((b + 1) * dataSeq.size()) / blocks;
+
+      arma::mat seqEmissionProb;
       arma::mat forward;
       arma::mat backward;
       arma::vec scales;
 
-      // Add the log-likelihood of this sequence.  This is the E-step.
-      loglik += Estimate(dataSeq[seq], stateProb, forward, backward, scales);
-
-      // Now re-estimate the parameters.  This is the M-step.
-      //   pi_i = sum_d ((1 / P(seq[d])) sum_t (f(i, 0) b(i, 0))
-      //   T_ij = sum_d ((1 / P(seq[d])) sum_t (f(i, t) T_ij E_i(seq[d][t]) b(i,
-      //           t + 1)))
-      //   E_ij = sum_d ((1 / P(seq[d])) sum_{t | seq[d][t] = j} f(i, t) b(i, t)
-      // We store the new estimates in a different matrix.
-      for (size_t t = 0; t < dataSeq[seq].n_cols; t++)
+      // Loop over each sequence.
+      for (size_t seq = begin; seq < end; seq++)
       {
-        for (size_t j = 0; j < transition.n_cols; j++)
+        // Each emission distribution is evaluated once for each observation;
+        // the Forward and Backward algorithms and the estimate of the
+        // transition matrix all use the same probabilities.
+        EmissionProbabilities(dataSeq[seq], seqEmissionProb);
+        ForwardEmission(seqEmissionProb, scales, forward);
+        BackwardEmission(seqEmissionProb, scales, backward);
+        const arma::mat stateProb = forward % backward;
+
+        // Add the log-likelihood of this sequence.  This is the E-step.
+        partialLoglik[b] += accu(log(scales));
+
+        // Now re-estimate the parameters.  This is the M-step.
+        //   pi_i = sum_d ((1 / P(seq[d])) sum_t (f(i, 0) b(i, 0))
+        //   T_ij = sum_d ((1 / P(seq[d])) sum_t (f(i, t) T_ij E_i(seq[d][t])
+        //           b(i, t + 1)))
+        //   E_ij = sum_d ((1 / P(seq[d])) sum_{t | seq[d][t] = j} f(i, t)
+        //           b(i, t)
+        // We store the new estimates in a different matrix.
+        partialInitial.col(b) += stateProb.col(0);
+        for (size_t t = 0; t < dataSeq[seq].n_cols; t++)
         {
-          // Add to estimate of initial probability for state j.
-          newInitial[j] = stateProb(j, 0);
-
           if (t < dataSeq[seq].n_cols - 1)
           {
             // Estimate of T_ij (probability of transition from state j to state
             // i).  We postpone multiplication of the old T_ij until later.
-            for (size_t i = 0; i < transition.n_rows; i++)
-              newTransition(i, j) += forward(j, t) * backward(i, t + 1) *
-                  emission[i].Probability(dataSeq[seq].unsafe_col(t + 1)) /
-                  scales[t + 1];
+            partialTransition.slice(b) += (backward.col(t + 1) %
+                seqEmissionProb.col(t + 1)) * trans(forward.col(t)) /
+                scales[t + 1];
           }
 
-          // Add to list of emission observations, for Distribution::Estimate().
-          emissionList.col(sumTime) = dataSeq[seq].col(t);
-          emissionProb[j][sumTime] = stateProb(j, t);
+          // Add to list of emission probabilities, for
+          // Distribution::Estimate().
+          for (size_t j = 0; j < transition.n_cols; j++)
+            emissionProb[j][offsets[seq] + t] = stateProb(j, t);
         }
-        sumTime++;
       }
     }
 
+    // Add the sums of each block.
+    double loglik = 0;
+    arma::vec newInitial(transition.n_rows, arma::fill::zeros);
+    arma::mat newTransition(transition.n_rows, transition.n_cols,
+        arma::fill::zeros);
+    for (size_t b = 0; b < blocks; ++b)
+    {
+      loglik += partialLoglik[b];
+      newInitial += partialInitial.col(b);
+      newTransition += partialTransition.slice(b);
+    }
+
     // Normalize the new initial probabilities.
     if (dataSeq.size() == 0)
       initial = newInitial / dataSeq.size();
@@ -286,9 +321,12 @@ double HMM<Distribution>::Estimate(const arma::mat& dataSeq,
                                    arma::mat& backwardProb,
                                    arma::vec& scales) const
 {
-  // First run the forward-backward algorithm.
-  Forward(dataSeq, scales, forwardProb);
-  Backward(dataSeq, scales, backwardProb);
+  // First run the forward-backward algorithm.  The emission probabilities are
+  // shared by both.
+  arma::mat emissionProb;
+  EmissionProbabilities(dataSeq, emissionProb);
+  ForwardEmission(emissionProb, scales, forwardProb);
+  BackwardEmission(emissionProb, scales, backwardProb);
 
   // Now assemble the state probability matrix based on the forward and backward
   // probabilities.
@@ -362,6 +400,46 @@ void HMM<Distribution>::Generate(const size_t length,
   }
 }
 
+/**
+ * Estimate the log-probabilities of each hidden state at each time step for
+ * each given data observation.
+ */
+template<typename Distribution>
+double HMM<Distribution>::LogEstimate(const arma::mat& dataSeq,
+                                      arma::mat& stateLogProb,
+                                      arma::mat& forwardLogProb,
+                                      arma::mat& backwardLogProb) const
+{
+  // First run the forward-backward algorithm in log space.  The emission
+  // log-probabilities are shared by both.
+  arma::mat emissionLogProb;
+  EmissionLogProbabilities(dataSeq, emissionLogProb);
+  if (SparseTransition())
+  {
+    const arma::sp_mat sparseTransition(transition);
+    LogForward(sparseTransition, emissionLogProb, forwardLogProb);
+    LogBackward(sparseTransition, emissionLogProb, backwardLogProb);
+  }
+  else
+  {
+    LogForward(transition, emissionLogProb, forwardLogProb);
+    LogBackward(transition, emissionLogProb, backwardLogProb);
+  }
+
+  // The log-likelihood is the log-sum-exp of the last forward
+  // log-probabilities.
+  const arma::vec last = forwardLogProb.col(dataSeq.n_cols - 1);
+  const double shift = last.max();
+  const double loglik = (shift == -std::numeric_limits<double>::infinity()) ?
+      shift : shift + std::log(accu(exp(last - shift)));
+
+  // Now assemble the state log-probability matrix based on the forward and
+  // backward log-probabilities.
+  stateLogProb = forwardLogProb + backwardLogProb - loglik;
+
+  return loglik;
+}
+
 /**
  * Compute the most probable hidden state sequence for the given observation
  * using the Viterbi algorithm. Returns the log-likelihood of the most likely
@@ -372,45 +450,77 @@ double HMM<Distribution>::Predict(const arma::mat& dataSeq,
                                   arma::Col<size_t>& stateSeq) const
 {
   // This is an implementation of the Viterbi algorithm for finding the most
-  // probable sequence of states to produce the observed data sequence.  We
-  // don't use log-likelihoods to save that little bit of time, but we'll
-  // calculate the log-likelihood at the end of it all.
+  // probable sequence of states to produce the observed data sequence.  All
+  // the work is done with log-probabilities.
   stateSeq.set_size(dataSeq.n_cols);
   arma::mat logStateProb(transition.n_rows, dataSeq.n_cols);
-  arma::mat stateSeqBack(transition.n_rows, dataSeq.n_cols);
+  arma::Mat<size_t> stateSeqBack(transition.n_rows, dataSeq.n_cols);
 
-  // Store the logs of the transposed transition matrix.  This is because we
-  // will be using the rows of the transition matrix.
-  arma::mat logTrans(log(trans(transition)));
+  arma::mat emissionLogProb;
+  EmissionLogProbabilities(dataSeq, emissionLogProb);
 
   // The calculation of the first state is slightly different; the probability
   // of the first state being state j is the maximum probability that the state
   // came to be j from another state.
-  logStateProb.col(0).zeros();
+  logStateProb.col(0) = log(initial) + emissionLogProb.col(0);
   for (size_t state = 0; state < transition.n_rows; state++)
-  {
-    logStateProb(state, 0) = log(initial[state] *
-        emission[state].Probability(dataSeq.unsafe_col(0)));
     stateSeqBack(state, 0) = state;
-  }
 
-  // Store the best first state.
-  arma::uword index;
-  for (size_t t = 1; t < dataSeq.n_cols; t++)
+  if (SparseTransition())
+  {
+    // Column j of the transposed transition matrix holds the states that can
+    // transition to state j, so only those have to be searched; each step
+    // takes time proportional to the number of nonzero transitions.
+    const arma::sp_mat predecessors(trans(transition));
+    const arma::vec logValues = log(arma::vec(predecessors.values,
+        predecessors.n_nonzero));
+
+    for (size_t t = 1; t < dataSeq.n_cols; t++)
+    {
+      for (size_t j = 0; j < transition.n_rows; j++)
+      {
+        double best = -std::numeric_limits<double>::infinity();
+        size_t index = 0;
+        for (size_t k = predecessors.col_ptrs[j];
+             k < predecessors.col_ptrs[j + 1]; ++k)
+        {
+          const double prob = logStateProb(predecessors.row_indices[k], t - 1)
+              + logValues[k];
+          if (prob > best)
+          {
+            best = prob;
+            index = predecessors.row_indices[k];
+          }
+        }
+
+        logStateProb(j, t) = best + emissionLogProb(j, t);
+        stateSeqBack(j, t) = index;
+      }
+    }
+  }
+  else
   {
-    // Assemble the state probability for this element.
-    // Given that we are in state j, we use state with the highest probability
-    // of being the previous state.
-    for (size_t j = 0; j < transition.n_rows; j++)
+    // Store the logs of the transposed transition matrix.  This is because we
+    // will be using the rows of the transition matrix.
+    const arma::mat logTrans(log(trans(transition)));
+
+    arma::uword index;
+    for (size_t t = 1; t < dataSeq.n_cols; t++)
     {
-      arma::vec prob = logStateProb.col(t - 1) + logTrans.col(j);
-      logStateProb(j, t) = prob.max(index) +
-          log(emission[j].Probability(dataSeq.unsafe_col(t)));
+      // Assemble the state probability for this element.
+      // Given that we are in state j, we use state with the highest
+      // probability of being the previous state.
+      for (size_t j = 0; j < transition.n_rows; j++)
+      {
+        arma::vec prob = logStateProb.col(t - 1) + logTrans.col(j);
+        logStateProb(j, t) = prob.max(index) + emissionLogProb(j, t);
         stateSeqBack(j, t) = index;
+      }
     }
   }
 
   // Backtrack to find the most probable state sequence.
+  arma::uword index;
   logStateProb.unsafe_col(dataSeq.n_cols - 1).max(index);
   stateSeq[dataSeq.n_cols - 1] = index;
   for (size_t t = 2; t <= dataSeq.n_cols; t++)
@@ -435,6 +545,39 @@ double HMM<Distribution>::LogLikelihood(const arma::mat& dataSeq) const
   return accu(log(scales));
 }
 
+/**
+ * Compute the log-likelihood of a data sequence from its emission
+ * log-probabilities.
+ */
+template<typename Distribution>
+double HMM<Distribution>::EmissionLogLikelihood(
+    const arma::mat& emissionLogProb) const
+{
+  if (emissionLogProb.n_rows != transition.n_rows)
+    Log::Fatal << "HMM::EmissionLogLikelihood(): emission log-probabilities "
+        << "have " << emissionLogProb.n_rows << " rows, but there are "
+        << transition.n_rows << " states!" << std::endl;
+
+  if (emissionLogProb.n_cols == 0)
+    return 0.0;
+
+  arma::mat forwardLogProb;
+  if (SparseTransition())
+  {
+    const arma::sp_mat sparseTransition(transition);
+    LogForward(sparseTransition, emissionLogProb, forwardLogProb);
+  }
+  else
+    LogForward(transition, emissionLogProb, forwardLogProb);
+
+  // The log-likelihood is the log-sum-exp of the last forward
+  // log-probabilities.
+  const arma::vec last = forwardLogProb.col(emissionLogProb.n_cols - 1);
+  const double shift = last.max();
+  return (shift == -std::numeric_limits<double>::infinity()) ? shift :
+      shift + std::log(accu(exp(last - shift)));
+}
+
 /**
  * HMM filtering.
  */
@@ -484,37 +627,76 @@ template<typename Distribution>
 void HMM<Distribution>::Forward(const arma::mat& dataSeq,
                                 arma::vec& scales,
                                 arma::mat& forwardProb) const
+{
+  arma::mat emissionProb;
+  EmissionProbabilities(dataSeq, emissionProb);
+  ForwardEmission(emissionProb, scales, forwardProb);
+}
+
+/**
+ * The Backward procedure (part of the Forward-Backward algorithm).
+ */
+template<typename Distribution>
+void HMM<Distribution>::Backward(const arma::mat& dataSeq,
+                                 const arma::vec& scales,
+                                 arma::mat& backwardProb) const
+{
+  arma::mat emissionProb;
+  EmissionProbabilities(dataSeq, emissionProb);
+  BackwardEmission(emissionProb, scales, backwardProb);
+}
+
+/**
+ * Compute the probability of each observation under each emission
+ * distribution.
+ */
+template<typename Distribution>
+void HMM<Distribution>::EmissionProbabilities(const arma::mat& dataSeq,
+                                              arma::mat& emissionProb) const
+{
+  // The whole sequence is evaluated at once for each state, if the emission
+  // distribution allows it.
+  emissionProb.set_size(transition.n_rows, dataSeq.n_cols);
+  arma::vec probabilities;
+  for (size_t state = 0; state < transition.n_rows; state++)
+  {
+    DistributionProbabilities(emission[state], dataSeq, probabilities);
+    emissionProb.row(state) = trans(probabilities);
+  }
+}
+
+/**
+ * The Forward procedure, given the emission probabilities.
+ */
+template<typename Distribution>
+void HMM<Distribution>::ForwardEmission(const arma::mat& emissionProb,
+                                        arma::vec& scales,
+                                        arma::mat& forwardProb) const
 {
   // Our goal is to calculate the forward probabilities:
   //  P(X_k | o_{1:k}) for all possible states X_k, for each time point k.
-  forwardProb.zeros(transition.n_rows, dataSeq.n_cols);
-  scales.zeros(dataSeq.n_cols);
+  forwardProb.zeros(transition.n_rows, emissionProb.n_cols);
+  scales.zeros(emissionProb.n_cols);
 
   // The first entry in the forward algorithm uses the initial state
   // probabilities.  Note that MATLAB assumes that the starting state (at
   // t = -1) is state 0; this is not our assumption here.  To force that
   // behavior, you could append a single starting state to every single data
   // sequence and that should produce results in line with MATLAB.
-  for (size_t state = 0; state < transition.n_rows; state++)
-    forwardProb(state, 0) = initial(state) *
-        emission[state].Probability(dataSeq.unsafe_col(0));
+  forwardProb.col(0) = initial % emissionProb.col(0);
 
   // Then normalize the column.
   scales[0] = accu(forwardProb.col(0));
   forwardProb.col(0) /= scales[0];
 
   // Now compute the probabilities for each successive observation.
-  for (size_t t = 1; t < dataSeq.n_cols; t++)
+  for (size_t t = 1; t < emissionProb.n_cols; t++)
   {
-    for (size_t j = 0; j < transition.n_rows; j++)
-    {
-      // The forward probability of state j at time t is the sum over all states
-      // of the probability of the previous state transitioning to the current
-      // state and emitting the given observation.
-      forwardProb(j, t) = accu(forwardProb.col(t - 1) %
-          trans(transition.row(j))) *
-          emission[j].Probability(dataSeq.unsafe_col(t));
-    }
+    // The forward probability of state j at time t is the sum over all states
+    // of the probability of the previous state transitioning to the current
+    // state and emitting the given observation.
+    forwardProb.col(t) = (transition * forwardProb.col(t - 1)) %
+        emissionProb.col(t);
 
     // Normalize probability.
     scales[t] = accu(forwardProb.col(t));
@@ -522,37 +704,132 @@ void HMM<Distribution>::Forward(const arma::mat& dataSeq,
   }
 }
 
+/**
+ * The Backward procedure, given the emission probabilities.
+ */
 template<typename Distribution>
-void HMM<Distribution>::Backward(const arma::mat& dataSeq,
-                                 const arma::vec& scales,
-                                 arma::mat& backwardProb) const
+void HMM<Distribution>::BackwardEmission(const arma::mat& emissionProb,
+                                         const arma::vec& scales,
+                                         arma::mat& backwardProb) const
 {
   // Our goal is to calculate the backward probabilities:
   //  P(X_k | o_{k + 1:T}) for all possible states X_k, for each time point k.
-  backwardProb.zeros(transition.n_rows, dataSeq.n_cols);
+  backwardProb.zeros(transition.n_rows, emissionProb.n_cols);
 
   // The last element probability is 1.
-  backwardProb.col(dataSeq.n_cols - 1).fill(1);
+  backwardProb.col(emissionProb.n_cols - 1).fill(1);
 
   // Now step backwards through all other observations.
-  for (size_t t = dataSeq.n_cols - 2; t + 1 > 0; t--)
+  for (size_t t = emissionProb.n_cols - 2; t + 1 > 0; t--)
   {
-    for (size_t j = 0; j < transition.n_rows; j++)
+    // The backward probability of state j at time t is the sum over all states
+    // of the probability of the next state having been a transition from the
+    // current state multiplied by the probability of each of those states
+    // emitting the given observation.  Then normalize by the weights from the
+    // forward algorithm.
+    backwardProb.col(t) = trans(transition) * (backwardProb.col(t + 1) %
+        emissionProb.col(t + 1)) / scales[t + 1];
+  }
+}
+
+/**
+ * Compute the log-probability of each observation under each emission
+ * distribution.
+ */
+template<typename Distribution>
+void HMM<Distribution>::EmissionLogProbabilities(
+    const arma::mat& dataSeq,
+    arma::mat& emissionLogProb) const
+{
+  // The whole sequence is evaluated at once for each state, if the emission
+  // distribution allows it.
+  emissionLogProb.set_size(transition.n_rows, dataSeq.n_cols);
+  arma::vec logProbabilities;
+  for (size_t state = 0; state < transition.n_rows; state++)
+  {
+    DistributionLogProbabilities(emission[state], dataSeq, logProbabilities);
+    emissionLogProb.row(state) = trans(logProbabilities);
+  }
+}
+
+/**
+ * The Forward procedure in log space.
+ */
+template<typename Distribution>
+template<typename TransitionMatType>
+void HMM<Distribution>::LogForward(const TransitionMatType& transitionMat,
+                                   const arma::mat& emissionLogProb,
+                                   arma::mat& forwardLogProb) const
+{
+  // Our goal is to calculate the forward log-probabilities:
+  //  log P(X_k, o_{1:k}) for all possible states X_k, for each time point k.
+  forwardLogProb.set_size(transition.n_rows, emissionLogProb.n_cols);
+  forwardLogProb.col(0) = log(initial) + emissionLogProb.col(0);
+
+  for (size_t t = 1; t < emissionLogProb.n_cols; t++)
+  {
+    // The sum over the previous states is a log-sum-exp; the largest previous
+    // log-probability is taken out so that the exponentials can't all
+    // underflow, and what is left is a matrix-vector product.
+    const double shift = forwardLogProb.col(t - 1).max();
+    if (shift == -std::numeric_limits<double>::infinity())
     {
-      // The backward probability of state j at time t is the sum over all state
-      // of the probability of the next state having been a transition from the
-      // current state multiplied by the probability of each of those states
-      // emitting the given observation.
-      for (size_t state = 0; state < transition.n_rows; state++)
-        backwardProb(j, t) += transition(state, j) * backwardProb(state, t + 1)
-            * emission[state].Probability(dataSeq.unsafe_col(t + 1));
-
-      // Normalize by the weights from the forward algorithm.
-      backwardProb(j, t) /= scales[t + 1];
+      // The sequence is impossible.
+      forwardLogProb.col(t).fill(shift);
+      continue;
     }
+
+    const arma::vec scaled = exp(forwardLogProb.col(t - 1) - shift);
+    const arma::vec sums = transitionMat * scaled;
+    forwardLogProb.col(t) = shift + log(sums) + emissionLogProb.col(t);
   }
 }
 
+/**
+ * The Backward procedure in log space.
+ */
+template<typename Distribution>
+template<typename TransitionMatType>
+void HMM<Distribution>::LogBackward(const TransitionMatType& transitionMat,
+                                    const arma::mat& emissionLogProb,
+                                    arma::mat& backwardLogProb) const
+{
+  // Our goal is to calculate the backward log-probabilities:
+  //  log P(o_{k + 1:T} | X_k) for all possible states X_k, for each time point
+  //  k.
+  backwardLogProb.set_size(transition.n_rows, emissionLogProb.n_cols);
+
+  // The last element probability is 1.
+  backwardLogProb.col(emissionLogProb.n_cols - 1).zeros();
+
+  // The sums go over the rows of the transition matrix.
+  const TransitionMatType transposed = trans(transitionMat);
+
+  // Now step backwards through all other observations.
+  for (size_t t = emissionLogProb.n_cols - 2; t + 1 > 0; t--)
+  {
+    const arma::vec next = emissionLogProb.col(t + 1) +
+        backwardLogProb.col(t + 1);
+    const double shift = next.max();
+    if (shift == -std::numeric_limits<double>::infinity())
+    {
+      // The rest of the sequence is impossible.
+      backwardLogProb.col(t).fill(shift);
+      continue;
+    }
+
+    const arma::vec scaled = exp(next - shift);
+    const arma::vec sums = transposed * scaled;
+    backwardLogProb.col(t) = shift + log(sums);
+  }
+}
+
+template<typename Distribution>
+bool HMM<Distribution>::SparseTransition() const
+{
+  return 10 * arma::accu(transition != 0) <= transition.n_elem;
+}
+
 template<typename Distribution>
 std::string HMM<Distribution>::ToString() const
 {
@@ -587,6 +864,19 @@ void HMM<Distribution>::Serialize(Archive& ar, const unsigned int /* version */)
   }
 }
 
+template<typename Distribution>
+size_t HMM<Distribution>::ThreadsToUse() const
+{
+  if (numThreads != 0)
+    return numThreads;
+
+#ifdef _OPENMP
+  return (size_t) omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
 }; // namespace hmm
 }; // namespace mlpack
 
@@ -11,13 +11,33 @@
 
 #include <mlpack/methods/gmm/gmm.hpp>
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 PROGRAM_INFO("Hidden Markov Model (HMM) Sequence Log-Likelihood", "This "
     "utility takes an already-trained HMM (--model_file) and evaluates the "
     "log-likelihood of a given sequence of observations (--input_file).  The "
-    "computed log-likelihood is given directly to stdout.");
+    "computed log-likelihood is given directly to stdout."
+    "\n\n"
+    "Many sequences can be scored at once, loading the model only once.  With "
+    "--batch, --input_file contains a list of files, one per line, each "
+    "holding a sequence.  With --offsets_file, --input_file holds all of the "
+    "sequences one after the other, and the offsets file holds the index of "
+    "the first observation of each sequence.  The sequences are scored in "
+    "parallel on --threads threads, and the log-likelihoods are saved to "
+    "--output_file, one per line (or given to stdout if it is not set).");
 
 PARAM_STRING_REQ("input_file", "File containing observations,", "i");
 PARAM_STRING_REQ("model_file", "File containing HMM.", "m");
+PARAM_FLAG("batch", "If true, input_file contains a list of files, each "
+    "holding an observation sequence.", "b");
+PARAM_STRING("offsets_file", "File containing the index of the first "
+    "observation of each sequence in input_file.", "O", "");
+PARAM_STRING("output_file", "File to save the log-likelihood of each sequence "
+    "to (in batch mode).", "o", "");
+PARAM_INT("threads", "Number of threads to use in batch mode (0 uses as many "
+    "threads as OpenMP allows).", "T", 1);
 
 using namespace mlpack;
 using namespace mlpack::hmm;
@@ -34,6 +54,12 @@ struct Loglik
   template<typename HMMType>
   static void Apply(HMMType& hmm, void* /* extraInfo */)
   {
+    if (CLI::HasParam("batch") || CLI::HasParam("offsets_file"))
+    {
+      ApplyBatch(hmm);
+      return;
+    }
+
     // Load the data sequence.
     const string inputFile = CLI::GetParam<string>("input_file");
     mat dataSeq;
@@ -57,6 +83,47 @@ struct Loglik
 
     cout << loglik << endl;
   }
+
+  // Score all of the sequences of the batch in parallel.
+  template<typename HMMType>
+  static void ApplyBatch(HMMType& hmm)
+  {
+    vector<mat> sequences;
+    LoadSequences(CLI::GetParam<string>("input_file"),
+        CLI::GetParam<string>("offsets_file"),
+        hmm.Emission()[0].Dimensionality(), sequences);
+
+    const int threads = CLI::GetParam<int>("threads");
+    if (threads < 0)
+      Log::Fatal << "Invalid number of threads: " << threads << ".  Must be "
+          << "greater than or equal to 0." << endl;
+
+    size_t threadsToUse = (size_t) threads;
+#ifdef _OPENMP
+    if (threadsToUse == 0)
+      threadsToUse = (size_t) omp_get_max_threads();
+#else
+    threadsToUse = 1;
+#endif
+
+    // The sequences may have very different lengths, so they are handed out
+    // dynamically.
+    vec logliks(sequences.size());
+    #pragma omp parallel for num_threads(threadsToUse) schedule(dynamic)
+    for (size_t i = 0; i < sequences.size(); ++i)
+      logliks[i] = hmm.LogLikelihood(sequences[i]);
+
+    const string outputFile = CLI::GetParam<string>("output_file");
+    if (outputFile == "")
+    {
+      for (size_t i = 0; i < logliks.n_elem; ++i)
+        cout << logliks[i] << endl;
+    }
+    else
+    {
+      data::Save(outputFile, logliks, true, false);
+    }
+  }
 };
 
 int main(int argc, char** argv)
@@ -24,7 +24,8 @@ PROGRAM_INFO("Hidden Markov Model (HMM) Training", "This program allows a "
     "\n\n"
     "The HMM is trained with the Baum-Welch algorithm if no labels are "
     "provided.  The tolerance of the Baum-Welch algorithm can be set with the "
-    "--tolerance option."
+    "--tolerance option, and the number of threads it uses with the --threads "
+    "option."
     "\n\n"
     "Optionally, a pre-created HMM model can be used as a guess for the "
     "transition matrix and emission probabilities; this is specifiable with "
@@ -47,6 +48,8 @@ PARAM_STRING("output_file", "File to save trained HMM to.", "o",
     "output_hmm.xml");
 PARAM_INT("seed", "Random seed.  If 0, 'std::time(NULL)' is used.", "s", 0);
 PARAM_DOUBLE("tolerance", "Tolerance of the Baum-Welch algorithm.", "T", 1e-5);
+PARAM_INT("threads", "Number of threads to use for the Baum-Welch algorithm "
+    "(0 uses as many threads as OpenMP allows).", "", 1);
 
 using namespace mlpack;
 using namespace mlpack::hmm;
@@ -71,6 +74,12 @@ struct Train
     if (CLI::HasParam("tolerance"))
       hmm.Tolerance() = tolerance;
 
+    const int threads = CLI::GetParam<int>("threads");
+    if (threads < 0)
+      Log::Fatal << "Invalid number of threads: " << threads << ".  Must be "
+          << "greater than or equal to 0." << endl;
+    hmm.NumThreads() = (size_t) threads;
+
     const string labelsFile = CLI::GetParam<string>("labels_file");
 
     // Verify that the dimensionality of our observations is the same as the
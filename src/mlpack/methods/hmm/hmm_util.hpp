@@ -31,6 +31,26 @@ void LoadHMMAndPerformAction(const std::string& modelFile,
 template<typename HMMType>
 void SaveHMM(HMMType& hmm, const std::string& modelFile);
 
+/**
+ * Load a batch of observation sequences of the given dimensionality.  If an
+ * offsets file is given, the input file holds all of the sequences one after
+ * the other, and the offsets file holds the index of the first observation of
+ * each sequence (in strictly increasing order, starting at 0; each sequence
+ * ends where the next one begins).  Invalid offsets are a fatal error.
+ * Otherwise, each line of the input file is the name of a file
+ * holding one sequence.  One-dimensional sequences stored as a column are
+ * transposed.
+ *
+ * @param inputFile File holding the sequences, or the list of files.
+ * @param offsetsFile File holding the offsets of the sequences (or "").
+ * @param dimensionality Dimensionality of the observations.
+ * @param sequences Vector in which the sequences are stored.
+ */
+inline void LoadSequences(const std::string& inputFile,
+                          const std::string& offsetsFile,
+                          const size_t dimensionality,
+                          std::vector<arma::mat>& sequences);
+
 } // namespace hmm
 } // namespace mlpack
 
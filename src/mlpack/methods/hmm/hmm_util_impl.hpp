@@ -67,14 +67,17 @@ void LoadHMMAndPerformActionHelper(const std::string& modelFile,
     case HMMType::DiscreteHMM:
       DeserializeHMMAndPerformAction<ActionType, ArchiveType,
           HMM<DiscreteDistribution>>(ar, x);
+      break;
 
     case HMMType::GaussianHMM:
       DeserializeHMMAndPerformAction<ActionType, ArchiveType,
           HMM<GaussianDistribution>>(ar, x);
+      break;
 
     case HMMType::GaussianMixtureModelHMM:
       DeserializeHMMAndPerformAction<ActionType, ArchiveType,
           HMM<gmm::GMM<>>>(ar, x);
+      break;
 
     default:
       Log::Fatal << "Unknown HMM type '" << (unsigned int) type << "'!"
@@ -155,6 +158,84 @@ char GetHMMType<HMM<gmm::GMM<>>>()
   return HMMType::GaussianMixtureModelHMM;
 }
 
+inline void LoadSequences(const std::string& inputFile,
+                          const std::string& offsetsFile,
+                          const size_t dimensionality,
+                          std::vector<arma::mat>& sequences)
+{
+  sequences.clear();
+  if (offsetsFile != "")
+  {
+    // All of the sequences are in one file.
+    arma::mat dataset;
+    data::Load(inputFile, dataset, true); // Fatal on failure.
+    if ((dataset.n_cols == 1) && (dimensionality == 1))
+      dataset = trans(dataset);
+
+    arma::Mat<size_t> offsets;
+    data::Load(offsetsFile, offsets, true);
+    if (offsets.n_elem == 0)
+      Log::Fatal << "No offsets in '" << offsetsFile << "'!" << std::endl;
+
+    // The first sequence must begin with the first observation (otherwise the
+    // observations before it would be silently dropped), and every other
+    // sequence must begin after the previous one and within the dataset.
+    if (offsets[0] != 0)
+      Log::Fatal << "The first offset in '" << offsetsFile << "' is "
+          << offsets[0] << ", but it must be 0!" << std::endl;
+
+    for (size_t i = 0; i < offsets.n_elem; ++i)
+    {
+      if (offsets[i] >= dataset.n_cols)
+        Log::Fatal << "Offset " << offsets[i] << " of sequence " << i
+            << " in '" << offsetsFile << "' is out of range (the dataset has "
+            << dataset.n_cols << " observations)!" << std::endl;
+
+      if (i > 0 && offsets[i] <= offsets[i - 1])
+        Log::Fatal << "Offset " << offsets[i] << " of sequence " << i
+            << " in '" << offsetsFile << "' is not greater than the offset of "
+            << "the previous sequence (" << offsets[i - 1] << ")!"
+            << std::endl;
+    }
+
+    for (size_t i = 0; i < offsets.n_elem; ++i)
+    {
+      const size_t end = (i + 1 < offsets.n_elem) ? offsets[i + 1] :
+          dataset.n_cols;
+      sequences.push_back(dataset.cols(offsets[i], end - 1));
+    }
+  }
+  else
+  {
+    // The input file contains a list of files to read.
+    std::fstream f(inputFile.c_str(), std::ios_base::in);
+    if (!f.is_open())
+      Log::Fatal << "Could not open '" << inputFile << "' for reading."
+          << std::endl;
+
+    std::string line;
+    while (std::getline(f, line))
+    {
+      if (line.empty())
+        continue;
+
+      sequences.push_back(arma::mat());
+      data::Load(line, sequences.back(), true); // Fatal on failure.
+      if ((sequences.back().n_cols == 1) && (dimensionality == 1))
+        sequences.back() = trans(sequences.back());
+    }
+  }
+
+  Log::Info << "Loaded " << sequences.size() << " sequences from '"
+      << inputFile << "'." << std::endl;
+
+  for (size_t i = 0; i < sequences.size(); ++i)
+    if (sequences[i].n_rows != dimensionality)
+      Log::Fatal << "Dimensionality of sequence " << i << " ("
+          << sequences[i].n_rows << ") is not equal to the dimensionality of "
+          << "the HMM (" << dimensionality << ")!" << std::endl;
+}
+
 } // namespace hmm
 } // namespace mlpack
 
@@ -12,16 +12,34 @@
 
 #include <mlpack/methods/gmm/gmm.hpp>
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 PROGRAM_INFO("Hidden Markov Model (HMM) Viterbi State Prediction", "This "
     "utility takes an already-trained HMM (--model_file) and evaluates the "
     "most probably hidden state sequence of a given sequence of observations "
     "(--input_file), using the Viterbi algorithm.  The computed state sequence "
-    "is saved to the specified output file (--output_file).");
+    "is saved to the specified output file (--output_file)."
+    "\n\n"
+    "Many sequences can be decoded at once, loading the model only once.  With "
+    "--batch, --input_file contains a list of files, one per line, each "
+    "holding a sequence.  With --offsets_file, --input_file holds all of the "
+    "sequences one after the other, and the offsets file holds the index of "
+    "the first observation of each sequence.  The sequences are decoded in "
+    "parallel on --threads threads, and the output file then holds the state "
+    "sequence of each input sequence on its own line.");
 
 PARAM_STRING_REQ("input_file", "File containing observations,", "i");
 PARAM_STRING_REQ("model_file", "File containing HMM.", "m");
 PARAM_STRING("output_file", "File to save predicted state sequence to.", "o",
     "output.csv");
+PARAM_FLAG("batch", "If true, input_file contains a list of files, each "
+    "holding an observation sequence.", "b");
+PARAM_STRING("offsets_file", "File containing the index of the first "
+    "observation of each sequence in input_file.", "O", "");
+PARAM_INT("threads", "Number of threads to use in batch mode (0 uses as many "
+    "threads as OpenMP allows).", "T", 1);
 
 using namespace mlpack;
 using namespace mlpack::hmm;
@@ -38,6 +56,12 @@ struct Viterbi
   template<typename HMMType>
   static void Apply(HMMType& hmm, void* /* extraInfo */)
   {
+    if (CLI::HasParam("batch") || CLI::HasParam("offsets_file"))
+    {
+      ApplyBatch(hmm);
+      return;
+    }
+
     // Load observations.
     const string inputFile = CLI::GetParam<string>("input_file");
 
@@ -65,6 +89,53 @@ struct Viterbi
     const string outputFile = CLI::GetParam<string>("output_file");
     data::Save(outputFile, sequence, true);
   }
+
+  // Decode all of the sequences of the batch in parallel.
+  template<typename HMMType>
+  static void ApplyBatch(HMMType& hmm)
+  {
+    vector<mat> sequences;
+    LoadSequences(CLI::GetParam<string>("input_file"),
+        CLI::GetParam<string>("offsets_file"),
+        hmm.Emission()[0].Dimensionality(), sequences);
+
+    const int threads = CLI::GetParam<int>("threads");
+    if (threads < 0)
+      Log::Fatal << "Invalid number of threads: " << threads << ".  Must be "
+          << "greater than or equal to 0." << endl;
+
+    size_t threadsToUse = (size_t) threads;
+#ifdef _OPENMP
+    if (threadsToUse == 0)
+      threadsToUse = (size_t) omp_get_max_threads();
+#else
+    threadsToUse = 1;
+#endif
+
+    // The sequences may have very different lengths, so they are handed out
+    // dynamically.
+    vector<arma::Col<size_t> > stateSeqs(sequences.size());
+    #pragma omp parallel for num_threads(threadsToUse) schedule(dynamic)
+    for (size_t i = 0; i < sequences.size(); ++i)
+      hmm.Predict(sequences[i], stateSeqs[i]);
+
+    // Save the state sequence of each input sequence on its own line.
+    const string outputFile = CLI::GetParam<string>("output_file");
+    ofstream out(outputFile.c_str());
+    if (!out.is_open())
+      Log::Fatal << "Cannot open file '" << outputFile << "'." << endl;
+
+    for (size_t i = 0; i < stateSeqs.size(); ++i)
+    {
+      for (size_t t = 0; t < stateSeqs[i].n_elem; ++t)
+        out << ((t == 0) ? "" : " ") << stateSeqs[i][t];
+      out << '\n';
+    }
+
+    if (!out.good())
+      Log::Fatal << "Writing state sequences to '" << outputFile << "' "
+          << "failed." << endl;
+  }
 };
 
 int main(int argc, char** argv)
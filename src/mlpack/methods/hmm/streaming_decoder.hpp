@@ -0,0 +1,151 @@
+/**
+ * @file streaming_decoder.hpp
+ *
+ * A decoder for HMMs that takes the observations of an unbounded stream one
+ * frame or one chunk at a time, and makes Viterbi decisions with a fixed lag.
+ */
+#ifndef __MLPACK_METHODS_HMM_STREAMING_DECODER_HPP
+#define __MLPACK_METHODS_HMM_STREAMING_DECODER_HPP
+
+#include <mlpack/core.hpp>
+#include "hmm.hpp"
+
+namespace mlpack {
+namespace hmm {
+
+/**
+ * A stateful decoder for one stream of observations of a given HMM.  The
+ * observations are given one frame or one chunk at a time with Update().  The
+ * decoder keeps the forward vector (the probability of each state given the
+ * observations so far) and the log-likelihood of the stream, and runs the
+ * Viterbi algorithm with fixed-lag traceback: once Lag() more observations have
+ * been seen after time t, the state at time t is decided by tracing back from
+ * the most likely state at the current time.  At the end of the stream,
+ * Finish() decides the last states with a full traceback.
+ *
+ * Only the last Lag() columns of Viterbi back pointers are kept, so the memory
+ * used is O(N * Lag()) for N states, no matter how long the stream is.  With a
+ * lag at least as long as the stream, the decisions are those of
+ * HMM::Predict(); with a shorter lag, they are an approximation, and two
+ * consecutive decisions may not be a possible transition.
+ *
+ * The decoder only holds a const reference to the HMM, so many streams can be
+ * decoded concurrently (for instance, one per thread) with one decoder each;
+ * the HMM must not be modified while decoders use it.
+ *
+ * @code
+ * extern HMM<GaussianDistribution> hmm;
+ * StreamingDecoder<GaussianDistribution> decoder(hmm, 50); // Lag of 50.
+ * arma::Col<size_t> states;
+ * while (...)
+ * {
+ *   arma::mat frames = ...; // The next frames of the stream.
+ *   decoder.Update(frames, states);
+ *   // Now 'states' holds the newly decided states.
+ * }
+ * decoder.Finish(states); // The last states.
+ * @endcode
+ *
+ * @tparam Distribution Type of emission distribution of the HMM.
+ */
+template<typename Distribution = distribution::DiscreteDistribution>
+class StreamingDecoder
+{
+ public:
+  /**
+   * Create the decoder for a stream of observations of the given HMM.  The
+   * HMM is not copied, so it must outlive the decoder.
+   *
+   * @param hmm HMM to decode observations with.
+   * @param lag Number of observations to wait before deciding a state.
+   */
+  StreamingDecoder(const HMM<Distribution>& hmm, const size_t lag = 20);
+
+  /**
+   * Add the given observations (one per column) to the stream.  The states
+   * that can now be decided (those Lag() observations behind the newest one)
+   * are stored in the given vector, in order; it may be empty.
+   *
+   * @param observations New observations of the stream.
+   * @param decisions Vector in which the newly decided states are stored.
+   */
+  void Update(const arma::mat& observations, arma::Col<size_t>& decisions);
+
+  /**
+   * End the stream: decide the states of the observations that have not been
+   * decided yet, with a full traceback, and store them in the given vector.
+   * The decoder is then reset, so it can be used for a new stream.
+   *
+   * @param decisions Vector in which the last decided states are stored.
+   */
+  void Finish(arma::Col<size_t>& decisions);
+
+  //! Forget the stream, so that the decoder can be used for a new one.
+  void Reset();
+
+  /**
+   * Get the probability of each state given the observations so far.  If an
+   * observation had probability 0 under the model (so that there is no such
+   * distribution), this is restarted from the initial state distribution of
+   * the HMM at that observation, and LogLikelihood() is -infinity from then
+   * on.
+   */
+  const arma::vec& StateProbabilities() const { return forward; }
+
+  //! Get the log-likelihood of the observations so far.
+  double LogLikelihood() const { return logLikelihood; }
+
+  //! Get the number of observations seen so far.
+  size_t Time() const { return time; }
+
+  //! Get the number of observations whose state has been decided.
+  size_t Decided() const { return (time > lag) ? time - lag : 0; }
+
+  //! Get the number of observations to wait before deciding a state.
+  size_t Lag() const { return lag; }
+
+ private:
+  //! The HMM.
+  const HMM<Distribution>& hmm;
+  //! Number of observations to wait before deciding a state.
+  size_t lag;
+
+  //! Whether the sparse transition matrix is used.
+  bool sparse;
+  //! Logs of the transposed transition matrix (if dense).
+  arma::mat logTrans;
+  //! Transposed transition matrix: column j holds the states that can
+  //! transition to state j (if sparse).
+  arma::sp_mat predecessors;
+  //! Logs of the nonzero values of the transposed transition matrix.
+  arma::vec logValues;
+  //! Transition matrix, for the forward vector (if sparse).
+  arma::sp_mat sparseTransition;
+
+  //! Number of observations seen so far.
+  size_t time;
+  //! Log-likelihood of the observations so far.
+  double logLikelihood;
+  //! Probability of each state given the observations so far.
+  arma::vec forward;
+  //! Viterbi log-probabilities of the best path to each state, up to a
+  //! constant.
+  arma::vec viterbi;
+  //! Back pointers of the last time steps, in a circular buffer.
+  arma::Mat<size_t> backPointers;
+
+  //! Process one observation, given its emission log-probabilities.
+  void Step(const arma::vec& emissionLogProb);
+
+  //! Trace back the given number of steps from the given state at the current
+  //! time, returning the state reached.
+  size_t TraceBack(size_t state, const size_t steps) const;
+};
+
+} // namespace hmm
+} // namespace mlpack
+
+// Include implementation.
+#include "streaming_decoder_impl.hpp"
+
+#endif
@@ -0,0 +1,218 @@
+/**
+ * @file streaming_decoder_impl.hpp
+ *
+ * Implementation of the streaming HMM decoder.
+ */
+#ifndef __MLPACK_METHODS_HMM_STREAMING_DECODER_IMPL_HPP
+#define __MLPACK_METHODS_HMM_STREAMING_DECODER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "streaming_decoder.hpp"
+
+namespace mlpack {
+namespace hmm {
+
+template<typename Distribution>
+StreamingDecoder<Distribution>::StreamingDecoder(
+    const HMM<Distribution>& hmm,
+    const size_t lag) :
+    hmm(hmm),
+    lag(lag),
+    sparse(hmm.SparseTransition())
+{
+  if (sparse)
+  {
+    // Column j of the transposed transition matrix holds the states that can
+    // transition to state j.
+    sparseTransition = arma::sp_mat(hmm.Transition());
+    predecessors = sparseTransition.t();
+    logValues = log(arma::vec(predecessors.values, predecessors.n_nonzero));
+  }
+  else
+  {
+    logTrans = log(trans(hmm.Transition()));
+  }
+
+  Reset();
+}
+
+template<typename Distribution>
+void StreamingDecoder<Distribution>::Update(const arma::mat& observations,
+                                            arma::Col<size_t>& decisions)
+{
+  if (observations.n_rows != hmm.Dimensionality())
+    Log::Fatal << "StreamingDecoder::Update(): observations have "
+        << "dimensionality " << observations.n_rows << " (expected "
+        << hmm.Dimensionality() << " dimensions)." << std::endl;
+
+  // The emission log-probabilities of the whole chunk are computed at once.
+  arma::mat emissionLogProb;
+  hmm.EmissionLogProbabilities(observations, emissionLogProb);
+
+  const size_t newTime = time + observations.n_cols;
+  decisions.set_size(((newTime > lag) ? newTime - lag : 0) - Decided());
+
+  size_t decided = 0;
+  for (size_t i = 0; i < observations.n_cols; ++i)
+  {
+    Step(emissionLogProb.unsafe_col(i));
+
+    // Decide the state Lag() observations back from the most likely state
+    // now.
+    if (time > lag)
+    {
+      arma::uword best;
+      viterbi.max(best);
+      decisions[decided++] = TraceBack(best, lag);
+    }
+  }
+}
+
+template<typename Distribution>
+void StreamingDecoder<Distribution>::Finish(arma::Col<size_t>& decisions)
+{
+  if (time == 0)
+  {
+    decisions.reset();
+    return;
+  }
+
+  // Trace back from the most likely state at the last time to the first
+  // undecided observation.
+  const size_t undecided = time - Decided();
+  decisions.set_size(undecided);
+
+  // With a lag of 0, every observation has already been decided.
+  if (undecided == 0)
+  {
+    Reset();
+    return;
+  }
+
+  arma::uword best;
+  viterbi.max(best);
+  size_t state = best;
+  decisions[undecided - 1] = state;
+  for (size_t k = 1; k < undecided; ++k)
+  {
+    state = backPointers(state, (time - k) % backPointers.n_cols);
+    decisions[undecided - 1 - k] = state;
+  }
+
+  Reset();
+}
+
+template<typename Distribution>
+void StreamingDecoder<Distribution>::Reset()
+{
+  time = 0;
+  logLikelihood = 0.0;
+  forward = hmm.Initial();
+  viterbi.zeros(hmm.Transition().n_rows);
+  backPointers.zeros(hmm.Transition().n_rows, std::max(lag, (size_t) 1));
+}
+
+template<typename Distribution>
+void StreamingDecoder<Distribution>::Step(const arma::vec& emissionLogProb)
+{
+  const size_t states = hmm.Transition().n_rows;
+  arma::vec predicted;
+  if (time == 0)
+  {
+    viterbi = log(hmm.Initial()) + emissionLogProb;
+    predicted = hmm.Initial();
+  }
+  else
+  {
+    // One step of the Viterbi algorithm, keeping the back pointers of this
+    // time step.
+    const size_t slot = time % backPointers.n_cols;
+    arma::vec newViterbi(states);
+    if (sparse)
+    {
+      for (size_t j = 0; j < states; ++j)
+      {
+        double best = -std::numeric_limits<double>::infinity();
+        size_t index = 0;
+        for (size_t k = predecessors.col_ptrs[j];
+             k < predecessors.col_ptrs[j + 1]; ++k)
+        {
+          const double prob = viterbi[predecessors.row_indices[k]] +
+              logValues[k];
+          if (prob > best)
+          {
+            best = prob;
+            index = predecessors.row_indices[k];
+          }
+        }
+
+        newViterbi[j] = best;
+        backPointers(j, slot) = index;
+      }
+
+      predicted = sparseTransition * forward;
+    }
+    else
+    {
+      arma::uword index;
+      for (size_t j = 0; j < states; ++j)
+      {
+        arma::vec prob = viterbi + logTrans.col(j);
+        newViterbi[j] = prob.max(index);
+        backPointers(j, slot) = index;
+      }
+
+      predicted = hmm.Transition() * forward;
+    }
+
+    viterbi = newViterbi + emissionLogProb;
+  }
+
+  // Only the differences between the Viterbi log-probabilities matter, so
+  // they are kept from drifting off.
+  const double bestViterbi = viterbi.max();
+  if (bestViterbi != -std::numeric_limits<double>::infinity())
+    viterbi -= bestViterbi;
+
+  // Update the forward vector.  The largest emission log-probability is taken
+  // out so that the probabilities can't all underflow.
+  const double shift = emissionLogProb.max();
+  double scale = 0.0;
+  if (shift != -std::numeric_limits<double>::infinity())
+  {
+    forward = predicted % exp(emissionLogProb - shift);
+    scale = accu(forward);
+  }
+
+  if (scale > 0.0)
+  {
+    forward /= scale;
+    logLikelihood += std::log(scale) + shift;
+  }
+  else
+  {
+    // This observation is impossible: either no state can emit it, or none of
+    // the states that can emit it can be reached.  Normalizing would fill the
+    // forward vector with NaNs, so it is restarted from the initial
+    // distribution instead.
+    forward = hmm.Initial();
+    logLikelihood = -std::numeric_limits<double>::infinity();
+  }
+
+  ++time;
+}
+
+template<typename Distribution>
+size_t StreamingDecoder<Distribution>::TraceBack(size_t state,
+                                                 const size_t steps) const
+{
+  for (size_t k = 0; k < steps; ++k)
+    state = backPointers(state, (time - 1 - k) % backPointers.n_cols);
+
+  return state;
+}
+
+} // namespace hmm
+} // namespace mlpack
+
+#endif
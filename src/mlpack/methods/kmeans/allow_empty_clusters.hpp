@@ -27,7 +27,8 @@ class AllowEmptyClusters
    * This function does nothing.  It is called by K-Means when K-Means detects
    * an empty cluster.
    *
-   * @tparam MatType Type of data (arma::mat or arma::spmat).
+   * @tparam MatType Type of data (arma::mat, arma::fmat, or arma::sp_mat).  The
+   *      centroids are dense matrices with the same element type.
    * @param data Dataset on which clustering is being performed.
    * @param emptyCluster Index of cluster which is empty.
    * @param oldCentroids Centroids of each cluster (one per column) at the start
@@ -44,8 +45,8 @@ class AllowEmptyClusters
   static inline force_inline size_t EmptyCluster(
       const MatType& /* data */,
       const size_t /* emptyCluster */,
-      const arma::mat& /* oldCentroids */,
-      arma::mat& /* newCentroids */,
+      const arma::Mat<typename MatType::elem_type>& /* oldCentroids */,
+      arma::Mat<typename MatType::elem_type>& /* newCentroids */,
       arma::Col<size_t>& /* clusterCounts */,
       MetricType& /* metric */,
       const size_t /* iteration */)
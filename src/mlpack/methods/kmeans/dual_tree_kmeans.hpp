@@ -25,6 +25,16 @@ namespace kmeans {
  * dataset.  The conditions under which this will perform best are probably
  * limited to the case where k is close to the number of points in the dataset,
  * and the number of iterations of the k-means algorithm will be few.
+ *
+ * By default, a new tree is built on the centroids in each iteration.  If
+ * ReuseCentroidTree() is set, the tree built in the first iteration is kept
+ * instead: in each later iteration the moved centroids are written into it and
+ * the bounds of its nodes are refitted bottom-up, which is cheaper than a
+ * rebuild but may give a somewhat looser tree.  This is only done for trees
+ * that can be refitted (binary space trees); other trees are always rebuilt.
+ *
+ * Each iteration is timed with the "centroid_tree_building",
+ * "dual_tree_traversal", and "tree_update" timers.
  */
 template<
     typename MetricType,
@@ -73,6 +83,12 @@ class DualTreeKMeans
   //! Modify the number of distance calculations.
   size_t& DistanceCalculations() { return distanceCalculations; }
 
+  //! Get whether the tree on the centroids is kept across iterations.
+  bool ReuseCentroidTree() const { return reuseCentroidTree; }
+  //! Modify whether the tree on the centroids is kept across iterations (and
+  //! refitted to the moved centroids) instead of being rebuilt.
+  bool& ReuseCentroidTree() { return reuseCentroidTree; }
+
  private:
   //! The original dataset reference.
   const MatType& datasetOrig; // Maybe not necessary.
@@ -88,6 +104,14 @@ class DualTreeKMeans
   //! Track iteration number.
   size_t iteration;
 
+  //! Whether or not to keep the centroid tree across iterations.
+  bool reuseCentroidTree;
+  //! The tree built on the centroids, if it is kept across iterations.
+  Tree* centroidTree;
+  //! Mappings from the centroids in the centroid tree to the original
+  //! centroids.
+  std::vector<size_t> oldFromNewCentroids;
+
   //! Upper bounds on nearest centroid.
   arma::vec upperBounds;
   //! Lower bounds on second closest cluster distance for each point.
@@ -153,6 +177,31 @@ void RestoreChildren(TreeType& node,
                      const typename boost::enable_if_c<tree::TreeTraits<
                          TreeType>::BinaryTree>::type* junk = 0);
 
+//! Move the points of a tree on the centroids to the new centroids and refit
+//! its bounds.  This is called if the tree rearranges its dataset (so it is a
+//! BinarySpaceTree).
+template<typename TreeType>
+void RefitTree(TreeType& tree,
+               const arma::mat& centroids,
+               const std::vector<size_t>& oldFromNew,
+               const typename boost::enable_if_c<tree::TreeTraits<
+                   TreeType>::RearrangesDataset>::type* junk = 0);
+
+//! Trees that do not rearrange their dataset can't be refitted, so this is
+//! never called and does nothing.
+template<typename TreeType>
+void RefitTree(TreeType& tree,
+               const arma::mat& centroids,
+               const std::vector<size_t>& oldFromNew,
+               const typename boost::disable_if_c<tree::TreeTraits<
+                   TreeType>::RearrangesDataset>::type* junk = 0);
+
+//! Refit the bounds of a node of a BinarySpaceTree and its descendants to the
+//! points they hold.  The bounds are emptied with Clear() and grown with
+//! operator|=, so HRectBound and BallBound trees can both be refitted.
+template<typename TreeType>
+void RefitNode(TreeType& node);
+
 //! A template typedef for the DualTreeKMeans algorithm with the default tree
 //! type (a kd-tree).
 template<typename MetricType, typename MatType>
@@ -58,6 +58,8 @@ DualTreeKMeans<MetricType, MatType, TreeType>::DualTreeKMeans(
     metric(metric),
     distanceCalculations(0),
     iteration(0),
+    reuseCentroidTree(false),
+    centroidTree(NULL),
     upperBounds(dataset.n_cols),
     lowerBounds(dataset.n_cols),
     prunedPoints(dataset.n_cols, false), // Fill with false.
@@ -83,6 +85,8 @@ DualTreeKMeans<MetricType, MatType, TreeType>::~DualTreeKMeans()
 {
   if (tree)
     delete tree;
+  if (centroidTree)
+    delete centroidTree;
 }
 
 // Run a single iteration.
@@ -96,11 +100,24 @@ double DualTreeKMeans<MetricType, MatType, TreeType>::Iterate(
     arma::mat& newCentroids,
     arma::Col<size_t>& counts)
 {
-  // Build a tree on the centroids.
+  // Build a tree on the centroids, or, if we are keeping the tree from the last
+  // iteration, move its points to the new centroids and refit its bounds.
+  Timer::Start("centroid_tree_building");
   arma::mat oldCentroids(centroids); // Slow. :(
-  std::vector<size_t> oldFromNewCentroids;
-  Tree* centroidTree = BuildTree<Tree>(const_cast<MatType&>(centroids),
-      oldFromNewCentroids);
+  if (reuseCentroidTree && tree::TreeTraits<Tree>::RearrangesDataset &&
+      centroidTree != NULL &&
+      centroidTree->Dataset().n_cols == centroids.n_cols)
+  {
+    RefitTree(*centroidTree, centroids, oldFromNewCentroids);
+  }
+  else
+  {
+    if (centroidTree)
+      delete centroidTree;
+    centroidTree = BuildTree<Tree>(const_cast<MatType&>(centroids),
+        oldFromNewCentroids);
+  }
+  Timer::Stop("centroid_tree_building");
 
   // Reset information in the tree, if we need to.
   if (iteration > 0)
@@ -134,7 +151,9 @@ double DualTreeKMeans<MetricType, MatType, TreeType>::Iterate(
 
     Timer::Stop("knn");
 
+    Timer::Start("tree_update");
     UpdateTree(*tree, oldCentroids);
+    Timer::Stop("tree_update");
 
     for (size_t i = 0; i < dataset.n_cols; ++i)
       visited[i] = false;
@@ -155,6 +174,7 @@ double DualTreeKMeans<MetricType, MatType, TreeType>::Iterate(
   typename Tree::template BreadthFirstDualTreeTraverser<RuleType>
       traverser(rules);
 
+  Timer::Start("dual_tree_traversal");
   Timer::Start("tree_mod");
   CoalesceTree(*tree);
   Timer::Stop("tree_mod");
@@ -167,8 +187,10 @@ double DualTreeKMeans<MetricType, MatType, TreeType>::Iterate(
   Timer::Start("tree_mod");
   DecoalesceTree(*tree);
   Timer::Stop("tree_mod");
+  Timer::Stop("dual_tree_traversal");
 
   // Now we need to extract the clusters.
+  Timer::Start("tree_update");
   newCentroids.zeros(centroids.n_rows, centroids.n_cols);
   counts.zeros(centroids.n_cols);
   ExtractCentroids(*tree, newCentroids, counts, oldCentroids);
@@ -199,8 +221,15 @@ double DualTreeKMeans<MetricType, MatType, TreeType>::Iterate(
     }
   }
   distanceCalculations += centroids.n_cols;
+  Timer::Stop("tree_update");
 
-  delete centroidTree;
+  // A tree that can't be refitted may hold a reference to the centroids, so it
+  // can't be kept.
+  if (!reuseCentroidTree || !tree::TreeTraits<Tree>::RearrangesDataset)
+  {
+    delete centroidTree;
+    centroidTree = NULL;
+  }
 
   ++iteration;
 
@@ -628,6 +657,62 @@ void DualTreeKMeans<MetricType, MatType, TreeType>::DecoalesceTree(Tree& node)
     DecoalesceTree(node.Child(i));
 }
 
+//! Move the points of a tree that rearranges its dataset (a BinarySpaceTree)
+//! and refit its bounds.
+template<typename TreeType>
+void RefitTree(TreeType& tree,
+               const arma::mat& centroids,
+               const std::vector<size_t>& oldFromNew,
+               const typename boost::enable_if_c<
+                   tree::TreeTraits<TreeType>::RearrangesDataset>::type*)
+{
+  // The tree holds its own copy of the centroids, in its own order.
+  for (size_t i = 0; i < centroids.n_cols; ++i)
+    tree.Dataset().col(i) = centroids.col(oldFromNew[i]);
+
+  RefitNode(tree);
+}
+
+//! Trees that don't rearrange their dataset are never refitted.
+template<typename TreeType>
+void RefitTree(TreeType& /* tree */,
+               const arma::mat& /* centroids */,
+               const std::vector<size_t>& /* oldFromNew */,
+               const typename boost::disable_if_c<
+                   tree::TreeTraits<TreeType>::RearrangesDataset>::type*)
+{
+  // Nothing to do.
+}
+
+//! Refit the bounds of a node of a BinarySpaceTree and its descendants.
+template<typename TreeType>
+void RefitNode(TreeType& node)
+{
+  for (size_t i = 0; i < node.NumChildren(); ++i)
+    RefitNode(node.Child(i));
+
+  // Each node's bound holds all of its descendant points, just like when the
+  // tree was built: the bound is emptied in place and grown to hold them.
+  node.Bound().Clear();
+  node.Bound() |= node.Dataset().cols(node.Begin(),
+      node.Begin() + node.Count() - 1);
+  node.FurthestDescendantDistance() = 0.5 * node.Bound().Diameter();
+
+  arma::vec center, childCenter;
+  node.Center(center);
+  for (size_t i = 0; i < node.NumChildren(); ++i)
+  {
+    node.Child(i).Center(childCenter);
+    node.Child(i).ParentDistance() = node.Metric().Evaluate(center,
+        childCenter);
+  }
+
+  // The statistic holds the empirical centroid of the node and the search
+  // bounds of the last iteration, so it must be recalculated too (after the
+  // children, since the centroid is calculated from theirs).
+  node.Stat() = DualTreeKMeansStatistic(node);
+}
+
 //! Utility function for hiding children in a non-binary tree.
 template<typename TreeType>
 void HideChild(TreeType& node,
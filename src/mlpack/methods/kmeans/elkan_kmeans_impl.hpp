@@ -10,6 +10,10 @@
 // In case it hasn't been included yet.
 #include "elkan_kmeans.hpp"
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace kmeans {
 
@@ -18,21 +22,19 @@ ElkanKMeans<MetricType, MatType>::ElkanKMeans(const MatType& dataset,
                                               MetricType& metric) :
     dataset(dataset),
     metric(metric),
-    distanceCalculations(0)
+    distanceCalculations(0),
+    numThreads(1)
 {
 
 }
 
 // Run a single iteration of Elkan's algorithm for Lloyd iterations.
 template<typename MetricType, typename MatType>
-double ElkanKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
-                                                 arma::mat& newCentroids,
-                                                 arma::Col<size_t>& counts)
+double ElkanKMeans<MetricType, MatType>::Iterate(
+    const arma::Mat<ElemType>& centroids,
+    arma::Mat<ElemType>& newCentroids,
+    arma::Col<size_t>& counts)
 {
-  // Clear new centroids.
-  newCentroids.zeros(centroids.n_rows, centroids.n_cols);
-  counts.zeros(centroids.n_cols);
-
   // At the beginning of the iteration, we must compute the distances between
   // all centers.  This is O(k^2).
   clusterDistances.set_size(centroids.n_cols, centroids.n_cols);
@@ -41,8 +43,9 @@ double ElkanKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
   // being the closest cluster centroid.
   clusterDistances.diag().fill(DBL_MAX);
 
-  // Initially set r(x) to true.
-  std::vector<bool> mustRecalculate(dataset.n_cols, true);
+  // Initially set r(x) to true.  (This is not a std::vector<bool>, because
+  // different threads write to neighboring elements.)
+  std::vector<char> mustRecalculate(dataset.n_cols, true);
 
   // If this is the first iteration, we must reset all the bounds.
   if (lowerBounds.n_rows != centroids.n_cols)
@@ -74,78 +77,108 @@ double ElkanKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
   // that this is equivalent to s(c) for each cluster c.
   minClusterDistances = 0.5 * arma::min(clusterDistances).t();
 
-  // Now loop over all points, and see which ones need to be updated.
-  for (size_t i = 0; i < dataset.n_cols; ++i)
+  // Now loop over all points, and see which ones need to be updated.  The
+  // points are split into one contiguous block per thread; each block keeps its
+  // own partial sums and counts, which are reduced in block order afterwards so
+  // that the result does not depend on the scheduling.
+  const size_t blocks = std::max(std::min(ThreadsToUse(), dataset.n_cols),
+      (size_t) 1);
+  arma::Cube<ElemType> partialCentroids(centroids.n_rows, centroids.n_cols,
+      blocks, arma::fill::zeros);
+  arma::Mat<size_t> partialCounts(centroids.n_cols, blocks, arma::fill::zeros);
+  std::vector<size_t> partialDistanceCalculations(blocks, 0);
+
+  #pragma omp parallel for num_threads(blocks) schedule(static, 1)
+  for (size_t b = 0; b < blocks; ++b)
   {
-    // Step 2: identify all points such that u(x) <= s(c(x)).
-    if (upperBounds(i) <= minClusterDistances(assignments[i]))
+    const size_t begin = (b * dataset.n_cols) / blocks;
+    const size_t end = ((b + 1) * dataset.n_cols) / blocks;
+    for (size_t i = begin; i < end; ++i)
     {
-      // No change needed.  This point must still belong to that cluster.
-      counts(assignments[i])++;
-      newCentroids.col(assignments[i]) += arma::vec(dataset.col(i));
-      continue;
-    }
-    else
-    {
-      for (size_t c = 0; c < centroids.n_cols; ++c)
+      // Step 2: identify all points such that u(x) <= s(c(x)).
+      if (upperBounds(i) <= minClusterDistances(assignments[i]))
       {
-        // Step 3: for all remaining points x and centers c such that c != c(x),
-        // u(x) > l(x, c) and u(x) > 0.5 d(c(x), c)...
-        if (assignments[i] == c)
-          continue; // Pruned because this cluster is already the assignment.
-
-        if (upperBounds(i) <= lowerBounds(c, i))
-          continue; // Pruned by triangle inequality on lower bound.
-
-        if (upperBounds(i) <= 0.5 * clusterDistances(assignments[i], c))
-          continue; // Pruned by triangle inequality on cluster distances.
-
-        // Step 3a: if r(x) then compute d(x, c(x)) and assign r(x) = false.
-        // Otherwise, d(x, c(x)) = u(x).
-        double dist;
-        if (mustRecalculate[i])
+        // No change needed.  This point must still belong to that cluster.
+        partialCounts(assignments[i], b)++;
+        partialCentroids.slice(b).col(assignments[i]) +=
+            arma::Col<ElemType>(dataset.col(i));
+        continue;
+      }
+      else
+      {
+        for (size_t c = 0; c < centroids.n_cols; ++c)
         {
-          mustRecalculate[i] = false;
-          dist = metric.Evaluate(dataset.col(i), centroids.col(assignments[i]));
-          lowerBounds(assignments[i], i) = dist;
-          upperBounds(i) = dist;
-          distanceCalculations++;
+          // Step 3: for all remaining points x and centers c such that
+          // c != c(x), u(x) > l(x, c) and u(x) > 0.5 d(c(x), c)...
+          if (assignments[i] == c)
+            continue; // Pruned because this cluster is already assigned.
 
-          // Check if we can prune again.
           if (upperBounds(i) <= lowerBounds(c, i))
             continue; // Pruned by triangle inequality on lower bound.
 
           if (upperBounds(i) <= 0.5 * clusterDistances(assignments[i], c))
             continue; // Pruned by triangle inequality on cluster distances.
-        }
-        else
-        {
-          dist = upperBounds(i); // This is equivalent to d(x, c(x)).
-        }
 
-        // Step 3b: if d(x, c(x)) > l(x, c) or d(x, c(x)) > 0.5 d(c(x), c)...
-        if (dist > lowerBounds(c, i) ||
-            dist > 0.5 * clusterDistances(assignments[i], c))
-        {
-          // Compute d(x, c).  If d(x, c) < d(x, c(x)) then assign c(x) = c.
-          const double pointDist = metric.Evaluate(dataset.col(i),
-                                                   centroids.col(c));
-          lowerBounds(c, i) = pointDist;
-          distanceCalculations++;
-          if (pointDist < dist)
+          // Step 3a: if r(x) then compute d(x, c(x)) and assign
+          // r(x) = false.  Otherwise, d(x, c(x)) = u(x).
+          double dist;
+          if (mustRecalculate[i])
           {
-            upperBounds(i) = pointDist;
-            assignments[i] = c;
+            mustRecalculate[i] = false;
+            dist = metric.Evaluate(dataset.col(i),
+                                   centroids.col(assignments[i]));
+            lowerBounds(assignments[i], i) = dist;
+            upperBounds(i) = dist;
+            partialDistanceCalculations[b]++;
+
+            // Check if we can prune again.
+            if (upperBounds(i) <= lowerBounds(c, i))
+              continue; // Pruned by triangle inequality on lower bound.
+
+            if (upperBounds(i) <= 0.5 * clusterDistances(assignments[i], c))
+              continue; // Pruned by triangle inequality on center distances.
+          }
+          else
+          {
+            dist = upperBounds(i); // This is equivalent to d(x, c(x)).
+          }
+
+          // Step 3b: if d(x, c(x)) > l(x, c) or
+          // d(x, c(x)) > 0.5 d(c(x), c)...
+          if (dist > lowerBounds(c, i) ||
+              dist > 0.5 * clusterDistances(assignments[i], c))
+          {
+            // Compute d(x, c).  If d(x, c) < d(x, c(x)) then assign c(x) = c.
+            const double pointDist = metric.Evaluate(dataset.col(i),
+                                                     centroids.col(c));
+            lowerBounds(c, i) = pointDist;
+            partialDistanceCalculations[b]++;
+            if (pointDist < dist)
+            {
+              upperBounds(i) = pointDist;
+              assignments[i] = c;
+            }
           }
         }
       }
+
+      // At this point, we know the new cluster assignment.
+      // Step 4: for each center c, let m(c) be the mean of the points
+      // assigned to c.
+      partialCentroids.slice(b).col(assignments[i]) +=
+          arma::Col<ElemType>(dataset.col(i));
+      partialCounts(assignments[i], b)++;
     }
+  }
 
-    // At this point, we know the new cluster assignment.
-    // Step 4: for each center c, let m(c) be the mean of the points assigned to
-    // c.
-    newCentroids.col(assignments[i]) += arma::vec(dataset.col(i));
-    counts[assignments[i]]++;
+  newCentroids = partialCentroids.slice(0);
+  counts = partialCounts.col(0);
+  distanceCalculations += partialDistanceCalculations[0];
+  for (size_t b = 1; b < blocks; ++b)
+  {
+    newCentroids += partialCentroids.slice(b);
+    counts += partialCounts.col(b);
+    distanceCalculations += partialDistanceCalculations[b];
   }
 
   // Now, normalize and calculate the distance each cluster has moved.
@@ -155,14 +188,15 @@ double ElkanKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
   {
     if (counts[c] > 0)
       newCentroids.col(c) /= counts[c];
-    else
-      newCentroids.fill(DBL_MAX); // Fill with invalid value.
+    else // Fill with invalid value.
+      newCentroids.col(c).fill(std::numeric_limits<ElemType>::max());
 
     moveDistances(c) = metric.Evaluate(newCentroids.col(c), centroids.col(c));
     cNorm += std::pow(moveDistances(c), 2.0);
     distanceCalculations++;
   }
 
+  #pragma omp parallel for num_threads(blocks) schedule(static)
   for (size_t i = 0; i < dataset.n_cols; ++i)
   {
     // Step 5: for each point x and center c, assign
@@ -180,6 +214,19 @@ double ElkanKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
   return std::sqrt(cNorm);
 }
 
+template<typename MetricType, typename MatType>
+size_t ElkanKMeans<MetricType, MatType>::ThreadsToUse() const
+{
+  if (numThreads != 0)
+    return numThreads;
+
+#ifdef _OPENMP
+  return (size_t) omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
 } // namespace kmeans
 } // namespace mlpack
 
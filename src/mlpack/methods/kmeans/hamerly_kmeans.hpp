@@ -14,6 +14,9 @@ template<typename MetricType, typename MatType>
 class HamerlyKMeans
 {
  public:
+  //! The type of the elements of the dataset and of the centroids.
+  typedef typename MatType::elem_type ElemType;
+
   /**
    * Construct the HamerlyKMeans object, which must store several sets of
    * bounds.
@@ -28,12 +31,18 @@ class HamerlyKMeans
    * @param newCentroids New cluster centroids.
    * @param counts Current counts, to be overwritten with new counts.
    */
-  double Iterate(const arma::mat& centroids,
-                 arma::mat& newCentroids,
+  double Iterate(const arma::Mat<ElemType>& centroids,
+                 arma::Mat<ElemType>& newCentroids,
                  arma::Col<size_t>& counts);
 
   size_t DistanceCalculations() const { return distanceCalculations; }
 
+  //! Get the number of threads used for each iteration.
+  size_t NumThreads() const { return numThreads; }
+  //! Modify the number of threads used for each iteration (0 means as many as
+  //! OpenMP allows).
+  size_t& NumThreads() { return numThreads; }
+
  private:
   //! The dataset.
   const MatType& dataset;
@@ -52,6 +61,11 @@ class HamerlyKMeans
 
   //! Track distance calculations.
   size_t distanceCalculations;
+  //! Number of threads to use for each iteration.
+  size_t numThreads;
+
+  //! Get the number of threads that will actually be used.
+  size_t ThreadsToUse() const;
 };
 
 } // namespace kmeans
@@ -10,6 +10,10 @@
 // In case it hasn't been included yet.
 #include "hamerly_kmeans.hpp"
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace kmeans {
 
@@ -18,18 +22,18 @@ HamerlyKMeans<MetricType, MatType>::HamerlyKMeans(const MatType& dataset,
                                                   MetricType& metric) :
     dataset(dataset),
     metric(metric),
-    distanceCalculations(0)
+    distanceCalculations(0),
+    numThreads(1)
 {
   // Nothing to do.
 }
 
 template<typename MetricType, typename MatType>
-double HamerlyKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
-                                                   arma::mat& newCentroids,
-                                                   arma::Col<size_t>& counts)
+double HamerlyKMeans<MetricType, MatType>::Iterate(
+    const arma::Mat<ElemType>& centroids,
+    arma::Mat<ElemType>& newCentroids,
+    arma::Col<size_t>& counts)
 {
-  size_t hamerlyPruned = 0;
-
   // If this is the first iteration, we need to set all the bounds.
   if (minClusterDistances.n_elem != centroids.n_cols)
   {
@@ -40,10 +44,6 @@ double HamerlyKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
     minClusterDistances.set_size(centroids.n_cols);
   }
 
-  // Reset new centroids.
-  newCentroids.zeros(centroids.n_rows, centroids.n_cols);
-  counts.zeros(centroids.n_cols);
-
   // Calculate minimum intra-cluster distance for each cluster.
   minClusterDistances.fill(DBL_MAX);
   for (size_t i = 0; i < centroids.n_cols; ++i)
@@ -62,63 +62,98 @@ double HamerlyKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
     }
   }
 
-  for (size_t i = 0; i < dataset.n_cols; ++i)
+  // The points are split into one contiguous block per thread.  Each block
+  // keeps its own partial sums and counts, which are reduced in block order
+  // afterwards so that the result does not depend on the scheduling.
+  const size_t blocks = std::max(std::min(ThreadsToUse(), dataset.n_cols),
+      (size_t) 1);
+  arma::Cube<ElemType> partialCentroids(centroids.n_rows, centroids.n_cols,
+      blocks, arma::fill::zeros);
+  arma::Mat<size_t> partialCounts(centroids.n_cols, blocks, arma::fill::zeros);
+  std::vector<size_t> partialDistanceCalculations(blocks, 0);
+  std::vector<size_t> partialPruned(blocks, 0);
+
+  #pragma omp parallel for num_threads(blocks) schedule(static, 1)
+  for (size_t b = 0; b < blocks; ++b)
   {
-    const double m = std::max(minClusterDistances(assignments[i]),
-                              lowerBounds(i));
-
-    // First bound test.
-    if (upperBounds(i) <= m)
-    {
-      ++hamerlyPruned;
-      newCentroids.col(assignments[i]) += dataset.col(i);
-      ++counts(assignments[i]);
-      continue;
-    }
-
-    // Tighten upper bound.
-    upperBounds(i) = metric.Evaluate(dataset.col(i),
-                                     centroids.col(assignments[i]));
-    ++distanceCalculations;
-
-    // Second bound test.
-    if (upperBounds(i) <= m)
+    const size_t begin = (b * dataset.n_cols) / blocks;
+    const size_t end = ((b + 1) * dataset.n_cols) / blocks;
+    for (size_t i = begin; i < end; ++i)
     {
-      newCentroids.col(assignments[i]) += dataset.col(i);
-      ++counts(assignments[i]);
-      continue;
-    }
+      const double m = std::max(minClusterDistances(assignments[i]),
+                                lowerBounds(i));
 
-    // The bounds failed.  So test against all other clusters.
-    // This is Hamerly's Point-All-Ctrs() function from the paper.
-    // We have to reset the lower bound first.
-    lowerBounds(i) = DBL_MAX;
-    for (size_t c = 0; c < centroids.n_cols; ++c)
-    {
-      if (c == assignments[i])
+      // First bound test.
+      if (upperBounds(i) <= m)
+      {
+        ++partialPruned[b];
+        partialCentroids.slice(b).col(assignments[i]) +=
+            arma::Col<ElemType>(dataset.col(i));
+        ++partialCounts(assignments[i], b);
         continue;
+      }
 
-      const double dist = metric.Evaluate(dataset.col(i), centroids.col(c));
+      // Tighten upper bound.
+      upperBounds(i) = metric.Evaluate(dataset.col(i),
+                                       centroids.col(assignments[i]));
+      ++partialDistanceCalculations[b];
 
-      // Is this a better cluster?  At this point, upperBounds[i] = d(i, c(i)).
-      if (dist < upperBounds(i))
+      // Second bound test.
+      if (upperBounds(i) <= m)
       {
-        // lowerBounds holds the second closest cluster.
-        lowerBounds(i) = upperBounds(i);
-        upperBounds(i) = dist;
-        assignments[i] = c;
+        partialCentroids.slice(b).col(assignments[i]) +=
+            arma::Col<ElemType>(dataset.col(i));
+        ++partialCounts(assignments[i], b);
+        continue;
       }
-      else if (dist < lowerBounds(i))
+
+      // The bounds failed.  So test against all other clusters.
+      // This is Hamerly's Point-All-Ctrs() function from the paper.
+      // We have to reset the lower bound first.
+      lowerBounds(i) = DBL_MAX;
+      for (size_t c = 0; c < centroids.n_cols; ++c)
       {
-        // This is a closer second-closest cluster.
-        lowerBounds(i) = dist;
+        if (c == assignments[i])
+          continue;
+
+        const double dist = metric.Evaluate(dataset.col(i), centroids.col(c));
+
+        // Is this a better cluster?  At this point,
+        // upperBounds[i] = d(i, c(i)).
+        if (dist < upperBounds(i))
+        {
+          // lowerBounds holds the second closest cluster.
+          lowerBounds(i) = upperBounds(i);
+          upperBounds(i) = dist;
+          assignments[i] = c;
+        }
+        else if (dist < lowerBounds(i))
+        {
+          // This is a closer second-closest cluster.
+          lowerBounds(i) = dist;
+        }
       }
+      partialDistanceCalculations[b] += centroids.n_cols - 1;
+
+      // Update new centroids.
+      partialCentroids.slice(b).col(assignments[i]) +=
+          arma::Col<ElemType>(dataset.col(i));
+      ++partialCounts(assignments[i], b);
     }
-    distanceCalculations += centroids.n_cols - 1;
+  }
 
-    // Update new centroids.
-    newCentroids.col(assignments[i]) += dataset.col(i);
-    ++counts(assignments[i]);
+  size_t hamerlyPruned = 0;
+  newCentroids = partialCentroids.slice(0);
+  counts = partialCounts.col(0);
+  for (size_t b = 0; b < blocks; ++b)
+  {
+    if (b > 0)
+    {
+      newCentroids += partialCentroids.slice(b);
+      counts += partialCounts.col(b);
+    }
+    distanceCalculations += partialDistanceCalculations[b];
+    hamerlyPruned += partialPruned[b];
   }
 
   // Normalize centroids and calculate cluster movement (contains parts of
@@ -132,8 +167,8 @@ double HamerlyKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
   {
     if (counts(c) > 0)
       newCentroids.col(c) /= counts(c);
-    else
-      newCentroids.col(c).fill(DBL_MAX); // Empty cluster.
+    else // Empty cluster.
+      newCentroids.col(c).fill(std::numeric_limits<ElemType>::max());
 
     // Calculate movement.
     const double movement = metric.Evaluate(centroids.col(c),
@@ -155,6 +190,7 @@ double HamerlyKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
   }
 
   // Now update bounds (lines 3-8 of Update-Bounds()).
+  #pragma omp parallel for num_threads(blocks) schedule(static)
   for (size_t i = 0; i < dataset.n_cols; ++i)
   {
     upperBounds(i) += centroidMovements(assignments[i]);
@@ -169,6 +205,19 @@ double HamerlyKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
   return std::sqrt(centroidMovement);
 }
 
+template<typename MetricType, typename MatType>
+size_t HamerlyKMeans<MetricType, MatType>::ThreadsToUse() const
+{
+  if (numThreads != 0)
+    return numThreads;
+
+#ifdef _OPENMP
+  return (size_t) omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
 } // namespace kmeans
 } // namespace mlpack
 
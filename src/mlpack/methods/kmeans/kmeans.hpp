@@ -8,6 +8,7 @@
 #define __MLPACK_METHODS_KMEANS_KMEANS_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/util/sfinae_utility.hpp>
 
 #include <mlpack/core/metrics/lmetric.hpp>
 #include "random_partition.hpp"
@@ -19,6 +20,24 @@
 namespace mlpack {
 namespace kmeans /** K-Means clustering. */ {
 
+// This gives us a HasNumThreadsCheck<T, U> type (where U is a function pointer)
+// we can use with SFINAE to catch when a Lloyd step type can use more than one
+// thread.
+HAS_MEM_FUNC(NumThreads, HasNumThreadsCheck);
+
+// This gives us a HasBatchSizeCheck<T, U> type (where U is a function pointer)
+// we can use with SFINAE to catch when a Lloyd step type uses mini-batches.
+HAS_MEM_FUNC(BatchSize, HasBatchSizeCheck);
+
+// This gives us a HasNumGroupsCheck<T, U> type (where U is a function pointer)
+// we can use with SFINAE to catch when a Lloyd step type groups its centroids.
+HAS_MEM_FUNC(NumGroups, HasNumGroupsCheck);
+
+// This gives us a HasReuseCentroidTreeCheck<T, U> type (where U is a function
+// pointer) we can use with SFINAE to catch when a Lloyd step type builds a tree
+// on the centroids.
+HAS_MEM_FUNC(ReuseCentroidTree, HasReuseCentroidTreeCheck);
+
 /**
  * This class implements K-Means clustering, using a variety of possible
  * implementations of Lloyd's algorithm.
@@ -53,9 +72,14 @@ namespace kmeans /** K-Means clustering. */ {
  *     implement a default constructor and 'void EmptyCluster(const arma::mat&,
  *     arma::Col<size_t&)'.
  * @tparam LloydStepType Implementation of single Lloyd step to use.
+ * @tparam MatType Type of the data (arma::mat, arma::fmat, or arma::sp_mat).
+ *     The centroids are dense matrices with the same element type, so with
+ *     arma::fmat, everything is done in single precision.  The tree-based
+ *     Lloyd steps (PellegMooreKMeans and DualTreeKMeans) need arma::mat.
  *
  * @see RandomPartition, RefinedStart, AllowEmptyClusters,
- *      MaxVarianceNewCluster, NaiveKMeans, ElkanKMeans
+ *      MaxVarianceNewCluster, NaiveKMeans, ElkanKMeans, MiniBatchKMeans,
+ *      YinyangKMeans
  */
 template<typename MetricType = metric::EuclideanDistance,
          typename InitialPartitionPolicy = RandomPartition,
@@ -65,6 +89,10 @@ template<typename MetricType = metric::EuclideanDistance,
 class KMeans
 {
  public:
+  //! The type of the elements of the data and of the centroids.  With
+  //! arma::fmat data, the whole computation is done in single precision.
+  typedef typename MatType::elem_type ElemType;
+
   /**
    * Create a K-Means object and (optionally) set the parameters which K-Means
    * will be run with.
@@ -90,7 +118,7 @@ class KMeans
    * initial guess of the cluster assignments; to do this, set initialGuess to
    * true.
    *
-   * @tparam MatType Type of matrix (arma::mat or arma::sp_mat).
+   * @tparam MatType Type of matrix (arma::mat, arma::fmat, or arma::sp_mat).
    * @param data Dataset to cluster.
    * @param clusters Number of clusters to compute.
    * @param assignments Vector to store cluster assignments in.
@@ -108,7 +136,7 @@ class KMeans
    * specified by filling the centroids matrix with the initial centroids and
    * specifying initialGuess = true.
    *
-   * @tparam MatType Type of matrix (arma::mat or arma::sp_mat).
+   * @tparam MatType Type of matrix (arma::mat, arma::fmat, or arma::sp_mat).
    * @param data Dataset to cluster.
    * @param clusters Number of clusters to compute.
    * @param centroids Matrix in which centroids are stored.
@@ -117,7 +145,7 @@ class KMeans
    */
   void Cluster(const MatType& data,
                const size_t clusters,
-               arma::mat& centroids,
+               arma::Mat<ElemType>& centroids,
                const bool initialGuess = false);
 
   /**
@@ -130,7 +158,7 @@ class KMeans
    * supersedes initialCentroidGuess, so if both are set to true, the
    * assignments vector is used.
    *
-   * @tparam MatType Type of matrix (arma::mat or arma::sp_mat).
+   * @tparam MatType Type of matrix (arma::mat, arma::fmat, or arma::sp_mat).
    * @param data Dataset to cluster.
    * @param clusters Number of clusters to compute.
    * @param assignments Vector to store cluster assignments in.
@@ -143,7 +171,7 @@ class KMeans
   void Cluster(const MatType& data,
                const size_t clusters,
                arma::Col<size_t>& assignments,
-               arma::mat& centroids,
+               arma::Mat<ElemType>& centroids,
                const bool initialAssignmentGuess = false,
                const bool initialCentroidGuess = false);
 
@@ -152,6 +180,37 @@ class KMeans
   //! Set the maximum number of iterations.
   size_t& MaxIterations() { return maxIterations; }
 
+  //! Get the number of threads used by the Lloyd step.
+  size_t NumThreads() const { return numThreads; }
+  //! Modify the number of threads used by the Lloyd step (0 means as many as
+  //! OpenMP allows).  This is ignored by Lloyd step types that do not have a
+  //! NumThreads() method.  For a given number of threads, the results are
+  //! deterministic.
+  size_t& NumThreads() { return numThreads; }
+
+  //! Get the batch size used by mini-batch Lloyd steps.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the batch size used by mini-batch Lloyd steps (such as
+  //! MiniBatchKMeans).  This is ignored by the other Lloyd step types.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the number of centroid groups used by Lloyd steps that group
+  //! centroids.
+  size_t NumGroups() const { return numGroups; }
+  //! Modify the number of centroid groups used by Lloyd steps that group
+  //! centroids (such as YinyangKMeans; 0 means the step's default).  This is
+  //! ignored by the other Lloyd step types.
+  size_t& NumGroups() { return numGroups; }
+
+  //! Get whether Lloyd steps that build a tree on the centroids keep it across
+  //! iterations.
+  bool ReuseCentroidTree() const { return reuseCentroidTree; }
+  //! Modify whether Lloyd steps that build a tree on the centroids (such as
+  //! DualTreeKMeans) keep it across iterations and refit it to the moved
+  //! centroids instead of rebuilding it.  This is ignored by the other Lloyd
+  //! step types.
+  bool& ReuseCentroidTree() { return reuseCentroidTree; }
+
   //! Get the distance metric.
   const MetricType& Metric() const { return metric; }
   //! Modify the distance metric.
@@ -178,12 +237,80 @@ class KMeans
  private:
   //! Maximum number of iterations before giving up.
   size_t maxIterations;
+  //! Number of threads for the Lloyd step.
+  size_t numThreads;
+  //! Batch size for mini-batch Lloyd steps.
+  size_t batchSize;
+  //! Number of centroid groups for Lloyd steps that group centroids.
+  size_t numGroups;
+  //! Whether to keep the centroid tree across iterations, for Lloyd steps that
+  //! build one.
+  bool reuseCentroidTree;
   //! Instantiated distance metric.
   MetricType metric;
   //! Instantiated initial partitioning policy.
   InitialPartitionPolicy partitioner;
   //! Instantiated empty cluster policy.
   EmptyClusterPolicy emptyClusterAction;
+
+  //! Pass the number of threads to a Lloyd step type that supports it.
+  template<typename StepType>
+  typename std::enable_if<
+      HasNumThreadsCheck<StepType, size_t&(StepType::*)(void)>::value,
+      void>::type
+  SetNumThreads(StepType& step) const { step.NumThreads() = numThreads; }
+
+  //! Do nothing for Lloyd step types that are single-threaded.
+  template<typename StepType>
+  typename std::enable_if<
+      !HasNumThreadsCheck<StepType, size_t&(StepType::*)(void)>::value,
+      void>::type
+  SetNumThreads(StepType& /* step */) const { }
+
+  //! Pass the batch size to a mini-batch Lloyd step type.
+  template<typename StepType>
+  typename std::enable_if<
+      HasBatchSizeCheck<StepType, size_t&(StepType::*)(void)>::value,
+      void>::type
+  SetBatchSize(StepType& step) const { step.BatchSize() = batchSize; }
+
+  //! Do nothing for Lloyd step types that use the whole dataset.
+  template<typename StepType>
+  typename std::enable_if<
+      !HasBatchSizeCheck<StepType, size_t&(StepType::*)(void)>::value,
+      void>::type
+  SetBatchSize(StepType& /* step */) const { }
+
+  //! Pass the number of groups to a Lloyd step type that groups centroids.
+  template<typename StepType>
+  typename std::enable_if<
+      HasNumGroupsCheck<StepType, size_t&(StepType::*)(void)>::value,
+      void>::type
+  SetNumGroups(StepType& step) const { step.NumGroups() = numGroups; }
+
+  //! Do nothing for Lloyd step types that do not group centroids.
+  template<typename StepType>
+  typename std::enable_if<
+      !HasNumGroupsCheck<StepType, size_t&(StepType::*)(void)>::value,
+      void>::type
+  SetNumGroups(StepType& /* step */) const { }
+
+  //! Pass the centroid tree setting to a Lloyd step type that builds a tree on
+  //! the centroids.
+  template<typename StepType>
+  typename std::enable_if<
+      HasReuseCentroidTreeCheck<StepType, bool&(StepType::*)(void)>::value,
+      void>::type
+  SetReuseCentroidTree(StepType& step) const
+  { step.ReuseCentroidTree() = reuseCentroidTree; }
+
+  //! Do nothing for Lloyd step types that do not build a tree on the
+  //! centroids.
+  template<typename StepType>
+  typename std::enable_if<
+      !HasReuseCentroidTreeCheck<StepType, bool&(StepType::*)(void)>::value,
+      void>::type
+  SetReuseCentroidTree(StepType& /* step */) const { }
 };
 
 } // namespace kmeans
@@ -31,6 +31,10 @@ KMeans(const size_t maxIterations,
        const InitialPartitionPolicy partitioner,
        const EmptyClusterPolicy emptyClusterAction) :
     maxIterations(maxIterations),
+    numThreads(1),
+    batchSize(1000),
+    numGroups(0),
+    reuseCentroidTree(false),
     metric(metric),
     partitioner(partitioner),
     emptyClusterAction(emptyClusterAction)
@@ -60,7 +64,7 @@ Cluster(const MatType& data,
         arma::Col<size_t>& assignments,
         const bool initialGuess)
 {
-  arma::mat centroids(data.n_rows, clusters);
+  arma::Mat<ElemType> centroids(data.n_rows, clusters);
   Cluster(data, clusters, assignments, centroids, initialGuess);
 }
 
@@ -81,7 +85,7 @@ void KMeans<
     MatType>::
 Cluster(const MatType& data,
         const size_t clusters,
-        arma::mat& centroids,
+        arma::Mat<ElemType>& centroids,
         const bool initialGuess)
 {
   // Make sure we have more points than clusters.
@@ -122,7 +126,7 @@ Cluster(const MatType& data,
     centroids.zeros(data.n_rows, clusters);
     for (size_t i = 0; i < data.n_cols; ++i)
     {
-      centroids.col(assignments[i]) += arma::vec(data.col(i));
+      centroids.col(assignments[i]) += arma::Col<ElemType>(data.col(i));
       counts[assignments[i]]++;
     }
 
@@ -137,7 +141,11 @@ Cluster(const MatType& data,
   size_t iteration = 0;
 
   LloydStepType<MetricType, MatType> lloydStep(data, metric);
-  arma::mat centroidsOther;
+  SetNumThreads(lloydStep);
+  SetBatchSize(lloydStep);
+  SetNumGroups(lloydStep);
+  SetReuseCentroidTree(lloydStep);
+  arma::Mat<ElemType> centroidsOther;
   double cNorm;
 
   do
@@ -211,7 +219,7 @@ void KMeans<
 Cluster(const MatType& data,
         const size_t clusters,
         arma::Col<size_t>& assignments,
-        arma::mat& centroids,
+        arma::Mat<ElemType>& centroids,
         const bool initialAssignmentGuess,
         const bool initialCentroidGuess)
 {
@@ -229,7 +237,7 @@ Cluster(const MatType& data,
     centroids.zeros(data.n_rows, clusters);
     for (size_t i = 0; i < data.n_cols; ++i)
     {
-      centroids.col(assignments[i]) += arma::vec(data.col(i));
+      centroids.col(assignments[i]) += arma::Col<ElemType>(data.col(i));
       counts[assignments[i]]++;
     }
 
@@ -9,10 +9,16 @@
 #include "kmeans.hpp"
 #include "allow_empty_clusters.hpp"
 #include "refined_start.hpp"
+#include "kmeans_plus_plus.hpp"
+#include "kmeans_parallel.hpp"
 #include "elkan_kmeans.hpp"
 #include "hamerly_kmeans.hpp"
 #include "pelleg_moore_kmeans.hpp"
 #include "dual_tree_kmeans.hpp"
+#include "mini_batch_kmeans.hpp"
+#include "yinyang_kmeans.hpp"
+#include "streaming_mini_batch_kmeans.hpp"
+#include "out_of_core_kmeans.hpp"
 
 using namespace mlpack;
 using namespace mlpack::kmeans;
@@ -34,12 +40,43 @@ PROGRAM_INFO("K-Means Clustering", "This program performs K-Means clustering "
     "to be used in each sample, the --percentage parameter is used (it should "
     "be a value between 0.0 and 1.0)."
     "\n\n"
+    "Alternately, the k-means++ seeding (\"k-means++: The advantages of careful "
+    "seeding\", 2007) can be used with the --kmeans_plus_plus (-K) option, or "
+    "its scalable variant k-means|| (\"Scalable k-means++\", 2012) with the "
+    "--kmeans_parallel (-k) option.  k-means|| runs --rounds sampling rounds, "
+    "each choosing about --oversampling candidates (0 means twice the number "
+    "of clusters), and uses --threads threads."
+    "\n\n"
     "There are several options available for the algorithm used for each Lloyd "
     "iteration, specified with the --algorithm (-a) option.  The standard O(kN)"
     " approach can be used ('naive').  Other options include the Pelleg-Moore "
     "tree-based algorithm ('pelleg-moore'), Elkan's triangle-inequality based "
     "algorithm ('elkan'), and Hamerly's modification to Elkan's algorithm "
-    "('hamerly')."
+    "('hamerly').  The 'naive', 'elkan', and 'hamerly' algorithms can use "
+    "several threads, specified with the --threads (-T) option; for a given "
+    "seed and number of threads, the results are deterministic."
+    "\n\n"
+    "Mini-batch k-means (Sculley, \"Web-scale k-means clustering\", 2010) can "
+    "be used with '--algorithm minibatch'.  Each iteration then uses only a "
+    "random sample of --batch_size (-b) points, so many more iterations are "
+    "needed, but each is much cheaper; the number of iterations is best "
+    "controlled with --max_iterations.  If the dataset does not fit in memory, "
+    "the --stream option reads the input file one batch at a time instead of "
+    "loading it; the points in the file should then be in random order, and "
+    "only the centroids (--centroid_file) can be saved."
+    "\n\n"
+    "If the dataset does not fit in memory but exact k-means is wanted, the "
+    "--out_of_core option reads the input file, which must be an Armadillo "
+    "binary file ('.bin', as saved by mlpack), one block of --block_size (-B) "
+    "points at a time in each iteration.  The naive algorithm is used, and "
+    "--output_file then holds only the labels, which are also written one "
+    "block at a time."
+    "\n\n"
+    "With the --float option, the dataset is loaded in single precision and "
+    "the whole of k-means (the initial partition, every Lloyd iteration, and "
+    "the empty cluster handling) is run in single precision, which halves the "
+    "memory used and is usually faster.  This is not available for the "
+    "'pelleg-moore' and 'dualtree' algorithms."
     "\n\n"
     "As of October 2014, the --overclustering option has been removed.  If you "
     "want this support back, let us know -- file a bug at "
@@ -76,25 +113,80 @@ PARAM_INT("samplings", "Number of samplings to perform for refined start (use "
 PARAM_DOUBLE("percentage", "Percentage of dataset to use for each refined start"
     " sampling (use when --refined_start is specified).", "p", 0.02);
 
+// Parameters for k-means++ and k-means||.
+PARAM_FLAG("kmeans_plus_plus", "Use the k-means++ seeding to choose initial "
+    "points.", "K");
+PARAM_FLAG("kmeans_parallel", "Use the k-means|| seeding to choose initial "
+    "points.", "k");
+PARAM_DOUBLE("oversampling", "Expected number of candidates chosen in each "
+    "round of k-means|| (0 means twice the number of clusters).", "O", 0.0);
+PARAM_INT("rounds", "Number of sampling rounds of k-means||.", "R", 5);
+
 PARAM_STRING("algorithm", "Algorithm to use for the Lloyd iteration ('naive', "
-    "'pelleg-moore', 'elkan', 'hamerly', or 'dtnn').", "a", "naive");
+    "'pelleg-moore', 'elkan', 'hamerly', 'yinyang', 'dtnn', or 'minibatch').",
+    "a", "naive");
+PARAM_INT("groups", "Number of groups of centroids for the 'yinyang' algorithm "
+    "(0 means one tenth of the number of clusters).", "g", 0);
+PARAM_FLAG("reuse_centroid_tree", "Keep the tree built on the centroids across "
+    "iterations of the 'dualtree' algorithm and refit it to the moved "
+    "centroids instead of rebuilding it.", "");
+PARAM_INT("batch_size", "Number of points in each batch for the 'minibatch' "
+    "algorithm.", "b", 1000);
+PARAM_FLAG("stream", "Read the input file one batch at a time instead of "
+    "loading it (only for the 'minibatch' algorithm).", "");
+PARAM_FLAG("out_of_core", "Read the input file (which must be an Armadillo "
+    "binary file) one block at a time in each iteration instead of loading "
+    "it.", "");
+PARAM_INT("block_size", "Number of points in each block for --out_of_core.",
+    "B", 100000);
+PARAM_FLAG("float", "Load the dataset and run k-means in single precision.",
+    "");
+PARAM_INT("threads", "Number of threads to use for the 'naive', 'elkan', "
+    "'hamerly', and 'yinyang' Lloyd iterations, and for k-means|| (0 uses as "
+    "many threads as OpenMP allows).",
+    "T", 1);
 
 // Given the type of initial partition policy, figure out the empty cluster
-// policy and run k-means.
+// policy and the matrix type and run k-means.
 template<typename InitialPartitionPolicy>
 void FindEmptyClusterPolicy(const InitialPartitionPolicy& ipp);
 
-// Given the initial partitionining policy and empty cluster policy, figure out
-// the Lloyd iteration step type and run k-means.
-template<typename InitialPartitionPolicy, typename EmptyClusterPolicy>
+// Given the initial partitionining policy, empty cluster policy, and matrix
+// type, figure out the Lloyd iteration step type and run k-means.
+template<typename InitialPartitionPolicy,
+         typename EmptyClusterPolicy,
+         typename MatType>
 void FindLloydStepType(const InitialPartitionPolicy& ipp);
 
+// Run k-means with one of the tree-based Lloyd steps, which need arma::mat.
+template<typename InitialPartitionPolicy,
+         typename EmptyClusterPolicy,
+         template<class, class> class LloydStepType,
+         typename MatType>
+typename std::enable_if<std::is_same<MatType, arma::mat>::value>::type
+RunTreeKMeans(const InitialPartitionPolicy& ipp);
+
+// For any other matrix type, the tree-based Lloyd steps are an error.
+template<typename InitialPartitionPolicy,
+         typename EmptyClusterPolicy,
+         template<class, class> class LloydStepType,
+         typename MatType>
+typename std::enable_if<!std::is_same<MatType, arma::mat>::value>::type
+RunTreeKMeans(const InitialPartitionPolicy& ipp);
+
 // Given the template parameters, sanitize/load input and run k-means.
 template<typename InitialPartitionPolicy,
          typename EmptyClusterPolicy,
-         template<class, class> class LloydStepType>
+         template<class, class> class LloydStepType,
+         typename MatType>
 void RunKMeans(const InitialPartitionPolicy& ipp);
 
+// Run mini-batch k-means, reading the input file one batch at a time.
+void RunStreamingKMeans();
+
+// Run k-means, reading the input file one block at a time in each iteration.
+void RunOutOfCoreKMeans();
+
 int main(int argc, char** argv)
 {
   CLI::ParseCommandLine(argc, argv);
@@ -105,9 +197,45 @@ int main(int argc, char** argv)
   else
     math::RandomSeed((size_t) std::time(NULL));
 
+  const int batchSize = CLI::GetParam<int>("batch_size");
+  if (batchSize <= 0)
+    Log::Fatal << "Invalid batch size (" << batchSize << ")!  Must be greater "
+        << "than 0." << endl;
+
+  if (CLI::HasParam("stream") && CLI::HasParam("out_of_core"))
+    Log::Fatal << "Only one of --stream and --out_of_core may be specified!"
+        << endl;
+
+  if (CLI::HasParam("float") &&
+      (CLI::HasParam("stream") || CLI::HasParam("out_of_core")))
+    Log::Fatal << "--float cannot be used with --stream or --out_of_core!"
+        << endl;
+
+  if (CLI::HasParam("stream"))
+  {
+    if (CLI::GetParam<string>("algorithm") != "minibatch")
+      Log::Fatal << "--stream can only be used with '--algorithm minibatch'."
+          << endl;
+
+    RunStreamingKMeans();
+    return 0;
+  }
+
+  if (CLI::HasParam("out_of_core"))
+  {
+    RunOutOfCoreKMeans();
+    return 0;
+  }
+
   // Now, start building the KMeans type that we'll be using.  Start with the
   // initial partition policy.  The call to FindEmptyClusterPolicy<> results in
   // a call to RunKMeans<> and the algorithm is completed.
+  if ((int) CLI::HasParam("refined_start") +
+      (int) CLI::HasParam("kmeans_plus_plus") +
+      (int) CLI::HasParam("kmeans_parallel") > 1)
+    Log::Fatal << "Only one of --refined_start, --kmeans_plus_plus, and "
+        << "--kmeans_parallel may be specified!" << endl;
+
   if (CLI::HasParam("refined_start"))
   {
     const int samplings = CLI::GetParam<int>("samplings");
@@ -122,6 +250,30 @@ int main(int argc, char** argv)
 
     FindEmptyClusterPolicy<RefinedStart>(RefinedStart(samplings, percentage));
   }
+  else if (CLI::HasParam("kmeans_plus_plus"))
+  {
+    FindEmptyClusterPolicy<KMeansPlusPlus>(KMeansPlusPlus());
+  }
+  else if (CLI::HasParam("kmeans_parallel"))
+  {
+    const double oversampling = CLI::GetParam<double>("oversampling");
+    const int rounds = CLI::GetParam<int>("rounds");
+    const int threads = CLI::GetParam<int>("threads");
+
+    if (oversampling < 0.0)
+      Log::Fatal << "Oversampling factor (" << oversampling << ") must be "
+          << "greater than or equal to 0!" << endl;
+    if (rounds < 0)
+      Log::Fatal << "Number of rounds (" << rounds << ") must be greater than "
+          << "or equal to 0!" << endl;
+    if (threads < 0)
+      Log::Fatal << "Invalid number of threads: " << threads << ".  Must be "
+          << "greater than or equal to 0." << endl;
+
+    KMeansParallel kmp(oversampling, (size_t) rounds);
+    kmp.NumThreads() = (size_t) threads;
+    FindEmptyClusterPolicy<KMeansParallel>(kmp);
+  }
   else
   {
     FindEmptyClusterPolicy<RandomPartition>(RandomPartition());
@@ -129,48 +281,101 @@ int main(int argc, char** argv)
 }
 
 // Given the type of initial partition policy, figure out the empty cluster
-// policy and run k-means.
+// policy and the matrix type and run k-means.
 template<typename InitialPartitionPolicy>
 void FindEmptyClusterPolicy(const InitialPartitionPolicy& ipp)
 {
   if (CLI::HasParam("allow_empty_clusters"))
-    FindLloydStepType<InitialPartitionPolicy, AllowEmptyClusters>(ipp);
+  {
+    if (CLI::HasParam("float"))
+      FindLloydStepType<InitialPartitionPolicy, AllowEmptyClusters,
+          arma::fmat>(ipp);
+    else
+      FindLloydStepType<InitialPartitionPolicy, AllowEmptyClusters,
+          arma::mat>(ipp);
+  }
   else
-    FindLloydStepType<InitialPartitionPolicy, MaxVarianceNewCluster>(ipp);
+  {
+    if (CLI::HasParam("float"))
+      FindLloydStepType<InitialPartitionPolicy, MaxVarianceNewCluster,
+          arma::fmat>(ipp);
+    else
+      FindLloydStepType<InitialPartitionPolicy, MaxVarianceNewCluster,
+          arma::mat>(ipp);
+  }
 }
 
-// Given the initial partitionining policy and empty cluster policy, figure out
-// the Lloyd iteration step type and run k-means.
-template<typename InitialPartitionPolicy, typename EmptyClusterPolicy>
+// Given the initial partitionining policy, empty cluster policy, and matrix
+// type, figure out the Lloyd iteration step type and run k-means.
+template<typename InitialPartitionPolicy,
+         typename EmptyClusterPolicy,
+         typename MatType>
 void FindLloydStepType(const InitialPartitionPolicy& ipp)
 {
   const string algorithm = CLI::GetParam<string>("algorithm");
   if (algorithm == "elkan")
-    RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy, ElkanKMeans>(ipp);
+    RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy, ElkanKMeans,
+        MatType>(ipp);
   else if (algorithm == "hamerly")
-    RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy, HamerlyKMeans>(ipp);
+    RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy, HamerlyKMeans,
+        MatType>(ipp);
   else if (algorithm == "pelleg-moore")
-    RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy,
-        PellegMooreKMeans>(ipp);
+    RunTreeKMeans<InitialPartitionPolicy, EmptyClusterPolicy,
+        PellegMooreKMeans, MatType>(ipp);
   else if (algorithm == "dualtree")
-    RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy,
-        DefaultDualTreeKMeans>(ipp);
+    RunTreeKMeans<InitialPartitionPolicy, EmptyClusterPolicy,
+        DefaultDualTreeKMeans, MatType>(ipp);
   else if (algorithm == "dualtree-covertree")
-    RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy,
-        CoverTreeDualTreeKMeans>(ipp);
+    RunTreeKMeans<InitialPartitionPolicy, EmptyClusterPolicy,
+        CoverTreeDualTreeKMeans, MatType>(ipp);
+  else if (algorithm == "yinyang")
+    RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy, YinyangKMeans,
+        MatType>(ipp);
+  else if (algorithm == "minibatch")
+    RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy, MiniBatchKMeans,
+        MatType>(ipp);
   else if (algorithm == "naive")
-    RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy, NaiveKMeans>(ipp);
+    RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy, NaiveKMeans,
+        MatType>(ipp);
   else
     Log::Fatal << "Unknown algorithm: '" << algorithm << "'.  Supported options"
-        << " are 'naive', 'pelleg-moore', 'elkan', and 'hamerly'." << endl;
+        << " are 'naive', 'pelleg-moore', 'elkan', 'hamerly', 'yinyang', and "
+        << "'minibatch'." << endl;
+}
+
+// Run k-means with one of the tree-based Lloyd steps, which need arma::mat.
+template<typename InitialPartitionPolicy,
+         typename EmptyClusterPolicy,
+         template<class, class> class LloydStepType,
+         typename MatType>
+typename std::enable_if<std::is_same<MatType, arma::mat>::value>::type
+RunTreeKMeans(const InitialPartitionPolicy& ipp)
+{
+  RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy, LloydStepType,
+      MatType>(ipp);
+}
+
+// For any other matrix type, the tree-based Lloyd steps are an error.
+template<typename InitialPartitionPolicy,
+         typename EmptyClusterPolicy,
+         template<class, class> class LloydStepType,
+         typename MatType>
+typename std::enable_if<!std::is_same<MatType, arma::mat>::value>::type
+RunTreeKMeans(const InitialPartitionPolicy& /* ipp */)
+{
+  Log::Fatal << "The '" << CLI::GetParam<string>("algorithm") << "' algorithm "
+      << "cannot be used with --float!" << endl;
 }
 
 // Given the template parameters, sanitize/load input and run k-means.
 template<typename InitialPartitionPolicy,
          typename EmptyClusterPolicy,
-         template<class, class> class LloydStepType>
+         template<class, class> class LloydStepType,
+         typename MatType>
 void RunKMeans(const InitialPartitionPolicy& ipp)
 {
+  typedef typename MatType::elem_type ElemType;
+
   // Now, do validation of input options.
   const string inputFile = CLI::GetParam<string>("inputFile");
   int clusters = CLI::GetParam<int>("clusters");
@@ -197,6 +402,13 @@ void RunKMeans(const InitialPartitionPolicy& ipp)
         ")! Must be greater than or equal to 0." << endl;
   }
 
+  const int threads = CLI::GetParam<int>("threads");
+  if (threads < 0)
+  {
+    Log::Fatal << "Invalid number of threads: " << threads << ".  Must be "
+        << "greater than or equal to 0." << endl;
+  }
+
   // Make sure we have an output file if we're not doing the work in-place.
   if (!CLI::HasParam("in_place") && !CLI::HasParam("output_file") &&
       !CLI::HasParam("centroid_file"))
@@ -206,10 +418,10 @@ void RunKMeans(const InitialPartitionPolicy& ipp)
   }
 
   // Load our dataset.
-  arma::mat dataset;
+  MatType dataset;
   data::Load(inputFile, dataset, true); // Fatal upon failure.
 
-  arma::mat centroids;
+  MatType centroids;
 
   const bool initialCentroidGuess = CLI::HasParam("initial_centroids");
   // Load initial centroids if the user asked for it.
@@ -220,9 +432,11 @@ void RunKMeans(const InitialPartitionPolicy& ipp)
     if (clusters == 0)
       clusters = centroids.n_cols;
 
-    if (CLI::HasParam("refined_start"))
+    if (CLI::HasParam("refined_start") || CLI::HasParam("kmeans_plus_plus") ||
+        CLI::HasParam("kmeans_parallel"))
       Log::Warn << "Initial centroids are specified, but will be ignored "
-          << "because --refined_start is also specified!" << endl;
+          << "because an initial partition strategy is also specified!"
+          << endl;
     else
       Log::Info << "Using initial centroid guesses from '" <<
           initialCentroidsFile << "'." << endl;
@@ -232,7 +446,19 @@ void RunKMeans(const InitialPartitionPolicy& ipp)
   KMeans<metric::EuclideanDistance,
          InitialPartitionPolicy,
          EmptyClusterPolicy,
-         LloydStepType> kmeans(maxIterations, metric::EuclideanDistance(), ipp);
+         LloydStepType,
+         MatType> kmeans(maxIterations, metric::EuclideanDistance(), ipp);
+  kmeans.NumThreads() = (size_t) threads;
+  kmeans.BatchSize() = (size_t) CLI::GetParam<int>("batch_size");
+
+  const int groups = CLI::GetParam<int>("groups");
+  if (groups < 0)
+  {
+    Log::Fatal << "Invalid number of groups (" << groups << ")!  Must be "
+        << "greater than or equal to 0." << endl;
+  }
+  kmeans.NumGroups() = (size_t) groups;
+  kmeans.ReuseCentroidTree() = CLI::HasParam("reuse_centroid_tree");
 
   if (CLI::HasParam("output_file") || CLI::HasParam("in_place"))
   {
@@ -246,10 +472,10 @@ void RunKMeans(const InitialPartitionPolicy& ipp)
     if (CLI::HasParam("in_place"))
     {
       // Add the column of assignments to the dataset; but we have to convert
-      // them to type double first.
-      arma::vec converted(assignments.n_elem);
+      // them to the element type of the dataset first.
+      arma::Col<ElemType> converted(assignments.n_elem);
       for (size_t i = 0; i < assignments.n_elem; i++)
-        converted(i) = (double) assignments(i);
+        converted(i) = (ElemType) assignments(i);
 
       dataset.insert_rows(dataset.n_rows, trans(converted));
 
@@ -267,10 +493,10 @@ void RunKMeans(const InitialPartitionPolicy& ipp)
       }
       else
       {
-        // Convert the assignments to doubles.
-        arma::vec converted(assignments.n_elem);
+        // Convert the assignments to the element type of the dataset.
+        arma::Col<ElemType> converted(assignments.n_elem);
         for (size_t i = 0; i < assignments.n_elem; i++)
-          converted(i) = (double) assignments(i);
+          converted(i) = (ElemType) assignments(i);
 
         dataset.insert_rows(dataset.n_rows, trans(converted));
 
@@ -291,3 +517,134 @@ void RunKMeans(const InitialPartitionPolicy& ipp)
   if (CLI::HasParam("centroid_file"))
     data::Save(CLI::GetParam<std::string>("centroid_file"), centroids);
 }
+
+// Run mini-batch k-means, reading the input file one batch at a time.
+void RunStreamingKMeans()
+{
+  const string inputFile = CLI::GetParam<string>("inputFile");
+  int clusters = CLI::GetParam<int>("clusters");
+  if (clusters < 0)
+  {
+    Log::Fatal << "Invalid number of clusters requested (" << clusters << ")! "
+        << "Must be greater than or equal to 0." << endl;
+  }
+  else if (clusters == 0 && !CLI::HasParam("initial_centroids"))
+  {
+    Log::Fatal << "Number of clusters requested is 0, and no initial centroids "
+        << "provided!" << endl;
+  }
+
+  const int maxIterations = CLI::GetParam<int>("max_iterations");
+  if (maxIterations < 0)
+  {
+    Log::Fatal << "Invalid value for maximum iterations (" << maxIterations <<
+        ")! Must be greater than or equal to 0." << endl;
+  }
+
+  // The whole dataset is never in memory, so we can't label it.
+  if (CLI::HasParam("in_place") || CLI::HasParam("output_file"))
+    Log::Fatal << "--in_place and --output_file cannot be used with --stream; "
+        << "only --centroid_file can be saved." << endl;
+  if (!CLI::HasParam("centroid_file"))
+    Log::Warn << "--centroid_file is not set; no results will be saved."
+        << endl;
+  if (CLI::HasParam("refined_start") || CLI::HasParam("kmeans_plus_plus") ||
+      CLI::HasParam("kmeans_parallel"))
+    Log::Warn << "The initial partition strategy is ignored with --stream."
+        << endl;
+
+  arma::mat centroids;
+  const bool initialCentroidGuess = CLI::HasParam("initial_centroids");
+  if (initialCentroidGuess)
+  {
+    data::Load(CLI::GetParam<string>("initial_centroids"), centroids, true);
+    if (clusters == 0)
+      clusters = centroids.n_cols;
+  }
+
+  Timer::Start("clustering");
+  StreamingMiniBatchKMeans<> kmeans(inputFile,
+      (size_t) CLI::GetParam<int>("batch_size"), (size_t) maxIterations);
+  kmeans.Cluster((size_t) clusters, centroids, initialCentroidGuess);
+  Timer::Stop("clustering");
+
+  if (CLI::HasParam("centroid_file"))
+    data::Save(CLI::GetParam<std::string>("centroid_file"), centroids);
+}
+
+void RunOutOfCoreKMeans()
+{
+  const string inputFile = CLI::GetParam<string>("inputFile");
+  if (data::Extension(inputFile) != "bin")
+    Log::Fatal << "--out_of_core needs an Armadillo binary input file (with "
+        << "the '.bin' extension)." << endl;
+
+  int clusters = CLI::GetParam<int>("clusters");
+  if (clusters < 0)
+  {
+    Log::Fatal << "Invalid number of clusters requested (" << clusters << ")! "
+        << "Must be greater than or equal to 0." << endl;
+  }
+  else if (clusters == 0 && !CLI::HasParam("initial_centroids"))
+  {
+    Log::Fatal << "Number of clusters requested is 0, and no initial centroids "
+        << "provided!" << endl;
+  }
+
+  const int maxIterations = CLI::GetParam<int>("max_iterations");
+  if (maxIterations < 0)
+  {
+    Log::Fatal << "Invalid value for maximum iterations (" << maxIterations <<
+        ")! Must be greater than or equal to 0." << endl;
+  }
+
+  const int blockSize = CLI::GetParam<int>("block_size");
+  if (blockSize <= 0)
+    Log::Fatal << "Invalid block size (" << blockSize << ")!  Must be greater "
+        << "than 0." << endl;
+
+  const int threads = CLI::GetParam<int>("threads");
+  if (threads < 0)
+    Log::Fatal << "Invalid number of threads: " << threads << ".  Must be "
+        << "greater than or equal to 0." << endl;
+
+  // The whole dataset is never in memory, so we can't add the labels to it.
+  if (CLI::HasParam("in_place"))
+    Log::Fatal << "--in_place cannot be used with --out_of_core." << endl;
+  if (!CLI::HasParam("output_file") && !CLI::HasParam("centroid_file"))
+    Log::Warn << "--output_file and --centroid_file are not set; no results "
+        << "will be saved." << endl;
+  if (CLI::HasParam("output_file") && !CLI::HasParam("labels_only"))
+    Log::Warn << "With --out_of_core, --output_file holds only the labels."
+        << endl;
+  if (CLI::HasParam("refined_start") || CLI::HasParam("kmeans_plus_plus") ||
+      CLI::HasParam("kmeans_parallel"))
+    Log::Warn << "The initial partition strategy is ignored with "
+        << "--out_of_core." << endl;
+  if (CLI::GetParam<string>("algorithm") != "naive")
+    Log::Warn << "--algorithm is ignored with --out_of_core; the naive "
+        << "algorithm is used." << endl;
+
+  arma::mat centroids;
+  const bool initialCentroidGuess = CLI::HasParam("initial_centroids");
+  if (initialCentroidGuess)
+  {
+    data::Load(CLI::GetParam<string>("initial_centroids"), centroids, true);
+    if (clusters == 0)
+      clusters = centroids.n_cols;
+  }
+
+  const string outputFile = CLI::HasParam("output_file") ?
+      CLI::GetParam<string>("output_file") : "";
+
+  Timer::Start("clustering");
+  OutOfCoreKMeans<> kmeans(inputFile, (size_t) blockSize,
+      (size_t) maxIterations);
+  kmeans.NumThreads() = (size_t) threads;
+  kmeans.Cluster((size_t) clusters, centroids, initialCentroidGuess,
+      outputFile);
+  Timer::Stop("clustering");
+
+  if (CLI::HasParam("centroid_file"))
+    data::Save(CLI::GetParam<std::string>("centroid_file"), centroids);
+}
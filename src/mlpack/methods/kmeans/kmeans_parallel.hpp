@@ -0,0 +1,135 @@
+/**
+ * @file kmeans_parallel.hpp
+ *
+ * An implementation of the k-means|| (scalable k-means++) seeding strategy of
+ * Bahmani et al.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_KMEANS_PARALLEL_HPP
+#define __MLPACK_METHODS_KMEANS_KMEANS_PARALLEL_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * The k-means|| initial partitioning policy.  Instead of choosing one center
+ * per pass over the data as k-means++ does, each of a small number of rounds
+ * samples every point independently with probability proportional to its
+ * squared distance to the closest candidate so far, with an oversampling
+ * factor l; after r rounds, about l * r candidates have been chosen.  Each
+ * candidate is weighted by the number of points closest to it, and the
+ * weighted candidates are clustered into k centers with k-means++ followed by
+ * a few weighted Lloyd iterations.  Finally, each point is assigned to its
+ * closest center.  This is an implementation of the following paper:
+ *
+ * @code
+ * @article{bahmani2012scalable,
+ *   title={Scalable k-means++},
+ *   author={Bahmani, Bahman and Moseley, Benjamin and Vattani, Andrea and
+ *       Kumar, Ravi and Vassilvitskii, Sergei},
+ *   journal={Proceedings of the VLDB Endowment},
+ *   volume={5},
+ *   number={7},
+ *   pages={622--633},
+ *   year={2012}
+ * }
+ * @endcode
+ *
+ * The passes over the dataset are parallelized with OpenMP.  The random
+ * choices are made by a single thread, so for a given random seed the result
+ * does not depend on the number of threads.
+ */
+class KMeansParallel
+{
+ public:
+  /**
+   * Create the KMeansParallel object, optionally specifying the oversampling
+   * factor and the number of rounds.
+   *
+   * @param oversampling Expected number of candidates chosen in each round (0
+   *     means twice the number of clusters).
+   * @param rounds Number of sampling rounds.
+   */
+  KMeansParallel(const double oversampling = 0.0,
+                 const size_t rounds = 5) :
+      oversampling(oversampling), rounds(rounds), numThreads(1) { }
+
+  /**
+   * Partition the given dataset into the given number of clusters with the
+   * k-means|| seeding.
+   *
+   * @tparam MatType Type of data (arma::mat or arma::sp_mat).
+   * @param data Dataset to partition.
+   * @param clusters Number of clusters to split dataset into.
+   * @param assignments Vector to store cluster assignments into.  Values will
+   *     be between 0 and (clusters - 1).
+   */
+  template<typename MatType>
+  void Cluster(const MatType& data,
+               const size_t clusters,
+               arma::Col<size_t>& assignments) const;
+
+  //! Get the oversampling factor (0 means twice the number of clusters).
+  double Oversampling() const { return oversampling; }
+  //! Modify the oversampling factor (0 means twice the number of clusters).
+  double& Oversampling() { return oversampling; }
+
+  //! Get the number of sampling rounds.
+  size_t Rounds() const { return rounds; }
+  //! Modify the number of sampling rounds.
+  size_t& Rounds() { return rounds; }
+
+  //! Get the number of threads.
+  size_t NumThreads() const { return numThreads; }
+  //! Modify the number of threads (0 means as many as OpenMP allows).
+  size_t& NumThreads() { return numThreads; }
+
+  //! Serialize the object.
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */)
+  {
+    ar & data::CreateNVP(oversampling, "oversampling");
+    ar & data::CreateNVP(rounds, "rounds");
+  }
+
+ private:
+  //! The oversampling factor.
+  double oversampling;
+  //! The number of sampling rounds.
+  size_t rounds;
+  //! The number of threads to use.
+  size_t numThreads;
+
+  /**
+   * For each point, find the closest of the given candidates, updating the
+   * squared distances and indices of the closest candidates so far.
+   */
+  template<typename MatType>
+  void UpdateClosest(const MatType& data,
+                     const arma::Mat<typename MatType::elem_type>& candidates,
+                     const size_t firstCandidate,
+                     arma::vec& distances,
+                     arma::Col<size_t>& closest) const;
+
+  /**
+   * Cluster the weighted candidates into the given number of centers with
+   * k-means++ followed by weighted Lloyd iterations.
+   */
+  template<typename eT>
+  void ReclusterCandidates(const arma::Mat<eT>& candidates,
+                           const arma::vec& weights,
+                           const size_t clusters,
+                           arma::Mat<eT>& centers) const;
+
+  //! Get the number of threads that will actually be used.
+  size_t ThreadsToUse() const;
+};
+
+} // namespace kmeans
+} // namespace mlpack
+
+// Include implementation.
+#include "kmeans_parallel_impl.hpp"
+
+#endif
@@ -0,0 +1,234 @@
+/**
+ * @file kmeans_parallel_impl.hpp
+ *
+ * Implementation of the k-means|| seeding strategy.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_KMEANS_PARALLEL_IMPL_HPP
+#define __MLPACK_METHODS_KMEANS_KMEANS_PARALLEL_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "kmeans_parallel.hpp"
+
+#include <mlpack/core/metrics/lmetric.hpp>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+namespace mlpack {
+namespace kmeans {
+
+template<typename MatType>
+void KMeansParallel::Cluster(const MatType& data,
+                             const size_t clusters,
+                             arma::Col<size_t>& assignments) const
+{
+  if (clusters == 0 || data.n_cols == 0)
+  {
+    assignments.zeros(data.n_cols);
+    return;
+  }
+
+  typedef typename MatType::elem_type ElemType;
+  const double l = (oversampling > 0.0) ? oversampling : 2.0 * clusters;
+
+  // The first candidate is chosen uniformly at random.
+  arma::Mat<ElemType> candidates(data.n_rows, 1);
+  candidates.col(0) = arma::Col<ElemType>(data.col(
+      math::RandInt(data.n_cols)));
+
+  arma::vec distances(data.n_cols);
+  distances.fill(DBL_MAX);
+  arma::Col<size_t> closest(data.n_cols);
+  UpdateClosest(data, candidates, 0, distances, closest);
+
+  for (size_t r = 0; r < rounds; ++r)
+  {
+    const double total = arma::accu(distances);
+    if (total == 0.0)
+      break; // Every point is a candidate already.
+
+    // Sample each point independently.
+    std::vector<size_t> sampled;
+    for (size_t i = 0; i < data.n_cols; ++i)
+      if (math::Random() < l * distances[i] / total)
+        sampled.push_back(i);
+
+    const size_t first = candidates.n_cols;
+    candidates.resize(data.n_rows, first + sampled.size());
+    for (size_t i = 0; i < sampled.size(); ++i)
+      candidates.col(first + i) = arma::Col<ElemType>(data.col(sampled[i]));
+
+    UpdateClosest(data, candidates, first, distances, closest);
+
+    Log::Info << "KMeansParallel::Cluster(): round " << (r + 1) << ", "
+        << candidates.n_cols << " candidates." << std::endl;
+  }
+
+  // If there are too few candidates, add more with k-means++ sampling.
+  while (candidates.n_cols < clusters)
+  {
+    const double total = arma::accu(distances);
+    size_t chosen = math::RandInt(data.n_cols);
+    if (total > 0.0)
+    {
+      double target = math::Random(0.0, total);
+      for (size_t i = 0; i < data.n_cols; ++i)
+      {
+        if (distances[i] == 0.0)
+          continue;
+
+        chosen = i;
+        target -= distances[i];
+        if (target <= 0.0)
+          break;
+      }
+    }
+
+    const size_t first = candidates.n_cols;
+    candidates.resize(data.n_rows, first + 1);
+    candidates.col(first) = arma::Col<ElemType>(data.col(chosen));
+    UpdateClosest(data, candidates, first, distances, closest);
+  }
+
+  // Weight each candidate by the number of points closest to it, and cluster
+  // the candidates.
+  arma::vec weights(candidates.n_cols, arma::fill::zeros);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    weights[closest[i]] += 1.0;
+
+  arma::Mat<ElemType> centers;
+  ReclusterCandidates(candidates, weights, clusters, centers);
+
+  // Assign each point to its closest center.
+  distances.fill(DBL_MAX);
+  UpdateClosest(data, centers, 0, distances, assignments);
+}
+
+template<typename MatType>
+void KMeansParallel::UpdateClosest(
+    const MatType& data,
+    const arma::Mat<typename MatType::elem_type>& candidates,
+    const size_t firstCandidate,
+    arma::vec& distances,
+    arma::Col<size_t>& closest) const
+{
+  if (closest.n_elem != data.n_cols)
+    closest.zeros(data.n_cols);
+
+  const size_t threads = ThreadsToUse();
+  #pragma omp parallel for num_threads(threads) schedule(static)
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    for (size_t c = firstCandidate; c < candidates.n_cols; ++c)
+    {
+      const double distance = metric::SquaredEuclideanDistance::Evaluate(
+          data.col(i), candidates.col(c));
+      if (distance < distances[i])
+      {
+        distances[i] = distance;
+        closest[i] = c;
+      }
+    }
+  }
+}
+
+template<typename eT>
+void KMeansParallel::ReclusterCandidates(const arma::Mat<eT>& candidates,
+                                         const arma::vec& weights,
+                                         const size_t clusters,
+                                         arma::Mat<eT>& centers) const
+{
+  // Weighted k-means++ seeding.
+  centers.set_size(candidates.n_rows, clusters);
+  arma::vec distances(candidates.n_cols);
+  distances.fill(DBL_MAX);
+  size_t chosen = math::RandInt(candidates.n_cols);
+  for (size_t c = 0; c < clusters; ++c)
+  {
+    if (c > 0)
+    {
+      const double total = arma::dot(weights, distances);
+      chosen = math::RandInt(candidates.n_cols);
+      if (total > 0.0)
+      {
+        double target = math::Random(0.0, total);
+        for (size_t i = 0; i < candidates.n_cols; ++i)
+        {
+          if (weights[i] * distances[i] == 0.0)
+            continue;
+
+          chosen = i;
+          target -= weights[i] * distances[i];
+          if (target <= 0.0)
+            break;
+        }
+      }
+    }
+
+    centers.col(c) = candidates.col(chosen);
+    for (size_t i = 0; i < candidates.n_cols; ++i)
+      distances[i] = std::min(distances[i],
+          metric::SquaredEuclideanDistance::Evaluate(candidates.col(i),
+          centers.col(c)));
+  }
+
+  // A few weighted Lloyd iterations on the candidates.
+  arma::Col<size_t> owners(candidates.n_cols);
+  for (size_t iteration = 0; iteration < 10; ++iteration)
+  {
+    bool changed = false;
+    for (size_t i = 0; i < candidates.n_cols; ++i)
+    {
+      double minDistance = DBL_MAX;
+      size_t owner = 0;
+      for (size_t c = 0; c < clusters; ++c)
+      {
+        const double distance = metric::SquaredEuclideanDistance::Evaluate(
+            candidates.col(i), centers.col(c));
+        if (distance < minDistance)
+        {
+          minDistance = distance;
+          owner = c;
+        }
+      }
+
+      if (iteration == 0 || owners[i] != owner)
+        changed = true;
+      owners[i] = owner;
+    }
+
+    if (!changed)
+      break;
+
+    arma::Mat<eT> sums(candidates.n_rows, clusters, arma::fill::zeros);
+    arma::vec totals(clusters, arma::fill::zeros);
+    for (size_t i = 0; i < candidates.n_cols; ++i)
+    {
+      sums.col(owners[i]) += weights[i] * candidates.col(i);
+      totals[owners[i]] += weights[i];
+    }
+
+    // A center that owns nothing stays where it is.
+    for (size_t c = 0; c < clusters; ++c)
+      if (totals[c] > 0.0)
+        centers.col(c) = sums.col(c) / totals[c];
+  }
+}
+
+inline size_t KMeansParallel::ThreadsToUse() const
+{
+  if (numThreads != 0)
+    return numThreads;
+
+#ifdef _OPENMP
+  return (size_t) omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+} // namespace kmeans
+} // namespace mlpack
+
+#endif
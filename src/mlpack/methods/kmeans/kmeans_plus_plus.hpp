@@ -0,0 +1,72 @@
+/**
+ * @file kmeans_plus_plus.hpp
+ *
+ * An implementation of the k-means++ seeding strategy of Arthur and
+ * Vassilvitskii, which chooses initial centroids that are likely to be far
+ * apart.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_KMEANS_PLUS_PLUS_HPP
+#define __MLPACK_METHODS_KMEANS_KMEANS_PLUS_PLUS_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * The k-means++ initial partitioning policy.  The first center is a point of
+ * the dataset chosen uniformly at random; each following center is a point of
+ * the dataset chosen with probability proportional to its squared distance to
+ * the closest center chosen so far.  The expected cost of the resulting
+ * clustering is O(log k) times the optimal cost.  Each point is then assigned
+ * to its closest center.  This is an implementation of the following paper:
+ *
+ * @code
+ * @inproceedings{arthur2007kmeans,
+ *   title={k-means++: The advantages of careful seeding},
+ *   author={Arthur, David and Vassilvitskii, Sergei},
+ *   booktitle={Proceedings of the Eighteenth Annual ACM-SIAM Symposium on
+ *       Discrete Algorithms (SODA '07)},
+ *   pages={1027--1035},
+ *   year={2007}
+ * }
+ * @endcode
+ *
+ * The seeding takes O(nk) distance calculations and k passes over the
+ * dataset; for large k, KMeansParallel needs far fewer passes.
+ */
+class KMeansPlusPlus
+{
+ public:
+  //! Empty constructor, required by the InitialPartitionPolicy policy.
+  KMeansPlusPlus() { }
+
+  /**
+   * Partition the given dataset into the given number of clusters with the
+   * k-means++ seeding.
+   *
+   * @tparam MatType Type of data (arma::mat or arma::sp_mat).
+   * @param data Dataset to partition.
+   * @param clusters Number of clusters to split dataset into.
+   * @param assignments Vector to store cluster assignments into.  Values will
+   *     be between 0 and (clusters - 1).
+   * @param rng Random number generator to draw the centers with.
+   */
+  template<typename MatType>
+  void Cluster(const MatType& data,
+               const size_t clusters,
+               arma::Col<size_t>& assignments,
+               std::mt19937& rng = math::randGen) const;
+
+  //! Serialize the partitioner (nothing to do).
+  template<typename Archive>
+  void Serialize(Archive& /* ar */, const unsigned int /* version */) { }
+};
+
+} // namespace kmeans
+} // namespace mlpack
+
+// Include implementation.
+#include "kmeans_plus_plus_impl.hpp"
+
+#endif
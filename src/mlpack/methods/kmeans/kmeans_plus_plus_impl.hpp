@@ -0,0 +1,87 @@
+/**
+ * @file kmeans_plus_plus_impl.hpp
+ *
+ * Implementation of the k-means++ seeding strategy.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_KMEANS_PLUS_PLUS_IMPL_HPP
+#define __MLPACK_METHODS_KMEANS_KMEANS_PLUS_PLUS_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "kmeans_plus_plus.hpp"
+
+#include <mlpack/core/metrics/lmetric.hpp>
+
+namespace mlpack {
+namespace kmeans {
+
+template<typename MatType>
+void KMeansPlusPlus::Cluster(const MatType& data,
+                             const size_t clusters,
+                             arma::Col<size_t>& assignments,
+                             std::mt19937& rng) const
+{
+  if (clusters == 0 || data.n_cols == 0)
+  {
+    assignments.zeros(data.n_cols);
+    return;
+  }
+
+  typedef typename MatType::elem_type ElemType;
+  std::uniform_real_distribution<double> uniform;
+
+  // The first center is chosen uniformly at random.
+  arma::Mat<ElemType> centers(data.n_rows, clusters);
+  centers.col(0) = arma::Col<ElemType>(data.col(
+      (size_t) std::floor(data.n_cols * uniform(rng))));
+
+  // The squared distance from each point to its closest center.
+  arma::vec distances(data.n_cols);
+  assignments.zeros(data.n_cols);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    distances[i] = metric::SquaredEuclideanDistance::Evaluate(data.col(i),
+        centers.col(0));
+
+  for (size_t c = 1; c < clusters; ++c)
+  {
+    // Choose the next center with probability proportional to the squared
+    // distance.  If all the points are on top of the centers, any point will
+    // do.
+    const double total = arma::accu(distances);
+    size_t chosen = (size_t) std::floor(data.n_cols * uniform(rng));
+    if (total > 0.0)
+    {
+      // If roundoff keeps the target from reaching zero, the last point with
+      // nonzero distance is taken.
+      double target = total * uniform(rng);
+      for (size_t i = 0; i < data.n_cols; ++i)
+      {
+        if (distances[i] == 0.0)
+          continue;
+
+        chosen = i;
+        target -= distances[i];
+        if (target <= 0.0)
+          break;
+      }
+    }
+
+    centers.col(c) = arma::Col<ElemType>(data.col(chosen));
+
+    // Update the closest centers.
+    for (size_t i = 0; i < data.n_cols; ++i)
+    {
+      const double distance = metric::SquaredEuclideanDistance::Evaluate(
+          data.col(i), centers.col(c));
+      if (distance < distances[i])
+      {
+        distances[i] = distance;
+        assignments[i] = c;
+      }
+    }
+  }
+}
+
+} // namespace kmeans
+} // namespace mlpack
+
+#endif
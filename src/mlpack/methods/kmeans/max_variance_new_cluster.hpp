@@ -28,7 +28,8 @@ class MaxVarianceNewCluster
    * Take the point furthest from the centroid of the cluster with maximum
    * variance to be a new cluster.
    *
-   * @tparam MatType Type of data (arma::mat or arma::sp_mat).
+   * @tparam MatType Type of data (arma::mat, arma::fmat, or arma::sp_mat).  The
+   *      centroids are dense matrices with the same element type.
    * @param data Dataset on which clustering is being performed.
    * @param emptyCluster Index of cluster which is empty.
    * @param oldCentroids Centroids of each cluster (one per column), at the
@@ -41,13 +42,14 @@ class MaxVarianceNewCluster
    * @return Number of points changed.
    */
   template<typename MetricType, typename MatType>
-  size_t EmptyCluster(const MatType& data,
-                      const size_t emptyCluster,
-                      const arma::mat& oldCentroids,
-                      arma::mat& newCentroids,
-                      arma::Col<size_t>& clusterCounts,
-                      MetricType& metric,
-                      const size_t iteration);
+  size_t EmptyCluster(
+      const MatType& data,
+      const size_t emptyCluster,
+      const arma::Mat<typename MatType::elem_type>& oldCentroids,
+      arma::Mat<typename MatType::elem_type>& newCentroids,
+      arma::Col<size_t>& clusterCounts,
+      MetricType& metric,
+      const size_t iteration);
 
   //! Serialize the object.
   template<typename Archive>
@@ -63,10 +65,11 @@ class MaxVarianceNewCluster
 
   //! Called when we are on a new iteration.
   template<typename MetricType, typename MatType>
-  void Precalculate(const MatType& data,
-                    const arma::mat& oldCentroids,
-                    arma::Col<size_t>& clusterCounts,
-                    MetricType& metric);
+  void Precalculate(
+      const MatType& data,
+      const arma::Mat<typename MatType::elem_type>& oldCentroids,
+      arma::Col<size_t>& clusterCounts,
+      MetricType& metric);
 };
 
 } // namespace kmeans
@@ -17,14 +17,17 @@ namespace kmeans {
  * Take action about an empty cluster.
  */
 template<typename MetricType, typename MatType>
-size_t MaxVarianceNewCluster::EmptyCluster(const MatType& data,
-                                           const size_t emptyCluster,
-                                           const arma::mat& oldCentroids,
-                                           arma::mat& newCentroids,
-                                           arma::Col<size_t>& clusterCounts,
-                                           MetricType& metric,
-                                           const size_t iteration)
+size_t MaxVarianceNewCluster::EmptyCluster(
+    const MatType& data,
+    const size_t emptyCluster,
+    const arma::Mat<typename MatType::elem_type>& oldCentroids,
+    arma::Mat<typename MatType::elem_type>& newCentroids,
+    arma::Col<size_t>& clusterCounts,
+    MetricType& metric,
+    const size_t iteration)
 {
+  typedef typename MatType::elem_type ElemType;
+
   // If necessary, calculate the variances and assignments.
   if (iteration != this->iteration || assignments.n_elem != data.n_cols)
     Precalculate(data, oldCentroids, clusterCounts, metric);
@@ -55,11 +58,13 @@ size_t MaxVarianceNewCluster::EmptyCluster(const MatType& data,
   // Take that point and add it to the empty cluster.
   newCentroids.col(maxVarCluster) *= (double(clusterCounts[maxVarCluster]) /
       double(clusterCounts[maxVarCluster] - 1));
-  newCentroids.col(maxVarCluster) -= (1.0 / (clusterCounts[maxVarCluster] - 1.0)) *
-      arma::vec(data.col(furthestPoint));
+  newCentroids.col(maxVarCluster) -= (1.0 /
+      (clusterCounts[maxVarCluster] - 1.0)) *
+      arma::Col<ElemType>(data.col(furthestPoint));
   clusterCounts[maxVarCluster]--;
   clusterCounts[emptyCluster]++;
-  newCentroids.col(emptyCluster) = arma::vec(data.col(furthestPoint));
+  newCentroids.col(emptyCluster) = arma::Col<ElemType>(
+      data.col(furthestPoint));
   assignments[furthestPoint] = emptyCluster;
 
   // Modify the variances, as necessary.
@@ -91,10 +96,11 @@ void MaxVarianceNewCluster::Serialize(Archive& /* ar */,
 }
 
 template<typename MetricType, typename MatType>
-void MaxVarianceNewCluster::Precalculate(const MatType& data,
-                                         const arma::mat& oldCentroids,
-                                         arma::Col<size_t>& clusterCounts,
-                                         MetricType& metric)
+void MaxVarianceNewCluster::Precalculate(
+    const MatType& data,
+    const arma::Mat<typename MatType::elem_type>& oldCentroids,
+    arma::Col<size_t>& clusterCounts,
+    MetricType& metric)
 {
   // We have to calculate the variances of each cluster and the assignments of
   // each point.  This is most easily done by iterating through the entire
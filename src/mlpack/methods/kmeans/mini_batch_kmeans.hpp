@@ -0,0 +1,115 @@
+/**
+ * @file mini_batch_kmeans.hpp
+ *
+ * An implementation of mini-batch k-means (Sculley, 2010), where each Lloyd
+ * iteration only looks at a small random sample of the dataset.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_MINI_BATCH_KMEANS_HPP
+#define __MLPACK_METHODS_KMEANS_MINI_BATCH_KMEANS_HPP
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * An implementation of a single step of mini-batch k-means, from the following
+ * paper:
+ *
+ * @code
+ * @inproceedings{sculley2010web,
+ *   title={Web-scale k-means clustering},
+ *   author={Sculley, D.},
+ *   booktitle={Proceedings of the 19th International Conference on World Wide
+ *       Web (WWW '10)},
+ *   pages={1177--1178},
+ *   year={2010}
+ * }
+ * @endcode
+ *
+ * Each call to Iterate() samples BatchSize() points from the dataset (with
+ * replacement), assigns each of them to its nearest centroid, and then moves
+ * each centroid towards each of its assigned points with a per-centroid
+ * learning rate of 1 / (number of points the centroid has been assigned so
+ * far).  Each iteration is therefore O(bk) instead of O(nk), but many more
+ * iterations are needed than for the exact Lloyd steps, and the centroids do
+ * not converge to a fixed point; the number of iterations is usually limited
+ * with KMeans::MaxIterations().
+ *
+ * The counts returned by Iterate() are the total number of points assigned to
+ * each centroid over all iterations so far, so a cluster is only reported as
+ * empty if it has never been assigned any point.
+ *
+ * @tparam MetricType Type of metric used with this implementation.
+ * @tparam MatType Matrix type (arma::mat or arma::sp_mat).
+ */
+template<typename MetricType, typename MatType>
+class MiniBatchKMeans
+{
+ public:
+  //! The type of the elements of the dataset and of the centroids.
+  typedef typename MatType::elem_type ElemType;
+
+  /**
+   * Construct the MiniBatchKMeans object with the given dataset and metric.
+   *
+   * @param dataset Dataset.
+   * @param metric Instantiated metric.
+   */
+  MiniBatchKMeans(const MatType& dataset, MetricType& metric);
+
+  /**
+   * Run a single iteration of mini-batch k-means, updating the given centroids
+   * into the newCentroids matrix.
+   *
+   * @param centroids Current cluster centroids.
+   * @param newCentroids New cluster centroids.
+   * @param counts Total number of points assigned to each centroid so far.
+   */
+  double Iterate(const arma::Mat<ElemType>& centroids,
+                 arma::Mat<ElemType>& newCentroids,
+                 arma::Col<size_t>& counts);
+
+  /**
+   * Update the centroids in place with the given batch of points, using and
+   * updating the number of points assigned to each centroid so far.  This is
+   * the update used by Iterate(), and it may also be used with batches that are
+   * read from disk.  The number of distance calculations is returned.
+   *
+   * @param batch Batch of points.
+   * @param centroids Centroids to update.
+   * @param centerCounts Number of points assigned to each centroid so far.
+   * @param metric Instantiated metric.
+   */
+  static size_t BatchUpdate(const arma::Mat<ElemType>& batch,
+                            arma::Mat<ElemType>& centroids,
+                            arma::Col<size_t>& centerCounts,
+                            MetricType& metric);
+
+  size_t DistanceCalculations() const { return distanceCalculations; }
+
+  //! Get the number of points sampled in each iteration.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the number of points sampled in each iteration.
+  size_t& BatchSize() { return batchSize; }
+
+ private:
+  //! The dataset.
+  const MatType& dataset;
+  //! The instantiated metric.
+  MetricType& metric;
+
+  //! The number of points sampled in each iteration.
+  size_t batchSize;
+  //! The number of points assigned to each centroid so far.
+  arma::Col<size_t> centerCounts;
+
+  //! Number of distance calculations.
+  size_t distanceCalculations;
+};
+
+} // namespace kmeans
+} // namespace mlpack
+
+// Include implementation.
+#include "mini_batch_kmeans_impl.hpp"
+
+#endif
@@ -0,0 +1,108 @@
+/**
+ * @file mini_batch_kmeans_impl.hpp
+ *
+ * Implementation of the mini-batch k-means Lloyd step.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_MINI_BATCH_KMEANS_IMPL_HPP
+#define __MLPACK_METHODS_KMEANS_MINI_BATCH_KMEANS_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "mini_batch_kmeans.hpp"
+
+namespace mlpack {
+namespace kmeans {
+
+template<typename MetricType, typename MatType>
+MiniBatchKMeans<MetricType, MatType>::MiniBatchKMeans(const MatType& dataset,
+                                                      MetricType& metric) :
+    dataset(dataset),
+    metric(metric),
+    batchSize(1000),
+    distanceCalculations(0)
+{ /* Nothing to do. */ }
+
+// Run a single iteration.
+template<typename MetricType, typename MatType>
+double MiniBatchKMeans<MetricType, MatType>::Iterate(
+    const arma::Mat<ElemType>& centroids,
+    arma::Mat<ElemType>& newCentroids,
+    arma::Col<size_t>& counts)
+{
+  if (batchSize == 0)
+    throw std::invalid_argument("MiniBatchKMeans::Iterate(): batch size must "
+        "be greater than 0");
+
+  // If this is the first iteration, no point has been assigned yet.
+  if (centerCounts.n_elem != centroids.n_cols)
+    centerCounts.zeros(centroids.n_cols);
+
+  // Sample the batch.
+  arma::Mat<ElemType> batch(dataset.n_rows, batchSize);
+  for (size_t i = 0; i < batchSize; ++i)
+    batch.col(i) = arma::Col<ElemType>(dataset.col(
+        math::RandInt(dataset.n_cols)));
+
+  newCentroids = centroids;
+  distanceCalculations += BatchUpdate(batch, newCentroids, centerCounts,
+      metric);
+  counts = centerCounts;
+
+  // Calculate cluster movement for this iteration.
+  double cNorm = 0.0;
+  for (size_t i = 0; i < centroids.n_cols; ++i)
+  {
+    cNorm += std::pow(metric.Evaluate(centroids.col(i), newCentroids.col(i)),
+        2.0);
+  }
+  distanceCalculations += centroids.n_cols;
+
+  return std::sqrt(cNorm);
+}
+
+template<typename MetricType, typename MatType>
+size_t MiniBatchKMeans<MetricType, MatType>::BatchUpdate(
+    const arma::Mat<ElemType>& batch,
+    arma::Mat<ElemType>& centroids,
+    arma::Col<size_t>& centerCounts,
+    MetricType& metric)
+{
+  // Find the closest centroid to each point of the batch, with the centroids as
+  // they were at the start of the batch.
+  arma::Col<size_t> closest(batch.n_cols);
+  for (size_t i = 0; i < batch.n_cols; ++i)
+  {
+    double minDistance = std::numeric_limits<double>::infinity();
+    size_t closestCluster = centroids.n_cols; // Invalid value.
+
+    for (size_t j = 0; j < centroids.n_cols; ++j)
+    {
+      const double distance = metric.Evaluate(batch.col(i), centroids.col(j));
+
+      if (distance < minDistance)
+      {
+        minDistance = distance;
+        closestCluster = j;
+      }
+    }
+
+    Log::Assert(closestCluster != centroids.n_cols);
+    closest[i] = closestCluster;
+  }
+
+  // Now take a gradient step towards each point, with a learning rate of one
+  // over the number of points assigned to the centroid so far.
+  for (size_t i = 0; i < batch.n_cols; ++i)
+  {
+    const size_t c = closest[i];
+    ++centerCounts[c];
+    const double eta = 1.0 / double(centerCounts[c]);
+    centroids.col(c) = (1.0 - eta) * centroids.col(c) + eta * batch.col(i);
+  }
+
+  return batch.n_cols * centroids.n_cols;
+}
+
+} // namespace kmeans
+} // namespace mlpack
+
+#endif
@@ -25,6 +25,9 @@ template<typename MetricType, typename MatType>
 class NaiveKMeans
 {
  public:
+  //! The type of the elements of the dataset and of the centroids.
+  typedef typename MatType::elem_type ElemType;
+
   /**
    * Construct the NaiveKMeans object with the given dataset and metric.
    *
@@ -40,12 +43,18 @@ class NaiveKMeans
    * @param centroids Current cluster centroids.
    * @param newCentroids New cluster centroids.
    */
-  double Iterate(const arma::mat& centroids,
-                 arma::mat& newCentroids,
+  double Iterate(const arma::Mat<ElemType>& centroids,
+                 arma::Mat<ElemType>& newCentroids,
                  arma::Col<size_t>& counts);
 
   size_t DistanceCalculations() const { return distanceCalculations; }
 
+  //! Get the number of threads used for each iteration.
+  size_t NumThreads() const { return numThreads; }
+  //! Modify the number of threads used for each iteration (0 means as many as
+  //! OpenMP allows).
+  size_t& NumThreads() { return numThreads; }
+
  private:
   //! The dataset.
   const MatType& dataset;
@@ -54,6 +63,11 @@ class NaiveKMeans
 
   //! Number of distance calculations.
   size_t distanceCalculations;
+  //! Number of threads to use for each iteration.
+  size_t numThreads;
+
+  //! Get the number of threads that will actually be used.
+  size_t ThreadsToUse() const;
 };
 
 } // namespace kmeans
@@ -12,6 +12,10 @@
 // In case it hasn't been included yet.
 #include "naive_kmeans.hpp"
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace kmeans {
 
@@ -20,49 +24,75 @@ NaiveKMeans<MetricType, MatType>::NaiveKMeans(const MatType& dataset,
                                               MetricType& metric) :
     dataset(dataset),
     metric(metric),
-    distanceCalculations(0)
+    distanceCalculations(0),
+    numThreads(1)
 { /* Nothing to do. */ }
 
 // Run a single iteration.
 template<typename MetricType, typename MatType>
-double NaiveKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
-                                                 arma::mat& newCentroids,
-                                                 arma::Col<size_t>& counts)
+double NaiveKMeans<MetricType, MatType>::Iterate(
+    const arma::Mat<ElemType>& centroids,
+    arma::Mat<ElemType>& newCentroids,
+    arma::Col<size_t>& counts)
 {
-  newCentroids.zeros(centroids.n_rows, centroids.n_cols);
-  counts.zeros(centroids.n_cols);
+  // The points are split into one contiguous block per thread, and each block
+  // accumulates its own partial sums and counts.  The partial results are
+  // reduced in block order, so the result does not depend on the scheduling.
+  const size_t blocks = std::max(std::min(ThreadsToUse(), dataset.n_cols),
+      (size_t) 1);
+  arma::Cube<ElemType> partialCentroids(centroids.n_rows, centroids.n_cols,
+      blocks, arma::fill::zeros);
+  arma::Mat<size_t> partialCounts(centroids.n_cols, blocks, arma::fill::zeros);
 
   // Find the closest centroid to each point and update the new centroids.
-  for (size_t i = 0; i < dataset.n_cols; i++)
+  #pragma omp parallel for num_threads(blocks) schedule(static, 1)
+  for (size_t b = 0; b < blocks; ++b)
   {
-    // Find the closest centroid to this point.
-    double minDistance = std::numeric_limits<double>::infinity();
-    size_t closestCluster = centroids.n_cols; // Invalid value.
-
-    for (size_t j = 0; j < centroids.n_cols; j++)
+    const size_t begin = (b * dataset.n_cols) / blocks;
+    const size_t end = ((b + 1) * dataset.n_cols) / blocks;
+    for (size_t i = begin; i < end; i++)
     {
-      const double distance = metric.Evaluate(dataset.col(i), centroids.col(j));
+      // Find the closest centroid to this point.
+      double minDistance = std::numeric_limits<double>::infinity();
+      size_t closestCluster = centroids.n_cols; // Invalid value.
 
-      if (distance < minDistance)
+      for (size_t j = 0; j < centroids.n_cols; j++)
       {
-        minDistance = distance;
-        closestCluster = j;
+        const double distance = metric.Evaluate(dataset.col(i),
+            centroids.col(j));
+
+        if (distance < minDistance)
+        {
+          minDistance = distance;
+          closestCluster = j;
+        }
       }
-    }
 
-    Log::Assert(closestCluster != centroids.n_cols);
+      Log::Assert(closestCluster != centroids.n_cols);
 
-    // We now have the minimum distance centroid index.  Update that centroid.
-    newCentroids.col(closestCluster) += arma::vec(dataset.col(i));
-    counts(closestCluster)++;
+      // We now have the minimum distance centroid index.  Update that
+      // centroid.
+      partialCentroids.slice(b).col(closestCluster) +=
+          arma::Col<ElemType>(dataset.col(i));
+      partialCounts(closestCluster, b)++;
+    }
+  }
+
+  // Reduce the partial results.
+  newCentroids = partialCentroids.slice(0);
+  counts = partialCounts.col(0);
+  for (size_t b = 1; b < blocks; ++b)
+  {
+    newCentroids += partialCentroids.slice(b);
+    counts += partialCounts.col(b);
   }
 
   // Now normalize the centroid.
   for (size_t i = 0; i < centroids.n_cols; ++i)
     if (counts(i) != 0)
       newCentroids.col(i) /= counts(i);
-    else
-      newCentroids.col(i).fill(DBL_MAX); // Invalid value.
+    else // Invalid value.
+      newCentroids.col(i).fill(std::numeric_limits<ElemType>::max());
 
   distanceCalculations += centroids.n_cols * dataset.n_cols;
 
@@ -78,6 +108,19 @@ double NaiveKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
   return std::sqrt(cNorm);
 }
 
+template<typename MetricType, typename MatType>
+size_t NaiveKMeans<MetricType, MatType>::ThreadsToUse() const
+{
+  if (numThreads != 0)
+    return numThreads;
+
+#ifdef _OPENMP
+  return (size_t) omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
 } // namespace kmeans
 } // namespace mlpack
 
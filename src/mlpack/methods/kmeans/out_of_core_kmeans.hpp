@@ -0,0 +1,169 @@
+/**
+ * @file out_of_core_kmeans.hpp
+ *
+ * K-means on a dataset stored in an Armadillo binary file, which is read one
+ * block of points at a time in each iteration, for datasets that do not fit in
+ * memory.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_OUT_OF_CORE_KMEANS_HPP
+#define __MLPACK_METHODS_KMEANS_OUT_OF_CORE_KMEANS_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/metrics/lmetric.hpp>
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * This class runs exact k-means (Lloyd's algorithm) on a dataset stored in an
+ * Armadillo binary file (the format used by data::Save() for files with the
+ * '.bin' extension), without ever holding more than one block of points in
+ * memory.  In each iteration, the file is read sequentially, one block of
+ * BlockSize() points at a time; each point of the block is assigned to its
+ * closest centroid, and the points are added to the sums of their clusters.
+ * Only the centroids, their sums and their counts are kept across blocks, so
+ * the memory used does not depend on the number of points.  The result is the
+ * same as that of KMeans with the naive Lloyd step.
+ *
+ * The closest centroids of the points of a block are found in parallel with
+ * OpenMP; the sums are accumulated in point order, so the result does not
+ * depend on the number of threads.
+ *
+ * If a cluster becomes empty, its centroid is left where it was.  If no
+ * initial centroids are given, distinct random points are used.  After the
+ * last iteration, the assignments of the points can be written to a file, one
+ * label per line, again one block at a time.
+ *
+ * @code
+ * OutOfCoreKMeans<> k("huge_dataset.bin");
+ * arma::mat centroids;
+ * k.Cluster(100, centroids, false, "assignments.csv"); // 100 clusters.
+ * @endcode
+ *
+ * @tparam MetricType The distance metric to use.
+ */
+template<typename MetricType = metric::EuclideanDistance>
+class OutOfCoreKMeans
+{
+ public:
+  /**
+   * Create the object for the dataset in the given file.  Nothing is read until
+   * Cluster() is called.  Files written by data::Save() hold one point per row
+   * (transposed); files written by arma::Mat<>::save() hold one point per
+   * column.  Both double and float data can be read.
+   *
+   * @param filename Armadillo binary file holding the dataset.
+   * @param blockSize Number of points in each block.
+   * @param maxIterations Maximum number of iterations (0 means no limit).
+   * @param transposed If true, each row of the matrix in the file is a point.
+   * @param metric Instantiated metric.
+   */
+  OutOfCoreKMeans(const std::string& filename,
+                  const size_t blockSize = 100000,
+                  const size_t maxIterations = 1000,
+                  const bool transposed = true,
+                  const MetricType metric = MetricType());
+
+  /**
+   * Cluster the dataset, storing the centroids of each cluster in the given
+   * matrix.  If initialGuess is true, the given centroids are used as the
+   * initial centroids.  If an assignments file is given, the assignment of each
+   * point is written to it (one per line) after the last iteration.
+   *
+   * @param clusters Number of clusters to compute.
+   * @param centroids Matrix in which centroids are stored.
+   * @param initialGuess If true, centroids contains the initial centroids.
+   * @param assignmentsFile If not empty, file to write the assignments to.
+   */
+  void Cluster(const size_t clusters,
+               arma::mat& centroids,
+               const bool initialGuess = false,
+               const std::string& assignmentsFile = "");
+
+  //! Get the name of the file holding the dataset.
+  const std::string& Filename() const { return filename; }
+
+  //! Get the number of points in each block.
+  size_t BlockSize() const { return blockSize; }
+  //! Modify the number of points in each block.
+  size_t& BlockSize() { return blockSize; }
+
+  //! Get the maximum number of iterations.
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations.
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the number of threads.
+  size_t NumThreads() const { return numThreads; }
+  //! Modify the number of threads (0 means as many as OpenMP allows).
+  size_t& NumThreads() { return numThreads; }
+
+  //! Get the distance metric.
+  const MetricType& Metric() const { return metric; }
+  //! Modify the distance metric.
+  MetricType& Metric() { return metric; }
+
+ private:
+  //! The file holding the dataset.
+  std::string filename;
+  //! Number of points in each block.
+  size_t blockSize;
+  //! Maximum number of iterations.
+  size_t maxIterations;
+  //! Whether each row of the matrix in the file is a point.
+  bool transposed;
+  //! The instantiated metric.
+  MetricType metric;
+  //! The number of threads to use.
+  size_t numThreads;
+
+  //! Dimensionality of the points in the file.
+  size_t dimensionality;
+  //! Number of points in the file.
+  size_t numPoints;
+  //! Size of each element in the file, in bytes (4 or 8).
+  size_t elementSize;
+  //! Offset of the first element in the file.
+  std::streamoff dataOffset;
+
+  /**
+   * Open the file and read its header, setting the dimensionality, number of
+   * points, element size and data offset.
+   */
+  void Open(std::ifstream& stream);
+
+  //! Read the given points from the file into the block matrix.
+  void ReadBlock(std::ifstream& stream,
+                 const size_t begin,
+                 const size_t count,
+                 arma::mat& block);
+
+  /**
+   * Read count consecutive elements of the file, starting at the given element,
+   * into out[0], out[stride], out[2 * stride], and so on.
+   */
+  void ReadElements(std::ifstream& stream,
+                    const size_t first,
+                    const size_t count,
+                    double* out,
+                    const size_t stride);
+
+  /**
+   * Find the closest centroid to each point of the block.  Returns the number
+   * of distance calculations.
+   */
+  size_t AssignBlock(const arma::mat& block,
+                     const arma::mat& centroids,
+                     arma::Col<size_t>& assignments);
+
+  //! Get the number of threads that will actually be used.
+  size_t ThreadsToUse() const;
+};
+
+} // namespace kmeans
+} // namespace mlpack
+
+// Include implementation.
+#include "out_of_core_kmeans_impl.hpp"
+
+#endif
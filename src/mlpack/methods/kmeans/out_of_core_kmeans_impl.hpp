@@ -0,0 +1,317 @@
+/**
+ * @file out_of_core_kmeans_impl.hpp
+ *
+ * Implementation of k-means on a dataset read from disk one block at a time.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_OUT_OF_CORE_KMEANS_IMPL_HPP
+#define __MLPACK_METHODS_KMEANS_OUT_OF_CORE_KMEANS_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "out_of_core_kmeans.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+namespace mlpack {
+namespace kmeans {
+
+template<typename MetricType>
+OutOfCoreKMeans<MetricType>::OutOfCoreKMeans(const std::string& filename,
+                                             const size_t blockSize,
+                                             const size_t maxIterations,
+                                             const bool transposed,
+                                             const MetricType metric) :
+    filename(filename),
+    blockSize(blockSize),
+    maxIterations(maxIterations),
+    transposed(transposed),
+    metric(metric),
+    numThreads(1),
+    dimensionality(0),
+    numPoints(0),
+    elementSize(0),
+    dataOffset(0)
+{
+  // Nothing to do.
+}
+
+template<typename MetricType>
+void OutOfCoreKMeans<MetricType>::Cluster(const size_t clusters,
+                                          arma::mat& centroids,
+                                          const bool initialGuess,
+                                          const std::string& assignmentsFile)
+{
+  if (blockSize == 0)
+    throw std::invalid_argument("OutOfCoreKMeans::Cluster(): block size must "
+        "be greater than 0");
+  if (clusters == 0)
+    throw std::invalid_argument("OutOfCoreKMeans::Cluster(): number of "
+        "clusters must be greater than 0");
+
+  std::ifstream stream;
+  Open(stream);
+
+  if (numPoints < clusters)
+    Log::Fatal << "OutOfCoreKMeans::Cluster(): '" << filename << "' holds "
+        << "fewer points (" << numPoints << ") than clusters (" << clusters
+        << ")!" << std::endl;
+
+  if (initialGuess)
+  {
+    if (centroids.n_cols != clusters)
+      Log::Fatal << "OutOfCoreKMeans::Cluster(): wrong number of initial "
+          << "cluster centroids (" << centroids.n_cols << ", should be "
+          << clusters << ")!" << std::endl;
+
+    if (centroids.n_rows != dimensionality)
+      Log::Fatal << "OutOfCoreKMeans::Cluster(): initial cluster centroids "
+          << "have wrong dimensionality (" << centroids.n_rows << ", should "
+          << "be " << dimensionality << ")!" << std::endl;
+  }
+  else
+  {
+    // Take distinct random points.  math::RandInt() can't index more than
+    // 2^31 points, so the index is drawn with math::Random().
+    std::vector<size_t> chosen;
+    arma::mat point;
+    centroids.set_size(dimensionality, clusters);
+    while (chosen.size() < clusters)
+    {
+      const size_t index = std::min((size_t) (math::Random() * numPoints),
+          numPoints - 1);
+      if (std::find(chosen.begin(), chosen.end(), index) != chosen.end())
+        continue;
+
+      ReadBlock(stream, index, 1, point);
+      centroids.col(chosen.size()) = point.col(0);
+      chosen.push_back(index);
+    }
+  }
+
+  arma::mat block;
+  arma::mat newCentroids;
+  arma::Col<size_t> counts;
+  arma::Col<size_t> blockAssignments;
+  size_t distanceCalculations = 0;
+
+  size_t iteration = 0;
+  double cNorm;
+  do
+  {
+    // Accumulate the sums and counts of the clusters, one block at a time.
+    newCentroids.zeros(dimensionality, clusters);
+    counts.zeros(clusters);
+    for (size_t begin = 0; begin < numPoints; begin += blockSize)
+    {
+      const size_t count = std::min(blockSize, numPoints - begin);
+      ReadBlock(stream, begin, count, block);
+      distanceCalculations += AssignBlock(block, centroids, blockAssignments);
+
+      for (size_t i = 0; i < count; ++i)
+      {
+        newCentroids.col(blockAssignments[i]) += block.col(i);
+        ++counts[blockAssignments[i]];
+      }
+    }
+
+    // Normalize the centroids and calculate how far they moved.  An empty
+    // cluster keeps its centroid.
+    cNorm = 0.0;
+    for (size_t c = 0; c < clusters; ++c)
+    {
+      if (counts[c] == 0)
+      {
+        newCentroids.col(c) = centroids.col(c);
+        continue;
+      }
+
+      newCentroids.col(c) /= counts[c];
+      cNorm += std::pow(metric.Evaluate(centroids.col(c), newCentroids.col(c)),
+          2.0);
+      ++distanceCalculations;
+    }
+    cNorm = std::sqrt(cNorm);
+    centroids.swap(newCentroids);
+
+    iteration++;
+    Log::Info << "OutOfCoreKMeans::Cluster(): iteration " << iteration
+        << ", residual " << cNorm << ".\n";
+
+  } while (cNorm > 1e-5 && iteration != maxIterations);
+
+  Log::Info << "OutOfCoreKMeans::Cluster(): finished after " << iteration
+      << " iterations." << std::endl;
+
+  // Write the assignments to the final centroids, if requested.
+  if (!assignmentsFile.empty())
+  {
+    std::ofstream out(assignmentsFile.c_str());
+    if (!out.is_open())
+      Log::Fatal << "Cannot open file '" << assignmentsFile << "'."
+          << std::endl;
+
+    for (size_t begin = 0; begin < numPoints; begin += blockSize)
+    {
+      const size_t count = std::min(blockSize, numPoints - begin);
+      ReadBlock(stream, begin, count, block);
+      distanceCalculations += AssignBlock(block, centroids, blockAssignments);
+
+      for (size_t i = 0; i < count; ++i)
+        out << blockAssignments[i] << '\n';
+    }
+
+    if (!out.good())
+      Log::Fatal << "Writing assignments to '" << assignmentsFile << "' "
+          << "failed." << std::endl;
+  }
+
+  Log::Info << distanceCalculations << " distance calculations." << std::endl;
+}
+
+template<typename MetricType>
+void OutOfCoreKMeans<MetricType>::Open(std::ifstream& stream)
+{
+  stream.open(filename.c_str(), std::ios::in | std::ios::binary);
+  if (!stream.is_open())
+    Log::Fatal << "Cannot open file '" << filename << "'." << std::endl;
+
+  // The header is the type of the elements, then the size of the matrix.
+  std::string header;
+  size_t rows = 0;
+  size_t cols = 0;
+  stream >> header >> rows >> cols;
+  stream.get(); // The newline after the size.
+
+  if (header == "ARMA_MAT_BIN_FN008")
+    elementSize = 8;
+  else if (header == "ARMA_MAT_BIN_FN004")
+    elementSize = 4;
+  else
+    Log::Fatal << "'" << filename << "' is not an Armadillo binary file "
+        << "holding double or float data!" << std::endl;
+
+  if (!stream.good())
+    Log::Fatal << "Cannot read the header of '" << filename << "'."
+        << std::endl;
+
+  dimensionality = transposed ? cols : rows;
+  numPoints = transposed ? rows : cols;
+  dataOffset = stream.tellg();
+
+  Log::Info << "OutOfCoreKMeans: '" << filename << "' holds " << numPoints
+      << " points of dimensionality " << dimensionality << "." << std::endl;
+}
+
+template<typename MetricType>
+void OutOfCoreKMeans<MetricType>::ReadBlock(std::ifstream& stream,
+                                            const size_t begin,
+                                            const size_t count,
+                                            arma::mat& block)
+{
+  block.set_size(dimensionality, count);
+  if (transposed)
+  {
+    // Each dimension is stored contiguously, so the block is read one
+    // dimension at a time.
+    for (size_t d = 0; d < dimensionality; ++d)
+      ReadElements(stream, d * numPoints + begin, count, block.memptr() + d,
+          dimensionality);
+  }
+  else
+  {
+    ReadElements(stream, begin * dimensionality, count * dimensionality,
+        block.memptr(), 1);
+  }
+}
+
+template<typename MetricType>
+void OutOfCoreKMeans<MetricType>::ReadElements(std::ifstream& stream,
+                                               const size_t first,
+                                               const size_t count,
+                                               double* out,
+                                               const size_t stride)
+{
+  stream.seekg(dataOffset + std::streamoff(first * elementSize));
+
+  if (elementSize == sizeof(double) && stride == 1)
+  {
+    stream.read((char*) out, count * sizeof(double));
+  }
+  else
+  {
+    std::vector<char> buffer(count * elementSize);
+    stream.read(buffer.data(), buffer.size());
+    for (size_t i = 0; i < count; ++i)
+    {
+      if (elementSize == sizeof(double))
+      {
+        double value;
+        std::memcpy(&value, &buffer[i * elementSize], sizeof(double));
+        out[i * stride] = value;
+      }
+      else
+      {
+        float value;
+        std::memcpy(&value, &buffer[i * elementSize], sizeof(float));
+        out[i * stride] = (double) value;
+      }
+    }
+  }
+
+  if (!stream.good())
+    Log::Fatal << "OutOfCoreKMeans: unexpected end of file '" << filename
+        << "'!" << std::endl;
+}
+
+template<typename MetricType>
+size_t OutOfCoreKMeans<MetricType>::AssignBlock(
+    const arma::mat& block,
+    const arma::mat& centroids,
+    arma::Col<size_t>& assignments)
+{
+  assignments.set_size(block.n_cols);
+
+  const size_t threads = ThreadsToUse();
+  #pragma omp parallel for num_threads(threads) schedule(static)
+  for (size_t i = 0; i < block.n_cols; ++i)
+  {
+    double minDistance = DBL_MAX;
+    size_t closestCluster = 0;
+    for (size_t c = 0; c < centroids.n_cols; ++c)
+    {
+      const double distance = metric.Evaluate(block.col(i), centroids.col(c));
+      if (distance < minDistance)
+      {
+        minDistance = distance;
+        closestCluster = c;
+      }
+    }
+
+    assignments[i] = closestCluster;
+  }
+
+  return block.n_cols * centroids.n_cols;
+}
+
+template<typename MetricType>
+size_t OutOfCoreKMeans<MetricType>::ThreadsToUse() const
+{
+  if (numThreads != 0)
+    return numThreads;
+
+#ifdef _OPENMP
+  return (size_t) omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+} // namespace kmeans
+} // namespace mlpack
+
+#endif
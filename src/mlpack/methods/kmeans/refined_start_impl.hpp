@@ -23,16 +23,22 @@ void RefinedStart::Cluster(const MatType& data,
 {
   math::RandomSeed(std::time(NULL));
 
+  // The sampled datasets and the centroids have the element type of the data,
+  // so that float data is clustered in single precision throughout.
+  typedef typename MatType::elem_type ElemType;
+  typedef KMeans<metric::EuclideanDistance, RandomPartition,
+      MaxVarianceNewCluster, NaiveKMeans, arma::Mat<ElemType> > KMeansType;
+
   // This will hold the sampled datasets.
   const size_t numPoints = size_t(percentage * data.n_cols);
-  MatType sampledData(data.n_rows, numPoints);
+  arma::Mat<ElemType> sampledData(data.n_rows, numPoints);
   // vector<bool> is packed so each bool is 1 bit.
   std::vector<bool> pointsUsed(data.n_cols, false);
-  arma::mat sampledCentroids(data.n_rows, samplings * clusters);
+  arma::Mat<ElemType> sampledCentroids(data.n_rows, samplings * clusters);
 
   // We will use these objects repeatedly for clustering.
   arma::Col<size_t> sampledAssignments;
-  arma::mat centroids;
+  arma::Mat<ElemType> centroids;
 
   for (size_t i = 0; i < samplings; ++i)
   {
@@ -56,7 +62,7 @@ void RefinedStart::Cluster(const MatType& data,
     // cluster, we re-initialize that cluster as the point furthest away from
     // the cluster with maximum variance.  This is not *exactly* what the paper
     // implements, but it is quite similar, and we'll call it "good enough".
-    KMeans<> kmeans;
+    KMeansType kmeans;
     kmeans.Cluster(sampledData, clusters, sampledAssignments, centroids);
 
     // Store the sampled centroids.
@@ -66,7 +72,7 @@ void RefinedStart::Cluster(const MatType& data,
   }
 
   // Now, we run k-means on the sampled centroids to get our final clusters.
-  KMeans<> kmeans;
+  KMeansType kmeans;
   kmeans.Cluster(sampledCentroids, clusters, sampledAssignments, centroids);
 
   // Turn the final centroids into assignments.
@@ -0,0 +1,115 @@
+/**
+ * @file streaming_mini_batch_kmeans.hpp
+ *
+ * Mini-batch k-means on a dataset that is read from disk one batch at a time,
+ * for datasets that do not fit in memory.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_STREAMING_MINI_BATCH_KMEANS_HPP
+#define __MLPACK_METHODS_KMEANS_STREAMING_MINI_BATCH_KMEANS_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/metrics/lmetric.hpp>
+#include <mlpack/core/data/chunk_reader.hpp>
+
+#include "mini_batch_kmeans.hpp"
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * This class runs mini-batch k-means (see MiniBatchKMeans) on a dataset stored
+ * in a text file (CSV or whitespace-separated, one point per line), without
+ * ever holding more than one batch of points in memory.  Batches are read
+ * sequentially from the file, and reading wraps around to the start of the
+ * file when the end is reached; so, unlike MiniBatchKMeans, the batches are
+ * not random samples, and the points in the file should be in random order.
+ *
+ * If no initial centroids are given, they are chosen at random among the
+ * points of the first batch.
+ *
+ * @code
+ * StreamingMiniBatchKMeans<> k("huge_dataset.csv", 5000);
+ * arma::mat centroids;
+ * k.Cluster(100, centroids); // 100 clusters.
+ * @endcode
+ *
+ * @tparam MetricType The distance metric to use.
+ */
+template<typename MetricType = metric::EuclideanDistance>
+class StreamingMiniBatchKMeans
+{
+ public:
+  /**
+   * Create the object for the dataset in the given file.  Nothing is read until
+   * Cluster() is called.
+   *
+   * @param filename File holding the dataset.
+   * @param batchSize Number of points in each batch.
+   * @param maxIterations Maximum number of batches (0 means no limit).
+   * @param metric Instantiated metric.
+   */
+  StreamingMiniBatchKMeans(const std::string& filename,
+                           const size_t batchSize = 1000,
+                           const size_t maxIterations = 1000,
+                           const MetricType metric = MetricType());
+
+  /**
+   * Cluster the dataset, storing the centroids of each cluster in the given
+   * matrix.  If initialGuess is true, the given centroids are used as the
+   * initial centroids.
+   *
+   * @param clusters Number of clusters to compute.
+   * @param centroids Matrix in which centroids are stored.
+   * @param initialGuess If true, centroids contains the initial centroids.
+   */
+  void Cluster(const size_t clusters,
+               arma::mat& centroids,
+               const bool initialGuess = false);
+
+  //! Get the name of the file holding the dataset.
+  const std::string& Filename() const { return filename; }
+
+  //! Get the number of points in each batch.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the number of points in each batch.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the maximum number of iterations.
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations.
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the distance metric.
+  const MetricType& Metric() const { return metric; }
+  //! Modify the distance metric.
+  MetricType& Metric() { return metric; }
+
+ private:
+  //! The file holding the dataset.
+  std::string filename;
+  //! Number of points in each batch.
+  size_t batchSize;
+  //! Maximum number of iterations.
+  size_t maxIterations;
+  //! The instantiated metric.
+  MetricType metric;
+
+  //! Dimensionality of the points in the file (0 until the first is read).
+  size_t dimensionality;
+
+  /**
+   * Read the given number of points from the file into the batch matrix,
+   * wrapping around to the start of the file if its end is reached.
+   */
+  void ReadBatch(data::ChunkReader& reader,
+                 const size_t points,
+                 arma::mat& batch);
+};
+
+} // namespace kmeans
+} // namespace mlpack
+
+// Include implementation.
+#include "streaming_mini_batch_kmeans_impl.hpp"
+
+#endif
@@ -0,0 +1,137 @@
+/**
+ * @file streaming_mini_batch_kmeans_impl.hpp
+ *
+ * Implementation of mini-batch k-means on a dataset read from disk.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_STREAMING_MINI_BATCH_KMEANS_IMPL_HPP
+#define __MLPACK_METHODS_KMEANS_STREAMING_MINI_BATCH_KMEANS_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "streaming_mini_batch_kmeans.hpp"
+
+namespace mlpack {
+namespace kmeans {
+
+template<typename MetricType>
+StreamingMiniBatchKMeans<MetricType>::StreamingMiniBatchKMeans(
+    const std::string& filename,
+    const size_t batchSize,
+    const size_t maxIterations,
+    const MetricType metric) :
+    filename(filename),
+    batchSize(batchSize),
+    maxIterations(maxIterations),
+    metric(metric),
+    dimensionality(0)
+{
+  // Nothing to do.
+}
+
+template<typename MetricType>
+void StreamingMiniBatchKMeans<MetricType>::Cluster(const size_t clusters,
+                                                   arma::mat& centroids,
+                                                   const bool initialGuess)
+{
+  if (batchSize == 0)
+    throw std::invalid_argument("StreamingMiniBatchKMeans::Cluster(): batch "
+        "size must be greater than 0");
+  if (clusters == 0)
+    throw std::invalid_argument("StreamingMiniBatchKMeans::Cluster(): number "
+        "of clusters must be greater than 0");
+
+  data::ChunkReader reader(filename);
+
+  // The first batch is used to choose the initial centroids, if necessary.
+  // It must hold at least as many points as there are clusters.
+  dimensionality = 0;
+  arma::mat batch;
+  ReadBatch(reader, initialGuess ? batchSize : std::max(batchSize, clusters),
+      batch);
+
+  if (initialGuess)
+  {
+    if (centroids.n_cols != clusters)
+      Log::Fatal << "StreamingMiniBatchKMeans::Cluster(): wrong number of "
+          << "initial cluster centroids (" << centroids.n_cols << ", should "
+          << "be " << clusters << ")!" << std::endl;
+
+    if (centroids.n_rows != dimensionality)
+      Log::Fatal << "StreamingMiniBatchKMeans::Cluster(): initial cluster "
+          << "centroids have wrong dimensionality (" << centroids.n_rows
+          << ", should be " << dimensionality << ")!" << std::endl;
+  }
+  else
+  {
+    // Take distinct random points of the first batch.  (If the file holds
+    // fewer points than clusters, the batch holds repeated points.)
+    const arma::Col<size_t> order = arma::shuffle(
+        arma::linspace<arma::Col<size_t> >(0, batch.n_cols - 1, batch.n_cols));
+    centroids.set_size(dimensionality, clusters);
+    for (size_t c = 0; c < clusters; ++c)
+      centroids.col(c) = batch.col(order[c]);
+  }
+
+  arma::Col<size_t> centerCounts(clusters);
+  centerCounts.zeros();
+  size_t distanceCalculations = 0;
+
+  typedef MiniBatchKMeans<MetricType, arma::mat> StepType;
+  size_t iteration = 0;
+  double cNorm;
+  do
+  {
+    if (iteration > 0)
+      ReadBatch(reader, batchSize, batch);
+
+    const arma::mat oldCentroids(centroids);
+    distanceCalculations += StepType::BatchUpdate(batch, centroids,
+        centerCounts, metric);
+
+    cNorm = 0.0;
+    for (size_t c = 0; c < clusters; ++c)
+      cNorm += std::pow(metric.Evaluate(oldCentroids.col(c),
+          centroids.col(c)), 2.0);
+    cNorm = std::sqrt(cNorm);
+    distanceCalculations += clusters;
+
+    iteration++;
+    Log::Info << "StreamingMiniBatchKMeans::Cluster(): iteration " << iteration
+        << ", residual " << cNorm << ".\n";
+
+  } while (cNorm > 1e-5 && iteration != maxIterations);
+
+  Log::Info << "StreamingMiniBatchKMeans::Cluster(): finished after "
+      << iteration << " iterations." << std::endl;
+  Log::Info << distanceCalculations << " distance calculations." << std::endl;
+}
+
+template<typename MetricType>
+void StreamingMiniBatchKMeans<MetricType>::ReadBatch(
+    data::ChunkReader& reader,
+    const size_t points,
+    arma::mat& batch)
+{
+  reader.Read(points, batch);
+  arma::mat chunk;
+  while (batch.n_cols < points)
+  {
+    Log::Info << "StreamingMiniBatchKMeans: reached the end of '" << filename
+        << "'; reading from the start again." << std::endl;
+    reader.Rewind();
+
+    // If we have been through the whole file without finding a point, the
+    // file holds no points at all.
+    if (reader.Read(points - batch.n_cols, chunk) == 0)
+      Log::Fatal << "StreamingMiniBatchKMeans: no points in file '"
+          << filename << "'!" << std::endl;
+
+    batch = arma::join_rows(batch, chunk);
+  }
+
+  dimensionality = reader.Dimensionality();
+}
+
+} // namespace kmeans
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,131 @@
+/**
+ * @file yinyang_kmeans.hpp
+ *
+ * An implementation of Yinyang k-means, which keeps one lower bound per group
+ * of centroids for each point.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_YINYANG_KMEANS_HPP
+#define __MLPACK_METHODS_KMEANS_YINYANG_KMEANS_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * An implementation of Yinyang k-means, from the following paper:
+ *
+ * @code
+ * @inproceedings{ding2015yinyang,
+ *   title={Yinyang k-means: A drop-in replacement of the classic k-means with
+ *       consistent speedup},
+ *   author={Ding, Yufei and Zhao, Yue and Shen, Xipeng and Musuvathi, Madanlal
+ *       and Mytkowicz, Todd},
+ *   booktitle={Proceedings of the 32nd International Conference on Machine
+ *       Learning (ICML '15)},
+ *   pages={579--587},
+ *   year={2015}
+ * }
+ * @endcode
+ *
+ * The centroids are split into t groups (by running k-means on the initial
+ * centroids).  For each point, an upper bound on the distance to its centroid
+ * and one lower bound per group (on the distance to every other centroid of
+ * the group) are kept.  A point is skipped if its upper bound is below all of
+ * its group bounds (global filter); otherwise, only the groups whose bound is
+ * below the upper bound are searched (group filter), and inside a group, a
+ * centroid is skipped if the group bound minus its own movement is above the
+ * best distance so far (local filter).
+ *
+ * ElkanKMeans keeps k bounds per point and HamerlyKMeans keeps one; Yinyang
+ * k-means keeps t, so the number of groups trades memory for pruning.  With
+ * t = 1 it is similar to Hamerly's algorithm, and with t = k it is similar to
+ * Elkan's algorithm.  The default is t = k / 10.
+ *
+ * @tparam MetricType Type of metric used with this implementation.
+ * @tparam MatType Matrix type (arma::mat or arma::sp_mat).
+ */
+template<typename MetricType, typename MatType>
+class YinyangKMeans
+{
+ public:
+  //! The type of the elements of the dataset and of the centroids.
+  typedef typename MatType::elem_type ElemType;
+
+  /**
+   * Construct the YinyangKMeans object, which must store several sets of
+   * bounds.
+   */
+  YinyangKMeans(const MatType& dataset, MetricType& metric);
+
+  /**
+   * Run a single iteration of Yinyang k-means, updating the given centroids
+   * into the newCentroids matrix.
+   *
+   * @param centroids Current cluster centroids.
+   * @param newCentroids New cluster centroids.
+   * @param counts Current counts, to be overwritten with new counts.
+   */
+  double Iterate(const arma::Mat<ElemType>& centroids,
+                 arma::Mat<ElemType>& newCentroids,
+                 arma::Col<size_t>& counts);
+
+  size_t DistanceCalculations() const { return distanceCalculations; }
+
+  //! Get the number of centroid groups (0 means k / 10).
+  size_t NumGroups() const { return numGroups; }
+  //! Modify the number of centroid groups (0 means k / 10).  This only takes
+  //! effect before the first iteration.
+  size_t& NumGroups() { return numGroups; }
+
+  //! Get the number of threads used for each iteration.
+  size_t NumThreads() const { return numThreads; }
+  //! Modify the number of threads used for each iteration (0 means as many as
+  //! OpenMP allows).
+  size_t& NumThreads() { return numThreads; }
+
+ private:
+  //! The dataset.
+  const MatType& dataset;
+  //! The instantiated metric.
+  MetricType& metric;
+
+  //! The requested number of groups (0 means k / 10).
+  size_t numGroups;
+  //! The centroids in each group.
+  std::vector<std::vector<size_t> > groups;
+  //! The group of each centroid.
+  arma::Col<size_t> groupOf;
+
+  //! Movement of each centroid in the last iteration.
+  arma::vec drifts;
+  //! Largest movement of a centroid of each group in the last iteration.
+  arma::vec groupDrifts;
+
+  //! Upper bounds on the distance between each point and its closest centroid.
+  arma::vec upperBounds;
+  //! Lower bounds on the distance between each point and the centroids of each
+  //! group (one column per point).
+  arma::mat lowerBounds;
+  //! Assignments for each point.
+  arma::Col<size_t> assignments;
+
+  //! Track distance calculations.
+  size_t distanceCalculations;
+  //! Number of threads to use for each iteration.
+  size_t numThreads;
+
+  //! Split the centroids into groups and reset the bounds.
+  void Initialize(const arma::Mat<ElemType>& centroids);
+
+  //! Get the number of threads that will actually be used.
+  size_t ThreadsToUse() const;
+};
+
+} // namespace kmeans
+} // namespace mlpack
+
+// Include implementation.
+#include "yinyang_kmeans_impl.hpp"
+
+#endif
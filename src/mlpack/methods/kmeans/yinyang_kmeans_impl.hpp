@@ -0,0 +1,295 @@
+/**
+ * @file yinyang_kmeans_impl.hpp
+ *
+ * Implementation of Yinyang k-means.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_YINYANG_KMEANS_IMPL_HPP
+#define __MLPACK_METHODS_KMEANS_YINYANG_KMEANS_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "yinyang_kmeans.hpp"
+
+#include "kmeans.hpp"
+#include "allow_empty_clusters.hpp"
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+namespace mlpack {
+namespace kmeans {
+
+template<typename MetricType, typename MatType>
+YinyangKMeans<MetricType, MatType>::YinyangKMeans(const MatType& dataset,
+                                                  MetricType& metric) :
+    dataset(dataset),
+    metric(metric),
+    numGroups(0),
+    distanceCalculations(0),
+    numThreads(1)
+{
+  // Nothing to do.
+}
+
+template<typename MetricType, typename MatType>
+double YinyangKMeans<MetricType, MatType>::Iterate(
+    const arma::Mat<ElemType>& centroids,
+    arma::Mat<ElemType>& newCentroids,
+    arma::Col<size_t>& counts)
+{
+  // If this is the first iteration, we need to make the groups and set all the
+  // bounds.
+  if (groupOf.n_elem != centroids.n_cols ||
+      assignments.n_elem != dataset.n_cols)
+    Initialize(centroids);
+
+  const size_t numGroupsUsed = groups.size();
+
+  // The points are split into one contiguous block per thread.  Each block
+  // keeps its own partial sums and counts, which are reduced in block order
+  // afterwards so that the result does not depend on the scheduling.
+  const size_t blocks = std::max(std::min(ThreadsToUse(), dataset.n_cols),
+      (size_t) 1);
+  arma::Cube<ElemType> partialCentroids(centroids.n_rows, centroids.n_cols,
+      blocks, arma::fill::zeros);
+  arma::Mat<size_t> partialCounts(centroids.n_cols, blocks, arma::fill::zeros);
+  std::vector<size_t> partialDistanceCalculations(blocks, 0);
+  std::vector<size_t> partialGlobalPruned(blocks, 0);
+  std::vector<size_t> partialGroupPruned(blocks, 0);
+
+  #pragma omp parallel for num_threads(blocks) schedule(static, 1)
+  for (size_t b = 0; b < blocks; ++b)
+  {
+    const size_t begin = (b * dataset.n_cols) / blocks;
+    const size_t end = ((b + 1) * dataset.n_cols) / blocks;
+
+    // For each searched group, the smallest and second smallest distance (or
+    // bound) to its centroids, and the centroid with the smallest.
+    arma::vec groupMin(numGroupsUsed);
+    arma::vec groupSecondMin(numGroupsUsed);
+    arma::Col<size_t> groupArgMin(numGroupsUsed);
+    std::vector<char> searched(numGroupsUsed);
+
+    for (size_t i = begin; i < end; ++i)
+    {
+      const size_t oldAssignment = assignments[i];
+      const double globalLowerBound = arma::min(lowerBounds.col(i));
+
+      // Global filter.
+      if (upperBounds(i) <= globalLowerBound)
+      {
+        ++partialGlobalPruned[b];
+        partialCentroids.slice(b).col(oldAssignment) +=
+            arma::Col<ElemType>(dataset.col(i));
+        ++partialCounts(oldAssignment, b);
+        continue;
+      }
+
+      // Tighten the upper bound and try again.
+      upperBounds(i) = metric.Evaluate(dataset.col(i),
+                                       centroids.col(oldAssignment));
+      ++partialDistanceCalculations[b];
+      if (upperBounds(i) <= globalLowerBound)
+      {
+        ++partialGlobalPruned[b];
+        partialCentroids.slice(b).col(oldAssignment) +=
+            arma::Col<ElemType>(dataset.col(i));
+        ++partialCounts(oldAssignment, b);
+        continue;
+      }
+
+      const double oldDistance = upperBounds(i);
+      size_t best = oldAssignment;
+      double bestDistance = oldDistance;
+
+      for (size_t g = 0; g < numGroupsUsed; ++g)
+      {
+        // Group filter.
+        searched[g] = false;
+        if (lowerBounds(g, i) >= bestDistance)
+        {
+          ++partialGroupPruned[b];
+          continue;
+        }
+        searched[g] = true;
+
+        // The group bound before it was shifted at the end of the last
+        // iteration bounds the distance to each centroid before it moved.
+        const double oldGroupBound = lowerBounds(g, i) + groupDrifts[g];
+        groupMin[g] = DBL_MAX;
+        groupSecondMin[g] = DBL_MAX;
+        groupArgMin[g] = centroids.n_cols;
+        for (size_t j = 0; j < groups[g].size(); ++j)
+        {
+          const size_t c = groups[g][j];
+          double distance;
+          if (c == oldAssignment)
+          {
+            distance = oldDistance;
+          }
+          else if (oldGroupBound - drifts[c] >= bestDistance)
+          {
+            // Local filter: this centroid can't be closer, and the bound is
+            // good enough for the new group bound.
+            distance = oldGroupBound - drifts[c];
+          }
+          else
+          {
+            distance = metric.Evaluate(dataset.col(i), centroids.col(c));
+            ++partialDistanceCalculations[b];
+            if (distance < bestDistance)
+            {
+              bestDistance = distance;
+              best = c;
+            }
+          }
+
+          if (distance < groupMin[g])
+          {
+            groupSecondMin[g] = groupMin[g];
+            groupMin[g] = distance;
+            groupArgMin[g] = c;
+          }
+          else if (distance < groupSecondMin[g])
+          {
+            groupSecondMin[g] = distance;
+          }
+        }
+      }
+
+      // Now update the bounds of the searched groups; the bound of a group must
+      // not include the new assignment.
+      for (size_t g = 0; g < numGroupsUsed; ++g)
+        if (searched[g])
+          lowerBounds(g, i) = (groupArgMin[g] == best) ? groupSecondMin[g] :
+              groupMin[g];
+
+      // If the point left a group that was not searched, the bound of that
+      // group must now include the old centroid.
+      const size_t oldGroup = groupOf[oldAssignment];
+      if (best != oldAssignment && !searched[oldGroup])
+        lowerBounds(oldGroup, i) = std::min(lowerBounds(oldGroup, i),
+            oldDistance);
+
+      assignments[i] = best;
+      upperBounds(i) = bestDistance;
+
+      partialCentroids.slice(b).col(best) +=
+          arma::Col<ElemType>(dataset.col(i));
+      ++partialCounts(best, b);
+    }
+  }
+
+  size_t globalPruned = 0;
+  size_t groupPruned = 0;
+  newCentroids = partialCentroids.slice(0);
+  counts = partialCounts.col(0);
+  for (size_t b = 0; b < blocks; ++b)
+  {
+    if (b > 0)
+    {
+      newCentroids += partialCentroids.slice(b);
+      counts += partialCounts.col(b);
+    }
+    distanceCalculations += partialDistanceCalculations[b];
+    globalPruned += partialGlobalPruned[b];
+    groupPruned += partialGroupPruned[b];
+  }
+
+  // Normalize centroids and calculate how far each one moved.
+  double cNorm = 0.0;
+  groupDrifts.zeros(numGroupsUsed);
+  for (size_t c = 0; c < centroids.n_cols; ++c)
+  {
+    if (counts(c) > 0)
+      newCentroids.col(c) /= counts(c);
+    else // Empty cluster.
+      newCentroids.col(c).fill(std::numeric_limits<ElemType>::max());
+
+    drifts[c] = metric.Evaluate(centroids.col(c), newCentroids.col(c));
+    cNorm += std::pow(drifts[c], 2.0);
+    ++distanceCalculations;
+
+    if (drifts[c] > groupDrifts[groupOf[c]])
+      groupDrifts[groupOf[c]] = drifts[c];
+  }
+
+  // Now update the bounds for the next iteration.
+  #pragma omp parallel for num_threads(blocks) schedule(static)
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+  {
+    upperBounds(i) += drifts[assignments[i]];
+    for (size_t g = 0; g < numGroupsUsed; ++g)
+      lowerBounds(g, i) -= groupDrifts[g];
+  }
+
+  Log::Info << "Yinyang prunes: " << globalPruned << " points, " << groupPruned
+      << " groups.\n";
+
+  return std::sqrt(cNorm);
+}
+
+template<typename MetricType, typename MatType>
+void YinyangKMeans<MetricType, MatType>::Initialize(
+    const arma::Mat<ElemType>& centroids)
+{
+  size_t t = (numGroups == 0) ? centroids.n_cols / 10 : numGroups;
+  t = std::max(std::min(t, (size_t) centroids.n_cols), (size_t) 1);
+
+  // Group the centroids by running a few iterations of k-means on them.
+  arma::Col<size_t> centroidGroups;
+  if (t == 1)
+  {
+    centroidGroups.zeros(centroids.n_cols);
+  }
+  else
+  {
+    KMeans<MetricType, RandomPartition, AllowEmptyClusters, NaiveKMeans,
+        arma::Mat<ElemType> > groupKMeans(5, metric);
+    groupKMeans.Cluster(centroids, t, centroidGroups);
+  }
+
+  // Drop any empty groups.
+  std::vector<size_t> newGroupIndices(t, t);
+  groups.clear();
+  groupOf.set_size(centroids.n_cols);
+  for (size_t c = 0; c < centroids.n_cols; ++c)
+  {
+    if (newGroupIndices[centroidGroups[c]] == t)
+    {
+      newGroupIndices[centroidGroups[c]] = groups.size();
+      groups.push_back(std::vector<size_t>());
+    }
+
+    groupOf[c] = newGroupIndices[centroidGroups[c]];
+    groups[groupOf[c]].push_back(c);
+  }
+
+  Log::Info << "YinyangKMeans: " << groups.size() << " groups of centroids."
+      << std::endl;
+
+  drifts.zeros(centroids.n_cols);
+  groupDrifts.zeros(groups.size());
+  upperBounds.set_size(dataset.n_cols);
+  upperBounds.fill(DBL_MAX);
+  lowerBounds.zeros(groups.size(), dataset.n_cols);
+  assignments.zeros(dataset.n_cols);
+}
+
+template<typename MetricType, typename MatType>
+size_t YinyangKMeans<MetricType, MatType>::ThreadsToUse() const
+{
+  if (numThreads != 0)
+    return numThreads;
+
+#ifdef _OPENMP
+  return (size_t) omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+} // namespace kmeans
+} // namespace mlpack
+
+#endif
@@ -41,15 +41,25 @@ PROGRAM_INFO("All K-Approximate-Nearest-Neighbor Search with LSH",
     "\n\n"
     "Because this is approximate-nearest-neighbors search, results may be "
     "different from run to run.  Thus, the --seed option can be specified to "
-    "set the random seed.");
+    "set the random seed."
+    "\n\n"
+    "The hash tables can be saved with --output_model (-m) and loaded again "
+    "with --input_model (-i), so that the reference set only needs to be "
+    "hashed once.  If a reference set is given together with --input_model, "
+    "its points are added to the loaded model, and receive indices following "
+    "the points already in the model.  For example, the following builds a "
+    "model and then uses it to search for the neighbors of a query set:"
+    "\n\n"
+    "$ lsh -r input.csv -m lsh_model.xml\n"
+    "$ lsh -i lsh_model.xml -q queries.csv -k 5 -n neighbors.csv");
 
 // Define our input parameters that this program will take.
-PARAM_STRING_REQ("reference_file", "File containing the reference dataset.",
-    "r");
+PARAM_STRING("reference_file", "File containing the reference dataset.",
+    "r", "");
 PARAM_STRING("distances_file", "File to output distances into.", "d", "");
 PARAM_STRING("neighbors_file", "File to output neighbors into.", "n", "");
 
-PARAM_INT_REQ("k", "Number of nearest neighbors to find.", "k");
+PARAM_INT("k", "Number of nearest neighbors to find.", "k", 0);
 
 PARAM_STRING("query_file", "File containing query points (optional).", "q", "");
 
@@ -65,6 +75,10 @@ PARAM_INT("bucket_size", "The size of a bucket in the second level hash.", "B",
     500);
 PARAM_INT("seed", "Random seed.  If 0, 'std::time(NULL)' is used.", "s", 0);
 
+// Model loading/saving.
+PARAM_STRING("input_model", "File containing a saved LSH model.", "i", "");
+PARAM_STRING("output_model", "File to save the LSH model to.", "m", "");
+
 int main(int argc, char *argv[])
 {
   // Give CLI the command line parameters the user passed in.
@@ -76,79 +90,135 @@ int main(int argc, char *argv[])
     math::RandomSeed((size_t) time(NULL));
 
   // Get all the parameters.
-  string referenceFile = CLI::GetParam<string>("reference_file");
-  string distancesFile = CLI::GetParam<string>("distances_file");
-  string neighborsFile = CLI::GetParam<string>("neighbors_file");
+  const string referenceFile = CLI::GetParam<string>("reference_file");
+  const string distancesFile = CLI::GetParam<string>("distances_file");
+  const string neighborsFile = CLI::GetParam<string>("neighbors_file");
+  const string inputModelFile = CLI::GetParam<string>("input_model");
+  const string outputModelFile = CLI::GetParam<string>("output_model");
+
+  if (referenceFile == "" && inputModelFile == "")
+    Log::Fatal << "Either a reference set must be specified with "
+        << "--reference_file or a model must be loaded with --input_model!"
+        << endl;
+
+  if (CLI::GetParam<int>("k") < 0)
+    Log::Fatal << "Invalid k: " << CLI::GetParam<int>("k") << "; must be "
+        << "greater than 0." << endl;
+  const size_t k = (size_t) CLI::GetParam<int>("k");
+
+  if (k == 0 && outputModelFile == "")
+    Log::Warn << "Neither --k nor --output_model is specified; no neighbors "
+        << "will be computed and the model will not be saved." << endl;
+
+  if (k == 0 && (distancesFile != "" || neighborsFile != ""))
+    Log::Warn << "--k is not specified, so --distances_file and "
+        << "--neighbors_file will be ignored." << endl;
 
-  size_t k = CLI::GetParam<int>("k");
   size_t secondHashSize = CLI::GetParam<int>("second_hash_size");
   size_t bucketSize = CLI::GetParam<int>("bucket_size");
 
-  arma::mat referenceData;
-  arma::mat queryData; // So it doesn't go out of scope.
-  data::Load(referenceFile, referenceData, true);
-
-  Log::Info << "Loaded reference data from '" << referenceFile << "' ("
-      << referenceData.n_rows << " x " << referenceData.n_cols << ")." << endl;
-
-  // Sanity check on k value: must be greater than 0, must be less than the
-  // number of reference points.
-  if (k > referenceData.n_cols)
-  {
-    Log::Fatal << "Invalid k: " << k << "; must be greater than 0 and less ";
-    Log::Fatal << "than or equal to the number of reference points (";
-    Log::Fatal << referenceData.n_cols << ")." << endl;
-  }
-
   // Pick up the LSH-specific parameters.
   const size_t numProj = CLI::GetParam<int>("projections");
   const size_t numTables = CLI::GetParam<int>("tables");
   const double hashWidth = CLI::GetParam<double>("hash_width");
 
-  arma::Mat<size_t> neighbors;
-  arma::mat distances;
-
-  if (CLI::GetParam<string>("query_file") != "")
+  arma::mat referenceData;
+  if (referenceFile != "")
   {
-    string queryFile = CLI::GetParam<string>("query_file");
+    data::Load(referenceFile, referenceData, true);
 
-    data::Load(queryFile, queryData, true);
-    Log::Info << "Loaded query data from '" << queryFile << "' ("
-              << queryData.n_rows << " x " << queryData.n_cols << ")." << endl;
+    Log::Info << "Loaded reference data from '" << referenceFile << "' ("
+        << referenceData.n_rows << " x " << referenceData.n_cols << ")."
+        << endl;
   }
 
-  if (hashWidth == 0.0)
-    Log::Info << "Using LSH with " << numProj << " projections (K) and " <<
-        numTables << " tables (L) with default hash width." << endl;
-  else
-    Log::Info << "Using LSH with " << numProj << " projections (K) and " <<
-        numTables << " tables (L) with hash width(r): " << hashWidth << endl;
-
-  Timer::Start("hash_building");
-
-  LSHSearch<>* allkann;
+  LSHSearch<> allkann;
 
-  if (CLI::GetParam<string>("query_file") != "")
-    allkann = new LSHSearch<>(referenceData, queryData, numProj, numTables,
-                              hashWidth, secondHashSize, bucketSize);
+  if (inputModelFile != "")
+  {
+    Log::Info << "Loading LSH model from '" << inputModelFile << "'." << endl;
+    data::Load(inputModelFile, "lsh_model", allkann, true);
+
+    // Add any new reference points to the loaded model.
+    if (referenceFile != "")
+    {
+      Log::Info << "Adding " << referenceData.n_cols << " points to the "
+          << "model." << endl;
+
+      if (referenceData.n_rows != allkann.ReferenceSet().n_rows)
+        Log::Fatal << "Dimensionality of reference set (" << referenceData.n_rows
+            << ") does not match the dimensionality of the model ("
+            << allkann.ReferenceSet().n_rows << ")!" << endl;
+
+      Timer::Start("hash_building");
+      allkann.Insert(referenceData);
+      Timer::Stop("hash_building");
+    }
+  }
   else
-    allkann = new LSHSearch<>(referenceData, numProj, numTables, hashWidth,
-                              secondHashSize, bucketSize);
-
-  Timer::Stop("hash_building");
-
-  Log::Info << "Computing " << k << " distance approximate nearest neighbors "
-      << endl;
-  allkann->Search(k, neighbors, distances);
-
-  Log::Info << "Neighbors computed." << endl;
-
-  // Save output.
-  if (distancesFile != "")
-    data::Save(distancesFile, distances);
+  {
+    if (hashWidth == 0.0)
+      Log::Info << "Using LSH with " << numProj << " projections (K) and " <<
+          numTables << " tables (L) with default hash width." << endl;
+    else
+      Log::Info << "Using LSH with " << numProj << " projections (K) and " <<
+          numTables << " tables (L) with hash width(r): " << hashWidth << endl;
+
+    Timer::Start("hash_building");
+    allkann.Train(referenceData, numProj, numTables, hashWidth, secondHashSize,
+        bucketSize);
+    Timer::Stop("hash_building");
+  }
 
-  if (neighborsFile != "")
-    data::Save(neighborsFile, neighbors);
+  if (k > 0)
+  {
+    // Sanity check on k value: must be less than the number of reference
+    // points.
+    if (k > allkann.ReferenceSet().n_cols)
+    {
+      Log::Fatal << "Invalid k: " << k << "; must be greater than 0 and less ";
+      Log::Fatal << "than or equal to the number of reference points (";
+      Log::Fatal << allkann.ReferenceSet().n_cols << ")." << endl;
+    }
+
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+
+    Log::Info << "Computing " << k << " distance approximate nearest neighbors "
+        << endl;
+    if (CLI::GetParam<string>("query_file") != "")
+    {
+      const string queryFile = CLI::GetParam<string>("query_file");
+
+      arma::mat queryData;
+      data::Load(queryFile, queryData, true);
+      Log::Info << "Loaded query data from '" << queryFile << "' ("
+                << queryData.n_rows << " x " << queryData.n_cols << ")."
+                << endl;
+
+      if (queryData.n_rows != allkann.ReferenceSet().n_rows)
+        Log::Fatal << "Dimensionality of query set (" << queryData.n_rows
+            << ") does not match the dimensionality of the reference set ("
+            << allkann.ReferenceSet().n_rows << ")!" << endl;
+
+      allkann.Search(queryData, k, neighbors, distances);
+    }
+    else
+    {
+      allkann.Search(k, neighbors, distances);
+    }
+
+    Log::Info << "Neighbors computed." << endl;
+
+    // Save output.
+    if (distancesFile != "")
+      data::Save(distancesFile, distances);
+
+    if (neighborsFile != "")
+      data::Save(neighborsFile, neighbors);
+  }
 
-  delete allkann;
+  // Save the model, if requested.
+  if (outputModelFile != "")
+    data::Save(outputModelFile, "lsh_model", allkann);
 }
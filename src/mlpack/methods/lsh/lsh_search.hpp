@@ -47,7 +47,12 @@ class LSHSearch
   /**
    * This function initializes the LSH class. It builds the hash on the
    * reference set with 2-stable distributions. See the individual functions
-   * performing the hashing for details on how the hashing is done.
+   * performing the hashing for details on how the hashing is done.  The query
+   * set is the one searched by Search(k, ...); it may also be passed to
+   * Search() directly, with the other constructor.
+   *
+   * Neither set is copied, so both must stay valid for the lifetime of this
+   * object.
    *
    * @param referenceSet Set of reference points.
    * @param querySet Set of query points.
@@ -78,7 +83,11 @@ class LSHSearch
    * reference set with 2-stable distributions. See the individual functions
    * performing the hashing for details on how the hashing is done.
    *
-   * @param referenceSet Set of reference points and the set of queries.
+   * The reference set is not copied, so it must stay valid for the lifetime of
+   * this object (unless points are added with Insert(), in which case an
+   * internal copy is made).
+   *
+   * @param referenceSet Set of reference points.
    * @param numProj Number of projections in each hash table (anything between
    *     10-50 might be a decent choice).
    * @param numTables Total number of hash tables (anything between 10-20
@@ -101,11 +110,62 @@ class LSHSearch
             const size_t bucketSize = 500);
 
   /**
-   * Compute the nearest neighbors and store the output in the given matrices.
-   * The matrices will be set to the size of n columns by k rows, where n is
-   * the number of points in the query dataset and k is the number of neighbors
-   * being searched for.
+   * Create an LSHSearch object without any reference data.  This is useful
+   * when a model is about to be loaded with Serialize().  If Search() or
+   * Insert() is called before the object is trained with Train(), an exception
+   * will be thrown.
+   */
+  LSHSearch();
+
+  /**
+   * Clean memory; this deletes the reference set if we own it.
+   */
+  ~LSHSearch();
+
+  /**
+   * Train the LSH model on the given dataset.  This builds new hash tables
+   * from scratch, replacing any existing hash tables.  The parameters are the
+   * same as for the constructor.
+   *
+   * @param referenceSet Set of reference points.
+   * @param numProj Number of projections in each hash table.
+   * @param numTables Total number of hash tables.
+   * @param hashWidth The width of hash for every table (0 for automatic).
+   * @param secondHashSize The size of the second hash table.
+   * @param bucketSize The size of the bucket in the second hash table.
+   */
+  void Train(const arma::mat& referenceSet,
+             const size_t numProj,
+             const size_t numTables,
+             const double hashWidth = 0.0,
+             const size_t secondHashSize = 99901,
+             const size_t bucketSize = 500);
+
+  /**
+   * Add the given points to the reference set, and hash them into the existing
+   * hash tables.  The projections, offsets and hash width are not changed, so
+   * the model behaves as though the new points had been part of the reference
+   * set from the start (except that buckets which are already full will not
+   * take any new points).  The new points receive the indices following the
+   * last point of the current reference set.
+   *
+   * The first time this is called on a model that does not own its reference
+   * set, the reference set is copied.
+   *
+   * @param newPoints Points to add to the reference set.
+   */
+  void Insert(const arma::mat& newPoints);
+
+  /**
+   * Compute the nearest neighbors of the points in the given query set and
+   * store the output in the given matrices.  The matrices will be set to the
+   * size of n columns by k rows, where n is the number of points in the query
+   * dataset and k is the number of neighbors being searched for.
+   *
+   * If OpenMP is available, the queries are processed in parallel; each
+   * thread gathers and evaluates the candidates of its own queries.
    *
+   * @param querySet Set of query points.
    * @param k Number of neighbors to search for.
    * @param resultingNeighbors Matrix storing lists of neighbors for each query
    *     point.
@@ -118,6 +178,28 @@ class LSHSearch
    *     By default, this is set to zero in which case all tables are
    *     considered.
    */
+  void Search(const arma::mat& querySet,
+              const size_t k,
+              arma::Mat<size_t>& resultingNeighbors,
+              arma::mat& distances,
+              const size_t numTablesToSearch = 0);
+
+  /**
+   * Compute the nearest neighbors of every point in the query set given to the
+   * constructor, or, if no query set was given, of every point in the
+   * reference set (a point is then never returned as its own neighbor), and
+   * store the output in the given matrices.  The matrices will be set to the
+   * size of n columns by k rows, where n is the number of query points and k
+   * is the number of neighbors being searched for.
+   *
+   * @param k Number of neighbors to search for.
+   * @param resultingNeighbors Matrix storing lists of neighbors for each query
+   *     point.
+   * @param distances Matrix storing distances of neighbors for each query
+   *     point.
+   * @param numTablesToSearch The number of hash tables to search; 0 (the
+   *     default) means that all tables are searched.
+   */
   void Search(const size_t k,
               arma::Mat<size_t>& resultingNeighbors,
               arma::mat& distances,
@@ -131,6 +213,32 @@ class LSHSearch
   //! Modify the number of distance evaluations performed.
   size_t& DistanceEvaluations() { return distanceEvaluations; }
 
+  //! Return the reference dataset.
+  const arma::mat& ReferenceSet() const { return *referenceSet; }
+
+  //! Get the number of projections.
+  size_t NumProjections() const { return numProj; }
+  //! Get the number of hash tables.
+  size_t NumTables() const { return numTables; }
+  //! Get the hash width.
+  double HashWidth() const { return hashWidth; }
+
+  //! Get the offsets 'b' for each of the projections.
+  const arma::mat& Offsets() const { return offsets; }
+  //! Get the projection matrix of the given table.
+  const arma::mat& Projection(const size_t i) const { return projections[i]; }
+
+  //! Get the weights of the second hash.
+  const arma::vec& SecondHashWeights() const { return secondHashWeights; }
+  //! Get the bucket size of the second hash.
+  size_t BucketSize() const { return bucketSize; }
+  //! Get the second hash table.
+  const arma::Mat<size_t>& SecondHashTable() const { return secondHashTable; }
+
+  //! Serialize the LSH model.
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */);
+
  private:
   /**
    * This function builds a hash table with two levels of hashing as presented
@@ -148,33 +256,62 @@ class LSHSearch
   void BuildHash();
 
   /**
-   * This function takes a query and hashes it into each of the hash tables to
-   * get keys for the query and then the key is hashed to a bucket of the second
-   * hash table and all the points (if any) in those buckets are collected as
-   * the potential neighbor candidates.
+   * Insert points into the buckets of the second hash table, growing the table
+   * if necessary.  Points are not inserted into buckets that are already full.
+   *
+   * @param hashes The bucket index of each point in each table, as computed by
+   *    ComputeHashes().
+   * @param firstIndex The index of the first point (the points have
+   *    consecutive indices).
+   */
+  void InsertIntoTable(const arma::Mat<size_t>& hashes,
+                       const size_t firstIndex);
+
+  /**
+   * Compute the second-level hash (the bucket index) of every given point in
+   * each of the first 'numTablesToSearch' hash tables.  For each table, all of
+   * the points are projected with a single matrix multiplication, so this is
+   * much faster than hashing the points one at a time.
+   *
+   * @param points The points to hash.
+   * @param numTablesToSearch The number of tables to compute hashes for.
+   * @param hashes Matrix to store the bucket indices in; this will be set to
+   *    size numTablesToSearch x points.n_cols.
+   */
+  void ComputeHashes(const arma::mat& points,
+                     const size_t numTablesToSearch,
+                     arma::Mat<size_t>& hashes) const;
+
+  /**
+   * This function takes the bucket indices of a query in each of the hash
+   * tables (as computed by ComputeHashes()), and collects all the points (if
+   * any) in those buckets as the potential neighbor candidates.  Each
+   * candidate is returned only once, in increasing order of index.
    *
-   * @param queryIndex The index of the query currently being processed.
+   * @param queryHashes The bucket index of the query in each table that is to
+   *    be searched.
    * @param referenceIndices The list of neighbor candidates obtained from
    *    hashing the query into all the hash tables and eventually into
    *    multiple buckets of the second hash table.
    */
-  void ReturnIndicesFromTable(const size_t queryIndex,
-                              arma::uvec& referenceIndices,
-                              size_t numTablesToSearch);
+  void ReturnIndicesFromTable(const arma::Col<size_t>& queryHashes,
+                              std::vector<size_t>& referenceIndices) const;
 
   /**
    * This is a helper function that computes the distance of the query to the
    * neighbor candidates and appropriately stores the best 'k' candidates
    *
+   * @param querySet The set of query points.
    * @param distances Matrix holding output distances.
    * @param neighbors Matrix holding output neighbors.
    * @param queryIndex The index of the query in question
    * @param referenceIndex The index of the neighbor candidate in question
    */
-  double BaseCase(arma::mat& distances,
+  double BaseCase(const arma::mat& querySet,
+                  arma::mat& distances,
                   arma::Mat<size_t>& neighbors,
                   const size_t queryIndex,
-                  const size_t referenceIndex);
+                  const size_t referenceIndex) const;
 
   /**
    * This is a helper function that efficiently inserts better neighbor
@@ -195,17 +332,19 @@ class LSHSearch
                       const size_t queryIndex,
                       const size_t pos,
                       const size_t neighbor,
-                      const double distance);
+                      const double distance) const;
 
-  //! Reference dataset.
-  const arma::mat& referenceSet;
-  //! Query dataset (may not be given).
-  const arma::mat& querySet;
+  //! Reference dataset.  In some situations we may be the owner of this.
+  const arma::mat* referenceSet;
+  //! If true, we own the reference set.
+  bool ownsSet;
+  //! Query dataset given to the constructor (NULL if none was given).
+  const arma::mat* querySet;
 
   //! The number of projections.
-  const size_t numProj;
+  size_t numProj;
   //! The number of hash tables.
-  const size_t numTables;
+  size_t numTables;
 
   //! The std::vector containing the projection matrix of each table.
   std::vector<arma::mat> projections; // should be [numProj x dims] x numTables
@@ -217,13 +356,13 @@ class LSHSearch
   double hashWidth;
 
   //! The big prime representing the size of the second hash.
-  const size_t secondHashSize;
+  size_t secondHashSize;
 
   //! The weights of the second hash.
   arma::vec secondHashWeights;
 
   //! The bucket size of the second hash.
-  const size_t bucketSize;
+  size_t bucketSize;
 
   //! The final hash table; should be (< secondHashSize) x bucketSize.
   arma::Mat<size_t> secondHashTable;
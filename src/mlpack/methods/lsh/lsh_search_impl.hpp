@@ -9,65 +9,104 @@
 
 #include <mlpack/core.hpp>
 
+#include <algorithm>
+
 namespace mlpack {
 namespace neighbor {
 
-// Construct the object.
+// Construct the object with a query set.
 template<typename SortPolicy>
 LSHSearch<SortPolicy>::
 LSHSearch(const arma::mat& referenceSet,
           const arma::mat& querySet,
           const size_t numProj,
           const size_t numTables,
-          const double hashWidthIn,
+          const double hashWidth,
           const size_t secondHashSize,
           const size_t bucketSize) :
-  referenceSet(referenceSet),
-  querySet(querySet),
+  referenceSet(NULL), // This will be set in Train().
+  ownsSet(false),
+  querySet(&querySet),
   numProj(numProj),
   numTables(numTables),
-  hashWidth(hashWidthIn),
+  hashWidth(hashWidth),
   secondHashSize(secondHashSize),
   bucketSize(bucketSize),
   distanceEvaluations(0)
 {
-  if (hashWidth == 0.0) // The user has not provided any value.
-  {
-    // Compute a heuristic hash width from the data.
-    for (size_t i = 0; i < 25; i++)
-    {
-      size_t p1 = (size_t) math::RandInt(referenceSet.n_cols);
-      size_t p2 = (size_t) math::RandInt(referenceSet.n_cols);
-
-      hashWidth += std::sqrt(metric::EuclideanDistance::Evaluate(
-          referenceSet.unsafe_col(p1), referenceSet.unsafe_col(p2)));
-    }
-
-    hashWidth /= 25;
-  }
-
-  Log::Info << "Hash width chosen as: " << hashWidth << std::endl;
-
-  BuildHash();
+  Train(referenceSet, numProj, numTables, hashWidth, secondHashSize,
+      bucketSize);
 }
 
+// Construct the object.
 template<typename SortPolicy>
 LSHSearch<SortPolicy>::
 LSHSearch(const arma::mat& referenceSet,
           const size_t numProj,
           const size_t numTables,
-          const double hashWidthIn,
+          const double hashWidth,
           const size_t secondHashSize,
           const size_t bucketSize) :
-  referenceSet(referenceSet),
-  querySet(referenceSet),
+  referenceSet(NULL), // This will be set in Train().
+  ownsSet(false),
+  querySet(NULL),
   numProj(numProj),
   numTables(numTables),
-  hashWidth(hashWidthIn),
+  hashWidth(hashWidth),
   secondHashSize(secondHashSize),
   bucketSize(bucketSize),
   distanceEvaluations(0)
 {
+  Train(referenceSet, numProj, numTables, hashWidth, secondHashSize,
+      bucketSize);
+}
+
+// Construct the object with no reference set.
+template<typename SortPolicy>
+LSHSearch<SortPolicy>::LSHSearch() :
+  referenceSet(new arma::mat()), // Empty matrix.
+  ownsSet(true),
+  querySet(NULL),
+  numProj(0),
+  numTables(0),
+  hashWidth(0),
+  secondHashSize(99901),
+  bucketSize(500),
+  distanceEvaluations(0)
+{
+  // Nothing to do.
+}
+
+// Clean memory.
+template<typename SortPolicy>
+LSHSearch<SortPolicy>::~LSHSearch()
+{
+  if (ownsSet)
+    delete referenceSet;
+}
+
+// Train on a new reference set.
+template<typename SortPolicy>
+void LSHSearch<SortPolicy>::Train(const arma::mat& referenceSet,
+                                  const size_t numProj,
+                                  const size_t numTables,
+                                  const double hashWidthIn,
+                                  const size_t secondHashSize,
+                                  const size_t bucketSize)
+{
+  // Set new reference set.
+  if (this->referenceSet && ownsSet)
+    delete this->referenceSet;
+  this->referenceSet = &referenceSet;
+  this->ownsSet = false;
+
+  // Set new parameters.
+  this->numProj = numProj;
+  this->numTables = numTables;
+  this->secondHashSize = secondHashSize;
+  this->bucketSize = bucketSize;
+  this->hashWidth = hashWidthIn;
+
   if (hashWidth == 0.0) // The user has not provided any value.
   {
     // Compute a heuristic hash width from the data.
@@ -88,13 +127,50 @@ LSHSearch(const arma::mat& referenceSet,
   BuildHash();
 }
 
+// Add new points to the reference set and the hash tables.
+template<typename SortPolicy>
+void LSHSearch<SortPolicy>::Insert(const arma::mat& newPoints)
+{
+  if (projections.size() == 0)
+    throw std::invalid_argument("LSHSearch::Insert(): cannot insert points "
+        "into a model that has not been trained");
+
+  if (newPoints.n_rows != referenceSet->n_rows)
+  {
+    std::ostringstream oss;
+    oss << "LSHSearch::Insert(): dimensionality of new points ("
+        << newPoints.n_rows << ") does not match the dimensionality of the "
+        << "reference set (" << referenceSet->n_rows << ")";
+    throw std::invalid_argument(oss.str());
+  }
+
+  if (newPoints.n_cols == 0)
+    return;
+
+  // Hash the new points with the existing projections.  This must be done
+  // before the reference set is replaced, in case 'newPoints' aliases it.
+  arma::Mat<size_t> newHashes;
+  ComputeHashes(newPoints, numTables, newHashes);
+
+  // Append the points to the reference set.  We will own the new set.
+  const size_t firstIndex = referenceSet->n_cols;
+  arma::mat* newReferenceSet = new arma::mat(arma::join_rows(*referenceSet,
+      newPoints));
+  if (ownsSet)
+    delete referenceSet;
+  referenceSet = newReferenceSet;
+  ownsSet = true;
+
+  InsertIntoTable(newHashes, firstIndex);
+}
+
 template<typename SortPolicy>
 void LSHSearch<SortPolicy>::InsertNeighbor(arma::mat& distances,
                                            arma::Mat<size_t>& neighbors,
                                            const size_t queryIndex,
                                            const size_t pos,
                                            const size_t neighbor,
-                                           const double distance)
+                                           const double distance) const
 {
   // We only memmove() if there is actually a need to shift something.
   if (pos < (distances.n_rows - 1))
@@ -115,18 +191,20 @@ void LSHSearch<SortPolicy>::InsertNeighbor(arma::mat& distances,
 
 template<typename SortPolicy>
 inline force_inline
-double LSHSearch<SortPolicy>::BaseCase(arma::mat& distances,
+double LSHSearch<SortPolicy>::BaseCase(const arma::mat& querySet,
+                                       arma::mat& distances,
                                        arma::Mat<size_t>& neighbors,
                                        const size_t queryIndex,
-                                       const size_t referenceIndex)
+                                       const size_t referenceIndex) const
 {
   // If the datasets are the same, then this search is only using one dataset
   // and we should not return identical points.
-  if ((&querySet == &referenceSet) && (queryIndex == referenceIndex))
+  if ((&querySet == referenceSet) && (queryIndex == referenceIndex))
     return 0.0;
 
   const double distance = metric::EuclideanDistance::Evaluate(
-      querySet.unsafe_col(queryIndex), referenceSet.unsafe_col(referenceIndex));
+      querySet.unsafe_col(queryIndex),
+      referenceSet->unsafe_col(referenceIndex));
 
   // If this distance is better than any of the current candidates, the
   // SortDistance() function will give us the position to insert it into.
@@ -144,102 +222,132 @@ double LSHSearch<SortPolicy>::BaseCase(arma::mat& distances,
 }
 
 template<typename SortPolicy>
-void LSHSearch<SortPolicy>::
-ReturnIndicesFromTable(const size_t queryIndex,
-                       arma::uvec& referenceIndices,
-                       size_t numTablesToSearch)
+void LSHSearch<SortPolicy>::ComputeHashes(const arma::mat& points,
+                                          const size_t numTablesToSearch,
+                                          arma::Mat<size_t>& hashes) const
 {
-  // Decide on the number of tables to look into.
-  if (numTablesToSearch == 0) // If no user input is given, search all.
-    numTablesToSearch = numTables;
+  hashes.set_size(numTablesToSearch, points.n_cols);
 
-  // Sanity check to make sure that the existing number of tables is not
-  // exceeded.
-  if (numTablesToSearch > numTables)
-    numTablesToSearch = numTables;
-
-  // Hash the query in each of the 'numTablesToSearch' hash tables using the
-  // 'numProj' projections for each table. This gives us 'numTablesToSearch'
-  // keys for the query where each key is a 'numProj' dimensional integer
-  // vector.
-
-  // Compute the projection of the query in each table.
-  arma::mat allProjInTables(numProj, numTablesToSearch);
   for (size_t i = 0; i < numTablesToSearch; i++)
   {
-    allProjInTables.unsafe_col(i) = projections[i].t() *
-        querySet.unsafe_col(queryIndex);
-  }
-  allProjInTables += offsets.cols(0, numTablesToSearch - 1);
-  allProjInTables /= hashWidth;
+    // For a single table, let the 'numProj' projections be denoted by 'proj_i'
+    // and the corresponding offset be 'offset_i'.  Then the key of a single
+    // point is obtained as:
+    // key = { floor( (<proj_i, point> + offset_i) / 'hashWidth' ) forall i }
+    //
+    // The keys of all the points are obtained with one matrix multiplication.
+    arma::mat hashMat = projections[i].t() * points;
+    hashMat.each_col() += offsets.unsafe_col(i);
+    hashMat /= hashWidth;
 
-  // Compute the hash value of each key of the query into a bucket of the
-  // 'secondHashTable' using the 'secondHashWeights'.
-  arma::rowvec hashVec = secondHashWeights.t() * arma::floor(allProjInTables);
+    // Now hash every key into its bucket in the 'secondHashTable' using the
+    // 'secondHashWeights'.
+    const arma::rowvec secondHashVec = secondHashWeights.t() *
+        arma::floor(hashMat);
 
-  for (size_t i = 0; i < hashVec.n_elem; i++)
-    hashVec[i] = (double) ((size_t) hashVec[i] % secondHashSize);
+    for (size_t j = 0; j < secondHashVec.n_elem; j++)
+      hashes(i, j) = (size_t) secondHashVec[j] % secondHashSize;
+  }
+}
 
-  Log::Assert(hashVec.n_elem == numTablesToSearch);
+template<typename SortPolicy>
+void LSHSearch<SortPolicy>::
+ReturnIndicesFromTable(const arma::Col<size_t>& queryHashes,
+                       std::vector<size_t>& referenceIndices) const
+{
+  referenceIndices.clear();
 
   // For all the buckets that the query is hashed into, sequentially
   // collect the indices in those buckets.
-  arma::Col<size_t> refPointsConsidered;
-  refPointsConsidered.zeros(referenceSet.n_cols);
-
-  for (size_t i = 0; i < hashVec.n_elem; i++) // For all tables.
+  for (size_t i = 0; i < queryHashes.n_elem; i++) // For all tables.
   {
-    size_t hashInd = (size_t) hashVec[i];
+    const size_t hashInd = queryHashes[i];
 
     if (bucketContentSize[hashInd] > 0)
     {
       // Pick the indices in the bucket corresponding to 'hashInd'.
-      size_t tableRow = bucketRowInHashTable[hashInd];
+      const size_t tableRow = bucketRowInHashTable[hashInd];
       assert(tableRow < secondHashSize);
       assert(tableRow < secondHashTable.n_rows);
 
       for (size_t j = 0; j < bucketContentSize[hashInd]; j++)
-        refPointsConsidered[secondHashTable(tableRow, j)]++;
+        referenceIndices.push_back(secondHashTable(tableRow, j));
     }
   }
 
-  referenceIndices = arma::find(refPointsConsidered > 0);
+  // A point may lie in the query's bucket in more than one table, so remove
+  // the duplicates.  This only touches the candidates themselves, not the
+  // whole reference set.
+  std::sort(referenceIndices.begin(), referenceIndices.end());
+  referenceIndices.erase(std::unique(referenceIndices.begin(),
+      referenceIndices.end()), referenceIndices.end());
 }
 
-
 template<typename SortPolicy>
 void LSHSearch<SortPolicy>::
-Search(const size_t k,
+Search(const arma::mat& querySet,
+       const size_t k,
        arma::Mat<size_t>& resultingNeighbors,
        arma::mat& distances,
-       const size_t numTablesToSearch)
+       const size_t numTablesToSearchIn)
 {
+  if (projections.size() == 0)
+    throw std::invalid_argument("LSHSearch::Search(): cannot search with a "
+        "model that has not been trained");
+
+  if (querySet.n_rows != referenceSet->n_rows)
+  {
+    std::ostringstream oss;
+    oss << "LSHSearch::Search(): dimensionality of query set ("
+        << querySet.n_rows << ") is not equal to the dimensionality of the "
+        << "reference set (" << referenceSet->n_rows << ")";
+    throw std::invalid_argument(oss.str());
+  }
+
+  // Decide on the number of tables to look into.  If no user input is given,
+  // search all; also make sure that the existing number of tables is not
+  // exceeded.
+  size_t numTablesToSearch = numTablesToSearchIn;
+  if (numTablesToSearch == 0 || numTablesToSearch > numTables)
+    numTablesToSearch = numTables;
+
   // Set the size of the neighbor and distance matrices.
   resultingNeighbors.set_size(k, querySet.n_cols);
   distances.set_size(k, querySet.n_cols);
   distances.fill(SortPolicy::WorstDistance());
-  resultingNeighbors.fill(referenceSet.n_cols);
+  resultingNeighbors.fill(referenceSet->n_cols);
 
   size_t avgIndicesReturned = 0;
 
   Timer::Start("computing_neighbors");
 
-  // Go through every query point sequentially.
-  for (size_t i = 0; i < querySet.n_cols; i++)
+  // Hash every query into every hash table and eventually into the
+  // 'secondHashTable'.  This is done for all of the queries at once.
+  arma::Mat<size_t> queryHashes;
+  ComputeHashes(querySet, numTablesToSearch, queryHashes);
+
+  // Now obtain the neighbor candidates of each query and evaluate them.  Each
+  // query only writes to its own column of the results, so the queries can be
+  // processed in parallel.
+  #pragma omp parallel reduction(+:avgIndicesReturned)
   {
-    // Hash every query into every hash table and eventually into the
-    // 'secondHashTable' to obtain the neighbor candidates.
-    arma::uvec refIndices;
-    ReturnIndicesFromTable(i, refIndices, numTablesToSearch);
-
-    // An informative book-keeping for the number of neighbor candidates
-    // returned on average.
-    avgIndicesReturned += refIndices.n_elem;
-
-    // Sequentially go through all the candidates and save the best 'k'
-    // candidates.
-    for (size_t j = 0; j < refIndices.n_elem; j++)
-      BaseCase(distances, resultingNeighbors, i, (size_t) refIndices[j]);
+    // Each thread keeps its own candidate list.
+    std::vector<size_t> refIndices;
+
+    #pragma omp for schedule(dynamic, 16)
+    for (size_t i = 0; i < querySet.n_cols; i++)
+    {
+      ReturnIndicesFromTable(queryHashes.unsafe_col(i), refIndices);
+
+      // An informative book-keeping for the number of neighbor candidates
+      // returned on average.
+      avgIndicesReturned += refIndices.size();
+
+      // Sequentially go through all the candidates and save the best 'k'
+      // candidates.
+      for (size_t j = 0; j < refIndices.size(); j++)
+        BaseCase(querySet, distances, resultingNeighbors, i, refIndices[j]);
+    }
   }
 
   Timer::Stop("computing_neighbors");
@@ -250,6 +358,19 @@ Search(const size_t k,
       std::endl;
 }
 
+template<typename SortPolicy>
+void LSHSearch<SortPolicy>::
+Search(const size_t k,
+       arma::Mat<size_t>& resultingNeighbors,
+       arma::mat& distances,
+       const size_t numTablesToSearch)
+{
+  // BaseCase() recognizes that the query set is the reference set and will not
+  // return a point as its own neighbor.
+  Search((querySet == NULL) ? *referenceSet : *querySet, k,
+      resultingNeighbors, distances, numTablesToSearch);
+}
+
 template<typename SortPolicy>
 void LSHSearch<SortPolicy>::BuildHash()
 {
@@ -274,16 +395,9 @@ void LSHSearch<SortPolicy>::BuildHash()
   secondHashWeights = arma::floor(arma::randu(numProj) *
                                   (double) secondHashSize);
 
-  // The 'secondHashTable' is initially an empty matrix of size
-  // ('secondHashSize' x 'bucketSize'). But by only filling the buckets
-  // as points land in them allows us to shrink the size of the
-  // 'secondHashTable' at the end of the hashing.
-
-  // Fill the second hash table n = referenceSet.n_cols.  This is because no
-  // point has index 'n' so the presence of this in the bucket denotes that
-  // there are no more points in this bucket.
-  secondHashTable.set_size(secondHashSize, bucketSize);
-  secondHashTable.fill(referenceSet.n_cols);
+  // The 'secondHashTable' is initially an empty matrix; rows are added only as
+  // points land in new buckets, so that only the non-empty buckets are stored.
+  secondHashTable.reset();
 
   // Keep track of the size of each bucket in the hash.  At the end of hashing
   // most buckets will be empty.
@@ -296,64 +410,72 @@ void LSHSearch<SortPolicy>::BuildHash()
   bucketRowInHashTable.set_size(secondHashSize);
   bucketRowInHashTable.fill(secondHashSize);
 
-  // Keep track of number of non-empty rows in the 'secondHashTable'.
-  size_t numRowsInTable = 0;
-
   // Step II: The offsets for all projections in all tables.
   // Since the 'offsets' are in [0, hashWidth], we obtain the 'offsets'
   // as randu(numProj, numTables) * hashWidth.
   offsets.randu(numProj, numTables);
   offsets *= hashWidth;
 
-  // Step III: Create each hash table in the first level hash one by one and
-  // putting them directly into the 'secondHashTable' for memory efficiency.
+  // Step III: Obtain the 'numProj' projections for each table.
+  // For L2 metric, 2-stable distributions are used, and the normal Z ~ N(0, 1)
+  // is a 2-stable distribution.
+  projections.clear();
   for (size_t i = 0; i < numTables; i++)
   {
-    // Step IV: Obtain the 'numProj' projections for each table.
-
-    // For L2 metric, 2-stable distributions are used, and
-    // the normal Z ~ N(0, 1) is a 2-stable distribution.
     arma::mat projMat;
-    projMat.randn(referenceSet.n_rows, numProj);
+    projMat.randn(referenceSet->n_rows, numProj);
 
     // Save the projection matrix for querying.
     projections.push_back(projMat);
+  }
 
-    // Step V: create the 'numProj'-dimensional key for each point in each
-    // table.
+  // Step IV: Create the 'numProj'-dimensional key for each point in each table
+  // and hash that key into the 'secondHashTable'.  This gives us the bucket of
+  // each point in each table.
+  arma::Mat<size_t> referenceHashes;
+  ComputeHashes(*referenceSet, numTables, referenceHashes);
 
-    // The following code performs the task of hashing each point to a
-    // 'numProj'-dimensional integer key.  Hence you get a ('numProj' x
-    // 'referenceSet.n_cols') key matrix.
-    //
-    // For a single table, let the 'numProj' projections be denoted by 'proj_i'
-    // and the corresponding offset be 'offset_i'.  Then the key of a single
-    // point is obtained as:
-    // key = { floor( (<proj_i, point> + offset_i) / 'hashWidth' ) forall i }
-    arma::mat offsetMat = arma::repmat(offsets.unsafe_col(i), 1,
-                                       referenceSet.n_cols);
-    arma::mat hashMat = projMat.t() * referenceSet;
-    hashMat += offsetMat;
-    hashMat /= hashWidth;
+  // Step V: Insert each point into the 'secondHashTable'.
+  InsertIntoTable(referenceHashes, 0);
 
-    // Step VI: Putting the points in the 'secondHashTable' by hashing the key.
-    // Now we hash every key, point ID to its corresponding bucket.
-    arma::rowvec secondHashVec = secondHashWeights.t()
-      * arma::floor(hashMat);
+  Log::Info << "Final hash table size: (" << secondHashTable.n_rows << " x "
+            << secondHashTable.n_cols << ")" << std::endl;
+}
 
-    // This gives us the bucket for the corresponding point ID.
-    for (size_t j = 0; j < secondHashVec.n_elem; j++)
-      secondHashVec[j] = (double)((size_t) secondHashVec[j] % secondHashSize);
+template<typename SortPolicy>
+void LSHSearch<SortPolicy>::InsertIntoTable(const arma::Mat<size_t>& hashes,
+                                            const size_t firstIndex)
+{
+  // First, find how large the 'secondHashTable' will need to be, so that we
+  // only need to resize it once.  New buckets get a new row, and the number of
+  // columns is the size of the largest bucket.
+  size_t numRowsInTable = secondHashTable.n_rows;
+  size_t maxBucketSize = secondHashTable.n_cols;
+  arma::Col<size_t> newContentSize(bucketContentSize);
+  size_t newRows = 0;
+  for (size_t i = 0; i < hashes.n_elem; i++)
+  {
+    const size_t hashInd = hashes[i];
+    if (newContentSize[hashInd] == 0)
+      newRows++;
+    if (newContentSize[hashInd] < bucketSize)
+      newContentSize[hashInd]++;
+    if (newContentSize[hashInd] > maxBucketSize)
+      maxBucketSize = newContentSize[hashInd];
+  }
 
-    Log::Assert(secondHashVec.n_elem == referenceSet.n_cols);
+  secondHashTable.resize(numRowsInTable + newRows, maxBucketSize);
 
-    // Insert the point in the corresponding row to its bucket in the
-    // 'secondHashTable'.
-    for (size_t j = 0; j < secondHashVec.n_elem; j++)
+  // Insert the point in the corresponding row to its bucket in the
+  // 'secondHashTable'.
+  for (size_t i = 0; i < hashes.n_rows; i++) // Loop over tables.
+  {
+    for (size_t j = 0; j < hashes.n_cols; j++)
     {
       // This is the bucket number.
-      size_t hashInd = (size_t) secondHashVec[j];
-      // The point ID is 'j'.
+      const size_t hashInd = hashes(i, j);
+      // This is the point ID.
+      const size_t pointInd = firstIndex + j;
 
       // If this is currently an empty bucket, start a new row keep track of
       // which row corresponds to the bucket.
@@ -361,7 +483,7 @@ void LSHSearch<SortPolicy>::BuildHash()
       {
         // Start a new row for hash.
         bucketRowInHashTable[hashInd] = numRowsInTable;
-        secondHashTable(numRowsInTable, 0) = j;
+        secondHashTable(numRowsInTable, 0) = pointInd;
 
         numRowsInTable++;
       }
@@ -373,24 +495,14 @@ void LSHSearch<SortPolicy>::BuildHash()
         // bucket is full, in which case, do nothing.
         if (bucketContentSize[hashInd] < bucketSize)
           secondHashTable(bucketRowInHashTable[hashInd],
-                          bucketContentSize[hashInd]) = j;
+                          bucketContentSize[hashInd]) = pointInd;
       }
 
       // Increment the count of the points in this bucket.
       if (bucketContentSize[hashInd] < bucketSize)
         bucketContentSize[hashInd]++;
-    } // Loop over all points in the reference set.
+    } // Loop over all points.
   } // Loop over tables.
-
-  // Step VII: Condensing the 'secondHashTable'.
-  size_t maxBucketSize = 0;
-  for (size_t i = 0; i < bucketContentSize.n_elem; i++)
-    if (bucketContentSize[i] > maxBucketSize)
-      maxBucketSize = bucketContentSize[i];
-
-  Log::Info << "Final hash table size: (" << numRowsInTable << " x "
-            << maxBucketSize << ")" << std::endl;
-  secondHashTable.resize(numRowsInTable, maxBucketSize);
 }
 
 template<typename SortPolicy>
@@ -398,17 +510,62 @@ std::string LSHSearch<SortPolicy>::ToString() const
 {
   std::ostringstream convert;
   convert << "LSHSearch [" << this << "]" << std::endl;
-  convert << "  Reference Set: " << referenceSet.n_rows << "x" ;
-  convert <<  referenceSet.n_cols << std::endl;
-  if (&referenceSet != &querySet)
-    convert << "  QuerySet: " << querySet.n_rows << "x" << querySet.n_cols
-        << std::endl;
+  convert << "  Reference Set: " << referenceSet->n_rows << "x" ;
+  convert <<  referenceSet->n_cols << std::endl;
   convert << "  Number of Projections: " << numProj << std::endl;
   convert << "  Number of Tables: " << numTables << std::endl;
   convert << "  Hash Width: " << hashWidth << std::endl;
   return convert.str();
 }
 
+//! Serialize the LSH model.
+template<typename SortPolicy>
+template<typename Archive>
+void LSHSearch<SortPolicy>::Serialize(Archive& ar,
+                                      const unsigned int /* version */)
+{
+  using data::CreateNVP;
+
+  // If we are loading, delete the current reference set, if necessary; we will
+  // own the loaded one.
+  if (Archive::is_loading::value)
+  {
+    if (ownsSet && referenceSet)
+      delete referenceSet;
+
+    ownsSet = true;
+
+    // The query set is not part of the model.
+    querySet = NULL;
+  }
+
+  ar & CreateNVP(referenceSet, "referenceSet");
+  ar & CreateNVP(numProj, "numProj");
+  ar & CreateNVP(numTables, "numTables");
+
+  // Serialize each projection matrix.  If we are loading, we must resize the
+  // vector of projections correctly.
+  if (Archive::is_loading::value)
+    projections.resize(numTables);
+
+  for (size_t i = 0; i < projections.size(); ++i)
+  {
+    std::ostringstream oss;
+    oss << "projection" << i;
+    ar & CreateNVP(projections[i], oss.str());
+  }
+
+  ar & CreateNVP(offsets, "offsets");
+  ar & CreateNVP(hashWidth, "hashWidth");
+  ar & CreateNVP(secondHashSize, "secondHashSize");
+  ar & CreateNVP(secondHashWeights, "secondHashWeights");
+  ar & CreateNVP(bucketSize, "bucketSize");
+  ar & CreateNVP(secondHashTable, "secondHashTable");
+  ar & CreateNVP(bucketContentSize, "bucketContentSize");
+  ar & CreateNVP(bucketRowInHashTable, "bucketRowInHashTable");
+  ar & CreateNVP(distanceEvaluations, "distanceEvaluations");
+}
+
 }; // namespace neighbor
 }; // namespace mlpack
 
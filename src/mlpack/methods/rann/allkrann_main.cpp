@@ -8,6 +8,7 @@
 #include <time.h>
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/tree/cover_tree.hpp>
 
 #include <string>
 #include <fstream>
@@ -75,6 +76,10 @@ PARAM_FLAG("first_leaf_exact", "The flag to trigger sampling only after "
            "exactly exploring the first leaf.", "X");
 PARAM_INT("single_sample_limit", "The limit on the maximum number of "
     "samples (and hence the largest node you can approximate).", "S", 20);
+PARAM_FLAG("cover_tree", "If true, use cover trees to perform the search "
+    "(experimental, may be slow).", "c");
+PARAM_INT("threads", "Number of threads to use for the tree search (0 uses as "
+    "many threads as OpenMP allows).", "T", 1);
 
 int main(int argc, char *argv[])
 {
@@ -100,6 +105,12 @@ int main(int argc, char *argv[])
   bool sampleAtLeaves = CLI::HasParam("sample_at_leaves");
   bool firstLeafExact = CLI::HasParam("first_leaf_exact");
 
+  // Sanity check on the number of threads.
+  if (CLI::GetParam<int>("threads") < 0)
+    Log::Fatal << "Invalid number of threads: " << CLI::GetParam<int>("threads")
+        << ".  Must be greater than or equal to 0." << endl;
+  const size_t threads = (size_t) CLI::GetParam<int>("threads");
+
   arma::mat referenceData;
   arma::mat queryData; // So it doesn't go out of scope.
   data::Load(referenceFile, referenceData, true);
@@ -143,6 +154,8 @@ int main(int argc, char *argv[])
   // Naive mode overrides single mode.
   if (singleMode && naive)
     Log::Warn << "--single_mode ignored because --naive is present." << endl;
+  if (CLI::HasParam("cover_tree") && naive)
+    Log::Warn << "--cover_tree ignored because --naive is present." << endl;
 
   // The actual output after the remapping.
   arma::Mat<size_t> neighbors;
@@ -162,6 +175,49 @@ int main(int argc, char *argv[])
 
     Log::Info << "Neighbors computed." << endl;
   }
+  else if (CLI::HasParam("cover_tree"))
+  {
+    // Cover trees do not rearrange the dataset, so no mapping is necessary.
+    Log::Info << "Building reference tree..." << endl;
+    Timer::Start("tree_building");
+    typedef StandardCoverTree<EuclideanDistance,
+        RAQueryStat<NearestNeighborSort>, arma::mat> TreeType;
+    TreeType refTree(referenceData, 1.3);
+    Timer::Stop("tree_building");
+
+    typedef RASearch<NearestNeighborSort, EuclideanDistance, arma::mat,
+        StandardCoverTree> AllkRANNType;
+    AllkRANNType allkrann(&refTree, singleMode, tau, alpha, sampleAtLeaves,
+        firstLeafExact, singleSampleLimit);
+    allkrann.NumThreads() = threads;
+
+    if (CLI::HasParam("query_file") && !singleMode)
+    {
+      Log::Info << "Building query tree..." << endl;
+      Timer::Start("tree_building");
+      TreeType queryTree(queryData, 1.3);
+      Timer::Stop("tree_building");
+      Log::Info << "Tree built." << endl;
+
+      Log::Info << "Computing " << k << " nearest neighbors " << "with " <<
+          tau << "% rank approximation..." << endl;
+      allkrann.Search(&queryTree, k, neighbors, distances);
+    }
+    else if (CLI::HasParam("query_file"))
+    {
+      Log::Info << "Computing " << k << " nearest neighbors " << "with " <<
+          tau << "% rank approximation..." << endl;
+      allkrann.Search(queryData, k, neighbors, distances);
+    }
+    else
+    {
+      Log::Info << "Computing " << k << " nearest neighbors " << "with " <<
+          tau << "% rank approximation..." << endl;
+      allkrann.Search(k, neighbors, distances);
+    }
+
+    Log::Info << "Neighbors computed." << endl;
+  }
   else
   {
     // The results output by the AllkRANN class are
@@ -185,6 +241,7 @@ int main(int argc, char *argv[])
     // Because we may construct it differently, we need a pointer.
     AllkRANN allkrann(&refTree, singleMode, tau, alpha, sampleAtLeaves,
         firstLeafExact, singleSampleLimit);
+    allkrann.NumThreads() = threads;
 
     if (CLI::HasParam("query_file") && !singleMode)
     {
@@ -49,6 +49,14 @@ namespace neighbor {
  *
  * RASearch is currently known to not work with ball trees (#356).
  *
+ * Tree-based search (single-tree or dual-tree) can be run on multiple threads
+ * by setting NumThreads().  In single-tree mode each thread handles a
+ * contiguous block of the query points, and in dual-tree mode each thread
+ * handles its own set of query subtrees.  Each thread draws its samples from
+ * its own random number generator, which is seeded from the global mlpack
+ * random number generator, so the results are deterministic for a given random
+ * seed and number of threads (whether or not OpenMP is available).
+ *
  * @tparam SortPolicy The sort policy for distances; see NearestNeighborSort.
  * @tparam MetricType The metric to use for computation.
  * @tparam TreeType The tree type to use.
@@ -287,10 +295,55 @@ class RASearch
   //! Modify the limit on the size of a node that can be approximation.
   size_t& SingleSampleLimit() { return singleSampleLimit; }
 
+  //! Get the number of threads used for tree-based search (0 means as many
+  //! as OpenMP allows).
+  size_t NumThreads() const { return numThreads; }
+  //! Modify the number of threads used for tree-based search (0 means as many
+  //! as OpenMP allows).
+  size_t& NumThreads() { return numThreads; }
+
   //! Returns a string representation of this object.
   std::string ToString() const;
 
  private:
+  /**
+   * Run single-tree search for each point in the query set on NumThreads()
+   * threads.  Each thread handles a contiguous block of query points with its
+   * own rules object and random number generator.  The results matrices must
+   * already be initialized.
+   *
+   * @param querySet Set of query points.
+   * @param sameSet Whether the query set is the reference set.
+   * @param neighbors Matrix storing lists of neighbors for each query point.
+   * @param distances Matrix storing distances of neighbors for each query
+   *     point.
+   */
+  void ParallelSingleTreeSearch(const MatType& querySet,
+                                const bool sameSet,
+                                arma::Mat<size_t>& neighbors,
+                                arma::mat& distances);
+
+  /**
+   * Run dual-tree search with the given query tree on NumThreads() threads.
+   * The query tree is split into disjoint subtrees, which are distributed over
+   * the threads; each thread traverses its subtrees against the whole
+   * reference tree with its own rules object and random number generator.  The
+   * results matrices must already be initialized.
+   *
+   * @param queryTree Tree built on query points.
+   * @param sameSet Whether the query tree is the reference tree.
+   * @param neighbors Matrix storing lists of neighbors for each query point.
+   * @param distances Matrix storing distances of neighbors for each query
+   *     point.
+   */
+  void ParallelDualTreeSearch(Tree* queryTree,
+                              const bool sameSet,
+                              arma::Mat<size_t>& neighbors,
+                              arma::mat& distances);
+
+  //! Return the number of threads that will actually be used for search.
+  size_t ThreadsToUse() const;
+
   //! Permutations of reference points during tree building.
   std::vector<size_t> oldFromNewReferences;
   //! Pointer to the root of the reference tree.
@@ -317,6 +370,8 @@ class RASearch
   //! The limit on the number of points in the largest node that can be
   //! approximated by sampling.
   size_t singleSampleLimit;
+  //! The number of threads to use for tree-based search.
+  size_t numThreads;
 
   //! Instantiation of kernel.
   MetricType metric;
@@ -10,8 +10,14 @@
 
 #include <mlpack/core.hpp>
 
+#include <algorithm>
+
 #include "ra_search_rules.hpp"
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace neighbor {
 
@@ -71,6 +77,7 @@ RASearch(const MatType& referenceSetIn,
     sampleAtLeaves(sampleAtLeaves),
     firstLeafExact(firstLeafExact),
     singleSampleLimit(singleSampleLimit),
+    numThreads(1),
     metric(metric)
 {
   // Nothing to do.
@@ -102,6 +109,7 @@ RASearch(Tree* referenceTree,
     sampleAtLeaves(sampleAtLeaves),
     firstLeafExact(firstLeafExact),
     singleSampleLimit(singleSampleLimit),
+    numThreads(1),
     metric(metric)
 // Nothing else to initialize.
 {  }
@@ -189,6 +197,13 @@ Search(const MatType& querySet,
       for (size_t j = 0; j < distinctSamples.n_elem; ++j)
         rules.BaseCase(i, (size_t) distinctSamples[j]);
   }
+  else if (singleMode && ThreadsToUse() > 1)
+  {
+    // As in the serial case, nothing is left to do if the reference root node
+    // is a leaf.
+    if (!referenceTree->IsLeaf())
+      ParallelSingleTreeSearch(querySet, false, *neighborPtr, *distancePtr);
+  }
   else if (singleMode)
   {
     RuleType rules(referenceSet, querySet, *neighborPtr, *distancePtr, metric,
@@ -226,19 +241,27 @@ Search(const MatType& querySet,
     Timer::Stop("tree_building");
     Timer::Start("computing_neighbors");
 
-    RuleType rules(referenceSet, queryTree->Dataset(), *neighborPtr,
-                   *distancePtr, metric, tau, alpha, naive, sampleAtLeaves,
-                   firstLeafExact, singleSampleLimit, false);
-    typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
+    if (ThreadsToUse() > 1)
+    {
+      ParallelDualTreeSearch(queryTree, false, *neighborPtr, *distancePtr);
+    }
+    else
+    {
+      RuleType rules(referenceSet, queryTree->Dataset(), *neighborPtr,
+                     *distancePtr, metric, tau, alpha, naive, sampleAtLeaves,
+                     firstLeafExact, singleSampleLimit, false);
+      typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
 
-    Log::Info << "Query statistic pre-search: "
-        << queryTree->Stat().NumSamplesMade() << std::endl;
+      Log::Info << "Query statistic pre-search: "
+          << queryTree->Stat().NumSamplesMade() << std::endl;
 
-    traverser.Traverse(*queryTree, *referenceTree);
+      traverser.Traverse(*queryTree, *referenceTree);
 
-    Log::Info << "Dual-tree traversal complete." << std::endl;
-    Log::Info << "Average number of distance calculations per query point: "
-        << (rules.NumDistComputations() / querySet.n_cols) << "." << std::endl;
+      Log::Info << "Dual-tree traversal complete." << std::endl;
+      Log::Info << "Average number of distance calculations per query point: "
+          << (rules.NumDistComputations() / querySet.n_cols) << "."
+          << std::endl;
+    }
 
     delete queryTree;
   }
@@ -338,15 +361,22 @@ void RASearch<SortPolicy, MetricType, MatType, TreeType>::Search(
   distances.set_size(k, querySet.n_cols);
   distances.fill(SortPolicy::WorstDistance());
 
-  // Create the helper object for the tree traversal.
-  typedef RASearchRules<SortPolicy, MetricType, Tree> RuleType;
-  RuleType rules(referenceSet, queryTree->Dataset(), *neighborPtr, distances,
-                 metric, tau, alpha, naive, sampleAtLeaves, firstLeafExact,
-                 singleSampleLimit, false);
+  if (ThreadsToUse() > 1)
+  {
+    ParallelDualTreeSearch(queryTree, false, *neighborPtr, distances);
+  }
+  else
+  {
+    // Create the helper object for the tree traversal.
+    typedef RASearchRules<SortPolicy, MetricType, Tree> RuleType;
+    RuleType rules(referenceSet, queryTree->Dataset(), *neighborPtr, distances,
+                   metric, tau, alpha, naive, sampleAtLeaves, firstLeafExact,
+                   singleSampleLimit, false);
 
-  // Create the traverser.
-  typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
-  traverser.Traverse(*queryTree, *referenceTree);
+    // Create the traverser.
+    typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
+    traverser.Traverse(*queryTree, *referenceTree);
+  }
 
   Timer::Stop("computing_neighbors");
 
@@ -416,6 +446,15 @@ void RASearch<SortPolicy, MetricType, MatType, TreeType>::Search(
       for (size_t j = 0; j < referenceSet.n_cols; ++j)
         rules.BaseCase(i, j);
   }
+  else if (ThreadsToUse() > 1)
+  {
+    // The query set is the reference set, and so the reference tree is also
+    // the query tree.
+    if (singleMode)
+      ParallelSingleTreeSearch(referenceSet, true, *neighborPtr, *distancePtr);
+    else
+      ParallelDualTreeSearch(referenceTree, true, *neighborPtr, *distancePtr);
+  }
   else if (singleMode)
   {
     // Create the traverser.
@@ -458,6 +497,180 @@ void RASearch<SortPolicy, MetricType, MatType, TreeType>::Search(
   }
 }
 
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+size_t RASearch<SortPolicy, MetricType, MatType, TreeType>::ThreadsToUse()
+    const
+{
+  if (numThreads != 0)
+    return numThreads;
+
+#ifdef _OPENMP
+  return (size_t) omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void RASearch<SortPolicy, MetricType, MatType, TreeType>::
+ParallelSingleTreeSearch(const MatType& querySet,
+                         const bool sameSet,
+                         arma::Mat<size_t>& neighbors,
+                         arma::mat& distances)
+{
+  typedef RASearchRules<SortPolicy, MetricType, Tree> RuleType;
+  const size_t threads = ThreadsToUse();
+
+  // Each thread gets its own random number generator and its own rules object.
+  // These are created serially, and the generators are seeded from the global
+  // generator, so the results only depend on the random seed and the number of
+  // threads.  Note that each rules object holds a vector of length
+  // querySet.n_cols.
+  std::vector<std::mt19937> rngs(threads);
+  std::vector<RuleType*> rules(threads);
+  for (size_t t = 0; t < threads; ++t)
+  {
+    rngs[t].seed((uint32_t) math::randGen());
+    rules[t] = new RuleType(referenceSet, querySet, neighbors, distances,
+        metric, tau, alpha, false, sampleAtLeaves, firstLeafExact,
+        singleSampleLimit, sameSet, rngs[t]);
+  }
+
+  Log::Info << "Performing single-tree traversal with " << threads
+      << " threads..." << std::endl;
+
+  // Thread t handles a contiguous block of query points, and only writes to
+  // the columns of the results that belong to those points.
+  #pragma omp parallel for num_threads(threads) schedule(static, 1)
+  for (size_t t = 0; t < threads; ++t)
+  {
+    const size_t begin = (t * querySet.n_cols) / threads;
+    const size_t end = ((t + 1) * querySet.n_cols) / threads;
+
+    typename Tree::template SingleTreeTraverser<RuleType> traverser(*rules[t]);
+    for (size_t i = begin; i < end; ++i)
+      traverser.Traverse(i, *referenceTree);
+  }
+
+  size_t numDistComputations = 0;
+  for (size_t t = 0; t < threads; ++t)
+  {
+    numDistComputations += rules[t]->NumDistComputations();
+    delete rules[t];
+  }
+
+  Log::Info << "Single-tree traversal complete." << std::endl;
+  Log::Info << "Average number of distance calculations per query point: "
+      << (numDistComputations / querySet.n_cols) << "." << std::endl;
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void RASearch<SortPolicy, MetricType, MatType, TreeType>::
+ParallelDualTreeSearch(Tree* queryTree,
+                       const bool sameSet,
+                       arma::Mat<size_t>& neighbors,
+                       arma::mat& distances)
+{
+  typedef RASearchRules<SortPolicy, MetricType, Tree> RuleType;
+  const size_t threads = ThreadsToUse();
+
+  // Split the query tree into disjoint subtrees by repeatedly replacing the
+  // largest non-leaf subtree with its children, until there are enough
+  // subtrees to balance the work or only leaves are left.  The rules only
+  // modify the statistics of the query nodes they are given (and their
+  // descendants), so each subtree can be traversed independently.
+  std::vector<Tree*> subtrees(1, queryTree);
+  while (subtrees.size() < 4 * threads)
+  {
+    size_t largest = subtrees.size();
+    for (size_t i = 0; i < subtrees.size(); ++i)
+    {
+      if (!subtrees[i]->IsLeaf() && (largest == subtrees.size() ||
+          subtrees[i]->NumDescendants() >
+          subtrees[largest]->NumDescendants()))
+        largest = i;
+    }
+
+    if (largest == subtrees.size())
+      break; // Everything is a leaf.
+
+    Tree* node = subtrees[largest];
+    subtrees.erase(subtrees.begin() + largest);
+    for (size_t i = 0; i < node->NumChildren(); ++i)
+      subtrees.push_back(&node->Child(i));
+  }
+
+  // Assign subtrees to threads, largest first, always to the thread with the
+  // fewest query points so far.  The assignment is deterministic.
+  std::vector<size_t> order(subtrees.size());
+  for (size_t i = 0; i < order.size(); ++i)
+    order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [&subtrees](const size_t a,
+      const size_t b)
+  {
+    return subtrees[a]->NumDescendants() > subtrees[b]->NumDescendants();
+  });
+
+  std::vector<std::vector<Tree*> > assignments(threads);
+  std::vector<size_t> load(threads, 0);
+  for (size_t i = 0; i < order.size(); ++i)
+  {
+    const size_t t = std::min_element(load.begin(), load.end()) - load.begin();
+    assignments[t].push_back(subtrees[order[i]]);
+    load[t] += subtrees[order[i]]->NumDescendants();
+  }
+
+  // Each thread gets its own random number generator, seeded serially from the
+  // global generator, and its own rules object.
+  std::vector<std::mt19937> rngs(threads);
+  std::vector<RuleType*> rules(threads);
+  for (size_t t = 0; t < threads; ++t)
+  {
+    rngs[t].seed((uint32_t) math::randGen());
+    rules[t] = new RuleType(referenceSet, queryTree->Dataset(), neighbors,
+        distances, metric, tau, alpha, false, sampleAtLeaves, firstLeafExact,
+        singleSampleLimit, sameSet, rngs[t]);
+  }
+
+  Log::Info << "Performing dual-tree traversal of " << subtrees.size()
+      << " query subtrees with " << threads << " threads..." << std::endl;
+
+  #pragma omp parallel for num_threads(threads) schedule(static, 1)
+  for (size_t t = 0; t < threads; ++t)
+  {
+    typename Tree::template DualTreeTraverser<RuleType> traverser(*rules[t]);
+    for (size_t i = 0; i < assignments[t].size(); ++i)
+      traverser.Traverse(*assignments[t][i], *referenceTree);
+  }
+
+  size_t numDistComputations = 0;
+  for (size_t t = 0; t < threads; ++t)
+  {
+    numDistComputations += rules[t]->NumDistComputations();
+    delete rules[t];
+  }
+
+  Log::Info << "Dual-tree traversal complete." << std::endl;
+  Log::Info << "Average number of distance calculations per query point: "
+      << (numDistComputations / queryTree->Dataset().n_cols) << "."
+      << std::endl;
+}
+
 template<typename SortPolicy,
          typename MetricType,
          typename MatType,
@@ -29,7 +29,8 @@ class RASearchRules
                 const bool sampleAtLeaves = false,
                 const bool firstLeafExact = false,
                 const size_t singleSampleLimit = 20,
-                const bool sameSet = false);
+                const bool sameSet = false,
+                std::mt19937& rng = math::randGen);
 
   double BaseCase(const size_t queryIndex, const size_t referenceIndex);
 
@@ -230,6 +231,9 @@ class RASearchRules
   //! If the query and reference set are identical, this is true.
   bool sameSet;
 
+  //! The random number generator used for sampling.
+  std::mt19937& rng;
+
   TraversalInfoType traversalInfo;
 
   /**
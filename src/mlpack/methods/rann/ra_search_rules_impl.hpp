@@ -26,7 +26,8 @@ RASearchRules(const arma::mat& referenceSet,
               const bool sampleAtLeaves,
               const bool firstLeafExact,
               const size_t singleSampleLimit,
-              const bool sameSet) :
+              const bool sameSet,
+              std::mt19937& rng) :
     referenceSet(referenceSet),
     querySet(querySet),
     neighbors(neighbors),
@@ -35,7 +36,8 @@ RASearchRules(const arma::mat& referenceSet,
     sampleAtLeaves(sampleAtLeaves),
     firstLeafExact(firstLeafExact),
     singleSampleLimit(singleSampleLimit),
-    sameSet(sameSet)
+    sameSet(sameSet),
+    rng(rng)
 {
   // Validate tau to make sure that the rank approximation is greater than the
   // number of neighbors requested.
@@ -74,7 +76,7 @@ RASearchRules(const arma::mat& referenceSet,
     for (size_t i = 0; i < querySet.n_cols; ++i)
     {
       arma::uvec distinctSamples;
-      RAUtil::ObtainDistinctSamples(numSamplesReqd, n, distinctSamples);
+      RAUtil::ObtainDistinctSamples(numSamplesReqd, n, distinctSamples, rng);
       for (size_t j = 0; j < distinctSamples.n_elem; j++)
         BaseCase(i, (size_t) distinctSamples[j]);
     }
@@ -180,7 +182,7 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
           arma::uvec distinctSamples;
           RAUtil::ObtainDistinctSamples(samplesReqd,
               referenceNode.NumDescendants(),
-                                distinctSamples);
+                                distinctSamples, rng);
           for (size_t i = 0; i < distinctSamples.n_elem; i++)
             // The counting of the samples are done in the 'BaseCase' function
             // so no book-keeping is required here.
@@ -197,7 +199,7 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
             arma::uvec distinctSamples;
             RAUtil::ObtainDistinctSamples(samplesReqd,
                 referenceNode.NumDescendants(),
-                                  distinctSamples);
+                                  distinctSamples, rng);
             for (size_t i = 0; i < distinctSamples.n_elem; i++)
               // The counting of the samples are done in the 'BaseCase' function
               // so no book-keeping is required here.
@@ -285,7 +287,7 @@ Rescore(const size_t queryIndex,
         // by sampling enough number of points.
         arma::uvec distinctSamples;
         RAUtil::ObtainDistinctSamples(samplesReqd,
-            referenceNode.NumDescendants(), distinctSamples);
+            referenceNode.NumDescendants(), distinctSamples, rng);
         for (size_t i = 0; i < distinctSamples.n_elem; i++)
           // The counting of the samples are done in the 'BaseCase' function so
           // no book-keeping is required here.
@@ -301,7 +303,7 @@ Rescore(const size_t queryIndex,
           // Approximate node by sampling enough points.
           arma::uvec distinctSamples;
           RAUtil::ObtainDistinctSamples(samplesReqd,
-              referenceNode.NumDescendants(), distinctSamples);
+              referenceNode.NumDescendants(), distinctSamples, rng);
           for (size_t i = 0; i < distinctSamples.n_elem; i++)
             // The counting of the samples are done in the 'BaseCase' function
             // so no book-keeping is required here.
@@ -488,7 +490,7 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
             const size_t queryIndex = queryNode.Descendant(i);
             arma::uvec distinctSamples;
             RAUtil::ObtainDistinctSamples(samplesReqd,
-                referenceNode.NumDescendants(), distinctSamples);
+                referenceNode.NumDescendants(), distinctSamples, rng);
             for (size_t j = 0; j < distinctSamples.n_elem; j++)
               // The counting of the samples are done in the 'BaseCase' function
               // so no book-keeping is required here.
@@ -518,7 +520,7 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
               const size_t queryIndex = queryNode.Descendant(i);
               arma::uvec distinctSamples;
               RAUtil::ObtainDistinctSamples(samplesReqd,
-                  referenceNode.NumDescendants(), distinctSamples);
+                  referenceNode.NumDescendants(), distinctSamples, rng);
               for (size_t j = 0; j < distinctSamples.n_elem; j++)
                 // The counting of the samples are done in the 'BaseCase'
                 // function so no book-keeping is required here.
@@ -693,7 +695,7 @@ Rescore(TreeType& queryNode,
           const size_t queryIndex = queryNode.Descendant(i);
           arma::uvec distinctSamples;
           RAUtil::ObtainDistinctSamples(samplesReqd,
-              referenceNode.NumDescendants(), distinctSamples);
+              referenceNode.NumDescendants(), distinctSamples, rng);
           for (size_t j = 0; j < distinctSamples.n_elem; j++)
             // The counting of the samples are done in the 'BaseCase'
             // function so no book-keeping is required here.
@@ -722,7 +724,7 @@ Rescore(TreeType& queryNode,
             const size_t queryIndex = queryNode.Descendant(i);
             arma::uvec distinctSamples;
             RAUtil::ObtainDistinctSamples(samplesReqd,
-                referenceNode.NumDescendants(), distinctSamples);
+                referenceNode.NumDescendants(), distinctSamples, rng);
             for (size_t j = 0; j < distinctSamples.n_elem; j++)
               // The counting of the samples are done in BaseCase() so no
               // book-keeping is required here.
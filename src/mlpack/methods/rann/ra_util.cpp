@@ -168,14 +168,20 @@ double mlpack::neighbor::RAUtil::SuccessProbability(const size_t n,
 void mlpack::neighbor::RAUtil::ObtainDistinctSamples(
     const size_t numSamples,
     const size_t rangeUpperBound,
-    arma::uvec& distinctSamples)
+    arma::uvec& distinctSamples,
+    std::mt19937& rng)
 {
+  // This gives the same samples as math::RandInt() when 'rng' is the global
+  // random number generator.
+  std::uniform_real_distribution<> uniform;
+
   // Keep track of the points that are sampled.
   arma::Col<size_t> sampledPoints;
   sampledPoints.zeros(rangeUpperBound);
 
   for (size_t i = 0; i < numSamples; i++)
-    sampledPoints[(size_t) math::RandInt(rangeUpperBound)]++;
+    sampledPoints[(size_t) std::floor((double) rangeUpperBound *
+        uniform(rng))]++;
 
   distinctSamples = arma::find(sampledPoints > 0);
   return;
@@ -52,10 +52,13 @@ class RAUtil
    * @param numSamples Number of random samples.
    * @param rangeUpperBound The upper bound on the range of integers.
    * @param distinctSamples The list of the distinct samples.
+   * @param rng Random number generator to draw the samples with.  By default,
+   *     the global mlpack random number generator is used.
    */
   static void ObtainDistinctSamples(const size_t numSamples,
                                     const size_t rangeUpperBound,
-                                    arma::uvec& distinctSamples);
+                                    arma::uvec& distinctSamples,
+                                    std::mt19937& rng = math::randGen);
 };
 
 } // namespace neighbor
@@ -393,6 +393,125 @@ BOOST_AUTO_TEST_CASE(DualCoverTreeTest)
   BOOST_REQUIRE_LT(numQueriesFail, maxNumQueriesFail);
 }
 
+/**
+ * Make sure that multithreaded rank-approximate search gives the same results
+ * every time it is run with the same random seed and number of threads, in
+ * single-tree and dual-tree mode, with kd-trees and cover trees.
+ */
+BOOST_AUTO_TEST_CASE(ParallelDeterminismTest)
+{
+  arma::mat refData;
+  arma::mat queryData;
+
+  data::Load("rann_test_r_3_900.csv", refData, true);
+  data::Load("rann_test_q_3_100.csv", queryData, true);
+
+  typedef RASearch<NearestNeighborSort, EuclideanDistance, arma::mat,
+      StandardCoverTree> RACoverTreeSearch;
+
+  for (size_t mode = 0; mode < 2; ++mode)
+  {
+    const bool singleMode = (mode == 0);
+
+    RASearch<> kdRann(refData, false, singleMode, 1.0, 0.95, false, false, 5);
+    RACoverTreeSearch coverRann(refData, false, singleMode, 1.0, 0.95, false,
+        false, 5);
+    kdRann.NumThreads() = 4;
+    coverRann.NumThreads() = 4;
+
+    arma::Mat<size_t> neighbors1, neighbors2;
+    arma::mat distances1, distances2;
+
+    math::RandomSeed(42);
+    kdRann.Search(queryData, 3, neighbors1, distances1);
+    math::RandomSeed(42);
+    kdRann.Search(queryData, 3, neighbors2, distances2);
+
+    BOOST_REQUIRE_EQUAL(neighbors1.n_cols, queryData.n_cols);
+    for (size_t i = 0; i < neighbors1.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors1[i], neighbors2[i]);
+      BOOST_REQUIRE_CLOSE(distances1[i], distances2[i], 1e-10);
+    }
+
+    math::RandomSeed(42);
+    coverRann.Search(queryData, 3, neighbors1, distances1);
+    math::RandomSeed(42);
+    coverRann.Search(queryData, 3, neighbors2, distances2);
+
+    BOOST_REQUIRE_EQUAL(neighbors1.n_cols, queryData.n_cols);
+    for (size_t i = 0; i < neighbors1.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors1[i], neighbors2[i]);
+      BOOST_REQUIRE_CLOSE(distances1[i], distances2[i], 1e-10);
+    }
+  }
+}
+
+/**
+ * Test the guarantee of dual-tree rank-approximate search when the query tree
+ * is split between several threads.
+ */
+BOOST_AUTO_TEST_CASE(ParallelDualTreeSearch)
+{
+  arma::mat refData;
+  arma::mat queryData;
+
+  data::Load("rann_test_r_3_900.csv", refData, true);
+  data::Load("rann_test_q_3_100.csv", queryData, true);
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+
+  RASearch<> tsdRann(refData, false, false, 1.0, 0.95, false, false, 5);
+  tsdRann.NumThreads() = 4;
+
+  arma::Mat<size_t> qrRanks;
+  data::Load("rann_test_qr_ranks.csv", qrRanks, true, false); // No transpose.
+
+  size_t numRounds = 1000;
+  arma::Col<size_t> numSuccessRounds(queryData.n_cols);
+  numSuccessRounds.fill(0);
+
+  // 1% of 900 is 9, so the rank is expected to be less than 10.
+  size_t expectedRankErrorUB = 10;
+
+  // Build query tree by hand.
+  typedef KDTree<EuclideanDistance, RAQueryStat<NearestNeighborSort>,
+      arma::mat> TreeType;
+  std::vector<size_t> oldFromNewQueries;
+  TreeType queryTree(queryData, oldFromNewQueries);
+
+  for (size_t rounds = 0; rounds < numRounds; rounds++)
+  {
+    tsdRann.Search(&queryTree, 1, neighbors, distances);
+
+    for (size_t i = 0; i < queryData.n_cols; i++)
+    {
+      const size_t oldIndex = oldFromNewQueries[i];
+      if (qrRanks(oldIndex, neighbors(0, i)) < expectedRankErrorUB)
+        numSuccessRounds[i]++;
+    }
+
+    neighbors.reset();
+    distances.reset();
+
+    tsdRann.ResetQueryTree(&queryTree);
+  }
+
+  size_t threshold = floor(numRounds *
+      (0.95 - (1.96 * sqrt(0.95 * 0.05 / numRounds))));
+  size_t numQueriesFail = 0;
+  for (size_t i = 0; i < queryData.n_cols; i++)
+    if (numSuccessRounds[i] < threshold)
+      numQueriesFail++;
+
+  Log::Warn << "RANN-TSD (4 threads): RANN guarantee fails on "
+      << numQueriesFail << " queries." << endl;
+
+  BOOST_REQUIRE_LT(numQueriesFail, (size_t) 6);
+}
+
 // Test single-tree rank-approximate search with ball trees.
 // This is known to not work right now.
 /*
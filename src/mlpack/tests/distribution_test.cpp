@@ -307,6 +307,112 @@ BOOST_AUTO_TEST_CASE(GaussianMultipointMultivariateProbabilityTest)
   BOOST_REQUIRE_CLOSE(phis(5), -14.900192463287908, 1e-5);
 }
 
+/**
+ * Make sure the batch log-probability (which whitens the observations with the
+ * Cholesky factor of the covariance) matches the direct computation with the
+ * inverse covariance, for full and diagonal covariances.
+ */
+BOOST_AUTO_TEST_CASE(GaussianBatchLogProbabilityTest)
+{
+  arma::vec mean("1.0 -2.0 0.5");
+  arma::mat fullCov("2.0 0.4 0.1;"
+                    "0.4 1.5 -0.3;"
+                    "0.1 -0.3 0.8");
+  arma::mat diagCov("2.0 0.0 0.0;"
+                    "0.0 1.5 0.0;"
+                    "0.0 0.0 0.8");
+
+  arma::mat x = 2.0 * arma::randn<arma::mat>(3, 50);
+
+  for (size_t c = 0; c < 2; ++c)
+  {
+    const arma::mat& cov = (c == 0) ? fullCov : diagCov;
+    GaussianDistribution d(mean, cov);
+
+    arma::vec logProbabilities;
+    d.LogProbability(x, logProbabilities);
+    BOOST_REQUIRE_EQUAL(logProbabilities.n_elem, x.n_cols);
+
+    const arma::mat invCov = arma::inv(cov);
+    for (size_t i = 0; i < x.n_cols; ++i)
+    {
+      const arma::vec diff = x.col(i) - mean;
+      const double expected = -0.5 * 3 * std::log(2 * M_PI) -
+          0.5 * std::log(arma::det(cov)) -
+          0.5 * arma::as_scalar(trans(diff) * invCov * diff);
+
+      BOOST_REQUIRE_CLOSE(logProbabilities[i], expected, 1e-8);
+      BOOST_REQUIRE_CLOSE(d.LogProbability(x.col(i)), expected, 1e-8);
+    }
+  }
+}
+
+/**
+ * Make sure DiagonalGaussianDistribution gives the same log-probabilities as a
+ * GaussianDistribution with the same diagonal covariance, and that Estimate()
+ * recovers the variances of each dimension.
+ */
+BOOST_AUTO_TEST_CASE(DiagonalGaussianDistributionTest)
+{
+  arma::vec mean("1.0 -2.0 0.5");
+  arma::vec variances("2.0 1.5 0.8");
+
+  DiagonalGaussianDistribution d(mean, variances);
+  GaussianDistribution g(mean, arma::diagmat(variances));
+
+  arma::mat x = 2.0 * arma::randn<arma::mat>(3, 50);
+  arma::vec logProbabilities;
+  d.LogProbability(x, logProbabilities);
+  BOOST_REQUIRE_EQUAL(logProbabilities.n_elem, x.n_cols);
+
+  for (size_t i = 0; i < x.n_cols; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(logProbabilities[i], g.LogProbability(x.col(i)), 1e-8);
+    BOOST_REQUIRE_CLOSE(d.LogProbability(x.col(i)), g.LogProbability(x.col(i)),
+        1e-8);
+  }
+
+  // Estimate on data generated from the distribution.
+  arma::mat samples(3, 5000);
+  for (size_t i = 0; i < samples.n_cols; ++i)
+    samples.col(i) = d.Random();
+
+  DiagonalGaussianDistribution e;
+  e.Estimate(samples);
+  GaussianDistribution f;
+  f.Estimate(samples);
+
+  BOOST_REQUIRE_EQUAL(e.Dimensionality(), 3);
+  for (size_t j = 0; j < 3; ++j)
+  {
+    BOOST_REQUIRE_CLOSE(e.Mean()[j], f.Mean()[j], 1e-8);
+    BOOST_REQUIRE_CLOSE(e.Covariance()[j], f.Covariance()(j, j), 1e-8);
+    BOOST_REQUIRE_SMALL(e.Covariance()[j] - variances[j], 0.15);
+  }
+}
+
+/**
+ * Estimating a DiagonalGaussianDistribution from one observation must give
+ * small positive variances, not NaN.
+ */
+BOOST_AUTO_TEST_CASE(DiagonalGaussianDistributionOneObservationTest)
+{
+  arma::mat x("1.0; -2.0; 0.5");
+
+  DiagonalGaussianDistribution d;
+  d.Estimate(x);
+
+  BOOST_REQUIRE_EQUAL(d.Dimensionality(), 3);
+  for (size_t j = 0; j < 3; ++j)
+  {
+    BOOST_REQUIRE_CLOSE(d.Mean()[j], x(j, 0), 1e-8);
+    BOOST_REQUIRE(std::isfinite(d.Covariance()[j]));
+    BOOST_REQUIRE_GT(d.Covariance()[j], 0.0);
+  }
+
+  BOOST_REQUIRE(std::isfinite(d.LogProbability(x.col(0))));
+}
+
 /**
  * Make sure random observations follow the probability distribution correctly.
  */
@@ -5,6 +5,8 @@
  */
 #include <mlpack/core.hpp>
 #include <mlpack/methods/emst/dtb.hpp>
+#include <mlpack/methods/emst/dendrogram.hpp>
+#include <mlpack/methods/emst/out_of_core_dtb.hpp>
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
 
@@ -275,4 +277,193 @@ BOOST_AUTO_TEST_CASE(BallTreeTest)
 
 }
 
+/**
+ * Make sure that the multithreaded computation gives the same MST as the
+ * single-threaded computation, both with a tree and in naive mode.
+ */
+BOOST_AUTO_TEST_CASE(ParallelVsSerial)
+{
+  arma::mat inputData;
+  if (!data::Load("test_data_3_1000.csv", inputData))
+    BOOST_FAIL("Cannot load test dataset test_data_3_1000.csv!");
+
+  for (size_t naive = 0; naive < 2; ++naive)
+  {
+    DualTreeBoruvka<> serial(inputData, (naive == 1));
+    DualTreeBoruvka<> parallel(inputData, (naive == 1));
+    parallel.NumThreads() = 4;
+
+    arma::mat serialResults;
+    arma::mat parallelResults;
+
+    serial.ComputeMST(serialResults);
+    parallel.ComputeMST(parallelResults);
+
+    BOOST_REQUIRE_EQUAL(serialResults.n_cols, parallelResults.n_cols);
+    for (size_t i = 0; i < serialResults.n_cols; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(serialResults(0, i), parallelResults(0, i));
+      BOOST_REQUIRE_EQUAL(serialResults(1, i), parallelResults(1, i));
+      BOOST_REQUIRE_CLOSE(serialResults(2, i), parallelResults(2, i), 1e-5);
+    }
+  }
+}
+
+/**
+ * Check the dendrogram of four points on a line, by hand.
+ */
+BOOST_AUTO_TEST_CASE(DendrogramTest)
+{
+  arma::mat inputData("0.0 1.0 3.0 7.0");
+
+  DualTreeBoruvka<> dtb(inputData, true);
+  arma::mat results;
+  dtb.ComputeMST(results);
+
+  arma::mat dendrogram;
+  ComputeDendrogram(results, inputData.n_cols, dendrogram);
+
+  BOOST_REQUIRE_EQUAL(dendrogram.n_rows, 4);
+  BOOST_REQUIRE_EQUAL(dendrogram.n_cols, 3);
+
+  // Points 0 and 1 merge at distance 1 into cluster 4.
+  BOOST_REQUIRE_EQUAL(dendrogram(0, 0), 0);
+  BOOST_REQUIRE_EQUAL(dendrogram(1, 0), 1);
+  BOOST_REQUIRE_CLOSE(dendrogram(2, 0), 1.0, 1e-5);
+  BOOST_REQUIRE_EQUAL(dendrogram(3, 0), 2);
+
+  // Point 2 and cluster 4 merge at distance 2 into cluster 5.
+  BOOST_REQUIRE_EQUAL(dendrogram(0, 1), 2);
+  BOOST_REQUIRE_EQUAL(dendrogram(1, 1), 4);
+  BOOST_REQUIRE_CLOSE(dendrogram(2, 1), 2.0, 1e-5);
+  BOOST_REQUIRE_EQUAL(dendrogram(3, 1), 3);
+
+  // Point 3 and cluster 5 merge at distance 4.
+  BOOST_REQUIRE_EQUAL(dendrogram(0, 2), 3);
+  BOOST_REQUIRE_EQUAL(dendrogram(1, 2), 5);
+  BOOST_REQUIRE_CLOSE(dendrogram(2, 2), 4.0, 1e-5);
+  BOOST_REQUIRE_EQUAL(dendrogram(3, 2), 4);
+}
+
+/**
+ * The dual-tree MST under the mutual reachability distance must have the same
+ * edge lengths as the naive one.  (There are many ties in the mutual
+ * reachability distance, so the edges themselves may differ.)
+ */
+BOOST_AUTO_TEST_CASE(MutualReachabilityTest)
+{
+  arma::mat inputData;
+  if (!data::Load("test_data_3_1000.csv", inputData))
+    BOOST_FAIL("Cannot load test dataset test_data_3_1000.csv!");
+
+  arma::vec coreDistances;
+  ComputeCoreDistances(inputData, 5, coreDistances);
+
+  DualTreeBoruvka<> dtb(inputData);
+  DualTreeBoruvka<> naive(inputData, true);
+
+  arma::mat dualResults;
+  arma::mat naiveResults;
+  dtb.ComputeMST(dualResults, coreDistances);
+  naive.ComputeMST(naiveResults, coreDistances);
+
+  BOOST_REQUIRE_EQUAL(dualResults.n_cols, naiveResults.n_cols);
+  for (size_t i = 0; i < dualResults.n_cols; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(dualResults(2, i), naiveResults(2, i), 1e-5);
+
+    // No edge can be shorter than the core distance of either endpoint.
+    BOOST_REQUIRE_GE(dualResults(2, i) + 1e-10,
+        coreDistances[(size_t) dualResults(0, i)]);
+    BOOST_REQUIRE_GE(dualResults(2, i) + 1e-10,
+        coreDistances[(size_t) dualResults(1, i)]);
+  }
+}
+
+/**
+ * With a pre-built tree (as in the emst program), the core distances must be
+ * computed in the order of the tree's dataset.  Make sure that the resulting
+ * MST has the same edge lengths as the naive MST with the core distances in the
+ * original order.
+ */
+BOOST_AUTO_TEST_CASE(MutualReachabilityPrebuiltTreeTest)
+{
+  arma::mat inputData;
+  if (!data::Load("test_data_3_1000.csv", inputData))
+    BOOST_FAIL("Cannot load test dataset test_data_3_1000.csv!");
+
+  arma::vec coreDistances;
+  ComputeCoreDistances(inputData, 10, coreDistances);
+
+  DualTreeBoruvka<> naive(inputData, true);
+  arma::mat naiveResults;
+  naive.ComputeMST(naiveResults, coreDistances);
+
+  std::vector<size_t> oldFromNew;
+  KDTree<EuclideanDistance, DTBStat, arma::mat> tree(inputData, oldFromNew);
+  arma::vec treeCoreDistances;
+  ComputeCoreDistances(tree.Dataset(), 10, treeCoreDistances);
+  for (size_t i = 0; i < inputData.n_cols; ++i)
+    BOOST_REQUIRE_CLOSE(treeCoreDistances[i], coreDistances[oldFromNew[i]],
+        1e-5);
+
+  EuclideanDistance metric;
+  DualTreeBoruvka<> dtb(&tree, metric);
+  arma::mat dualResults;
+  dtb.ComputeMST(dualResults, treeCoreDistances);
+
+  BOOST_REQUIRE_EQUAL(dualResults.n_cols, naiveResults.n_cols);
+  for (size_t i = 0; i < dualResults.n_cols; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(dualResults(2, i), naiveResults(2, i), 1e-5);
+
+    // The edges are given in the order of the tree.
+    const size_t a = oldFromNew[(size_t) dualResults(0, i)];
+    const size_t b = oldFromNew[(size_t) dualResults(1, i)];
+    BOOST_REQUIRE_GE(dualResults(2, i) + 1e-10, coreDistances[a]);
+    BOOST_REQUIRE_GE(dualResults(2, i) + 1e-10, coreDistances[b]);
+    BOOST_REQUIRE_GE(dualResults(2, i) + 1e-10,
+        metric.Evaluate(inputData.col(a), inputData.col(b)));
+  }
+}
+
+/**
+ * Split the dataset into chunks of different sizes, and make sure the
+ * out-of-core computation gives the same MST as the in-memory computation.
+ */
+BOOST_AUTO_TEST_CASE(OutOfCoreTest)
+{
+  arma::mat inputData;
+  if (!data::Load("test_data_3_1000.csv", inputData))
+    BOOST_FAIL("Cannot load test dataset test_data_3_1000.csv!");
+
+  std::vector<std::string> chunkFiles;
+  chunkFiles.push_back("emst_test_chunk_0.csv");
+  chunkFiles.push_back("emst_test_chunk_1.csv");
+  chunkFiles.push_back("emst_test_chunk_2.csv");
+  data::Save(chunkFiles[0], arma::mat(inputData.cols(0, 299)));
+  data::Save(chunkFiles[1], arma::mat(inputData.cols(300, 399)));
+  data::Save(chunkFiles[2], arma::mat(inputData.cols(400, 999)));
+
+  DualTreeBoruvka<> dtb(inputData);
+  OutOfCoreBoruvka<> oocb(chunkFiles);
+
+  arma::mat dtbResults;
+  arma::mat oocbResults;
+  dtb.ComputeMST(dtbResults);
+  oocb.ComputeMST(oocbResults);
+
+  remove(chunkFiles[0].c_str());
+  remove(chunkFiles[1].c_str());
+  remove(chunkFiles[2].c_str());
+
+  BOOST_REQUIRE_EQUAL(dtbResults.n_cols, oocbResults.n_cols);
+  for (size_t i = 0; i < dtbResults.n_cols; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(dtbResults(0, i), oocbResults(0, i));
+    BOOST_REQUIRE_EQUAL(dtbResults(1, i), oocbResults(1, i));
+    BOOST_REQUIRE_CLOSE(dtbResults(2, i), oocbResults(2, i), 1e-5);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
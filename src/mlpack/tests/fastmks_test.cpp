@@ -8,6 +8,8 @@
 #include <mlpack/methods/fastmks/fastmks.hpp>
 #include <mlpack/core/kernels/linear_kernel.hpp>
 #include <mlpack/core/kernels/polynomial_kernel.hpp>
+#include <mlpack/core/kernels/gaussian_kernel.hpp>
+#include <mlpack/core/kernels/cosine_distance.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
@@ -202,4 +204,94 @@ BOOST_AUTO_TEST_CASE(SparsePolynomialFastMKSTest)
 
 }
 
+/**
+ * Make sure that the blocked kernel evaluations are the same as evaluating the
+ * kernel on each pair of points.
+ */
+template<typename KernelType>
+void CheckBlockKernel(KernelType& kernel)
+{
+  arma::mat queries(6, 30, arma::fill::randu);
+  arma::mat references(6, 50, arma::fill::randu);
+
+  arma::mat blockKernels;
+  BlockKernel<KernelType>::Evaluate(kernel, queries, 5, 20, references, 10,
+      35, blockKernels);
+
+  BOOST_REQUIRE_EQUAL(blockKernels.n_rows, 35);
+  BOOST_REQUIRE_EQUAL(blockKernels.n_cols, 20);
+
+  for (size_t q = 0; q < 20; ++q)
+  {
+    for (size_t r = 0; r < 35; ++r)
+    {
+      BOOST_REQUIRE_CLOSE(blockKernels(r, q), kernel.Evaluate(
+          queries.col(5 + q), references.col(10 + r)), 1e-5);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(BlockKernelTest)
+{
+  LinearKernel lk;
+  CheckBlockKernel(lk);
+
+  PolynomialKernel pk(3.0, 1.5);
+  CheckBlockKernel(pk);
+
+  GaussianKernel gk(0.8);
+  CheckBlockKernel(gk);
+
+  // This uses the generic implementation.
+  CosineDistance cd;
+  CheckBlockKernel(cd);
+}
+
+/**
+ * Compare multithreaded naive, single-tree, and dual-tree search with
+ * single-threaded single-tree search.
+ */
+BOOST_AUTO_TEST_CASE(ParallelVsSerial)
+{
+  arma::mat referenceData;
+  referenceData.randn(5, 3000);
+  arma::mat queryData;
+  queryData.randn(5, 500);
+  PolynomialKernel pk(2.0, 1.0);
+
+  FastMKS<PolynomialKernel> serial(referenceData, pk, true);
+
+  arma::Mat<size_t> serialIndices, serialAllIndices;
+  arma::mat serialKernels, serialAllKernels;
+  serial.Search(queryData, 5, serialIndices, serialKernels);
+  serial.Search(5, serialAllIndices, serialAllKernels);
+
+  for (size_t mode = 0; mode < 3; ++mode)
+  {
+    FastMKS<PolynomialKernel> fastmks(referenceData, pk, (mode == 1),
+        (mode == 0));
+    fastmks.NumThreads() = 4;
+
+    arma::Mat<size_t> indices;
+    arma::mat kernels;
+    fastmks.Search(queryData, 5, indices, kernels);
+
+    BOOST_REQUIRE_EQUAL(indices.n_cols, queryData.n_cols);
+    for (size_t i = 0; i < indices.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(indices[i], serialIndices[i]);
+      BOOST_REQUIRE_CLOSE(kernels[i], serialKernels[i], 1e-5);
+    }
+
+    fastmks.Search(5, indices, kernels);
+
+    BOOST_REQUIRE_EQUAL(indices.n_cols, referenceData.n_cols);
+    for (size_t i = 0; i < indices.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(indices[i], serialAllIndices[i]);
+      BOOST_REQUIRE_CLOSE(kernels[i], serialAllKernels[i], 1e-5);
+    }
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -8,6 +8,10 @@
 #include <mlpack/core.hpp>
 
 #include <mlpack/methods/gmm/gmm.hpp>
+#include <mlpack/methods/gmm/diagonal_gmm.hpp>
+#include <mlpack/methods/gmm/online_em_fit.hpp>
+#include <mlpack/methods/gmm/subsampled_kmeans.hpp>
+#include <mlpack/methods/gmm/gmm_tree_scorer.hpp>
 
 #include <mlpack/methods/gmm/no_constraint.hpp>
 #include <mlpack/methods/gmm/positive_definite_constraint.hpp>
@@ -773,5 +777,412 @@ BOOST_AUTO_TEST_CASE(UseExistingModelTest)
   }
 }
 
+/**
+ * Make sure that EM gives the same model with one thread and with several
+ * threads, on a dataset large enough that each thread processes several
+ * chunks of points.
+ */
+BOOST_AUTO_TEST_CASE(GMMParallelEMTest)
+{
+  // Three well-separated Gaussians in 4 dimensions.
+  arma::mat data(4, 6000);
+  for (size_t i = 0; i < 3; ++i)
+  {
+    arma::mat c = arma::randu<arma::mat>(4, 4);
+    data.cols(2000 * i, 2000 * i + 1999) = c * arma::randn<arma::mat>(4, 2000)
+        + 20.0 * (i + 1);
+  }
+
+  // Both models start from the same initial model.
+  std::vector<distribution::GaussianDistribution> dists;
+  for (size_t i = 0; i < 3; ++i)
+    dists.push_back(distribution::GaussianDistribution(data.col(2000 * i),
+        arma::eye<arma::mat>(4, 4)));
+  const arma::vec weights("0.3 0.3 0.4");
+
+  EMFit<> serialFitter(10);
+  GMM<> serialGMM(dists, weights, serialFitter);
+  const double serialLikelihood = serialGMM.Estimate(data, 1, true);
+
+  EMFit<> parallelFitter(10);
+  parallelFitter.NumThreads() = 4;
+  GMM<> parallelGMM(dists, weights, parallelFitter);
+  const double parallelLikelihood = parallelGMM.Estimate(data, 1, true);
+
+  BOOST_REQUIRE_CLOSE(parallelLikelihood, serialLikelihood, 1e-5);
+  for (size_t i = 0; i < 3; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(parallelGMM.Weights()[i], serialGMM.Weights()[i],
+        1e-5);
+
+    for (size_t j = 0; j < 4; ++j)
+    {
+      BOOST_REQUIRE_CLOSE(parallelGMM.Component(i).Mean()[j],
+          serialGMM.Component(i).Mean()[j], 1e-5);
+
+      for (size_t k = 0; k < 4; ++k)
+        BOOST_REQUIRE_CLOSE(parallelGMM.Component(i).Covariance()(j, k),
+            serialGMM.Component(i).Covariance()(j, k), 1e-5);
+    }
+  }
+}
+
+/**
+ * Make sure the batch Probability() and LogProbability() functions match the
+ * single-observation Probability(), and that Classify() picks the most likely
+ * component.
+ */
+BOOST_AUTO_TEST_CASE(GMMBatchProbabilityTest)
+{
+  GMM<> gmm(3, 2);
+  gmm.Component(0).Mean() = "0.0 0.0";
+  gmm.Component(1).Mean() = "3.0 1.0";
+  gmm.Component(1).Covariance(arma::mat("2.0 0.5; 0.5 1.0"));
+  gmm.Component(2).Mean() = "-2.0 4.0";
+  gmm.Component(2).Covariance(arma::mat("0.5 0.0; 0.0 3.0"));
+  gmm.Weights() = "0.2 0.5 0.3";
+
+  arma::mat observations = 3.0 * arma::randn<arma::mat>(2, 100);
+
+  arma::vec probabilities, logProbabilities;
+  gmm.Probability(observations, probabilities);
+  gmm.LogProbability(observations, logProbabilities);
+  arma::Col<size_t> labels;
+  gmm.Classify(observations, labels);
+
+  for (size_t i = 0; i < observations.n_cols; ++i)
+  {
+    const double probability = gmm.Probability(observations.col(i));
+    BOOST_REQUIRE_CLOSE(probabilities[i], probability, 1e-8);
+    BOOST_REQUIRE_CLOSE(logProbabilities[i], std::log(probability), 1e-8);
+
+    for (size_t j = 0; j < 3; ++j)
+      BOOST_REQUIRE_LE(gmm.Probability(observations.col(i), j),
+          gmm.Probability(observations.col(i), labels[i]));
+  }
+}
+
+/**
+ * A DiagonalGMM should train to the same model as a GMM with full covariances
+ * that uses the DiagonalConstraint, when both start from the same model.
+ */
+BOOST_AUTO_TEST_CASE(DiagonalGMMTrainEMTest)
+{
+  // Three Gaussians with diagonal covariances in 3 dimensions.
+  arma::mat data(3, 3000);
+  for (size_t i = 0; i < 3; ++i)
+  {
+    arma::vec stddevs = arma::randu<arma::vec>(3) + 0.5;
+    data.cols(1000 * i, 1000 * i + 999) = arma::diagmat(stddevs) *
+        arma::randn<arma::mat>(3, 1000) + 10.0 * i;
+  }
+
+  std::vector<distribution::GaussianDistribution> dists;
+  std::vector<distribution::DiagonalGaussianDistribution> diagonalDists;
+  for (size_t i = 0; i < 3; ++i)
+  {
+    dists.push_back(distribution::GaussianDistribution(data.col(1000 * i),
+        arma::eye<arma::mat>(3, 3)));
+    diagonalDists.push_back(distribution::DiagonalGaussianDistribution(
+        data.col(1000 * i), arma::ones<arma::vec>(3)));
+  }
+  const arma::vec weights("0.3 0.3 0.4");
+
+  EMFit<kmeans::KMeans<>, DiagonalConstraint> fitter(10);
+  GMM<EMFit<kmeans::KMeans<>, DiagonalConstraint> > gmm(dists, weights,
+      fitter);
+  const double likelihood = gmm.Estimate(data, 1, true);
+
+  DiagonalEMFit<> diagonalFitter(10);
+  DiagonalGMM<> diagonalGMM(diagonalDists, weights, diagonalFitter);
+  const double diagonalLikelihood = diagonalGMM.Estimate(data, 1, true);
+
+  BOOST_REQUIRE_CLOSE(diagonalLikelihood, likelihood, 1e-5);
+  for (size_t i = 0; i < 3; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(diagonalGMM.Weights()[i], gmm.Weights()[i], 1e-5);
+
+    for (size_t j = 0; j < 3; ++j)
+    {
+      BOOST_REQUIRE_CLOSE(diagonalGMM.Component(i).Mean()[j],
+          gmm.Component(i).Mean()[j], 1e-5);
+      BOOST_REQUIRE_CLOSE(diagonalGMM.Component(i).Covariance()[j],
+          gmm.Component(i).Covariance()(j, j), 1e-5);
+    }
+  }
+
+  // The recovered components should be close to the true ones.
+  for (size_t i = 0; i < 3; ++i)
+    for (size_t j = 0; j < 3; ++j)
+      BOOST_REQUIRE_SMALL(diagonalGMM.Component(i).Mean()[j] - 10.0 * i, 0.2);
+}
+
+/**
+ * Train a GMM with online EM, both in memory and from a file, and make sure the
+ * components are recovered.
+ */
+BOOST_AUTO_TEST_CASE(GMMTrainOnlineEMTest)
+{
+  // Three well-separated Gaussians in 2 dimensions, in random order.
+  arma::mat means("0.0 10.0 0.0;"
+                  "0.0 0.0 10.0");
+  arma::vec trueWeights("0.2 0.3 0.5");
+  arma::mat data(2, 10000);
+  arma::Col<size_t> labels(10000);
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    const double r = math::Random();
+    labels[i] = (r < 0.2) ? 0 : ((r < 0.5) ? 1 : 2);
+    data.col(i) = means.col(labels[i]) + arma::randn<arma::vec>(2);
+  }
+
+  // Start from a model near the true model, so the components are in the same
+  // order.
+  std::vector<distribution::GaussianDistribution> dists;
+  for (size_t i = 0; i < 3; ++i)
+    dists.push_back(distribution::GaussianDistribution(means.col(i) + 1.0,
+        arma::eye<arma::mat>(2, 2)));
+  arma::vec weights("0.3 0.3 0.4");
+
+  OnlineEMFit<> fitter(500, 3);
+  GMM<OnlineEMFit<> > gmm(dists, weights, fitter);
+  gmm.Estimate(data, 1, true);
+  BOOST_REQUIRE_EQUAL(fitter.Steps(), 60);
+
+  for (size_t i = 0; i < 3; ++i)
+  {
+    BOOST_REQUIRE_SMALL(gmm.Weights()[i] - trueWeights[i], 0.03);
+    for (size_t j = 0; j < 2; ++j)
+    {
+      BOOST_REQUIRE_SMALL(gmm.Component(i).Mean()[j] - means(j, i), 0.15);
+      BOOST_REQUIRE_SMALL(gmm.Component(i).Covariance()(j, j) - 1.0, 0.15);
+    }
+  }
+
+  // Continuing with more data keeps the statistics.
+  gmm.Estimate(data.cols(0, 999), 1, true);
+  BOOST_REQUIRE_EQUAL(fitter.Steps(), 62);
+
+  // Now stream the data from a file, with diagonal Gaussians.
+  data::Save("online_em_test.csv", data);
+
+  std::vector<distribution::DiagonalGaussianDistribution> diagonalDists;
+  for (size_t i = 0; i < 3; ++i)
+    diagonalDists.push_back(distribution::DiagonalGaussianDistribution(
+        means.col(i) + 1.0, arma::ones<arma::vec>(2)));
+  weights = "0.3 0.3 0.4";
+
+  data::ChunkReader reader("online_em_test.csv");
+  OnlineEMFit<kmeans::KMeans<>, PositiveDefiniteConstraint,
+      distribution::DiagonalGaussianDistribution> diagonalFitter(500, 2);
+  diagonalFitter.Estimate(reader, diagonalDists, weights, true);
+  BOOST_REQUIRE_EQUAL(diagonalFitter.Steps(), 40);
+
+  for (size_t i = 0; i < 3; ++i)
+  {
+    BOOST_REQUIRE_SMALL(weights[i] - trueWeights[i], 0.03);
+    for (size_t j = 0; j < 2; ++j)
+    {
+      BOOST_REQUIRE_SMALL(diagonalDists[i].Mean()[j] - means(j, i), 0.15);
+      BOOST_REQUIRE_SMALL(diagonalDists[i].Covariance()[j] - 1.0, 0.15);
+    }
+  }
+
+  remove("online_em_test.csv");
+}
+
+/**
+ * The trials of GMM::Estimate() with online EM must not share the statistics of
+ * the fitter: each trial starts from the same fitter.
+ */
+BOOST_AUTO_TEST_CASE(GMMTrainOnlineEMTrialsTest)
+{
+  arma::mat means("0.0 10.0;"
+                  "0.0 0.0");
+  arma::mat data(2, 2000);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    data.col(i) = means.col(i % 2) + arma::randn<arma::vec>(2);
+
+  std::vector<distribution::GaussianDistribution> dists;
+  for (size_t i = 0; i < 2; ++i)
+    dists.push_back(distribution::GaussianDistribution(means.col(i) + 1.0,
+        arma::eye<arma::mat>(2, 2)));
+  arma::vec weights("0.4 0.6");
+
+  // Each trial takes 2 passes of 4 mini-batches.
+  OnlineEMFit<> fitter(500, 2);
+  GMM<OnlineEMFit<> > gmm(dists, weights, fitter);
+  gmm.Estimate(data, 3, true);
+  BOOST_REQUIRE_EQUAL(fitter.Steps(), 8);
+
+  // The same holds when the fitter already has statistics from earlier calls.
+  gmm.Estimate(data, 3, true);
+  BOOST_REQUIRE_EQUAL(fitter.Steps(), 16);
+
+  for (size_t i = 0; i < 2; ++i)
+  {
+    BOOST_REQUIRE_SMALL(gmm.Weights()[i] - 0.5, 0.05);
+    for (size_t j = 0; j < 2; ++j)
+      BOOST_REQUIRE_SMALL(gmm.Component(i).Mean()[j] - means(j, i), 0.2);
+  }
+}
+
+/**
+ * Train a GMM initialized from k-means on a subsample, with the trials run one
+ * at a time and in parallel, and make sure the components are recovered and
+ * both give the same result.
+ */
+BOOST_AUTO_TEST_CASE(GMMTrainSubsampledKMeansTest)
+{
+  // Three well-separated Gaussians in 2 dimensions.
+  arma::mat means("0.0 10.0 0.0;"
+                  "0.0 0.0 10.0");
+  arma::mat data(2, 6000);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    data.col(i) = means.col(i % 3) + arma::randn<arma::vec>(2);
+
+  typedef EMFit<SubsampledKMeans<> > FitterType;
+  FitterType fitter(300, 1e-10, SubsampledKMeans<>(500));
+  BOOST_REQUIRE_EQUAL(fitter.Clusterer().SampleSize(), 500);
+
+  const size_t seed = (size_t) std::time(NULL);
+  math::RandomSeed(seed);
+  GMM<FitterType> gmm(3, 2, fitter);
+  const double likelihood = gmm.Estimate(data, 4);
+
+  // Each true mean should be close to one of the components.
+  for (size_t i = 0; i < 3; ++i)
+  {
+    double minDistance = DBL_MAX;
+    for (size_t j = 0; j < 3; ++j)
+      minDistance = std::min(minDistance, metric::EuclideanDistance::Evaluate(
+          means.col(i), gmm.Component(j).Mean()));
+
+    BOOST_REQUIRE_SMALL(minDistance, 0.2);
+  }
+
+  // When the trials run in parallel, each draws its seed as it starts, so the
+  // seeds may go to different trials; but the same set of seeds is drawn, so
+  // the best log-likelihood is the same.
+  math::RandomSeed(seed);
+  GMM<FitterType> parallelGMM(3, 2, fitter);
+  parallelGMM.NumThreads() = 4;
+  const double parallelLikelihood = parallelGMM.Estimate(data, 4);
+
+  BOOST_REQUIRE_CLOSE(parallelLikelihood, likelihood, 1e-8);
+}
+
+/**
+ * Make sure that the log-probabilities computed with GMMTreeScorer are within
+ * their error bounds of the exact log-probabilities, and that most of the
+ * components are pruned.
+ */
+BOOST_AUTO_TEST_CASE(GMMTreeScorerTest)
+{
+  // 1024 narrow Gaussians on a 32x32 grid.
+  GMM<> gmm(1024, 2);
+  for (size_t i = 0; i < 1024; ++i)
+  {
+    gmm.Component(i).Mean()[0] = 10.0 * (i % 32);
+    gmm.Component(i).Mean()[1] = 10.0 * (i / 32);
+
+    arma::mat covariance = 0.5 * arma::randu<arma::mat>(2, 2);
+    covariance = covariance * trans(covariance) + arma::eye<arma::mat>(2, 2);
+    gmm.Component(i).Covariance(std::move(covariance));
+  }
+  gmm.Weights().randu();
+  gmm.Weights() += 0.1;
+  gmm.Weights() /= accu(gmm.Weights());
+
+  arma::mat queries = 330.0 * arma::randu<arma::mat>(2, 500) - 5.0;
+  arma::vec exactLogProbabilities;
+  gmm.LogProbability(queries, exactLogProbabilities);
+
+  GMMTreeScorer<> scorer(gmm, 1e-3);
+  BOOST_REQUIRE_EQUAL(scorer.Components(), 1024);
+
+  arma::vec logProbabilities, errorBounds;
+  scorer.LogProbability(queries, logProbabilities, errorBounds);
+  BOOST_REQUIRE_LT(scorer.BaseCases(), 1024 * 500 / 4);
+
+  for (size_t i = 0; i < queries.n_cols; ++i)
+  {
+    const double error = exactLogProbabilities[i] - logProbabilities[i];
+    BOOST_REQUIRE_GE(error, -1e-10);
+    BOOST_REQUIRE_LE(error, errorBounds[i] + 1e-10);
+    BOOST_REQUIRE_LE(errorBounds[i], std::log1p(1e-3) + 1e-10);
+  }
+
+  double errorBound;
+  const double logLikelihood = scorer.LogLikelihood(queries, errorBound);
+  BOOST_REQUIRE_CLOSE(logLikelihood, accu(logProbabilities), 1e-10);
+  BOOST_REQUIRE_CLOSE(errorBound, accu(errorBounds), 1e-10);
+
+  // The same results should be found in parallel.
+  scorer.NumThreads() = 4;
+  arma::vec parallelLogProbabilities, parallelErrorBounds;
+  scorer.LogProbability(queries, parallelLogProbabilities, parallelErrorBounds);
+  for (size_t i = 0; i < queries.n_cols; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(parallelLogProbabilities[i], logProbabilities[i],
+        1e-10);
+    BOOST_REQUIRE_SMALL(parallelErrorBounds[i] - errorBounds[i], 1e-12);
+  }
+
+  // With a tolerance of 0, the result is exact.
+  scorer.Tolerance() = 0.0;
+  scorer.LogProbability(queries, logProbabilities, errorBounds);
+  for (size_t i = 0; i < queries.n_cols; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(logProbabilities[i], exactLogProbabilities[i], 1e-8);
+    BOOST_REQUIRE_EQUAL(errorBounds[i], 0.0);
+  }
+}
+
+/**
+ * Copies of a GMMTreeScorer must have their own tree, and must give the same
+ * results as the original after it is destroyed; moved scorers must keep
+ * working too.
+ */
+BOOST_AUTO_TEST_CASE(GMMTreeScorerCopyTest)
+{
+  GMM<> gmm(50, 3);
+  for (size_t i = 0; i < 50; ++i)
+    gmm.Component(i).Mean() = 10.0 * arma::randu<arma::vec>(3);
+  gmm.Weights().fill(1.0 / 50);
+
+  arma::mat queries = 10.0 * arma::randu<arma::mat>(3, 100);
+  arma::vec logProbabilities, errorBounds;
+
+  GMMTreeScorer<>* original = new GMMTreeScorer<>(gmm, 1e-3, 5);
+  original->LogProbability(queries, logProbabilities, errorBounds);
+
+  GMMTreeScorer<> copy(*original);
+  GMMTreeScorer<> assigned(gmm, 0.5, 10);
+  assigned = *original;
+  BOOST_REQUIRE_NE(&copy.ReferenceTree(), &original->ReferenceTree());
+  BOOST_REQUIRE_NE(&assigned.ReferenceTree(), &original->ReferenceTree());
+  delete original;
+
+  // One scorer for each of several models, as for the states of an HMM.
+  std::vector<GMMTreeScorer<> > scorers;
+  scorers.push_back(copy);
+  scorers.push_back(std::move(assigned));
+  scorers.push_back(GMMTreeScorer<>(gmm, 1e-3, 5));
+
+  for (size_t s = 0; s < scorers.size(); ++s)
+  {
+    BOOST_REQUIRE_EQUAL(scorers[s].Components(), 50);
+    BOOST_REQUIRE_CLOSE(scorers[s].Tolerance(), 1e-3, 1e-10);
+
+    arma::vec copyLogProbabilities, copyErrorBounds;
+    scorers[s].LogProbability(queries, copyLogProbabilities, copyErrorBounds);
+    for (size_t i = 0; i < queries.n_cols; ++i)
+    {
+      BOOST_REQUIRE_CLOSE(copyLogProbabilities[i], logProbabilities[i], 1e-8);
+      BOOST_REQUIRE_SMALL(copyErrorBounds[i] - errorBounds[i], 1e-10);
+    }
+  }
+}
 
 BOOST_AUTO_TEST_SUITE_END();
@@ -5,7 +5,10 @@
  */
 #include <mlpack/core.hpp>
 #include <mlpack/methods/hmm/hmm.hpp>
+#include <mlpack/methods/hmm/streaming_decoder.hpp>
+#include <mlpack/methods/hmm/hmm_util.hpp>
 #include <mlpack/methods/gmm/gmm.hpp>
+#include <mlpack/methods/gmm/gmm_tree_scorer.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
@@ -152,6 +155,262 @@ BOOST_AUTO_TEST_CASE(ForwardBackwardTwoState)
   BOOST_REQUIRE_SMALL(stateProb(1, 9), 1e-5);
 }
 
+/**
+ * Ensure that the forward-backward algorithm in log space gives the same
+ * results as the scaled one.
+ */
+BOOST_AUTO_TEST_CASE(LogForwardBackwardTwoState)
+{
+  arma::mat obs("3 3 2 1 1 1 1 3 3 1");
+
+  arma::vec initial("0.1 0.4");
+  arma::mat transition("0.1 0.9; 0.4 0.6");
+  std::vector<DiscreteDistribution> emis(2);
+  emis[0] = DiscreteDistribution("0.85 0.15 0.00 0.00");
+  emis[1] = DiscreteDistribution("0.00 0.00 0.50 0.50");
+
+  HMM<DiscreteDistribution> hmm(initial, transition, emis);
+
+  arma::mat stateProb;
+  const double loglik = hmm.Estimate(obs, stateProb);
+
+  arma::mat stateLogProb;
+  arma::mat forwardLogProb;
+  arma::mat backwardLogProb;
+  const double logLoglik = hmm.LogEstimate(obs, stateLogProb, forwardLogProb,
+      backwardLogProb);
+
+  BOOST_REQUIRE_CLOSE(logLoglik, -23.4349, 1e-3);
+  BOOST_REQUIRE_CLOSE(logLoglik, loglik, 1e-5);
+
+  BOOST_REQUIRE_EQUAL(stateLogProb.n_rows, 2);
+  BOOST_REQUIRE_EQUAL(stateLogProb.n_cols, obs.n_cols);
+  for (size_t i = 0; i < stateProb.n_elem; ++i)
+  {
+    if (stateProb[i] < 1e-10)
+      BOOST_REQUIRE_SMALL(std::exp(stateLogProb[i]), 1e-10);
+    else
+      BOOST_REQUIRE_CLOSE(std::exp(stateLogProb[i]), stateProb[i], 1e-5);
+  }
+}
+
+/**
+ * Make sure that the Viterbi algorithm and the log-space forward-backward
+ * algorithm work with a left-to-right model, whose transition matrix is sparse.
+ */
+BOOST_AUTO_TEST_CASE(LeftToRightGaussianHMMTest)
+{
+  // Each state either stays or moves to the next one.
+  const size_t states = 30;
+  arma::mat transition(states, states, arma::fill::zeros);
+  std::vector<GaussianDistribution> emissions(states);
+  for (size_t i = 0; i < states; ++i)
+  {
+    if (i + 1 < states)
+    {
+      transition(i, i) = 0.9;
+      transition(i + 1, i) = 0.1;
+    }
+    else
+    {
+      transition(i, i) = 1.0;
+    }
+
+    emissions[i] = GaussianDistribution(arma::vec(1).fill(5.0 * i),
+        arma::mat(1, 1).fill(1.0));
+  }
+
+  arma::vec initial(states, arma::fill::zeros);
+  initial[0] = 1.0;
+  HMM<GaussianDistribution> hmm(initial, transition, emissions);
+
+  arma::mat observations;
+  arma::Col<size_t> trueStates;
+  hmm.Generate(300, observations, trueStates, 0);
+
+  arma::Col<size_t> predictedStates;
+  const double viterbiLoglik = hmm.Predict(observations, predictedStates);
+
+  // The path must be possible, and the states are far enough apart that it
+  // should be almost always right.
+  BOOST_REQUIRE_EQUAL(predictedStates[0], (size_t) 0);
+  size_t correct = 0;
+  for (size_t t = 0; t < predictedStates.n_elem; ++t)
+  {
+    if (t > 0)
+      BOOST_REQUIRE_GT(transition(predictedStates[t], predictedStates[t - 1]),
+          0.0);
+    if (predictedStates[t] == trueStates[t])
+      ++correct;
+  }
+  BOOST_REQUIRE_GE(correct, (size_t) 290);
+
+  // The log-likelihood of the sequence can't be less than that of its most
+  // likely path, and must match the scaled forward algorithm.
+  arma::mat stateLogProb;
+  arma::mat forwardLogProb;
+  arma::mat backwardLogProb;
+  const double loglik = hmm.LogEstimate(observations, stateLogProb,
+      forwardLogProb, backwardLogProb);
+  BOOST_REQUIRE_GE(loglik, viterbiLoglik);
+  BOOST_REQUIRE_CLOSE(loglik, hmm.LogLikelihood(observations), 1e-5);
+
+  // Each column of state probabilities sums to one.
+  for (size_t t = 0; t < observations.n_cols; ++t)
+    BOOST_REQUIRE_CLOSE(arma::accu(arma::exp(stateLogProb.col(t))), 1.0, 1e-5);
+}
+
+/**
+ * Decode the given sequence with a streaming decoder, in chunks of the given
+ * size, and return all the decisions.
+ */
+template<typename Distribution>
+arma::Col<size_t> StreamDecode(StreamingDecoder<Distribution>& decoder,
+                               const arma::mat& observations,
+                               const size_t chunkSize)
+{
+  arma::Col<size_t> result;
+  arma::Col<size_t> decisions;
+  for (size_t begin = 0; begin < observations.n_cols; begin += chunkSize)
+  {
+    const size_t end = std::min(begin + chunkSize,
+        (size_t) observations.n_cols);
+    decoder.Update(observations.cols(begin, end - 1), decisions);
+    BOOST_REQUIRE_EQUAL(decoder.Time(), end);
+    BOOST_REQUIRE_EQUAL(result.n_elem + decisions.n_elem, decoder.Decided());
+    result = arma::join_cols(result, decisions);
+  }
+
+  decoder.Finish(decisions);
+  return arma::join_cols(result, decisions);
+}
+
+/**
+ * With a lag as long as the stream, the streaming decoder must give the same
+ * states as the Viterbi algorithm, no matter how the stream is split; with a
+ * short lag, it should still be almost always right.
+ */
+BOOST_AUTO_TEST_CASE(StreamingDecoderTest)
+{
+  // A dense model and a sparse (left-to-right) one.
+  HMM<GaussianDistribution> dense(3, GaussianDistribution(2));
+  dense.Transition() = arma::mat("0.4 0.6 0.8; 0.2 0.2 0.1; 0.4 0.2 0.1");
+  dense.Emission()[0] = GaussianDistribution("0.0 0.0", "1.0 0.0; 0.0 1.0");
+  dense.Emission()[1] = GaussianDistribution("2.0 2.0", "1.0 0.5; 0.5 1.2");
+  dense.Emission()[2] = GaussianDistribution("-2.0 1.0", "2.0 0.1; 0.1 1.0");
+
+  const size_t states = 30;
+  arma::mat transition(states, states, arma::fill::zeros);
+  std::vector<GaussianDistribution> emissions(states);
+  for (size_t i = 0; i < states; ++i)
+  {
+    transition(i, i) = (i + 1 < states) ? 0.9 : 1.0;
+    if (i + 1 < states)
+      transition(i + 1, i) = 0.1;
+    emissions[i] = GaussianDistribution(arma::vec(2).fill(3.0 * i),
+        arma::mat(2, 2, arma::fill::eye));
+  }
+  arma::vec initial(states, arma::fill::zeros);
+  initial[0] = 1.0;
+  HMM<GaussianDistribution> sparse(initial, transition, emissions);
+
+  std::vector<HMM<GaussianDistribution>*> hmms;
+  hmms.push_back(&dense);
+  hmms.push_back(&sparse);
+  for (size_t h = 0; h < hmms.size(); ++h)
+  {
+    const HMM<GaussianDistribution>& hmm = *hmms[h];
+    arma::mat observations;
+    arma::Col<size_t> trueStates;
+    hmm.Generate(250, observations, trueStates, 0);
+
+    arma::Col<size_t> predicted;
+    hmm.Predict(observations, predicted);
+
+    StreamingDecoder<GaussianDistribution> decoder(hmm, 250);
+    const size_t chunkSizes[] = { 1, 7, 250 };
+    for (size_t c = 0; c < 3; ++c)
+    {
+      const arma::Col<size_t> streamed = StreamDecode(decoder, observations,
+          chunkSizes[c]);
+      BOOST_REQUIRE_EQUAL(streamed.n_elem, predicted.n_elem);
+      for (size_t t = 0; t < predicted.n_elem; ++t)
+        BOOST_REQUIRE_EQUAL(streamed[t], predicted[t]);
+    }
+
+    // The log-likelihood of the stream is that of the sequence.
+    arma::Col<size_t> decisions;
+    decoder.Update(observations, decisions);
+    BOOST_REQUIRE_EQUAL(decisions.n_elem, (size_t) 0);
+    BOOST_REQUIRE_CLOSE(decoder.LogLikelihood(),
+        hmm.LogLikelihood(observations), 1e-5);
+    BOOST_REQUIRE_CLOSE(arma::accu(decoder.StateProbabilities()), 1.0, 1e-5);
+    decoder.Reset();
+    BOOST_REQUIRE_EQUAL(decoder.Time(), (size_t) 0);
+
+    // A short lag.
+    StreamingDecoder<GaussianDistribution> lagged(hmm, 5);
+    const arma::Col<size_t> streamed = StreamDecode(lagged, observations, 3);
+    BOOST_REQUIRE_EQUAL(streamed.n_elem, predicted.n_elem);
+    size_t same = 0;
+    for (size_t t = 0; t < predicted.n_elem; ++t)
+      if (streamed[t] == predicted[t])
+        ++same;
+    BOOST_REQUIRE_GE(same, (size_t) 225);
+
+    // With a lag of 0, each state is decided as soon as its observation
+    // arrives, and there is nothing left to decide at the end.  The last
+    // decision is the end of the most likely sequence.
+    StreamingDecoder<GaussianDistribution> greedy(hmm, 0);
+    const arma::Col<size_t> immediate = StreamDecode(greedy, observations, 4);
+    BOOST_REQUIRE_EQUAL(immediate.n_elem, predicted.n_elem);
+    BOOST_REQUIRE_EQUAL(immediate[immediate.n_elem - 1],
+        predicted[predicted.n_elem - 1]);
+
+    greedy.Update(observations.cols(0, 9), decisions);
+    BOOST_REQUIRE_EQUAL(decisions.n_elem, (size_t) 10);
+    greedy.Finish(decisions);
+    BOOST_REQUIRE_EQUAL(decisions.n_elem, (size_t) 0);
+    BOOST_REQUIRE_EQUAL(greedy.Time(), (size_t) 0);
+  }
+}
+
+/**
+ * An observation that is impossible given the earlier ones must not fill the
+ * forward vector with NaNs: it is restarted from the initial distribution, and
+ * the log-likelihood becomes -infinity.
+ */
+BOOST_AUTO_TEST_CASE(StreamingDecoderImpossibleObservationTest)
+{
+  // Each state emits only its own symbol and never leaves.
+  HMM<DiscreteDistribution> hmm(2, DiscreteDistribution(2));
+  hmm.Initial() = "0.7 0.3";
+  hmm.Transition() = arma::eye<arma::mat>(2, 2);
+  hmm.Emission()[0] = DiscreteDistribution("1.0 0.0");
+  hmm.Emission()[1] = DiscreteDistribution("0.0 1.0");
+
+  StreamingDecoder<DiscreteDistribution> decoder(hmm, 1);
+  arma::Col<size_t> decisions;
+  decoder.Update(arma::mat("0 0"), decisions);
+  BOOST_REQUIRE_CLOSE(decoder.LogLikelihood(), std::log(0.7), 1e-5);
+  BOOST_REQUIRE_CLOSE(decoder.StateProbabilities()[0], 1.0, 1e-5);
+  BOOST_REQUIRE_SMALL(decoder.StateProbabilities()[1], 1e-5);
+
+  // State 1 can emit this symbol, but it can't be reached from state 0.
+  decoder.Update(arma::mat("1"), decisions);
+  BOOST_REQUIRE_EQUAL(decoder.Time(), (size_t) 3);
+  BOOST_REQUIRE(std::isinf(decoder.LogLikelihood()));
+  BOOST_REQUIRE_LT(decoder.LogLikelihood(), 0.0);
+  BOOST_REQUIRE_CLOSE(decoder.StateProbabilities()[0], 0.7, 1e-5);
+  BOOST_REQUIRE_CLOSE(decoder.StateProbabilities()[1], 0.3, 1e-5);
+
+  // The stream goes on from the restarted forward vector.
+  decoder.Update(arma::mat("1"), decisions);
+  BOOST_REQUIRE(std::isinf(decoder.LogLikelihood()));
+  BOOST_REQUIRE_SMALL(decoder.StateProbabilities()[0], 1e-5);
+  BOOST_REQUIRE_CLOSE(decoder.StateProbabilities()[1], 1.0, 1e-5);
+}
+
 /**
  * In this example we try to estimate the transmission and emission matrices
  * based on some observations.  We use the simplest possible model.
@@ -764,6 +1023,62 @@ BOOST_AUTO_TEST_CASE(GaussianHMMGenerateTest)
   }
 }
 
+/**
+ * Make sure that Baum-Welch training gives the same model (up to rounding) no
+ * matter how many threads are used, and that the log-likelihood of the
+ * training sequences does not decrease.
+ */
+BOOST_AUTO_TEST_CASE(GaussianHMMParallelTrainTest)
+{
+  HMM<GaussianDistribution> hmm(3, GaussianDistribution(2));
+  hmm.Transition() = arma::mat("0.4 0.6 0.8; 0.2 0.2 0.1; 0.4 0.2 0.1");
+  hmm.Emission()[0] = GaussianDistribution("0.0 0.0", "1.0 0.0; 0.0 1.0");
+  hmm.Emission()[1] = GaussianDistribution("2.0 2.0", "1.0 0.5; 0.5 1.2");
+  hmm.Emission()[2] = GaussianDistribution("-2.0 1.0", "2.0 0.1; 0.1 1.0");
+
+  // Generate a few sequences of different lengths.
+  std::vector<arma::mat> observations(7);
+  for (size_t i = 0; i < observations.size(); ++i)
+  {
+    arma::Col<size_t> states;
+    hmm.Generate(200 + 50 * i, observations[i], states, i % 3);
+  }
+
+  // Start from a perturbed model.
+  HMM<GaussianDistribution> hmm1(3, GaussianDistribution(2));
+  hmm1.Transition() = arma::mat("0.3 0.3 0.5; 0.3 0.4 0.2; 0.4 0.3 0.3");
+  hmm1.Emission()[0] = GaussianDistribution("0.5 0.0", "1.0 0.0; 0.0 1.0");
+  hmm1.Emission()[1] = GaussianDistribution("1.5 1.5", "1.0 0.0; 0.0 1.0");
+  hmm1.Emission()[2] = GaussianDistribution("-1.5 0.5", "1.0 0.0; 0.0 1.0");
+  HMM<GaussianDistribution> hmm4(hmm1);
+  hmm4.NumThreads() = 4;
+
+  double oldLoglik = 0.0;
+  for (size_t i = 0; i < observations.size(); ++i)
+    oldLoglik += hmm1.LogLikelihood(observations[i]);
+
+  hmm1.Train(observations);
+  hmm4.Train(observations);
+
+  double loglik = 0.0;
+  for (size_t i = 0; i < observations.size(); ++i)
+    loglik += hmm1.LogLikelihood(observations[i]);
+  BOOST_REQUIRE_GE(loglik, oldLoglik);
+
+  for (size_t i = 0; i < hmm1.Transition().n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(hmm1.Transition()[i], hmm4.Transition()[i], 1e-3);
+
+  for (size_t em = 0; em < 3; ++em)
+  {
+    for (size_t d = 0; d < 2; ++d)
+      BOOST_REQUIRE_CLOSE(hmm1.Emission()[em].Mean()[d],
+          hmm4.Emission()[em].Mean()[d], 1e-3);
+    for (size_t i = 0; i < 4; ++i)
+      BOOST_REQUIRE_CLOSE(hmm1.Emission()[em].Covariance()[i],
+          hmm4.Emission()[em].Covariance()[i], 1e-3);
+  }
+}
+
 /**
  * Test that HMMs work with Gaussian mixture models.  We'll try putting in a
  * simple model by hand and making sure that prediction of observation sequences
@@ -1154,5 +1469,137 @@ BOOST_AUTO_TEST_CASE(DiscreteHMMLoadSaveTest)
           hmm2.Emission()[j].Probabilities()[i], 1e-3);
 }
 
+/**
+ * Make sure that a batch of sequences is loaded correctly both from a list of
+ * files and from one file with offsets.
+ */
+BOOST_AUTO_TEST_CASE(LoadSequencesTest)
+{
+  arma::mat dataset(2, 20);
+  dataset.randu();
+  data::Save("hmm_sequences_test.csv", dataset);
+
+  // Sequences of length 5, 3, and 12.
+  arma::Col<size_t> offsets("0 5 8");
+  data::Save("hmm_offsets_test.csv", offsets, true, false);
+
+  std::vector<arma::mat> sequences;
+  LoadSequences("hmm_sequences_test.csv", "hmm_offsets_test.csv", 2,
+      sequences);
+  BOOST_REQUIRE_EQUAL(sequences.size(), 3);
+  BOOST_REQUIRE_EQUAL(sequences[0].n_cols, 5);
+  BOOST_REQUIRE_EQUAL(sequences[1].n_cols, 3);
+  BOOST_REQUIRE_EQUAL(sequences[2].n_cols, 12);
+  for (size_t s = 0; s < sequences.size(); ++s)
+    for (size_t i = 0; i < sequences[s].n_elem; ++i)
+      BOOST_REQUIRE_CLOSE(sequences[s][i], dataset[2 * offsets[s] + i], 1e-3);
+
+  // Now a list of files.
+  data::Save("hmm_sequence_0_test.csv", sequences[0]);
+  data::Save("hmm_sequence_1_test.csv", sequences[2]);
+  std::ofstream list("hmm_sequence_list_test.txt");
+  list << "hmm_sequence_0_test.csv" << std::endl;
+  list << "hmm_sequence_1_test.csv" << std::endl;
+  list.close();
+
+  std::vector<arma::mat> listed;
+  LoadSequences("hmm_sequence_list_test.txt", "", 2, listed);
+  BOOST_REQUIRE_EQUAL(listed.size(), 2);
+  BOOST_REQUIRE_EQUAL(listed[0].n_cols, 5);
+  BOOST_REQUIRE_EQUAL(listed[1].n_cols, 12);
+  for (size_t i = 0; i < listed[1].n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(listed[1][i], sequences[2][i], 1e-3);
+
+  remove("hmm_sequences_test.csv");
+  remove("hmm_offsets_test.csv");
+  remove("hmm_sequence_0_test.csv");
+  remove("hmm_sequence_1_test.csv");
+  remove("hmm_sequence_list_test.txt");
+}
+
+/**
+ * Offsets that don't start at 0, are not strictly increasing, or are out of
+ * range must be rejected.
+ */
+BOOST_AUTO_TEST_CASE(LoadSequencesInvalidOffsetsTest)
+{
+  arma::mat dataset(2, 20);
+  dataset.randu();
+  data::Save("hmm_sequences_test.csv", dataset);
+
+  const char* invalidOffsets[] = { "3 5 8", "0 8 5", "0 5 5", "0 5 20",
+      "0 5 25" };
+  std::vector<arma::mat> sequences;
+  for (size_t i = 0; i < 5; ++i)
+  {
+    arma::Col<size_t> offsets(invalidOffsets[i]);
+    data::Save("hmm_offsets_test.csv", offsets, true, false);
+    BOOST_REQUIRE_THROW(LoadSequences("hmm_sequences_test.csv",
+        "hmm_offsets_test.csv", 2, sequences), std::runtime_error);
+  }
+
+  remove("hmm_sequences_test.csv");
+  remove("hmm_offsets_test.csv");
+}
+
+/**
+ * Make sure that the log-likelihood of a GMM HMM computed from emission
+ * log-probabilities is the same as LogLikelihood(), and that approximate
+ * emission log-probabilities from GMMTreeScorer give a log-likelihood within
+ * the sum of their error bounds.
+ */
+BOOST_AUTO_TEST_CASE(GMMHMMEmissionLogLikelihoodTest)
+{
+  // Two states, each with 200 components spread over a line.
+  HMM<GMM<> > hmm(2, GMM<>(200, 2));
+  hmm.Transition() = arma::mat("0.9 0.2;"
+                               "0.1 0.8");
+  for (size_t j = 0; j < hmm.Emission().size(); ++j)
+  {
+    hmm.Emission()[j].Weights().fill(1.0 / 200);
+    for (size_t i = 0; i < hmm.Emission()[j].Gaussians(); ++i)
+    {
+      hmm.Emission()[j].Component(i).Mean()[0] = 5.0 * i;
+      hmm.Emission()[j].Component(i).Mean()[1] = 10.0 * j;
+      hmm.Emission()[j].Component(i).Covariance(
+          arma::eye<arma::mat>(2, 2));
+    }
+  }
+
+  arma::mat dataSeq = 1000.0 * arma::randu<arma::mat>(2, 100);
+  dataSeq.row(1) = 10.0 * arma::randu<arma::rowvec>(100);
+
+  arma::mat emissionLogProb(2, dataSeq.n_cols);
+  arma::vec logProbabilities;
+  for (size_t j = 0; j < 2; ++j)
+  {
+    hmm.Emission()[j].LogProbability(dataSeq, logProbabilities);
+    emissionLogProb.row(j) = trans(logProbabilities);
+  }
+
+  const double logLikelihood = hmm.LogLikelihood(dataSeq);
+  BOOST_REQUIRE_CLOSE(hmm.EmissionLogLikelihood(emissionLogProb),
+      logLikelihood, 1e-5);
+
+  // Now approximate the emission log-probabilities.  The log-likelihood can be
+  // underestimated by at most the largest error of each observation.
+  arma::mat errorBounds(2, dataSeq.n_cols);
+  arma::vec bounds;
+  for (size_t j = 0; j < 2; ++j)
+  {
+    GMMTreeScorer<> scorer(hmm.Emission()[j], 1e-2);
+    scorer.LogProbability(dataSeq, logProbabilities, bounds);
+    emissionLogProb.row(j) = trans(logProbabilities);
+    errorBounds.row(j) = trans(bounds);
+  }
+
+  const double errorBound = accu(arma::max(errorBounds, 0));
+  const double approximateLogLikelihood =
+      hmm.EmissionLogLikelihood(emissionLogProb);
+  BOOST_REQUIRE_LE(approximateLogLikelihood, logLikelihood + 1e-8);
+  BOOST_REQUIRE_GE(approximateLogLikelihood,
+      logLikelihood - errorBound - 1e-8);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
 
@@ -7,10 +7,16 @@
 #include <mlpack/methods/kmeans/kmeans.hpp>
 #include <mlpack/methods/kmeans/allow_empty_clusters.hpp>
 #include <mlpack/methods/kmeans/refined_start.hpp>
+#include <mlpack/methods/kmeans/kmeans_plus_plus.hpp>
+#include <mlpack/methods/kmeans/kmeans_parallel.hpp>
 #include <mlpack/methods/kmeans/elkan_kmeans.hpp>
 #include <mlpack/methods/kmeans/hamerly_kmeans.hpp>
 #include <mlpack/methods/kmeans/pelleg_moore_kmeans.hpp>
 #include <mlpack/methods/kmeans/dual_tree_kmeans.hpp>
+#include <mlpack/methods/kmeans/mini_batch_kmeans.hpp>
+#include <mlpack/methods/kmeans/yinyang_kmeans.hpp>
+#include <mlpack/methods/kmeans/streaming_mini_batch_kmeans.hpp>
+#include <mlpack/methods/kmeans/out_of_core_kmeans.hpp>
 
 #include <mlpack/core/tree/cover_tree/cover_tree.hpp>
 #include <mlpack/methods/neighbor_search/neighbor_search.hpp>
@@ -564,6 +570,46 @@ BOOST_AUTO_TEST_CASE(HamerlyTest)
   }
 }
 
+BOOST_AUTO_TEST_CASE(YinyangTest)
+{
+  const size_t trials = 5;
+
+  for (size_t t = 0; t < trials; ++t)
+  {
+    arma::mat dataset(10, 1000);
+    dataset.randu();
+
+    const size_t k = 10 * (t + 1);
+    arma::mat centroids(10, k);
+    centroids.randu();
+
+    arma::mat naiveCentroids(centroids);
+    KMeans<> km;
+    arma::Col<size_t> assignments;
+    km.Cluster(dataset, k, assignments, naiveCentroids, false, true);
+
+    // Try the default number of groups, one group, a few groups, and one group
+    // per centroid.
+    const size_t groups[] = { 0, 1, 3, k };
+    for (size_t g = 0; g < 4; ++g)
+    {
+      KMeans<metric::EuclideanDistance, RandomPartition, MaxVarianceNewCluster,
+          YinyangKMeans> yinyang;
+      yinyang.NumGroups() = groups[g];
+      arma::Col<size_t> yinyangAssignments;
+      arma::mat yinyangCentroids(centroids);
+      yinyang.Cluster(dataset, k, yinyangAssignments, yinyangCentroids, false,
+          true);
+
+      for (size_t i = 0; i < dataset.n_cols; ++i)
+        BOOST_REQUIRE_EQUAL(assignments[i], yinyangAssignments[i]);
+
+      for (size_t i = 0; i < centroids.n_elem; ++i)
+        BOOST_REQUIRE_CLOSE(naiveCentroids[i], yinyangCentroids[i], 1e-5);
+    }
+  }
+}
+
 BOOST_AUTO_TEST_CASE(PellegMooreTest)
 {
   const size_t trials = 5;
@@ -662,4 +708,447 @@ BOOST_AUTO_TEST_CASE(DTNNCoverTreeTest)
   }
 }
 
+/**
+ * Make sure that the dual-tree algorithm gives the same results as the naive
+ * algorithm when the centroid tree is refitted instead of rebuilt.
+ */
+BOOST_AUTO_TEST_CASE(DTNNReuseCentroidTreeTest)
+{
+  const size_t trials = 5;
+
+  for (size_t t = 0; t < trials; ++t)
+  {
+    arma::mat dataset(10, 1000);
+    dataset.randu();
+
+    const size_t k = 5 * (t + 1);
+    arma::mat centroids(10, k);
+    centroids.randu();
+
+    arma::mat naiveCentroids(centroids);
+    KMeans<> km;
+    arma::Col<size_t> assignments;
+    km.Cluster(dataset, k, assignments, naiveCentroids, false, true);
+
+    KMeans<metric::EuclideanDistance, RandomPartition, MaxVarianceNewCluster,
+        DefaultDualTreeKMeans> dtnn;
+    dtnn.ReuseCentroidTree() = true;
+    arma::Col<size_t> dtnnAssignments;
+    arma::mat dtnnCentroids(centroids);
+    dtnn.Cluster(dataset, k, dtnnAssignments, dtnnCentroids, false, true);
+
+    for (size_t i = 0; i < dataset.n_cols; ++i)
+      BOOST_REQUIRE_EQUAL(assignments[i], dtnnAssignments[i]);
+
+    for (size_t i = 0; i < centroids.n_elem; ++i)
+      BOOST_REQUIRE_CLOSE(naiveCentroids[i], dtnnCentroids[i], 1e-5);
+  }
+}
+
+//! Dual-tree k-means with a ball tree on the centroids.
+template<typename MetricType, typename MatType>
+using BallTreeDualTreeKMeans = DualTreeKMeans<MetricType, MatType,
+    tree::BallTree>;
+
+/**
+ * Make sure that refitting the centroid tree also works for trees whose nodes
+ * are bounded by balls.
+ */
+BOOST_AUTO_TEST_CASE(DTNNReuseBallTreeTest)
+{
+  arma::mat dataset(10, 1000);
+  dataset.randu();
+
+  const size_t k = 15;
+  arma::mat centroids(10, k);
+  centroids.randu();
+
+  arma::mat naiveCentroids(centroids);
+  KMeans<> km;
+  arma::Col<size_t> assignments;
+  km.Cluster(dataset, k, assignments, naiveCentroids, false, true);
+
+  KMeans<metric::EuclideanDistance, RandomPartition, MaxVarianceNewCluster,
+      BallTreeDualTreeKMeans> dtnn;
+  dtnn.ReuseCentroidTree() = true;
+  arma::Col<size_t> dtnnAssignments;
+  arma::mat dtnnCentroids(centroids);
+  dtnn.Cluster(dataset, k, dtnnAssignments, dtnnCentroids, false, true);
+
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], dtnnAssignments[i]);
+
+  for (size_t i = 0; i < centroids.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(naiveCentroids[i], dtnnCentroids[i], 1e-5);
+}
+
+//! Make sure that the bound of each node holds all of its descendant points,
+//! and that the furthest descendant distance is correct.
+template<typename TreeType>
+void CheckRefittedBounds(TreeType& node)
+{
+  arma::vec center;
+  node.Center(center);
+  double furthest = 0.0;
+  for (size_t i = 0; i < node.NumDescendants(); ++i)
+  {
+    const arma::vec point = node.Dataset().col(node.Descendant(i));
+    BOOST_REQUIRE_SMALL(node.Bound().MinDistance(point), 1e-5);
+    furthest = std::max(furthest, metric::EuclideanDistance::Evaluate(center,
+        point));
+  }
+
+  BOOST_REQUIRE_LE(furthest, node.FurthestDescendantDistance() + 1e-5);
+
+  for (size_t i = 0; i < node.NumChildren(); ++i)
+    CheckRefittedBounds(node.Child(i));
+}
+
+/**
+ * Refit a ball tree built on centroids to moved centroids, and make sure the
+ * bounds hold the moved points.
+ */
+BOOST_AUTO_TEST_CASE(RefitBallTreeBoundsTest)
+{
+  typedef BallTree<metric::EuclideanDistance, DualTreeKMeansStatistic,
+      arma::mat> TreeType;
+
+  arma::mat centroids(5, 200);
+  centroids.randu();
+
+  std::vector<size_t> oldFromNew;
+  TreeType tree(centroids, oldFromNew, 5);
+
+  // Move the centroids far enough that the old bounds are wrong.
+  arma::mat movedCentroids = 3.0 * centroids + 1.0;
+  RefitTree(tree, movedCentroids, oldFromNew);
+
+  for (size_t i = 0; i < movedCentroids.n_cols; ++i)
+    for (size_t d = 0; d < movedCentroids.n_rows; ++d)
+      BOOST_REQUIRE_CLOSE(tree.Dataset()(d, i),
+          movedCentroids(d, oldFromNew[i]), 1e-5);
+
+  CheckRefittedBounds(tree);
+}
+
+/**
+ * Run k-means with the given Lloyd step type with one and with several threads,
+ * and make sure that the results are the same, and that two runs with the same
+ * number of threads give exactly the same centroids.
+ */
+template<template<class, class> class LloydStepType>
+void CheckParallelLloydStep()
+{
+  arma::mat dataset(10, 1000);
+  dataset.randu();
+
+  const size_t k = 15;
+  arma::mat centroids(10, k);
+  centroids.randu();
+
+  KMeans<metric::EuclideanDistance, RandomPartition, MaxVarianceNewCluster,
+      LloydStepType> km;
+  arma::Col<size_t> assignments;
+  arma::mat serialCentroids(centroids);
+  km.Cluster(dataset, k, assignments, serialCentroids, false, true);
+
+  km.NumThreads() = 3;
+  arma::Col<size_t> parallelAssignments;
+  arma::mat parallelCentroids(centroids);
+  km.Cluster(dataset, k, parallelAssignments, parallelCentroids, false, true);
+
+  arma::Col<size_t> repeatAssignments;
+  arma::mat repeatCentroids(centroids);
+  km.Cluster(dataset, k, repeatAssignments, repeatCentroids, false, true);
+
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(assignments[i], parallelAssignments[i]);
+    BOOST_REQUIRE_EQUAL(parallelAssignments[i], repeatAssignments[i]);
+  }
+
+  for (size_t i = 0; i < centroids.n_elem; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(serialCentroids[i], parallelCentroids[i], 1e-5);
+    BOOST_REQUIRE_EQUAL(parallelCentroids[i], repeatCentroids[i]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ParallelLloydStepTest)
+{
+  CheckParallelLloydStep<NaiveKMeans>();
+  CheckParallelLloydStep<ElkanKMeans>();
+  CheckParallelLloydStep<HamerlyKMeans>();
+  CheckParallelLloydStep<YinyangKMeans>();
+}
+
+/**
+ * Make sure mini-batch k-means finds the three classes of the simple dataset,
+ * starting from one point of each class.
+ */
+BOOST_AUTO_TEST_CASE(MiniBatchKMeansTest)
+{
+  const arma::mat data = trans(kMeansData);
+  arma::mat centroids(2, 3);
+  centroids.col(0) = data.col(0);
+  centroids.col(1) = data.col(13);
+  centroids.col(2) = data.col(20);
+
+  KMeans<metric::EuclideanDistance, RandomPartition, MaxVarianceNewCluster,
+      MiniBatchKMeans> kmeans(100);
+  kmeans.BatchSize() = 10;
+  arma::Col<size_t> assignments;
+  kmeans.Cluster(data, 3, assignments, centroids, false, true);
+
+  for (size_t i = 0; i < 13; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], 0);
+  for (size_t i = 13; i < 20; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], 1);
+  for (size_t i = 20; i < 30; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], 2);
+
+  // The centroids should be close to the means of each class.
+  const arma::vec mean0 = arma::mean(data.cols(0, 12), 1);
+  const arma::vec mean1 = arma::mean(data.cols(13, 19), 1);
+  const arma::vec mean2 = arma::mean(data.cols(20, 29), 1);
+  BOOST_REQUIRE_LT(arma::norm(centroids.col(0) - mean0, 2), 0.3);
+  BOOST_REQUIRE_LT(arma::norm(centroids.col(1) - mean1, 2), 0.3);
+  BOOST_REQUIRE_LT(arma::norm(centroids.col(2) - mean2, 2), 0.3);
+}
+
+/**
+ * Make sure mini-batch k-means on a dataset read from disk finds the three
+ * classes of the simple dataset.  The batch size does not divide the size of
+ * the dataset, so reading must wrap around the end of the file.
+ */
+BOOST_AUTO_TEST_CASE(StreamingMiniBatchKMeansTest)
+{
+  const arma::mat data = trans(kMeansData);
+  data::Save("streaming_kmeans_test.csv", data);
+
+  arma::mat centroids(2, 3);
+  centroids.col(0) = data.col(0);
+  centroids.col(1) = data.col(13);
+  centroids.col(2) = data.col(20);
+
+  StreamingMiniBatchKMeans<> kmeans("streaming_kmeans_test.csv", 7, 100);
+  kmeans.Cluster(3, centroids, true);
+
+  const arma::vec mean0 = arma::mean(data.cols(0, 12), 1);
+  const arma::vec mean1 = arma::mean(data.cols(13, 19), 1);
+  const arma::vec mean2 = arma::mean(data.cols(20, 29), 1);
+  BOOST_REQUIRE_LT(arma::norm(centroids.col(0) - mean0, 2), 0.3);
+  BOOST_REQUIRE_LT(arma::norm(centroids.col(1) - mean1, 2), 0.3);
+  BOOST_REQUIRE_LT(arma::norm(centroids.col(2) - mean2, 2), 0.3);
+
+  // Without initial centroids, there should still be one centroid per class.
+  arma::mat randomCentroids;
+  StreamingMiniBatchKMeans<> kmeans2("streaming_kmeans_test.csv", 30, 100);
+  kmeans2.Cluster(3, randomCentroids);
+  BOOST_REQUIRE_EQUAL(randomCentroids.n_rows, 2);
+  BOOST_REQUIRE_EQUAL(randomCentroids.n_cols, 3);
+
+  remove("streaming_kmeans_test.csv");
+}
+
+/**
+ * Out-of-core k-means should give the same results as KMeans with the naive
+ * Lloyd step, for transposed and non-transposed files and for float data, even
+ * if the last block is smaller than the others.
+ */
+BOOST_AUTO_TEST_CASE(OutOfCoreKMeansTest)
+{
+  arma::mat dataset(10, 1000);
+  dataset.randu();
+
+  const size_t k = 5;
+  arma::mat centroids = dataset.cols(0, k - 1);
+
+  KMeans<> km;
+  arma::Col<size_t> assignments;
+  arma::mat naiveCentroids(centroids);
+  km.Cluster(dataset, k, assignments, naiveCentroids, false, true);
+
+  // data::Save() writes one point per row.
+  data::Save("out_of_core_kmeans_test.bin", dataset);
+  arma::mat oocCentroids(centroids);
+  OutOfCoreKMeans<> ooc("out_of_core_kmeans_test.bin", 77);
+  ooc.Cluster(k, oocCentroids, true, "out_of_core_kmeans_test.csv");
+
+  for (size_t i = 0; i < naiveCentroids.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(naiveCentroids[i], oocCentroids[i], 1e-5);
+
+  std::ifstream labels("out_of_core_kmeans_test.csv");
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+  {
+    size_t label;
+    BOOST_REQUIRE(labels >> label);
+    BOOST_REQUIRE_EQUAL(label, assignments[i]);
+  }
+  labels.close();
+
+  // arma::Mat<>::save() writes one point per column.
+  dataset.save("out_of_core_kmeans_test.bin", arma::arma_binary);
+  arma::mat columnCentroids(centroids);
+  OutOfCoreKMeans<> columnOoc("out_of_core_kmeans_test.bin", 200, 1000,
+      false);
+  columnOoc.Cluster(k, columnCentroids, true);
+
+  for (size_t i = 0; i < naiveCentroids.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(naiveCentroids[i], columnCentroids[i], 1e-5);
+
+  // Float data is converted as it is read.
+  arma::fmat floatDataset = arma::conv_to<arma::fmat>::from(dataset);
+  floatDataset.save("out_of_core_kmeans_test.bin", arma::arma_binary);
+  const arma::mat convertedDataset = arma::conv_to<arma::mat>::from(
+      floatDataset);
+  arma::mat floatNaiveCentroids(centroids);
+  km.Cluster(convertedDataset, k, floatNaiveCentroids, true);
+  arma::mat floatCentroids(centroids);
+  OutOfCoreKMeans<> floatOoc("out_of_core_kmeans_test.bin", 100, 1000,
+      false);
+  floatOoc.Cluster(k, floatCentroids, true);
+
+  for (size_t i = 0; i < naiveCentroids.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(floatNaiveCentroids[i], floatCentroids[i], 1e-5);
+
+  remove("out_of_core_kmeans_test.bin");
+  remove("out_of_core_kmeans_test.csv");
+}
+
+/**
+ * Make sure that the given partition of the simple dataset puts each class in
+ * its own cluster.
+ */
+void CheckSimplePartition(const arma::Col<size_t>& assignments)
+{
+  BOOST_REQUIRE_EQUAL(assignments.n_elem, 30);
+
+  for (size_t i = 1; i < 13; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], assignments[0]);
+  for (size_t i = 14; i < 20; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], assignments[13]);
+  for (size_t i = 21; i < 30; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], assignments[20]);
+
+  BOOST_REQUIRE_NE(assignments[0], assignments[13]);
+  BOOST_REQUIRE_NE(assignments[0], assignments[20]);
+  BOOST_REQUIRE_NE(assignments[13], assignments[20]);
+}
+
+/**
+ * The k-means++ seeding should pick one center in each of the well-separated
+ * classes, and then k-means should finish the job.
+ */
+BOOST_AUTO_TEST_CASE(KMeansPlusPlusTest)
+{
+  const arma::mat data = trans(kMeansData);
+
+  KMeansPlusPlus kpp;
+  arma::Col<size_t> assignments;
+  kpp.Cluster(data, 3, assignments);
+  CheckSimplePartition(assignments);
+
+  KMeans<metric::EuclideanDistance, KMeansPlusPlus> kmeans;
+  kmeans.Cluster(data, 3, assignments);
+  CheckSimplePartition(assignments);
+}
+
+/**
+ * The k-means|| seeding should also find the three classes, and should not
+ * depend on the number of threads.
+ */
+BOOST_AUTO_TEST_CASE(KMeansParallelTest)
+{
+  const arma::mat data = trans(kMeansData);
+
+  KMeansParallel kmp;
+  arma::Col<size_t> assignments;
+  math::RandomSeed(12);
+  kmp.Cluster(data, 3, assignments);
+  CheckSimplePartition(assignments);
+
+  kmp.NumThreads() = 3;
+  arma::Col<size_t> parallelAssignments;
+  math::RandomSeed(12);
+  kmp.Cluster(data, 3, parallelAssignments);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], parallelAssignments[i]);
+
+  // With only one round and a tiny oversampling factor, extra candidates are
+  // added with k-means++ sampling.
+  KMeansParallel kmp2(0.5, 1);
+  kmp2.Cluster(data, 3, assignments);
+  CheckSimplePartition(assignments);
+
+  KMeans<metric::EuclideanDistance, KMeansParallel> kmeans;
+  kmeans.Cluster(data, 3, assignments);
+  CheckSimplePartition(assignments);
+}
+
+/**
+ * Run k-means in single precision on the simple dataset with the given
+ * policies, and make sure the three classes are found and the centroids match
+ * the double precision ones.
+ */
+template<typename InitialPartitionPolicy,
+         typename EmptyClusterPolicy,
+         template<class, class> class LloydStepType>
+void CheckFloatKMeans()
+{
+  const arma::mat data = trans(kMeansData);
+  const arma::fmat floatData = arma::conv_to<arma::fmat>::from(data);
+
+  KMeans<metric::EuclideanDistance, InitialPartitionPolicy, EmptyClusterPolicy,
+      LloydStepType, arma::fmat> floatKMeans;
+  arma::Col<size_t> assignments;
+  arma::fmat floatCentroids;
+  floatKMeans.Cluster(floatData, 3, assignments, floatCentroids);
+  CheckSimplePartition(assignments);
+
+  // Starting from the float centroids, the double precision k-means should
+  // not move them by more than rounding error.
+  KMeans<metric::EuclideanDistance, InitialPartitionPolicy, EmptyClusterPolicy,
+      LloydStepType> kmeans;
+  arma::mat centroids = arma::conv_to<arma::mat>::from(floatCentroids);
+  kmeans.Cluster(data, 3, centroids, true);
+  for (size_t i = 0; i < centroids.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE((double) floatCentroids[i], centroids[i], 1e-3);
+}
+
+/**
+ * The whole of k-means should work on arma::fmat: every initial partition
+ * policy, the empty cluster policies, and the Lloyd steps that don't need
+ * trees.
+ */
+BOOST_AUTO_TEST_CASE(FloatKMeansTest)
+{
+  CheckFloatKMeans<KMeansPlusPlus, MaxVarianceNewCluster, NaiveKMeans>();
+  CheckFloatKMeans<KMeansPlusPlus, MaxVarianceNewCluster, ElkanKMeans>();
+  CheckFloatKMeans<KMeansPlusPlus, MaxVarianceNewCluster, HamerlyKMeans>();
+  CheckFloatKMeans<KMeansPlusPlus, MaxVarianceNewCluster, YinyangKMeans>();
+  CheckFloatKMeans<KMeansParallel, AllowEmptyClusters, NaiveKMeans>();
+  CheckFloatKMeans<RandomPartition, MaxVarianceNewCluster, NaiveKMeans>();
+
+  // The refined start needs more points than the simple dataset has, so only
+  // make sure that it gives a valid partition of float data.
+  arma::fmat dataset(4, 2000);
+  dataset.randu();
+  RefinedStart r(5, 0.2);
+  arma::Col<size_t> assignments;
+  r.Cluster(dataset, 10, assignments);
+  BOOST_REQUIRE_EQUAL(assignments.n_elem, dataset.n_cols);
+  BOOST_REQUIRE_LT(arma::max(assignments), (size_t) 10);
+
+  // Mini-batch k-means in single precision.
+  KMeans<metric::EuclideanDistance, KMeansPlusPlus, MaxVarianceNewCluster,
+      MiniBatchKMeans, arma::fmat> miniBatch(200);
+  miniBatch.BatchSize() = 500;
+  arma::fmat centroids;
+  miniBatch.Cluster(dataset, 10, assignments, centroids);
+  BOOST_REQUIRE_EQUAL(centroids.n_rows, 4);
+  BOOST_REQUIRE_EQUAL(centroids.n_cols, 10);
+  BOOST_REQUIRE_EQUAL(assignments.n_elem, dataset.n_cols);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
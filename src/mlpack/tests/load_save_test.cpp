@@ -809,5 +809,56 @@ BOOST_AUTO_TEST_CASE(LoadTextTest)
   BOOST_REQUIRE_EQUAL(y.inb.s, x.inb.s);
 }
 
+/**
+ * Make sure ChunkReader reads a CSV a chunk at a time, and gives the same
+ * points as data::Load().
+ */
+BOOST_AUTO_TEST_CASE(ChunkReaderTest)
+{
+  arma::mat points = arma::randu<arma::mat>(3, 10);
+
+  std::fstream f;
+  f.open("test_chunk_file.csv", std::fstream::out);
+  f.precision(17);
+  for (size_t i = 0; i < points.n_cols; ++i)
+  {
+    f << points(0, i) << ", " << points(1, i) << ", " << points(2, i)
+        << std::endl;
+    if (i == 5)
+      f << std::endl; // A blank line should be skipped.
+  }
+  f.close();
+
+  data::ChunkReader reader("test_chunk_file.csv");
+  arma::mat chunk;
+  size_t read = 0;
+  const size_t expected[] = { 4, 4, 2, 0 };
+  for (size_t c = 0; c < 4; ++c)
+  {
+    BOOST_REQUIRE_EQUAL(reader.Read(4, chunk), expected[c]);
+    BOOST_REQUIRE_EQUAL(chunk.n_cols, expected[c]);
+    BOOST_REQUIRE_EQUAL(reader.Dimensionality(), 3);
+
+    for (size_t i = 0; i < chunk.n_cols; ++i)
+      for (size_t j = 0; j < 3; ++j)
+        BOOST_REQUIRE_CLOSE(chunk(j, i), points(j, read + i), 1e-10);
+    read += chunk.n_cols;
+  }
+
+  // After rewinding, the whole file can be read at once, and it should match
+  // data::Load().
+  arma::mat test;
+  BOOST_REQUIRE(data::Load("test_chunk_file.csv", test) == true);
+
+  reader.Rewind();
+  BOOST_REQUIRE_EQUAL(reader.Read(100, chunk), 10);
+  BOOST_REQUIRE_EQUAL(chunk.n_rows, test.n_rows);
+  BOOST_REQUIRE_EQUAL(chunk.n_cols, test.n_cols);
+  for (size_t i = 0; i < chunk.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(chunk[i], test[i], 1e-10);
+
+  // Remove the file.
+  remove("test_chunk_file.csv");
+}
 
 BOOST_AUTO_TEST_SUITE_END();
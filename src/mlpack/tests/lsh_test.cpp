@@ -9,6 +9,7 @@
 #include "old_boost_test_definitions.hpp"
 
 #include <mlpack/methods/lsh/lsh_search.hpp>
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
 
 using namespace std;
 using namespace mlpack;
@@ -108,4 +109,136 @@ BOOST_AUTO_TEST_CASE(LSHSearchTest)
   }
 }
 
+/**
+ * If the hash width is very large, every point is hashed into the same bucket
+ * in every table, so each query has every reference point as a candidate.  In
+ * that case the (batched, possibly parallel) search must return exactly the
+ * same results as naive search.
+ */
+BOOST_AUTO_TEST_CASE(LSHSearchWideHashExactTest)
+{
+  arma::mat rdata;
+  rdata.randu(3, 200);
+  arma::mat qdata;
+  qdata.randu(3, 100);
+
+  LSHSearch<> lsh(rdata, qdata, 5, 4, 1e10, 99901, 500);
+
+  arma::Mat<size_t> lshNeighbors;
+  arma::mat lshDistances;
+  lsh.Search(3, lshNeighbors, lshDistances);
+
+  AllkNN naive(rdata, true);
+  arma::Mat<size_t> naiveNeighbors;
+  arma::mat naiveDistances;
+  naive.Search(qdata, 3, naiveNeighbors, naiveDistances);
+
+  BOOST_REQUIRE_EQUAL(lshNeighbors.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(lshNeighbors.n_cols, 100);
+  for (size_t i = 0; i < lshNeighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(lshNeighbors[i], naiveNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(lshDistances[i], naiveDistances[i], 1e-5);
+  }
+
+  // Every reference point was a candidate for every query.
+  BOOST_REQUIRE_EQUAL(lsh.DistanceEvaluations(), 200 * 100);
+}
+
+/**
+ * Passing the query set to Search() must give the same results as passing it
+ * to the constructor, and without any query set, the reference set must be
+ * searched without returning a point as its own neighbor.
+ */
+BOOST_AUTO_TEST_CASE(LSHSearchQuerySetTest)
+{
+  arma::mat rdata;
+  rdata.randu(4, 300);
+  arma::mat qdata;
+  qdata.randu(4, 50);
+
+  math::RandomSeed(42);
+  LSHSearch<> lsh(rdata, qdata, 4, 5, 0.5, 99901, 500);
+
+  math::RandomSeed(42);
+  LSHSearch<> lshNoQuery(rdata, 4, 5, 0.5, 99901, 500);
+
+  arma::Mat<size_t> neighbors, queryNeighbors;
+  arma::mat distances, queryDistances;
+  lsh.Search(3, neighbors, distances);
+  lshNoQuery.Search(qdata, 3, queryNeighbors, queryDistances);
+
+  BOOST_REQUIRE_EQUAL(neighbors.n_cols, 50);
+  BOOST_REQUIRE_EQUAL(queryNeighbors.n_cols, 50);
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], queryNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(distances[i], queryDistances[i], 1e-5);
+  }
+
+  arma::Mat<size_t> selfNeighbors;
+  arma::mat selfDistances;
+  lshNoQuery.Search(3, selfNeighbors, selfDistances);
+
+  BOOST_REQUIRE_EQUAL(selfNeighbors.n_cols, 300);
+  for (size_t i = 0; i < selfNeighbors.n_cols; ++i)
+    for (size_t j = 0; j < selfNeighbors.n_rows; ++j)
+      BOOST_REQUIRE_NE(selfNeighbors(j, i), i);
+}
+
+/**
+ * Points added with Insert() must be hashed into the same buckets that they
+ * would have been hashed into if they had been part of the reference set from
+ * the start.  We check this by giving a model all the data at once, and
+ * another model the same data in two pieces, with the same random seed.
+ */
+BOOST_AUTO_TEST_CASE(LSHSearchInsertTest)
+{
+  arma::mat rdata;
+  rdata.randu(4, 300);
+  arma::mat qdata;
+  qdata.randu(4, 50);
+
+  math::RandomSeed(42);
+  LSHSearch<> lsh(rdata, 4, 5, 0.5, 99901, 500);
+
+  math::RandomSeed(42);
+  const arma::mat firstHalf = rdata.cols(0, 149);
+  LSHSearch<> lshInsert(firstHalf, 4, 5, 0.5, 99901, 500);
+  lshInsert.Insert(rdata.cols(150, 299));
+
+  BOOST_REQUIRE_EQUAL(lshInsert.ReferenceSet().n_cols, 300);
+
+  arma::Mat<size_t> neighbors, insertNeighbors;
+  arma::mat distances, insertDistances;
+  lsh.Search(qdata, 3, neighbors, distances);
+  lshInsert.Search(qdata, 3, insertNeighbors, insertDistances);
+
+  BOOST_REQUIRE_EQUAL(lsh.DistanceEvaluations(),
+      lshInsert.DistanceEvaluations());
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], insertNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(distances[i], insertDistances[i], 1e-5);
+  }
+}
+
+/**
+ * Make sure that inserting points of the wrong dimensionality, or into an
+ * untrained model, throws an exception.
+ */
+BOOST_AUTO_TEST_CASE(LSHSearchInsertInvalidTest)
+{
+  arma::mat rdata;
+  rdata.randu(4, 100);
+  arma::mat wrongData;
+  wrongData.randu(3, 10);
+
+  LSHSearch<> lsh(rdata, 4, 5);
+  BOOST_REQUIRE_THROW(lsh.Insert(wrongData), std::invalid_argument);
+
+  LSHSearch<> empty;
+  BOOST_REQUIRE_THROW(empty.Insert(rdata), std::invalid_argument);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -21,12 +21,16 @@
 #include <mlpack/core/tree/hrectbound.hpp>
 #include <mlpack/core/metrics/mahalanobis_distance.hpp>
 #include <mlpack/core/tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/cover_tree.hpp>
 
 #include <mlpack/methods/perceptron/perceptron.hpp>
 #include <mlpack/methods/logistic_regression/logistic_regression.hpp>
 #include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+#include <mlpack/methods/lsh/lsh_search.hpp>
+#include <mlpack/methods/fastmks/fastmks.hpp>
 #include <mlpack/methods/softmax_regression/softmax_regression.hpp>
 #include <mlpack/methods/det/dtree.hpp>
+#include <mlpack/methods/gmm/diagonal_gmm.hpp>
 
 using namespace mlpack;
 using namespace mlpack::distribution;
@@ -422,6 +426,97 @@ BOOST_AUTO_TEST_CASE(GaussianDistributionTest)
   }
 }
 
+BOOST_AUTO_TEST_CASE(DiagonalGaussianDistributionTest)
+{
+  vec mean(10);
+  mean.randu();
+  vec variances(10);
+  variances.randu();
+  variances += 0.1;
+
+  DiagonalGaussianDistribution d(mean, variances);
+  DiagonalGaussianDistribution xmlD, textD, binaryD;
+
+  SerializeObjectAll(d, xmlD, textD, binaryD);
+
+  BOOST_REQUIRE_EQUAL(d.Dimensionality(), xmlD.Dimensionality());
+  BOOST_REQUIRE_EQUAL(d.Dimensionality(), textD.Dimensionality());
+  BOOST_REQUIRE_EQUAL(d.Dimensionality(), binaryD.Dimensionality());
+
+  CheckMatrices(d.Mean(), xmlD.Mean(), textD.Mean(), binaryD.Mean());
+  CheckMatrices(d.Covariance(), xmlD.Covariance(), textD.Covariance(),
+      binaryD.Covariance());
+
+  // The cached inverse variances and log-determinant are used here.
+  arma::mat randomObs;
+  randomObs.randu(10, 500);
+
+  for (size_t i = 0; i < 500; ++i)
+  {
+    const double logProb = d.LogProbability(randomObs.unsafe_col(i));
+
+    BOOST_REQUIRE_CLOSE(logProb, xmlD.LogProbability(randomObs.unsafe_col(i)),
+        1e-8);
+    BOOST_REQUIRE_CLOSE(logProb, textD.LogProbability(randomObs.unsafe_col(i)),
+        1e-8);
+    BOOST_REQUIRE_CLOSE(logProb,
+        binaryD.LogProbability(randomObs.unsafe_col(i)), 1e-8);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(DiagonalGMMTest)
+{
+  using gmm::DiagonalGMM;
+
+  DiagonalGMM<> g(5, 4);
+  g.Weights().randu();
+  g.Weights() /= accu(g.Weights());
+  for (size_t i = 0; i < g.Gaussians(); ++i)
+  {
+    g.Component(i).Mean().randu();
+    g.Component(i).Covariance(arma::randu<vec>(4) + 0.1);
+  }
+
+  DiagonalGMM<> xmlG, textG, binaryG;
+
+  SerializeObjectAll(g, xmlG, textG, binaryG);
+
+  BOOST_REQUIRE_EQUAL(g.Gaussians(), xmlG.Gaussians());
+  BOOST_REQUIRE_EQUAL(g.Gaussians(), textG.Gaussians());
+  BOOST_REQUIRE_EQUAL(g.Gaussians(), binaryG.Gaussians());
+
+  BOOST_REQUIRE_EQUAL(g.Dimensionality(), xmlG.Dimensionality());
+  BOOST_REQUIRE_EQUAL(g.Dimensionality(), textG.Dimensionality());
+  BOOST_REQUIRE_EQUAL(g.Dimensionality(), binaryG.Dimensionality());
+
+  CheckMatrices(g.Weights(), xmlG.Weights(), textG.Weights(),
+      binaryG.Weights());
+
+  for (size_t i = 0; i < g.Gaussians(); ++i)
+  {
+    CheckMatrices(g.Component(i).Mean(), xmlG.Component(i).Mean(),
+        textG.Component(i).Mean(), binaryG.Component(i).Mean());
+    CheckMatrices(g.Component(i).Covariance(),
+        xmlG.Component(i).Covariance(), textG.Component(i).Covariance(),
+        binaryG.Component(i).Covariance());
+  }
+
+  // Lastly, make sure the reloaded models give the same probabilities.
+  arma::mat randomObs;
+  randomObs.randu(4, 100);
+
+  for (size_t i = 0; i < 100; ++i)
+  {
+    const double prob = g.Probability(randomObs.unsafe_col(i));
+
+    BOOST_REQUIRE_CLOSE(prob, xmlG.Probability(randomObs.unsafe_col(i)), 1e-8);
+    BOOST_REQUIRE_CLOSE(prob, textG.Probability(randomObs.unsafe_col(i)),
+        1e-8);
+    BOOST_REQUIRE_CLOSE(prob, binaryG.Probability(randomObs.unsafe_col(i)),
+        1e-8);
+  }
+}
+
 BOOST_AUTO_TEST_CASE(LaplaceDistributionTest)
 {
   vec mean(20);
@@ -722,6 +817,46 @@ BOOST_AUTO_TEST_CASE(BinarySpaceTreeOverwriteTest)
   CheckTrees(tree, xmlTree, textTree, binaryTree);
 }
 
+BOOST_AUTO_TEST_CASE(CoverTreeTest)
+{
+  arma::mat data;
+  data.randu(3, 100);
+  typedef StandardCoverTree<EuclideanDistance, EmptyStatistic, arma::mat>
+      TreeType;
+  TreeType tree(data);
+
+  TreeType* xmlTree;
+  TreeType* textTree;
+  TreeType* binaryTree;
+
+  SerializePointerObjectAll(&tree, xmlTree, textTree, binaryTree);
+
+  CheckTrees(tree, *xmlTree, *textTree, *binaryTree);
+
+  delete xmlTree;
+  delete textTree;
+  delete binaryTree;
+}
+
+BOOST_AUTO_TEST_CASE(CoverTreeOverwriteTest)
+{
+  arma::mat data;
+  data.randu(3, 100);
+  typedef StandardCoverTree<EuclideanDistance, EmptyStatistic, arma::mat>
+      TreeType;
+  TreeType tree(data);
+
+  arma::mat otherData;
+  otherData.randu(3, 50);
+  TreeType xmlTree(otherData);
+  TreeType textTree(otherData);
+  TreeType binaryTree(otherData);
+
+  SerializeObjectAll(tree, xmlTree, textTree, binaryTree);
+
+  CheckTrees(tree, xmlTree, textTree, binaryTree);
+}
+
 BOOST_AUTO_TEST_CASE(PerceptronTest)
 {
   // Create a perceptron.  Train it randomly.  Then check that it hasn't
@@ -801,6 +936,104 @@ BOOST_AUTO_TEST_CASE(AllkNNTest)
   CheckMatrices(neighbors, xmlNeighbors, textNeighbors, binaryNeighbors);
 }
 
+BOOST_AUTO_TEST_CASE(LSHTest)
+{
+  using neighbor::LSHSearch;
+  arma::mat dataset = arma::randu<arma::mat>(5, 2000);
+
+  LSHSearch<> lsh(dataset, 5, 10);
+
+  LSHSearch<> lshXml, lshText;
+  LSHSearch<> lshBinary(dataset, 3, 3);
+
+  SerializeObjectAll(lsh, lshXml, lshText, lshBinary);
+
+  CheckMatrices(lsh.ReferenceSet(), lshXml.ReferenceSet(),
+      lshText.ReferenceSet(), lshBinary.ReferenceSet());
+
+  // Now run nearest neighbor and make sure the results are the same.
+  arma::mat querySet = arma::randu<arma::mat>(5, 1000);
+
+  arma::mat distances, xmlDistances, textDistances, binaryDistances;
+  arma::Mat<size_t> neighbors, xmlNeighbors, textNeighbors, binaryNeighbors;
+
+  lsh.Search(querySet, 5, neighbors, distances);
+  lshXml.Search(querySet, 5, xmlNeighbors, xmlDistances);
+  lshText.Search(querySet, 5, textNeighbors, textDistances);
+  lshBinary.Search(querySet, 5, binaryNeighbors, binaryDistances);
+
+  CheckMatrices(distances, xmlDistances, textDistances, binaryDistances);
+  CheckMatrices(neighbors, xmlNeighbors, textNeighbors, binaryNeighbors);
+}
+
+BOOST_AUTO_TEST_CASE(FastMKSTest)
+{
+  using namespace fastmks;
+  using kernel::PolynomialKernel;
+
+  arma::mat dataset = arma::randu<arma::mat>(5, 500);
+  PolynomialKernel pk(2.0);
+
+  FastMKS<PolynomialKernel> fastmks(dataset, pk);
+
+  FastMKS<PolynomialKernel> fXml, fText;
+  FastMKS<PolynomialKernel> fBinary(false, true);
+  fBinary.Train(dataset);
+
+  SerializeObjectAll(fastmks, fXml, fText, fBinary);
+
+  // Now run the search and make sure the results are the same.
+  arma::mat querySet = arma::randu<arma::mat>(5, 100);
+
+  arma::mat kernels, xmlKernels, textKernels, binaryKernels;
+  arma::Mat<size_t> indices, xmlIndices, textIndices, binaryIndices;
+
+  fastmks.Search(querySet, 5, indices, kernels);
+  fXml.Search(querySet, 5, xmlIndices, xmlKernels);
+  fText.Search(querySet, 5, textIndices, textKernels);
+  fBinary.Search(querySet, 5, binaryIndices, binaryKernels);
+
+  CheckMatrices(kernels, xmlKernels, textKernels, binaryKernels);
+  CheckMatrices(indices, xmlIndices, textIndices, binaryIndices);
+}
+
+/**
+ * Load a naive FastMKS model into objects that hold a tree, and make sure the
+ * tree is discarded.
+ */
+BOOST_AUTO_TEST_CASE(FastMKSNaiveOverwriteTest)
+{
+  using namespace fastmks;
+  using kernel::LinearKernel;
+
+  arma::mat dataset = arma::randu<arma::mat>(5, 200);
+
+  FastMKS<LinearKernel> naive(dataset, false, true);
+
+  arma::mat otherDataset = arma::randu<arma::mat>(5, 100);
+  FastMKS<LinearKernel> fXml(otherDataset), fText(otherDataset),
+      fBinary(otherDataset);
+
+  SerializeObjectAll(naive, fXml, fText, fBinary);
+
+  BOOST_REQUIRE_EQUAL(fXml.Naive(), true);
+  BOOST_REQUIRE_EQUAL(fText.Naive(), true);
+  BOOST_REQUIRE_EQUAL(fBinary.Naive(), true);
+
+  arma::mat querySet = arma::randu<arma::mat>(5, 50);
+
+  arma::mat kernels, xmlKernels, textKernels, binaryKernels;
+  arma::Mat<size_t> indices, xmlIndices, textIndices, binaryIndices;
+
+  naive.Search(querySet, 5, indices, kernels);
+  fXml.Search(querySet, 5, xmlIndices, xmlKernels);
+  fText.Search(querySet, 5, textIndices, textKernels);
+  fBinary.Search(querySet, 5, binaryIndices, binaryKernels);
+
+  CheckMatrices(kernels, xmlKernels, textKernels, binaryKernels);
+  CheckMatrices(indices, xmlIndices, textIndices, binaryIndices);
+}
+
 BOOST_AUTO_TEST_CASE(SoftmaxRegressionTest)
 {
   using regression::SoftmaxRegression;
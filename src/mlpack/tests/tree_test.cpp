@@ -668,6 +668,36 @@ BOOST_AUTO_TEST_CASE(TestBallBound)
  * Ensure that we calculate the correct minimum distance between a point and a
  * bound.
  */
+/**
+ * Test that clearing a ball bound makes it empty, and that it can then be grown
+ * again to hold new points.
+ */
+BOOST_AUTO_TEST_CASE(BallBoundClear)
+{
+  arma::mat points("0.0 1.0 2.0;"
+                   "0.0 1.0 0.0");
+  BallBound<> b(2);
+  b |= points;
+  BOOST_REQUIRE_GT(b.Radius(), 0.0);
+
+  b.Clear();
+
+  BOOST_REQUIRE_LT(b.Radius(), 0.0);
+  BOOST_REQUIRE_EQUAL(b.Center().n_elem, 2);
+  BOOST_REQUIRE_SMALL(b.Center()[0], 1e-5);
+  BOOST_REQUIRE_SMALL(b.Center()[1], 1e-5);
+  BOOST_REQUIRE(!b.Contains(b.Center()));
+
+  arma::mat newPoints("10.0 11.0;"
+                      "10.0 10.0");
+  b |= newPoints;
+
+  BOOST_REQUIRE(b.Contains(arma::vec(newPoints.col(0))));
+  BOOST_REQUIRE(b.Contains(arma::vec(newPoints.col(1))));
+  BOOST_REQUIRE(!b.Contains(arma::vec(points.col(0))));
+  BOOST_REQUIRE_CLOSE(b.Radius(), 0.5, 1e-5);
+}
+
 BOOST_AUTO_TEST_CASE(HRectBoundRootMinDistancePoint)
 {
   // We'll do the calculation in five dimensions, and we'll use three cases for
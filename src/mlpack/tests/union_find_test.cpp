@@ -46,4 +46,28 @@ BOOST_AUTO_TEST_CASE(TestUnion)
   BOOST_REQUIRE(testUnionFind_.Find(6) == testUnionFind_.Find(3));
 }
 
+/**
+ * Find() may be called from several threads at once; the components must not
+ * change.
+ */
+BOOST_AUTO_TEST_CASE(TestConcurrentFind)
+{
+  static const size_t testSize_ = 1000;
+  UnionFind testUnionFind_(testSize_);
+
+  // Put everything into one component.
+  for (size_t i = 1; i < testSize_; ++i)
+    testUnionFind_.Union(i - 1, i);
+
+  const size_t root = testUnionFind_.Find(0);
+  arma::Col<size_t> results(4 * testSize_);
+
+  #pragma omp parallel for num_threads(4)
+  for (size_t i = 0; i < results.n_elem; ++i)
+    results[i] = testUnionFind_.Find(testSize_ - 1 - (i % testSize_));
+
+  for (size_t i = 0; i < results.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(results[i], root);
+}
+
 BOOST_AUTO_TEST_SUITE_END();